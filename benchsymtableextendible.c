@@ -0,0 +1,112 @@
+/*--------------------------------------------------------------------*/
+/* benchsymtableextendible.c                                          */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#include "symtable.h"
+#include "symtableextendible.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The longest key that the benchmark builds. */
+
+enum {MAX_KEY_LENGTH = 32};
+
+/* The bytes of one bucket and of one directory entry. */
+
+enum {BUCKET_BYTES = 4096};
+enum {DIRECTORY_ENTRY_BYTES = sizeof(void*)};
+
+/*--------------------------------------------------------------------*/
+
+/* Write one row about the space oSymTable uses to stdout: its
+   bindings, buckets and directory entries, the share of bucket slots
+   in use, and the bucket and directory bytes per binding. */
+
+static void reportSpace(SymTable_T oSymTable)
+{
+   size_t uLength = SymTable_getLength(oSymTable);
+   size_t uBuckets;
+   size_t uSlots;
+   size_t uDirectory;
+
+   SymTable_getSpaceUsage(oSymTable, &uBuckets, &uSlots, &uDirectory);
+   printf("   %9lu %8lu %9lu %7.1f%% %9.1f\n", (unsigned long)uLength,
+      (unsigned long)uBuckets, (unsigned long)uDirectory,
+      100.0 * (double)uLength / (double)uSlots,
+      (double)(uBuckets * BUCKET_BYTES + uDirectory * DIRECTORY_ENTRY_BYTES)
+      / (double)(uLength > 0 ? uLength : 1));
+   fflush(stdout);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Measure how full an extendible hash table keeps its buckets.
+   argv[1] is the number of keys to put. Report the space in use each
+   time the number of bindings doubles, and again after every other key
+   is removed, to stdout. Exit with EXIT_FAILURE if argv[1] is missing
+   or not a positive number, or if memory is insufficient. Otherwise
+   return 0. */
+
+int main(int argc, char *argv[])
+{
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   int iKeyCount;
+   int iNextReport;
+   int i;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s keycount\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+
+   if (sscanf(argv[1], "%d", &iKeyCount) != 1 || iKeyCount <= 0)
+   {
+      fprintf(stderr, "keycount must be a positive number\n");
+      exit(EXIT_FAILURE);
+   }
+
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL)
+   {
+      fprintf(stderr, "insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+
+   printf("------------------------------------------------------\n");
+   printf("%s: space in use while putting %d keys:\n", argv[0],
+      iKeyCount);
+   printf("   %9s %8s %9s %8s %9s\n", "bindings", "buckets", "directory",
+      "full", "bytes/key");
+   iNextReport = 1024;
+   for (i = 0; i < iKeyCount; i++)
+   {
+      sprintf(acKey, "tok_%d", i);
+      if (! SymTable_put(oSymTable, acKey, oSymTable))
+      {
+         fprintf(stderr, "insufficient memory\n");
+         exit(EXIT_FAILURE);
+      }
+      if (i + 1 == iNextReport)
+      {
+         reportSpace(oSymTable);
+         iNextReport *= 2;
+      }
+   }
+   reportSpace(oSymTable);
+
+   printf("After removing every other key (buckets never merge):\n");
+   for (i = 0; i < iKeyCount; i += 2)
+   {
+      sprintf(acKey, "tok_%d", i);
+      SymTable_remove(oSymTable, acKey);
+   }
+   reportSpace(oSymTable);
+
+   SymTable_free(oSymTable);
+   return 0;
+}
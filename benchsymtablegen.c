@@ -0,0 +1,203 @@
+/*--------------------------------------------------------------------*/
+/* benchsymtablegen.c                                                 */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "symtable.h"
+#include "symtablehash.h"
+#include "symtablekeywords.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The longest key that the benchmark builds. */
+
+enum {MAX_KEY_LENGTH = 32};
+
+/* How many identifiers the miss lookups cycle through. */
+
+enum {IDENTIFIER_COUNT = 1024};
+
+/* How many times each table is built for the start-up figures. */
+
+enum {BUILD_ROUNDS = 2000};
+
+/* The keywords, collected from the generated table, and their
+   number. */
+
+static const char *apcKeywords[64];
+static int iKeywordCount;
+
+/*--------------------------------------------------------------------*/
+
+/* Return the current value of the monotonic clock in seconds. */
+
+static double getSeconds(void)
+{
+   struct timespec sNow;
+   clock_gettime(CLOCK_MONOTONIC, &sNow);
+   return (double)sNow.tv_sec + (double)sNow.tv_nsec / 1e9;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add pcKey to apcKeywords. */
+
+static void collectKeyword(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   (void)pvValue;
+   (void)pvExtra;
+   assert(iKeywordCount < (int)(sizeof(apcKeywords) /
+      sizeof(apcKeywords[0])));
+   apcKeywords[iKeywordCount++] = pcKey;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a table, populated at run time, that binds each keyword to
+   itself, frozen if iFrozen. */
+
+static SymTable_T makeTable(int iFrozen)
+{
+   SymTable_T oSymTable;
+   int i;
+
+   oSymTable = SymTable_new();
+   assert(oSymTable != NULL);
+   for (i = 0; i < iKeywordCount; i++)
+      SymTable_put(oSymTable, apcKeywords[i], apcKeywords[i]);
+   if (iFrozen)
+      SymTable_freeze(oSymTable);
+   return oSymTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write to stdout the time it takes to have a keyword table ready:
+   none for the generated table, and building, and then freezing, one
+   at run time. */
+
+static void reportStartUp(void)
+{
+   double dStart;
+   double dElapsed;
+   int iFrozen;
+   int iRound;
+
+   printf("Time to have the table ready:\n");
+   printf("   %-10s %10.1f ns\n", "generated", 0.0);
+   for (iFrozen = 0; iFrozen < 2; iFrozen++)
+   {
+      dStart = getSeconds();
+      for (iRound = 0; iRound < BUILD_ROUNDS; iRound++)
+         SymTable_free(makeTable(iFrozen));
+      dElapsed = getSeconds() - dStart;
+      printf("   %-10s %10.1f ns\n", iFrozen ? "frozen" : "chained",
+         dElapsed * 1e9 / BUILD_ROUNDS);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Look up iLookups keys, each of apcKeys[i % iCount] in turn, in the
+   generated table if oSymTable is NULL and in oSymTable otherwise.
+   Write the cost of a lookup to stdout in ns, and report a lookup
+   that does not find a key exactly when iMiss. */
+
+static void timeLookups(SymTable_T oSymTable, const char *const apcKeys[],
+   int iCount, int iLookups, int iMiss)
+{
+   double dStart;
+   double dElapsed;
+   int iFound = 0;
+   int i;
+
+   dStart = getSeconds();
+   if (oSymTable == NULL)
+      for (i = 0; i < iLookups; i++)
+         iFound += SymTableKeywords_get(apcKeys[i % iCount]) != NULL;
+   else
+      for (i = 0; i < iLookups; i++)
+         iFound += SymTable_get(oSymTable, apcKeys[i % iCount]) != NULL;
+   dElapsed = getSeconds() - dStart;
+
+   if (iFound != (iMiss ? 0 : iLookups))
+      printf("   lookup failed\n");
+   printf("  %8.1f ns", dElapsed * 1e9 / iLookups);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Compare the keyword table that symtablegen generated with hash
+   tables of the same keywords populated at run time, chained and
+   frozen. argv[1] is the number of lookups of each kind. Write the
+   time each table takes to be ready and the cost of looking up a
+   keyword and an identifier that is not a keyword to stdout. Exit
+   with EXIT_FAILURE if argv[1] is missing or not a positive number.
+   Otherwise return 0. */
+
+int main(int argc, char *argv[])
+{
+   static char aacIdentifiers[IDENTIFIER_COUNT][MAX_KEY_LENGTH];
+   const char *apcIdentifiers[IDENTIFIER_COUNT];
+   SymTable_T aoSymTables[3];
+   int iLookups;
+   int i;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s lookupcount\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+
+   if (sscanf(argv[1], "%d", &iLookups) != 1 || iLookups <= 0)
+   {
+      fprintf(stderr, "lookupcount must be a positive number\n");
+      exit(EXIT_FAILURE);
+   }
+
+   SymTableKeywords_map(collectKeyword, NULL);
+
+   /* Identifiers as short as keywords, so that the generated table's
+      length bounds do not turn them away */
+   for (i = 0; i < IDENTIFIER_COUNT; i++)
+   {
+      sprintf(aacIdentifiers[i], "%c%d", 'a' + i % 26, i);
+      apcIdentifiers[i] = aacIdentifiers[i];
+   }
+
+   printf("------------------------------------------------------\n");
+   printf("%d C keywords, %d lookups of each kind.\n", iKeywordCount,
+      iLookups);
+   reportStartUp();
+
+   aoSymTables[0] = NULL;
+   aoSymTables[1] = makeTable(0);
+   aoSymTables[2] = makeTable(1);
+   printf("Cost of a keyword lookup and of an identifier lookup:\n");
+   for (i = 0; i < 3; i++)
+   {
+      printf("   %-10s", i == 0 ? "generated" : i == 1 ? "chained" :
+         "frozen");
+      timeLookups(aoSymTables[i], apcKeywords, iKeywordCount, iLookups,
+         0);
+      timeLookups(aoSymTables[i], apcIdentifiers, IDENTIFIER_COUNT,
+         iLookups, 1);
+      printf("\n");
+      fflush(stdout);
+   }
+   SymTable_free(aoSymTables[1]);
+   SymTable_free(aoSymTables[2]);
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
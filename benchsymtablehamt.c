@@ -0,0 +1,218 @@
+/*--------------------------------------------------------------------*/
+/* benchsymtablehamt.c                                                */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "symtable.h"
+#include "symtablehamt.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* glibc reports the bytes that malloc has handed out; elsewhere the
+   memory column is left out. */
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+#define HAVE_MALLINFO2 1
+#include <malloc.h>
+#else
+#define HAVE_MALLINFO2 0
+#endif
+
+/*--------------------------------------------------------------------*/
+
+/* The longest key that the benchmark builds. */
+
+enum {MAX_KEY_LENGTH = 32};
+
+/* How many forks each way of forking makes, at most, and how many
+   changes each fork tries before it is discarded. */
+
+enum {FORK_COUNT = 1000, CHANGES_PER_FORK = 16};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the current value of the monotonic clock in seconds. */
+
+static double getSeconds(void)
+{
+   struct timespec sNow;
+   clock_gettime(CLOCK_MONOTONIC, &sNow);
+   return (double)sNow.tv_sec + (double)sNow.tv_nsec / 1e9;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of bytes that malloc has handed out and not taken
+   back, or 0 where that is not known. */
+
+static size_t getHeapBytes(void)
+{
+#if HAVE_MALLINFO2
+   struct mallinfo2 sInfo = mallinfo2();
+   return sInfo.uordblks + sInfo.hblkhd;
+#else
+   return 0;
+#endif
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Put the binding of pcKey to pvValue into the SymTable that pvExtra
+   points to. */
+
+static void copyBinding(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   SymTable_put((SymTable_T)pvExtra, pcKey, pvValue);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a copy of oSymTable made the way a client without
+   SymTable_clone has to: a new table and a put of every binding. */
+
+static SymTable_T deepCopy(SymTable_T oSymTable)
+{
+   SymTable_T oCopy = SymTable_new();
+
+   if (oCopy != NULL)
+      SymTable_map(oSymTable, copyBinding, oCopy);
+   return oCopy;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Fork oSymTable, by SymTable_clone if iClone and by deepCopy
+   otherwise, make CHANGES_PER_FORK changes to the fork among the
+   iCount keys of pcKeys, and discard it. If puHeap is not NULL, store
+   in *puHeap the heap bytes in use just before the fork is discarded. */
+
+static void forkOnce(SymTable_T oSymTable, int iClone,
+   const char *pcKeys, int iCount, size_t *puHeap)
+{
+   SymTable_T oFork;
+   const char *pcKey;
+   int i;
+
+   oFork = iClone ? SymTable_clone(oSymTable) : deepCopy(oSymTable);
+   if (oFork == NULL)
+   {
+      fprintf(stderr, "insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+
+   /* Half the changes add a key, half remove one */
+   for (i = 0; i < CHANGES_PER_FORK; i++)
+   {
+      pcKey = pcKeys + (size_t)(rand() % iCount) * MAX_KEY_LENGTH;
+      if (i % 2 == 0)
+         SymTable_put(oFork, "speculative", oFork);
+      else
+         SymTable_remove(oFork, pcKey);
+   }
+   if (puHeap != NULL)
+      *puHeap = getHeapBytes();
+   SymTable_free(oFork);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Fork oSymTable iForkCount times as forkOnce does, and write to
+   stdout, under the label pcLabel, the time a fork and its changes
+   took, and the heap bytes that one more fork takes. */
+
+static void forkAndDiscard(const char *pcLabel, SymTable_T oSymTable,
+   int iClone, const char *pcKeys, int iCount, int iForkCount)
+{
+   size_t uHeapBefore;
+   size_t uHeapFork;
+   double dStart;
+   double dSeconds;
+   int iFork;
+
+   srand(3);
+   dStart = getSeconds();
+   for (iFork = 0; iFork < iForkCount; iFork++)
+      forkOnce(oSymTable, iClone, pcKeys, iCount, NULL);
+   dSeconds = getSeconds() - dStart;
+
+   /* Reading the heap's size walks malloc's free lists, so it is kept
+      out of the timing */
+   uHeapBefore = getHeapBytes();
+   forkOnce(oSymTable, iClone, pcKeys, iCount, &uHeapFork);
+
+   printf("   %-22s %12.2f us per fork, %10.1f KB\n", pcLabel,
+      dSeconds / iForkCount * 1e6,
+      HAVE_MALLINFO2 ? (double)(uHeapFork - uHeapBefore) / 1024 : 0.0);
+   fflush(stdout);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Build a HAMT table of argv[1] keys, then write to stdout the time
+   and memory it takes to fork the table, try CHANGES_PER_FORK changes
+   and discard them, first copying every binding and then with
+   SymTable_clone. Exit with EXIT_FAILURE if argv[1] is missing or not
+   a positive number, or if memory is insufficient. Otherwise return
+   0. */
+
+int main(int argc, char *argv[])
+{
+   SymTable_T oSymTable;
+   char *pcKeys;
+   int iCount;
+   int iCopies;
+   int i;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s keycount\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+
+   if (sscanf(argv[1], "%d", &iCount) != 1 || iCount <= 0)
+   {
+      fprintf(stderr, "keycount must be a positive number\n");
+      exit(EXIT_FAILURE);
+   }
+
+   pcKeys = (char*)malloc((size_t)iCount * MAX_KEY_LENGTH);
+   oSymTable = SymTable_new();
+   if (pcKeys == NULL || oSymTable == NULL)
+   {
+      fprintf(stderr, "insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+   for (i = 0; i < iCount; i++)
+   {
+      sprintf(pcKeys + (size_t)i * MAX_KEY_LENGTH, "symbol_%d", i);
+      if (! SymTable_put(oSymTable, pcKeys + (size_t)i * MAX_KEY_LENGTH,
+         oSymTable))
+      {
+         fprintf(stderr, "insufficient memory\n");
+         exit(EXIT_FAILURE);
+      }
+   }
+
+   /* Copying is slow enough that a few million bindings' worth will do */
+   iCopies = 4000000 / iCount;
+   if (iCopies < 1)
+      iCopies = 1;
+   if (iCopies > FORK_COUNT)
+      iCopies = FORK_COUNT;
+
+   printf("------------------------------------------------------\n");
+   printf("%d keys, %d changes per fork.\n", iCount, CHANGES_PER_FORK);
+   forkAndDiscard("map and put", oSymTable, 0, pcKeys, iCount, iCopies);
+   forkAndDiscard("SymTable_clone", oSymTable, 1, pcKeys, iCount,
+      FORK_COUNT);
+
+   SymTable_free(oSymTable);
+   free(pcKeys);
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
@@ -0,0 +1,507 @@
+/*--------------------------------------------------------------------*/
+/* benchsymtablehash.c                                                */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "symtable.h"
+#include "symtablehash.h"
+#include "symtablehashfn.h"
+#include "symtablemph.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The longest key that the benchmarks build. */
+
+enum {MAX_KEY_LENGTH = 80};
+
+/* The longest chain that the distribution reports on its own; longer
+   chains are counted together. */
+
+enum {MAX_CHAIN_LENGTH = 8};
+
+/* Roughly how many key bytes each throughput run hashes. */
+
+#define BYTES_PER_RUN 200e6
+
+/*--------------------------------------------------------------------*/
+
+/* A hash function under test and the name to report it by. */
+
+struct HashChoice
+{
+   const char *pcName;
+   SymTableHashFn_T pfHash;
+};
+
+static const struct HashChoice asHashChoices[] =
+{
+   {"wyhash", SymTableHash_wyhash},
+   {"fnv1a", SymTableHash_fnv1a},
+   {"siphash", SymTableHash_siphash},
+   {"crc32c", SymTableHash_crc32c},
+   {"murmur3", SymTableHash_murmur3},
+   {"legacy", SymTableHash_legacy}
+};
+
+enum {HASH_CHOICE_COUNT =
+   sizeof(asHashChoices) / sizeof(asHashChoices[0])};
+
+/* A kind of key: a name and the printf format that spells key i. */
+
+struct KeyShape
+{
+   const char *pcName;
+   const char *pcFormat;
+};
+
+static const struct KeyShape asKeyShapes[] =
+{
+   {"numeric", "%d"},
+   {"identifier", "tok_%d"},
+   {"mangled", "_ZN4core3ops8function6FnOnce9call_once17h%08dE"}
+};
+
+enum {KEY_SHAPE_COUNT = sizeof(asKeyShapes) / sizeof(asKeyShapes[0])};
+
+/* Where timeHash leaves the hashes it computes, so that the compiler
+   cannot drop the calls. */
+
+static volatile uint64_t uHashSink;
+
+/*--------------------------------------------------------------------*/
+
+/* Return the current value of the monotonic clock in seconds. */
+
+static double getSeconds(void)
+{
+   struct timespec sNow;
+   clock_gettime(CLOCK_MONOTONIC, &sNow);
+   return (double)sNow.tv_sec + (double)sNow.tv_nsec / 1e9;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return an array of iCount keys spelled with pcFormat that the
+   caller must free with freeKeys. Store the total number of key bytes
+   in *puBytes. Exit with EXIT_FAILURE if memory is insufficient. */
+
+static char **makeKeys(const char *pcFormat, int iCount, size_t *puBytes)
+{
+   char **ppcKeys;
+   int i;
+
+   ppcKeys = (char**)malloc(sizeof(char*) * (size_t)iCount);
+   if (ppcKeys == NULL)
+   {
+      fprintf(stderr, "insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+   *puBytes = 0;
+   for (i = 0; i < iCount; i++)
+   {
+      ppcKeys[i] = (char*)malloc(MAX_KEY_LENGTH);
+      if (ppcKeys[i] == NULL)
+      {
+         fprintf(stderr, "insufficient memory\n");
+         exit(EXIT_FAILURE);
+      }
+      sprintf(ppcKeys[i], pcFormat, i);
+      *puBytes += strlen(ppcKeys[i]);
+   }
+   return ppcKeys;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free the iCount keys in ppcKeys and the array itself. */
+
+static void freeKeys(char **ppcKeys, int iCount)
+{
+   int i;
+   for (i = 0; i < iCount; i++)
+      free(ppcKeys[i]);
+   free(ppcKeys);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Hash the iCount keys of ppcKeys, uBytes bytes in all, with
+   psChoice's function until about BYTES_PER_RUN bytes have been
+   hashed. Write the rate to stdout in GB/s. */
+
+static void timeHash(const struct HashChoice *psChoice, char **ppcKeys,
+   int iCount, size_t uBytes)
+{
+   size_t *auLengths;
+   uint64_t uSink = 0;
+   double dStart;
+   double dElapsed;
+   int iRounds;
+   int iRound;
+   int i;
+
+   auLengths = (size_t*)malloc(sizeof(size_t) * (size_t)iCount);
+   if (auLengths == NULL)
+   {
+      fprintf(stderr, "insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+   for (i = 0; i < iCount; i++)
+      auLengths[i] = strlen(ppcKeys[i]);
+
+   iRounds = (int)(BYTES_PER_RUN / (double)uBytes) + 1;
+   dStart = getSeconds();
+   for (iRound = 0; iRound < iRounds; iRound++)
+      for (i = 0; i < iCount; i++)
+         uSink ^= (*psChoice->pfHash)(ppcKeys[i], auLengths[i],
+            (uint64_t)iRound);
+   dElapsed = getSeconds() - dStart;
+
+   printf("   %-8s %8.3f GB/s  %8.1f Mkeys/s\n", psChoice->pcName,
+      (double)uBytes * iRounds / dElapsed / 1e9,
+      (double)iCount * iRounds / dElapsed / 1e6);
+   fflush(stdout);
+   uHashSink = uSink;
+   free(auLengths);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Put the iCount keys of ppcKeys into a table that hashes with
+   psChoice's function. Write the chain-length distribution and the
+   time to put and then get every key to stdout. */
+
+static void reportChains(const struct HashChoice *psChoice,
+   char **ppcKeys, int iCount)
+{
+   SymTable_T oSymTable;
+   size_t auCounts[MAX_CHAIN_LENGTH + 1];
+   size_t uBuckets = 0;
+   double dStart;
+   double dElapsed;
+   int i;
+
+   oSymTable = SymTable_newWithHash(psChoice->pfHash);
+   assert(oSymTable != NULL);
+
+   dStart = getSeconds();
+   for (i = 0; i < iCount; i++)
+      SymTable_put(oSymTable, ppcKeys[i], ppcKeys[i]);
+   for (i = 0; i < iCount; i++)
+      if (SymTable_get(oSymTable, ppcKeys[i]) != ppcKeys[i])
+         printf("   %s: lookup failed\n", psChoice->pcName);
+   dElapsed = getSeconds() - dStart;
+
+   SymTable_getChainHistogram(oSymTable, auCounts, MAX_CHAIN_LENGTH);
+   printf("   %-8s", psChoice->pcName);
+   for (i = 0; i <= MAX_CHAIN_LENGTH; i++)
+   {
+      printf(" %7lu", (unsigned long)auCounts[i]);
+      uBuckets += auCounts[i];
+   }
+   printf("  %6.1f%% empty  %7.3f s\n",
+      100.0 * (double)auCounts[0] / (double)uBuckets, dElapsed);
+   fflush(stdout);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Time looking up the iCount keys of ppcKeys, each bound to itself in
+   oSymTable, in scattered order, and looking up as many keys that are
+   absent but spelled alike, from ppcMissKeys. Write the cost of each
+   kind of lookup to stdout in ns, labelled pcName. */
+
+static void reportLookups(const char *pcName, SymTable_T oSymTable,
+   char **ppcKeys, char **ppcMissKeys, int iCount)
+{
+   double dStart;
+   double dElapsed;
+   int iRounds = (int)(BYTES_PER_RUN / 20.0 / iCount) + 1;
+   int iRound;
+   int iMiss;
+   int i;
+
+   printf("   %-8s", pcName);
+   for (iMiss = 0; iMiss < 2; iMiss++)
+   {
+      char **ppcLookups = iMiss ? ppcMissKeys : ppcKeys;
+      dStart = getSeconds();
+      for (iRound = 0; iRound < iRounds; iRound++)
+         for (i = 0; i < iCount; i++)
+         {
+            /* A fixed odd stride visits the keys out of insertion
+               order, so that neighbouring nodes are not cached */
+            int iKey = (int)(((size_t)i * 40503u) % (size_t)iCount);
+            if ((SymTable_get(oSymTable, ppcLookups[iKey]) != NULL)
+               != ! iMiss)
+               printf("   %s: lookup failed\n", pcName);
+         }
+      dElapsed = getSeconds() - dStart;
+      printf("  %8.1f ns", dElapsed * 1e9 / ((double)iCount * iRounds));
+   }
+   printf("\n");
+   fflush(stdout);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a table that hashes with pfHash and binds each of the iCount
+   keys of ppcKeys to itself. */
+
+static SymTable_T makeTable(SymTableHashFn_T pfHash, char **ppcKeys,
+   int iCount)
+{
+   SymTable_T oSymTable;
+   int i;
+
+   oSymTable = SymTable_newWithHash(pfHash);
+   assert(oSymTable != NULL);
+   for (i = 0; i < iCount; i++)
+      SymTable_put(oSymTable, ppcKeys[i], ppcKeys[i]);
+   return oSymTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Time looking up keys from ppcKeys and ppcMissKeys, as reportLookups
+   does, in a table of the iCount keys of ppcKeys that hashes with
+   psChoice's function. */
+
+static void timeLookups(const struct HashChoice *psChoice,
+   char **ppcKeys, char **ppcMissKeys, int iCount)
+{
+   SymTable_T oSymTable = makeTable(psChoice->pfHash, ppcKeys, iCount);
+   reportLookups(psChoice->pcName, oSymTable, ppcKeys, ppcMissKeys,
+      iCount);
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Freeze tables of the iCount keys of ppcKeys on one thread and on
+   several, and write the time each freeze takes and the size of the
+   frozen index to stdout. Then compare lookups, as reportLookups does,
+   in a frozen table and in the same table before it froze. */
+
+static void benchFreeze(char **ppcKeys, char **ppcMissKeys, int iCount)
+{
+   static const size_t auThreadCounts[] = {1, 4};
+   SymTable_T oSymTable;
+   SymTableMPH_T oSymTableMPH;
+   double dStart;
+   size_t i;
+
+   printf("Freezing a table:\n");
+   for (i = 0; i < sizeof(auThreadCounts) / sizeof(auThreadCounts[0]);
+      i++)
+   {
+      oSymTable = makeTable(SymTableHash_wyhash, ppcKeys, iCount);
+      SymTable_setResizeThreads(oSymTable, auThreadCounts[i]);
+      dStart = getSeconds();
+      if (! SymTable_freeze(oSymTable))
+         printf("   freeze failed\n");
+      printf("   on %lu thread(s)  %8.3f s\n",
+         (unsigned long)auThreadCounts[i], getSeconds() - dStart);
+      fflush(stdout);
+      SymTable_free(oSymTable);
+   }
+
+   oSymTableMPH = SymTableMPH_new((const char *const *)(void*)ppcKeys,
+      (const void *const *)(void*)ppcKeys, (size_t)iCount, 1);
+   assert(oSymTableMPH != NULL);
+   printf("   index size        %8.2f bits per key\n",
+      8.0 * (double)SymTableMPH_getIndexBytes(oSymTableMPH) / iCount);
+   SymTableMPH_free(oSymTableMPH);
+
+   printf("Cost of a lookup that hits and of one that misses:\n");
+   oSymTable = makeTable(SymTableHash_wyhash, ppcKeys, iCount);
+   reportLookups("chained", oSymTable, ppcKeys, ppcMissKeys, iCount);
+   SymTable_freeze(oSymTable);
+   reportLookups("frozen", oSymTable, ppcKeys, ppcMissKeys, iCount);
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Compare hashing the iCount identifier keys of ppcKeys one at a time,
+   with the tables' default SymTableHash_wyhash as the baseline, with
+   hashing them in batches, and looking them up one at a time with
+   looking them up in batches. Write the rates to stdout in keys/s. */
+
+static void benchBatch(char **ppcKeys, int iCount)
+{
+   enum {BATCH_SIZE = 256};
+
+   const char **ppcConstKeys = (const char**)(void*)ppcKeys;
+   size_t *auLengths;
+   uint64_t *auHashes;
+   void *apvValues[BATCH_SIZE];
+   SymTable_T oSymTable;
+   uint64_t uSink = 0;
+   double dStart;
+   double dElapsed;
+   int iRounds = (int)(BYTES_PER_RUN / 10.0 / iCount) + 1;
+   int iRound;
+   int iMethod;
+   int i;
+
+   auLengths = (size_t*)malloc(sizeof(size_t) * (size_t)iCount);
+   auHashes = (uint64_t*)malloc(sizeof(uint64_t) * (size_t)iCount);
+   if (auLengths == NULL || auHashes == NULL)
+   {
+      fprintf(stderr, "insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+   for (i = 0; i < iCount; i++)
+      auLengths[i] = strlen(ppcKeys[i]);
+
+   printf("Batch hashing:\n");
+   for (iMethod = 0; iMethod < 4; iMethod++)
+   {
+      dStart = getSeconds();
+      for (iRound = 0; iRound < iRounds; iRound++)
+      {
+         if (iMethod == 0)
+            for (i = 0; i < iCount; i++)
+               uSink ^= SymTableHash_wyhash(ppcKeys[i], auLengths[i], 0);
+         else if (iMethod == 1)
+            for (i = 0; i < iCount; i++)
+               uSink ^= SymTableHash_legacy(ppcKeys[i], auLengths[i], 0);
+         else if (iMethod == 2)
+            for (i = 0; i < iCount; i++)
+               uSink ^= SymTableHash_murmur3(ppcKeys[i], auLengths[i], 0);
+         else
+         {
+            SymTableHash_hashBatch(SymTableHash_murmur3, ppcConstKeys,
+               auLengths, (size_t)iCount, 0, auHashes);
+            uSink ^= auHashes[iRound % iCount];
+         }
+      }
+      dElapsed = getSeconds() - dStart;
+      printf("   %-32s %8.1f Mkeys/s\n",
+         iMethod == 0 ? "wyhash (default), one at a time" :
+         iMethod == 1 ? "legacy, one at a time" :
+         iMethod == 2 ? "murmur3, one at a time" : "murmur3, batched",
+         (double)iCount * iRounds / dElapsed / 1e6);
+      fflush(stdout);
+   }
+   uHashSink = uSink;
+
+   oSymTable = SymTable_newWithHash(SymTableHash_murmur3);
+   assert(oSymTable != NULL);
+   SymTable_putBatch(oSymTable, ppcConstKeys,
+      (const void *const *)(void*)ppcKeys, (size_t)iCount, NULL);
+
+   printf("Batch lookups in a murmur3 table:\n");
+   for (iMethod = 0; iMethod < 2; iMethod++)
+   {
+      dStart = getSeconds();
+      for (iRound = 0; iRound < iRounds; iRound++)
+         for (i = 0; i < iCount; i += BATCH_SIZE)
+         {
+            int iBatch = iCount - i < BATCH_SIZE ? iCount - i : BATCH_SIZE;
+            if (iMethod == 0)
+            {
+               int j;
+               for (j = 0; j < iBatch; j++)
+                  apvValues[j] = SymTable_get(oSymTable, ppcKeys[i + j]);
+            }
+            else
+               SymTable_getBatch(oSymTable, ppcConstKeys + i,
+                  (size_t)iBatch, apvValues);
+            if (apvValues[0] != ppcKeys[i])
+               printf("   lookup failed\n");
+         }
+      dElapsed = getSeconds() - dStart;
+      printf("   %-32s %8.1f Mkeys/s\n",
+         iMethod == 0 ? "SymTable_get" : "SymTable_getBatch",
+         (double)iCount * iRounds / dElapsed / 1e6);
+      fflush(stdout);
+   }
+
+   SymTable_free(oSymTable);
+   free(auLengths);
+   free(auHashes);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Benchmark each hash function on each kind of key. argv[1] is the
+   number of keys of each kind. Exit with EXIT_FAILURE if argv[1] is
+   missing or not a positive number. Otherwise return 0. */
+
+int main(int argc, char *argv[])
+{
+   int iKeyCount;
+   char **ppcKeys;
+   char **ppcMissKeys;
+   char acMissFormat[MAX_KEY_LENGTH];
+   size_t uBytes;
+   size_t uMissBytes;
+   int iShape;
+   int iChoice;
+   int i;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s keycount\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+
+   if (sscanf(argv[1], "%d", &iKeyCount) != 1 || iKeyCount <= 0)
+   {
+      fprintf(stderr, "keycount must be a positive number\n");
+      exit(EXIT_FAILURE);
+   }
+
+   for (iShape = 0; iShape < KEY_SHAPE_COUNT; iShape++)
+   {
+      ppcKeys = makeKeys(asKeyShapes[iShape].pcFormat, iKeyCount,
+         &uBytes);
+
+      printf("------------------------------------------------------\n");
+      printf("%d %s keys, %.1f bytes on average.\n", iKeyCount,
+         asKeyShapes[iShape].pcName, (double)uBytes / iKeyCount);
+      printf("Hashing throughput:\n");
+      for (iChoice = 0; iChoice < HASH_CHOICE_COUNT; iChoice++)
+         timeHash(&asHashChoices[iChoice], ppcKeys, iKeyCount, uBytes);
+
+      printf("Buckets by chain length (last column: %d or more),\n",
+         (int)MAX_CHAIN_LENGTH);
+      printf("and time to put and get every key:\n");
+      printf("   %-8s", "");
+      for (i = 0; i <= MAX_CHAIN_LENGTH; i++)
+         printf(" %7d", i);
+      printf("\n");
+      for (iChoice = 0; iChoice < HASH_CHOICE_COUNT; iChoice++)
+         reportChains(&asHashChoices[iChoice], ppcKeys, iKeyCount);
+
+      sprintf(acMissFormat, "%s#", asKeyShapes[iShape].pcFormat);
+      ppcMissKeys = makeKeys(acMissFormat, iKeyCount, &uMissBytes);
+      printf("Cost of a lookup that hits and of one that misses:\n");
+      for (iChoice = 0; iChoice < HASH_CHOICE_COUNT; iChoice++)
+         timeLookups(&asHashChoices[iChoice], ppcKeys, ppcMissKeys,
+            iKeyCount);
+      if (strcmp(asKeyShapes[iShape].pcName, "identifier") == 0)
+         benchFreeze(ppcKeys, ppcMissKeys, iKeyCount);
+      freeKeys(ppcMissKeys, iKeyCount);
+
+      if (strcmp(asKeyShapes[iShape].pcName, "identifier") == 0)
+         benchBatch(ppcKeys, iKeyCount);
+
+      freeKeys(ppcKeys, iKeyCount);
+   }
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
@@ -0,0 +1,166 @@
+/*--------------------------------------------------------------------*/
+/* benchsymtablelatency.c                                             */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "symtable.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The longest key that the benchmark builds. */
+
+enum {MAX_KEY_LENGTH = 32};
+
+/* At least this many lookups of each kind are timed, so that the
+   99.99th percentile rests on a hundred samples or more. */
+
+enum {MIN_SAMPLES = 1000000};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the current value of the monotonic clock in nanoseconds. */
+
+static long getNanoseconds(void)
+{
+   struct timespec sNow;
+   clock_gettime(CLOCK_MONOTONIC, &sNow);
+   return (long)sNow.tv_sec * 1000000000L + sNow.tv_nsec;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Compare the longs that pvFirst and pvSecond point to, for qsort. */
+
+static int compareLongs(const void *pvFirst, const void *pvSecond)
+{
+   long lFirst = *(const long*)pvFirst;
+   long lSecond = *(const long*)pvSecond;
+   return (lFirst > lSecond) - (lFirst < lSecond);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Sort the uCount latencies of alSamples and write their percentiles
+   to stdout, labelled pcLabel. */
+
+static void reportPercentiles(const char *pcLabel, long alSamples[],
+   size_t uCount)
+{
+   static const double adPercentiles[] = {50.0, 99.0, 99.9, 99.99};
+   size_t i;
+
+   qsort(alSamples, uCount, sizeof(long), compareLongs);
+   printf("   %-6s", pcLabel);
+   for (i = 0; i < sizeof(adPercentiles) / sizeof(adPercentiles[0]); i++)
+      printf(" %8ld", alSamples[(size_t)(adPercentiles[i] / 100.0 *
+         (double)(uCount - 1))]);
+   printf(" %8ld\n", alSamples[uCount - 1]);
+   fflush(stdout);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Time, one by one, lookups of the iCount keys spelled by pcFormat in
+   oSymTable, visiting the keys in scattered order. Store each latency
+   in ns in alSamples, uCount of them. Return the number of lookups
+   whose result differed from iExpectFound. */
+
+static int timeLookups(SymTable_T oSymTable, const char *pcFormat,
+   int iCount, int iExpectFound, long alSamples[], size_t uCount)
+{
+   char acKey[MAX_KEY_LENGTH];
+   long lStart;
+   int iWrong = 0;
+   int iFound;
+   size_t u;
+
+   for (u = 0; u < uCount; u++)
+   {
+      sprintf(acKey, pcFormat,
+         (int)((u * 40503u) % (size_t)iCount));
+      lStart = getNanoseconds();
+      iFound = SymTable_get(oSymTable, acKey) != NULL;
+      alSamples[u] = getNanoseconds() - lStart;
+      iWrong += iFound != iExpectFound;
+   }
+   return iWrong;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Measure the latency of single operations on a SymTable. argv[1] is
+   the number of keys to put. Write percentiles of the time each put
+   takes, and of the time each lookup takes for keys present and
+   absent, to stdout. Exit with EXIT_FAILURE if argv[1] is missing or
+   not a positive number, or if memory is insufficient. Otherwise
+   return 0. */
+
+int main(int argc, char *argv[])
+{
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   long *alSamples;
+   size_t uCount;
+   int iKeyCount;
+   int iWrong;
+   int i;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s keycount\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+
+   if (sscanf(argv[1], "%d", &iKeyCount) != 1 || iKeyCount <= 0)
+   {
+      fprintf(stderr, "keycount must be a positive number\n");
+      exit(EXIT_FAILURE);
+   }
+
+   /* The puts need iKeyCount samples, the lookups MIN_SAMPLES. */
+   uCount = (size_t)iKeyCount < MIN_SAMPLES ?
+      MIN_SAMPLES : (size_t)iKeyCount;
+   alSamples = (long*)malloc(sizeof(long) * uCount);
+   oSymTable = SymTable_new();
+   if (alSamples == NULL || oSymTable == NULL)
+   {
+      fprintf(stderr, "insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+
+   printf("------------------------------------------------------\n");
+   printf("%s: latency in ns, %d puts, %lu lookups of each kind:\n",
+      argv[0], iKeyCount, (unsigned long)uCount);
+   printf("   %-6s %8s %8s %8s %8s %8s\n", "", "p50", "p99", "p99.9",
+      "p99.99", "max");
+
+   iWrong = 0;
+   for (i = 0; i < iKeyCount; i++)
+   {
+      long lStart;
+      sprintf(acKey, "tok_%d", i);
+      lStart = getNanoseconds();
+      iWrong += ! SymTable_put(oSymTable, acKey, oSymTable);
+      alSamples[i] = getNanoseconds() - lStart;
+   }
+   reportPercentiles("put", alSamples, (size_t)iKeyCount);
+
+   iWrong += timeLookups(oSymTable, "tok_%d", iKeyCount, 1, alSamples,
+      uCount);
+   reportPercentiles("hit", alSamples, uCount);
+   iWrong += timeLookups(oSymTable, "tok_%d#", iKeyCount, 0, alSamples,
+      uCount);
+   reportPercentiles("miss", alSamples, uCount);
+   if (iWrong != 0)
+      printf("   %d operations failed\n", iWrong);
+
+   SymTable_free(oSymTable);
+   free(alSamples);
+   return 0;
+}
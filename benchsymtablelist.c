@@ -0,0 +1,206 @@
+/*--------------------------------------------------------------------*/
+/* benchsymtablelist.c                                                */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "symtable.h"
+#include "symtablelist.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The longest key that the benchmark builds. */
+
+enum {MAX_KEY_LENGTH = 24};
+
+/* How many lookups each run makes. */
+
+enum {LOOKUP_COUNT = 1000000};
+
+/* The Zipf exponents that lookups are drawn with: the larger, the more
+   the most popular keys dominate. */
+
+static const double adExponents[] = {0.8, 1.0, 1.2};
+
+enum {EXPONENT_COUNT = sizeof(adExponents) / sizeof(adExponents[0])};
+
+/* The policies compared, and their labels. */
+
+static const enum SymTableListPolicy aePolicies[] =
+   {SYMTABLE_KEEP_ORDER, SYMTABLE_MOVE_TO_FRONT, SYMTABLE_TRANSPOSE};
+
+static const char *apcPolicyNames[] =
+   {"insertion order", "move to front", "transpose"};
+
+enum {POLICY_COUNT = sizeof(aePolicies) / sizeof(aePolicies[0])};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the current value of the monotonic clock in seconds. */
+
+static double getSeconds(void)
+{
+   struct timespec sNow;
+   clock_gettime(CLOCK_MONOTONIC, &sNow);
+   return (double)sNow.tv_sec + (double)sNow.tv_nsec / 1e9;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Fill aiLookups with LOOKUP_COUNT key indexes below iCount, drawn so
+   that the key of popularity rank r comes up in proportion to
+   1 / r^dExponent. Which key has which rank is given by aiRanked. */
+
+static void drawZipf(int aiLookups[], const int aiRanked[], int iCount,
+   double dExponent)
+{
+   double *adCumulative;
+   double dTotal = 0.0;
+   double dTarget;
+   int iLow;
+   int iHigh;
+   int iMiddle;
+   int i;
+
+   adCumulative = (double*)malloc((size_t)iCount * sizeof(double));
+   if (adCumulative == NULL)
+   {
+      fprintf(stderr, "insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+   for (i = 0; i < iCount; i++)
+   {
+      dTotal += 1.0 / pow((double)(i + 1), dExponent);
+      adCumulative[i] = dTotal;
+   }
+   for (i = 0; i < LOOKUP_COUNT; i++)
+   {
+      dTarget = (double)rand() / ((double)RAND_MAX + 1.0) * dTotal;
+      iLow = 0;
+      iHigh = iCount - 1;
+      while (iLow < iHigh)
+      {
+         iMiddle = (iLow + iHigh) / 2;
+         if (adCumulative[iMiddle] <= dTarget)
+            iLow = iMiddle + 1;
+         else
+            iHigh = iMiddle;
+      }
+      aiLookups[i] = aiRanked[iLow];
+   }
+   free(adCumulative);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Compare the average number of key comparisons per lookup, and the
+   time per lookup, of a list table of argv[1] bindings under each
+   access policy, with lookups drawn from Zipf distributions. Write
+   the results to stdout. Exit with EXIT_FAILURE if argv[1] is missing
+   or not a positive number, or if memory is insufficient. Otherwise
+   return 0. */
+
+int main(int argc, char *argv[])
+{
+   SymTable_T oSymTable;
+   char *pcKeys;
+   int *aiRanked;
+   int *aiLookups;
+   double dStart;
+   double dElapsed;
+   int iCount;
+   int iTemp;
+   int iFound;
+   size_t e;
+   size_t p;
+   int i;
+   int j;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s keycount\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+
+   if (sscanf(argv[1], "%d", &iCount) != 1 || iCount <= 0)
+   {
+      fprintf(stderr, "keycount must be a positive number\n");
+      exit(EXIT_FAILURE);
+   }
+
+   pcKeys = (char*)malloc((size_t)iCount * MAX_KEY_LENGTH);
+   aiRanked = (int*)malloc((size_t)iCount * sizeof(int));
+   aiLookups = (int*)malloc(LOOKUP_COUNT * sizeof(int));
+   if (pcKeys == NULL || aiRanked == NULL || aiLookups == NULL)
+   {
+      fprintf(stderr, "insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+
+   /* The popular keys are scattered through the insertion order */
+   srand(1);
+   for (i = 0; i < iCount; i++)
+   {
+      sprintf(pcKeys + (size_t)i * MAX_KEY_LENGTH, "sym_%d", i);
+      aiRanked[i] = i;
+   }
+   for (i = iCount - 1; i > 0; i--)
+   {
+      j = rand() % (i + 1);
+      iTemp = aiRanked[i];
+      aiRanked[i] = aiRanked[j];
+      aiRanked[j] = iTemp;
+   }
+
+   printf("------------------------------------------------------\n");
+   printf("%d bindings, %d lookups per run.\n", iCount, LOOKUP_COUNT);
+   printf("   %-8s %-16s %14s %12s\n", "exponent", "policy",
+      "compares/lookup", "ns/lookup");
+
+   for (e = 0; e < EXPONENT_COUNT; e++)
+   {
+      drawZipf(aiLookups, aiRanked, iCount, adExponents[e]);
+      for (p = 0; p < POLICY_COUNT; p++)
+      {
+         oSymTable = SymTable_new();
+         if (oSymTable == NULL)
+         {
+            fprintf(stderr, "insufficient memory\n");
+            exit(EXIT_FAILURE);
+         }
+         for (i = 0; i < iCount; i++)
+            SymTable_put(oSymTable, pcKeys + (size_t)i * MAX_KEY_LENGTH,
+               pcKeys + (size_t)i * MAX_KEY_LENGTH);
+         SymTable_setAccessPolicy(oSymTable, aePolicies[p]);
+
+         iFound = 0;
+         dStart = getSeconds();
+         for (i = 0; i < LOOKUP_COUNT; i++)
+            iFound += SymTable_get(oSymTable,
+               pcKeys + (size_t)aiLookups[i] * MAX_KEY_LENGTH) != NULL;
+         dElapsed = getSeconds() - dStart;
+
+         printf("   %-8.1f %-16s %14.2f %12.1f%s\n", adExponents[e],
+            apcPolicyNames[p],
+            (double)SymTable_getComparisonCount(oSymTable) / LOOKUP_COUNT,
+            dElapsed * 1e9 / LOOKUP_COUNT,
+            iFound == LOOKUP_COUNT ? "" : "   (lookup failed)");
+         fflush(stdout);
+         SymTable_free(oSymTable);
+      }
+   }
+
+   free(aiLookups);
+   free(aiRanked);
+   free(pcKeys);
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
@@ -0,0 +1,192 @@
+/*--------------------------------------------------------------------*/
+/* benchsymtableload.c                                                */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "symtable.h"
+#include "symtablehash.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The longest line that the naive loader reads. */
+
+enum {MAX_LINE_LENGTH = 256};
+
+/* The thread counts that SymTable_loadText is timed with. */
+
+static const size_t auThreadCounts[] = {1, 2, 4, 8};
+
+enum {THREAD_COUNT_CHOICES =
+   sizeof(auThreadCounts) / sizeof(auThreadCounts[0])};
+
+/* The file that the benchmark writes and loads. */
+
+static const char *pcTextPath = "benchsymtableload.tsv";
+
+/*--------------------------------------------------------------------*/
+
+/* Return the current value of the monotonic clock in seconds. */
+
+static double getSeconds(void)
+{
+   struct timespec sNow;
+   clock_gettime(CLOCK_MONOTONIC, &sNow);
+   return (double)sNow.tv_sec + (double)sNow.tv_nsec / 1e9;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Convert the uLength decimal digits at pcText into an integer stored
+   in *ppvValue, for SymTable_loadText. */
+
+static int parseInteger(const char *pcText, size_t uLength,
+   void **ppvValue, void *pvExtra)
+{
+   size_t uValue = 0;
+   size_t u;
+
+   (void)pvExtra;
+   for (u = 0; u < uLength; u++)
+   {
+      if (pcText[u] < '0' || pcText[u] > '9')
+         return 0;
+      uValue = uValue * 10 + (size_t)(pcText[u] - '0');
+   }
+   *ppvValue = (void*)uValue;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Load the file named pcTextPath into a new table the naive way: read
+   each line with fgets, split it at its tab, convert the value with
+   strtoul and SymTable_put the binding. Return the table. */
+
+static SymTable_T loadNaively(void)
+{
+   SymTable_T oSymTable;
+   FILE *psFile;
+   char acLine[MAX_LINE_LENGTH];
+   char *pcTab;
+
+   oSymTable = SymTable_new();
+   psFile = fopen(pcTextPath, "r");
+   if (oSymTable == NULL || psFile == NULL)
+   {
+      fprintf(stderr, "cannot load %s\n", pcTextPath);
+      exit(EXIT_FAILURE);
+   }
+   while (fgets(acLine, sizeof(acLine), psFile) != NULL)
+   {
+      pcTab = strchr(acLine, '\t');
+      if (pcTab == NULL)
+         continue;
+      *pcTab = '\0';
+      SymTable_put(oSymTable, acLine,
+         (void*)(size_t)strtoul(pcTab + 1, NULL, 10));
+   }
+   fclose(psFile);
+   return oSymTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write the time it took to load a table of iCount bindings and a
+   check of one binding to stdout, with pcName as the label, and free
+   the table. */
+
+static void report(const char *pcName, SymTable_T oSymTable,
+   double dElapsed, int iCount)
+{
+   printf("   %-22s %10.1f ms %8.1f ns per line%s\n", pcName,
+      dElapsed * 1e3, dElapsed * 1e9 / iCount,
+      SymTable_getLength(oSymTable) == (size_t)iCount &&
+      SymTable_get(oSymTable, "sym_0") == (void*)(size_t)1 ?
+      "" : "   (wrong table)");
+   fflush(stdout);
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Compare loading a text file of argv[1] "key<TAB>value" lines with
+   an fgets and SymTable_put loop and with SymTable_loadText on several
+   thread counts. Write the results to stdout. Exit with EXIT_FAILURE
+   if argv[1] is missing or not a positive number, or if the file
+   cannot be written or loaded. Otherwise return 0. */
+
+int main(int argc, char *argv[])
+{
+   SymTable_T oSymTable;
+   FILE *psFile;
+   char acName[32];
+   double dStart;
+   int iCount;
+   size_t u;
+   int i;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s linecount\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+
+   if (sscanf(argv[1], "%d", &iCount) != 1 || iCount <= 0)
+   {
+      fprintf(stderr, "linecount must be a positive number\n");
+      exit(EXIT_FAILURE);
+   }
+
+   psFile = fopen(pcTextPath, "w");
+   if (psFile == NULL)
+   {
+      fprintf(stderr, "cannot write %s\n", pcTextPath);
+      exit(EXIT_FAILURE);
+   }
+   for (i = 0; i < iCount; i++)
+      fprintf(psFile, "sym_%d\t%d\n", i, i + 1);
+   if (fclose(psFile) != 0)
+   {
+      fprintf(stderr, "cannot write %s\n", pcTextPath);
+      exit(EXIT_FAILURE);
+   }
+
+   printf("------------------------------------------------------\n");
+   printf("Loading %d lines.\n", iCount);
+
+   dStart = getSeconds();
+   oSymTable = loadNaively();
+   report("fgets and put", oSymTable, getSeconds() - dStart, iCount);
+
+   for (u = 0; u < THREAD_COUNT_CHOICES; u++)
+   {
+      oSymTable = SymTable_new();
+      if (oSymTable == NULL)
+      {
+         fprintf(stderr, "insufficient memory\n");
+         exit(EXIT_FAILURE);
+      }
+      SymTable_setResizeThreads(oSymTable, auThreadCounts[u]);
+      dStart = getSeconds();
+      if (! SymTable_loadText(oSymTable, pcTextPath, parseInteger, NULL))
+      {
+         fprintf(stderr, "cannot load %s\n", pcTextPath);
+         exit(EXIT_FAILURE);
+      }
+      sprintf(acName, "loadText, %lu threads",
+         (unsigned long)auThreadCounts[u]);
+      report(acName, oSymTable, getSeconds() - dStart, iCount);
+   }
+
+   remove(pcTextPath);
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
@@ -0,0 +1,204 @@
+/*--------------------------------------------------------------------*/
+/* benchsymtablememory.c                                              */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "symtable.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* glibc reports the bytes that malloc has handed out; elsewhere the
+   memory column is left out. */
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+#define HAVE_MALLINFO2 1
+#include <malloc.h>
+#else
+#define HAVE_MALLINFO2 0
+#endif
+
+/*--------------------------------------------------------------------*/
+
+/* The longest key that the benchmark builds. */
+
+enum {MAX_KEY_LENGTH = 96};
+
+/* The namespaces and class names that the keys are made of. */
+
+static const char *apcNamespaces[] =
+{
+   "std", "boost", "llvm", "clang", "absl", "folly", "google", "mozilla"
+};
+
+static const char *apcInner[] =
+{
+   "detail", "internal", "impl", "util", "io", "ranges"
+};
+
+enum {NAMESPACE_COUNT = sizeof(apcNamespaces) / sizeof(apcNamespaces[0]),
+   INNER_COUNT = sizeof(apcInner) / sizeof(apcInner[0])};
+
+/* How many members each class has. */
+
+enum {MEMBERS_PER_CLASS = 16};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the current value of the monotonic clock in seconds. */
+
+static double getSeconds(void)
+{
+   struct timespec sNow;
+   clock_gettime(CLOCK_MONOTONIC, &sNow);
+   return (double)sNow.tv_sec + (double)sNow.tv_nsec / 1e9;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of bytes that malloc has handed out and not taken
+   back, or 0 where that is not known. */
+
+static size_t getHeapBytes(void)
+{
+#if HAVE_MALLINFO2
+   return mallinfo2().uordblks;
+#else
+   return 0;
+#endif
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write to acKey the iIndex-th key of the corpus: a member of a class
+   in a nested namespace, such as "llvm::detail::Class12::member_3".
+   Neighbouring indexes are members of the same class. */
+
+static void makeKey(char *acKey, int iIndex)
+{
+   int iMember = iIndex % MEMBERS_PER_CLASS;
+   int iClass = iIndex / MEMBERS_PER_CLASS;
+
+   sprintf(acKey, "%s::%s::Class%d::member_%d",
+      apcNamespaces[iClass % NAMESPACE_COUNT],
+      apcInner[iClass / NAMESPACE_COUNT % INNER_COUNT],
+      iClass / (NAMESPACE_COUNT * INNER_COUNT), iMember);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Build a table of argv[1] keys of a corpus of namespaced identifiers
+   and write to stdout the heap bytes it takes per key and the rate of
+   lookups that hit and that miss, in shuffled order. Exit with
+   EXIT_FAILURE if argv[1] is missing or not a positive number, or if
+   memory is insufficient. Otherwise return 0. */
+
+int main(int argc, char *argv[])
+{
+   SymTable_T oSymTable;
+   char *pcKeys;
+   int *aiOrder;
+   char acMiss[MAX_KEY_LENGTH + 1];
+   size_t uKeyBytes = 0;
+   size_t uHeapBefore;
+   size_t uHeapAfter;
+   double dStart;
+   double dBuild;
+   double dHits;
+   double dMisses;
+   int iFound = 0;
+   int iCount;
+   int iTemp;
+   int i;
+   int j;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s keycount\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+
+   if (sscanf(argv[1], "%d", &iCount) != 1 || iCount <= 0)
+   {
+      fprintf(stderr, "keycount must be a positive number\n");
+      exit(EXIT_FAILURE);
+   }
+
+   pcKeys = (char*)malloc((size_t)iCount * MAX_KEY_LENGTH);
+   aiOrder = (int*)malloc((size_t)iCount * sizeof(int));
+   if (pcKeys == NULL || aiOrder == NULL)
+   {
+      fprintf(stderr, "insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+   for (i = 0; i < iCount; i++)
+   {
+      makeKey(pcKeys + (size_t)i * MAX_KEY_LENGTH, i);
+      uKeyBytes += strlen(pcKeys + (size_t)i * MAX_KEY_LENGTH);
+      aiOrder[i] = i;
+   }
+   srand(1);
+   for (i = iCount - 1; i > 0; i--)
+   {
+      j = rand() % (i + 1);
+      iTemp = aiOrder[i];
+      aiOrder[i] = aiOrder[j];
+      aiOrder[j] = iTemp;
+   }
+
+   uHeapBefore = getHeapBytes();
+   dStart = getSeconds();
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL)
+   {
+      fprintf(stderr, "insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+   for (i = 0; i < iCount; i++)
+      if (! SymTable_put(oSymTable,
+         pcKeys + (size_t)aiOrder[i] * MAX_KEY_LENGTH, oSymTable))
+      {
+         fprintf(stderr, "insufficient memory\n");
+         exit(EXIT_FAILURE);
+      }
+   dBuild = getSeconds() - dStart;
+   uHeapAfter = getHeapBytes();
+
+   dStart = getSeconds();
+   for (i = 0; i < iCount; i++)
+      iFound += SymTable_contains(oSymTable,
+         pcKeys + (size_t)aiOrder[i] * MAX_KEY_LENGTH);
+   dHits = getSeconds() - dStart;
+
+   /* A miss shares all but its last byte with a key */
+   dStart = getSeconds();
+   for (i = 0; i < iCount; i++)
+   {
+      strcpy(acMiss, pcKeys + (size_t)aiOrder[i] * MAX_KEY_LENGTH);
+      acMiss[strlen(acMiss) - 1] = 'x';
+      iFound -= SymTable_contains(oSymTable, acMiss);
+   }
+   dMisses = getSeconds() - dStart;
+
+   printf("------------------------------------------------------\n");
+   printf("%d namespaced keys, %.1f bytes on average.\n", iCount,
+      (double)uKeyBytes / iCount);
+   if (HAVE_MALLINFO2)
+      printf("   %-18s %10.1f bytes\n", "heap per key",
+         (double)(uHeapAfter - uHeapBefore) / iCount);
+   printf("   %-18s %10.1f ms\n", "build", dBuild * 1e3);
+   printf("   %-18s %10.2f M/s\n", "hits", iCount / dHits / 1e6);
+   printf("   %-18s %10.2f M/s\n", "misses", iCount / dMisses / 1e6);
+   if (iFound != iCount)
+      printf("   (wrong table)\n");
+
+   SymTable_free(oSymTable);
+   free(aiOrder);
+   free(pcKeys);
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
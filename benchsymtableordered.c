@@ -0,0 +1,223 @@
+/*--------------------------------------------------------------------*/
+/* benchsymtableordered.c                                             */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "symtable.h"
+#include "symtableordered.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The longest key that the benchmark builds. */
+
+enum {MAX_KEY_LENGTH = 48};
+
+/* How many namespaces the keys are spread over. */
+
+enum {NAMESPACE_COUNT = 100};
+
+/* How many times each query is repeated. */
+
+enum {QUERY_REPEATS = 20};
+
+/*--------------------------------------------------------------------*/
+
+/* What a query visits: the prefix or range it selects, for the
+   filtering SymTable_map, and how many bindings it matched. */
+
+struct Query
+{
+   const char *pcPrefix;
+   size_t uPrefixLength;
+   const char *pcLow;
+   const char *pcHigh;
+   long lMatches;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the current value of the monotonic clock in seconds. */
+
+static double getSeconds(void)
+{
+   struct timespec sNow;
+   clock_gettime(CLOCK_MONOTONIC, &sNow);
+   return (double)sNow.tv_sec + (double)sNow.tv_nsec / 1e9;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Count a binding in the struct Query that pvExtra points to. */
+
+static void countMatch(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   (void)pcKey;
+   (void)pvValue;
+   ((struct Query*)pvExtra)->lMatches++;
+}
+
+/* Count a binding in the struct Query that pvExtra points to if its
+   key has the query's prefix. */
+
+static void filterPrefix(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   struct Query *psQuery = (struct Query*)pvExtra;
+
+   (void)pvValue;
+   if (strncmp(pcKey, psQuery->pcPrefix, psQuery->uPrefixLength) == 0)
+      psQuery->lMatches++;
+}
+
+/* Count a binding in the struct Query that pvExtra points to if its
+   key lies in the query's range. */
+
+static void filterRange(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   struct Query *psQuery = (struct Query*)pvExtra;
+
+   (void)pvValue;
+   if (strcmp(pcKey, psQuery->pcLow) >= 0 &&
+      strcmp(pcKey, psQuery->pcHigh) < 0)
+      psQuery->lMatches++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write one line comparing the time of QUERY_REPEATS filtered
+   SymTable_map calls with that of as many direct queries, labelled
+   pcName, with the matches each found. */
+
+static void report(const char *pcName, double dFiltered, long lFiltered,
+   double dDirect, long lDirect)
+{
+   printf("   %-24s %10.3f ms %10.3f ms %8ld%s\n", pcName,
+      dFiltered * 1e3 / QUERY_REPEATS, dDirect * 1e3 / QUERY_REPEATS,
+      lDirect / QUERY_REPEATS,
+      lFiltered == lDirect ? "" : "   (results differ)");
+   fflush(stdout);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Compare answering prefix and range queries on a table of argv[1]
+   namespaced keys with SymTable_map and a filter, as a table without
+   order must, and with SymTable_mapPrefix and SymTable_mapRange.
+   Write the results to stdout. Exit with EXIT_FAILURE if argv[1] is
+   missing or not a positive number, or if memory is insufficient.
+   Otherwise return 0. */
+
+int main(int argc, char *argv[])
+{
+   static const char *apcPrefixes[] =
+      {"ns7::", "ns42::detail::symbol_1"};
+   static const char *apcRanges[][2] =
+      {{"ns7::", "ns8::"}, {"ns3::detail::symbol_2", "ns3::detail::symbol_3"}};
+   enum {PREFIX_COUNT = sizeof(apcPrefixes) / sizeof(apcPrefixes[0]),
+      RANGE_COUNT = sizeof(apcRanges) / sizeof(apcRanges[0])};
+   SymTable_T oSymTable;
+   struct Query sFiltered;
+   struct Query sDirect;
+   char acKey[MAX_KEY_LENGTH];
+   char acName[64];
+   double dStart;
+   double dFiltered;
+   double dDirect;
+   int iCount;
+   int i;
+   int r;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s keycount\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+
+   if (sscanf(argv[1], "%d", &iCount) != 1 || iCount <= 0)
+   {
+      fprintf(stderr, "keycount must be a positive number\n");
+      exit(EXIT_FAILURE);
+   }
+
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL)
+   {
+      fprintf(stderr, "insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+   dStart = getSeconds();
+   for (i = 0; i < iCount; i++)
+   {
+      sprintf(acKey, "ns%d::detail::symbol_%d", i % NAMESPACE_COUNT,
+         i / NAMESPACE_COUNT);
+      if (! SymTable_put(oSymTable, acKey, oSymTable))
+      {
+         fprintf(stderr, "insufficient memory\n");
+         exit(EXIT_FAILURE);
+      }
+   }
+
+   printf("------------------------------------------------------\n");
+   printf("%d bindings, built in %.1f ms.\n", iCount,
+      (getSeconds() - dStart) * 1e3);
+   printf("   %-24s %13s %13s %8s\n", "query", "map + filter", "direct",
+      "matches");
+
+   for (i = 0; i < PREFIX_COUNT; i++)
+   {
+      memset(&sFiltered, 0, sizeof(sFiltered));
+      sFiltered.pcPrefix = apcPrefixes[i];
+      sFiltered.uPrefixLength = strlen(apcPrefixes[i]);
+      sDirect = sFiltered;
+
+      dStart = getSeconds();
+      for (r = 0; r < QUERY_REPEATS; r++)
+         SymTable_map(oSymTable, filterPrefix, &sFiltered);
+      dFiltered = getSeconds() - dStart;
+
+      dStart = getSeconds();
+      for (r = 0; r < QUERY_REPEATS; r++)
+         SymTable_mapPrefix(oSymTable, apcPrefixes[i], countMatch,
+            &sDirect);
+      dDirect = getSeconds() - dStart;
+
+      sprintf(acName, "prefix %.17s", apcPrefixes[i]);
+      report(acName, dFiltered, sFiltered.lMatches, dDirect,
+         sDirect.lMatches);
+   }
+
+   for (i = 0; i < RANGE_COUNT; i++)
+   {
+      memset(&sFiltered, 0, sizeof(sFiltered));
+      sFiltered.pcLow = apcRanges[i][0];
+      sFiltered.pcHigh = apcRanges[i][1];
+      sDirect = sFiltered;
+
+      dStart = getSeconds();
+      for (r = 0; r < QUERY_REPEATS; r++)
+         SymTable_map(oSymTable, filterRange, &sFiltered);
+      dFiltered = getSeconds() - dStart;
+
+      dStart = getSeconds();
+      for (r = 0; r < QUERY_REPEATS; r++)
+         SymTable_mapRange(oSymTable, apcRanges[i][0], apcRanges[i][1],
+            countMatch, &sDirect);
+      dDirect = getSeconds() - dStart;
+
+      sprintf(acName, "range from %.13s", apcRanges[i][0]);
+      report(acName, dFiltered, sFiltered.lMatches, dDirect,
+         sDirect.lMatches);
+   }
+
+   SymTable_free(oSymTable);
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
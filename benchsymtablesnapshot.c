@@ -0,0 +1,290 @@
+/*--------------------------------------------------------------------*/
+/* benchsymtablesnapshot.c                                            */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "symtable.h"
+#include "symtablehash.h"
+#include "symtablestream.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include <sys/stat.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The longest key that the benchmark builds. */
+
+enum {MAX_KEY_LENGTH = 24};
+
+/* How many lookups follow the opening of a table in the start-up
+   figures. */
+
+enum {FIRST_LOOKUPS = 1000};
+
+/* The files that the benchmark saves and streams to. */
+
+static const char *pcSnapshotPath = "benchsymtablesnapshot.snapshot";
+static const char *pcStreamPath = "benchsymtablesnapshot.stream";
+
+/*--------------------------------------------------------------------*/
+
+/* Return the current value of the monotonic clock in seconds. */
+
+static double getSeconds(void)
+{
+   struct timespec sNow;
+   clock_gettime(CLOCK_MONOTONIC, &sNow);
+   return (double)sNow.tv_sec + (double)sNow.tv_nsec / 1e9;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a table that binds each of the iCount keys apcKeys[i] to the
+   integer i + 1, put one at a time. */
+
+static SymTable_T buildTable(const char *const apcKeys[], int iCount)
+{
+   SymTable_T oSymTable;
+   int i;
+
+   oSymTable = SymTable_new();
+   assert(oSymTable != NULL);
+   for (i = 0; i < iCount; i++)
+      SymTable_put(oSymTable, apcKeys[i], (void*)(size_t)(i + 1));
+   return oSymTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Encode pvValue, an integer, as the bytes of a size_t, for
+   SymTable_writeStream. */
+
+static size_t encodeValue(const void *pvValue, void *pvBuffer,
+   size_t uSize, void *pvExtra)
+{
+   size_t uValue = (size_t)pvValue;
+
+   (void)pvExtra;
+   if (uSize >= sizeof(uValue))
+      memcpy(pvBuffer, &uValue, sizeof(uValue));
+   return sizeof(uValue);
+}
+
+/* Decode the bytes of a size_t that encodeValue wrote, for
+   SymTable_readStream. */
+
+static int decodeValue(const void *pvBuffer, size_t uLength,
+   void **ppvValue, void *pvExtra)
+{
+   size_t uValue;
+
+   (void)pvExtra;
+   if (uLength != sizeof(uValue))
+      return 0;
+   memcpy(&uValue, pvBuffer, sizeof(uValue));
+   *ppvValue = (void*)uValue;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write oSymTable to the file named pcStreamPath and read it back into
+   a new table, storing the time each takes in *pdWrite and *pdRead,
+   and the size of the stream in *plBytes. Return the table read. */
+
+static SymTable_T streamTable(SymTable_T oSymTable, double *pdWrite,
+   double *pdRead, long *plBytes)
+{
+   SymTable_T oRead;
+   FILE *psFile;
+   double dStart;
+
+   psFile = fopen(pcStreamPath, "w+b");
+   oRead = SymTable_new();
+   if (psFile == NULL || oRead == NULL)
+   {
+      fprintf(stderr, "cannot stream to %s\n", pcStreamPath);
+      exit(EXIT_FAILURE);
+   }
+
+   dStart = getSeconds();
+   if (! SymTable_writeStream(oSymTable, psFile, encodeValue, NULL))
+   {
+      fprintf(stderr, "cannot write %s\n", pcStreamPath);
+      exit(EXIT_FAILURE);
+   }
+   *pdWrite = getSeconds() - dStart;
+   *plBytes = ftell(psFile);
+
+   rewind(psFile);
+   dStart = getSeconds();
+   if (! SymTable_readStream(oRead, psFile, decodeValue, NULL, NULL))
+   {
+      fprintf(stderr, "cannot read %s\n", pcStreamPath);
+      exit(EXIT_FAILURE);
+   }
+   *pdRead = getSeconds() - dStart;
+
+   fclose(psFile);
+   remove(pcStreamPath);
+   return oRead;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Look up iLookups of the iCount keys apcKeys[i] in oSymTable, in the
+   order that aiOrder gives. Return the time they take in seconds, and
+   report a key not bound to its expected value. */
+
+static double timeLookups(SymTable_T oSymTable, const char *const apcKeys[],
+   const int aiOrder[], int iLookups)
+{
+   double dStart;
+   int iWrong = 0;
+   int i;
+
+   dStart = getSeconds();
+   for (i = 0; i < iLookups; i++)
+      iWrong += SymTable_get(oSymTable, apcKeys[aiOrder[i]]) !=
+         (void*)(size_t)(aiOrder[i] + 1);
+   if (iWrong != 0)
+      printf("   lookup failed\n");
+   return getSeconds() - dStart;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Compare getting a table of argv[1] bindings ready by building it
+   with SymTable_put, by reading it from a stream that
+   SymTable_writeStream wrote, and by mapping a snapshot that
+   SymTable_save wrote, and compare the steady cost of a lookup in the
+   built and the mapped table. Write the results to stdout. Exit with
+   EXIT_FAILURE if argv[1] is missing or not a positive number, or if
+   memory is insufficient. Otherwise return 0. */
+
+int main(int argc, char *argv[])
+{
+   char *pcKeyBytes;
+   const char **apcKeys;
+   int *aiOrder;
+   SymTable_T oBuilt;
+   SymTable_T oMapped;
+   SymTable_T oStreamed;
+   struct stat sStat;
+   long lStreamBytes;
+   double dStart;
+   double dBuild;
+   double dSave;
+   double dOpen;
+   double dFirst;
+   double dStreamWrite;
+   double dStreamRead;
+   int iCount;
+   int iTemp;
+   int i;
+   int j;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s keycount\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+
+   if (sscanf(argv[1], "%d", &iCount) != 1 || iCount <= 0)
+   {
+      fprintf(stderr, "keycount must be a positive number\n");
+      exit(EXIT_FAILURE);
+   }
+
+   pcKeyBytes = (char*)malloc((size_t)iCount * MAX_KEY_LENGTH);
+   apcKeys = (const char**)malloc((size_t)iCount * sizeof(const char*));
+   aiOrder = (int*)malloc((size_t)iCount * sizeof(int));
+   if (pcKeyBytes == NULL || apcKeys == NULL || aiOrder == NULL)
+   {
+      fprintf(stderr, "insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+   for (i = 0; i < iCount; i++)
+   {
+      sprintf(pcKeyBytes + (size_t)i * MAX_KEY_LENGTH, "sym_%d", i);
+      apcKeys[i] = pcKeyBytes + (size_t)i * MAX_KEY_LENGTH;
+      aiOrder[i] = i;
+   }
+   srand(1);
+   for (i = iCount - 1; i > 0; i--)
+   {
+      j = rand() % (i + 1);
+      iTemp = aiOrder[i];
+      aiOrder[i] = aiOrder[j];
+      aiOrder[j] = iTemp;
+   }
+
+   printf("------------------------------------------------------\n");
+   printf("%d bindings.\n", iCount);
+   fflush(stdout);
+
+   dStart = getSeconds();
+   oBuilt = buildTable(apcKeys, iCount);
+   dBuild = getSeconds() - dStart;
+
+   oStreamed = streamTable(oBuilt, &dStreamWrite, &dStreamRead,
+      &lStreamBytes);
+   /* Only to check that every binding came back */
+   (void)timeLookups(oStreamed, apcKeys, aiOrder, iCount);
+   SymTable_free(oStreamed);
+
+   dStart = getSeconds();
+   if (! SymTable_save(oBuilt, pcSnapshotPath))
+   {
+      fprintf(stderr, "cannot save %s\n", pcSnapshotPath);
+      exit(EXIT_FAILURE);
+   }
+   dSave = getSeconds() - dStart;
+   if (stat(pcSnapshotPath, &sStat) != 0)
+      sStat.st_size = 0;
+
+   dStart = getSeconds();
+   oMapped = SymTable_openMapped(pcSnapshotPath);
+   dOpen = getSeconds() - dStart;
+   if (oMapped == NULL)
+   {
+      fprintf(stderr, "cannot map %s\n", pcSnapshotPath);
+      exit(EXIT_FAILURE);
+   }
+   dFirst = timeLookups(oMapped, apcKeys, aiOrder,
+      iCount < FIRST_LOOKUPS ? iCount : FIRST_LOOKUPS);
+
+   printf("Time to have the table ready:\n");
+   printf("   %-22s %12.3f ms\n", "built with puts", dBuild * 1e3);
+   printf("   %-22s %12.3f ms\n", "read from a stream",
+      dStreamRead * 1e3);
+   printf("   %-22s %12.3f ms\n", "mapped", dOpen * 1e3);
+   printf("   %-22s %12.3f ms\n", "mapped, first lookups",
+      (dOpen + dFirst) * 1e3);
+   printf("Time to write:\n");
+   printf("   %-22s %12.3f ms, %5.1f bytes per binding\n", "stream",
+      dStreamWrite * 1e3, (double)lStreamBytes / iCount);
+   printf("   %-22s %12.3f ms, %5.1f bytes per binding\n", "snapshot",
+      dSave * 1e3, (double)sStat.st_size / iCount);
+   printf("Cost of a lookup, in random order:\n");
+   printf("   %-22s %12.1f ns\n", "built",
+      timeLookups(oBuilt, apcKeys, aiOrder, iCount) * 1e9 / iCount);
+   printf("   %-22s %12.1f ns\n", "mapped",
+      timeLookups(oMapped, apcKeys, aiOrder, iCount) * 1e9 / iCount);
+
+   SymTable_free(oMapped);
+   SymTable_free(oBuilt);
+   remove(pcSnapshotPath);
+   free(aiOrder);
+   free(apcKeys);
+   free(pcKeyBytes);
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
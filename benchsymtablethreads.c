@@ -0,0 +1,463 @@
+/*--------------------------------------------------------------------*/
+/* benchsymtablethreads.c                                             */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "symtable.h"
+#include "symtablehash.h"
+#include "symtablefc.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include <pthread.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The largest number of threads that a benchmark starts. */
+
+enum {MAX_THREADS = 8};
+
+/* The longest key that the benchmarks build. */
+
+enum {MAX_KEY_LENGTH = 16};
+
+/* The number of lookups that each reader thread performs. */
+
+enum {LOOKUPS_PER_THREAD = 2000000};
+
+/* The number of keys that each writer thread cycles through. */
+
+enum {KEYS_PER_WRITER = 20000};
+
+/* The number of put/replace/remove rounds over those keys. */
+
+enum {WRITER_ROUNDS = 10};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the current value of the monotonic clock in seconds. */
+
+static double getSeconds(void)
+{
+   struct timespec sNow;
+   clock_gettime(CLOCK_MONOTONIC, &sNow);
+   return (double)sNow.tv_sec + (double)sNow.tv_nsec / 1e9;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return an array of iCount keys "0", "1", ... that the caller must
+   free with freeKeys. Exit with EXIT_FAILURE if memory is
+   insufficient. */
+
+static char **makeKeys(int iCount)
+{
+   char **ppcKeys;
+   int i;
+
+   ppcKeys = (char**)malloc(sizeof(char*) * (size_t)iCount);
+   if (ppcKeys == NULL)
+   {
+      fprintf(stderr, "insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+   for (i = 0; i < iCount; i++)
+   {
+      ppcKeys[i] = (char*)malloc(MAX_KEY_LENGTH);
+      if (ppcKeys[i] == NULL)
+      {
+         fprintf(stderr, "insufficient memory\n");
+         exit(EXIT_FAILURE);
+      }
+      sprintf(ppcKeys[i], "%d", i);
+   }
+   return ppcKeys;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free the iCount keys in ppcKeys and the array itself. */
+
+static void freeKeys(char **ppcKeys, int iCount)
+{
+   int i;
+   for (i = 0; i < iCount; i++)
+      free(ppcKeys[i]);
+   free(ppcKeys);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* State shared by the threads of one reader-scaling run. A run either
+   reads a read-mostly table directly or reads an ordinary table
+   under psLock. */
+
+struct ReaderRun
+{
+   SymTable_T oSymTable;
+   pthread_mutex_t *psLock;
+   char **ppcKeys;
+   int iKeyCount;
+   volatile int iStop;
+};
+
+/* One reader thread's view of a ReaderRun. */
+
+struct ReaderWork
+{
+   struct ReaderRun *psRun;
+   unsigned int uSeed;
+   size_t uMisses;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Look up LOOKUPS_PER_THREAD pseudo-random keys of the run described
+   by pvArg (a struct ReaderWork), counting the keys not found. */
+
+static void *readerThread(void *pvArg)
+{
+   struct ReaderWork *psWork = (struct ReaderWork*)pvArg;
+   struct ReaderRun *psRun = psWork->psRun;
+   unsigned int uState = psWork->uSeed;
+   const char *pcKey;
+   int i;
+
+   for (i = 0; i < LOOKUPS_PER_THREAD; i++)
+   {
+      uState = uState * 1103515245U + 12345U;
+      pcKey = psRun->ppcKeys[(uState >> 8) % (unsigned int)psRun->iKeyCount];
+      if (psRun->psLock != NULL)
+      {
+         pthread_mutex_lock(psRun->psLock);
+         if (SymTable_get(psRun->oSymTable, pcKey) == NULL)
+            psWork->uMisses++;
+         pthread_mutex_unlock(psRun->psLock);
+      }
+      else if (SymTable_get(psRun->oSymTable, pcKey) == NULL)
+         psWork->uMisses++;
+   }
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Until the run described by pvArg (a struct ReaderRun) stops,
+   replace one binding roughly every 100 microseconds. */
+
+static void *writerThread(void *pvArg)
+{
+   struct ReaderRun *psRun = (struct ReaderRun*)pvArg;
+   struct timespec sPause;
+   int i = 0;
+
+   sPause.tv_sec = 0;
+   sPause.tv_nsec = 100000;
+   while (! psRun->iStop)
+   {
+      const char *pcKey = psRun->ppcKeys[i % psRun->iKeyCount];
+      if (psRun->psLock != NULL)
+         pthread_mutex_lock(psRun->psLock);
+      SymTable_replace(psRun->oSymTable, pcKey, pcKey);
+      if (psRun->psLock != NULL)
+         pthread_mutex_unlock(psRun->psLock);
+      i++;
+      nanosleep(&sPause, NULL);
+   }
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Time iThreadCount readers (and one writer if iWithWriter) against
+   the table of psRun. Write the aggregate lookup rate to stdout. */
+
+static void timeReaders(const char *pcLabel, struct ReaderRun *psRun,
+   int iThreadCount, int iWithWriter)
+{
+   pthread_t aThreads[MAX_THREADS];
+   struct ReaderWork asWork[MAX_THREADS];
+   pthread_t oWriter;
+   double dStart;
+   double dElapsed;
+   size_t uMisses = 0;
+   int i;
+
+   psRun->iStop = 0;
+   if (iWithWriter)
+      pthread_create(&oWriter, NULL, writerThread, psRun);
+
+   dStart = getSeconds();
+   for (i = 0; i < iThreadCount; i++)
+   {
+      asWork[i].psRun = psRun;
+      asWork[i].uSeed = (unsigned int)i * 7919U + 1U;
+      asWork[i].uMisses = 0;
+      pthread_create(&aThreads[i], NULL, readerThread, &asWork[i]);
+   }
+   for (i = 0; i < iThreadCount; i++)
+   {
+      pthread_join(aThreads[i], NULL);
+      uMisses += asWork[i].uMisses;
+   }
+   dElapsed = getSeconds() - dStart;
+
+   psRun->iStop = 1;
+   if (iWithWriter)
+      pthread_join(oWriter, NULL);
+
+   printf("%-28s %2d threads %s  %8.2f Mlookups/s%s\n", pcLabel,
+      iThreadCount, iWithWriter ? "+writer" : "       ",
+      (double)iThreadCount * LOOKUPS_PER_THREAD / dElapsed / 1e6,
+      uMisses != 0 ? "  (MISSES!)" : "");
+   fflush(stdout);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Compare how lookups scale with the reader thread count for a
+   read-mostly table and for an ordinary table behind a mutex. */
+
+static void benchReaderScaling(int iBindingCount)
+{
+   struct ReaderRun sRun;
+   pthread_mutex_t oLock;
+   SymTable_T oReadMostly;
+   SymTable_T oPlain;
+   int iThreads;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Reader scaling, %d bindings, %d lookups per thread.\n",
+      iBindingCount, (int)LOOKUPS_PER_THREAD);
+   fflush(stdout);
+
+   sRun.ppcKeys = makeKeys(iBindingCount);
+   sRun.iKeyCount = iBindingCount;
+
+   oReadMostly = SymTable_newReadMostly();
+   oPlain = SymTable_new();
+   assert(oReadMostly != NULL && oPlain != NULL);
+   for (i = 0; i < iBindingCount; i++)
+   {
+      SymTable_put(oReadMostly, sRun.ppcKeys[i], sRun.ppcKeys[i]);
+      SymTable_put(oPlain, sRun.ppcKeys[i], sRun.ppcKeys[i]);
+   }
+   pthread_mutex_init(&oLock, NULL);
+
+   for (iThreads = 1; iThreads <= MAX_THREADS; iThreads *= 2)
+   {
+      sRun.oSymTable = oReadMostly;
+      sRun.psLock = NULL;
+      timeReaders("read-mostly (seqlock)", &sRun, iThreads, 0);
+      timeReaders("read-mostly (seqlock)", &sRun, iThreads, 1);
+
+      sRun.oSymTable = oPlain;
+      sRun.psLock = &oLock;
+      timeReaders("ordinary + mutex", &sRun, iThreads, 0);
+      timeReaders("ordinary + mutex", &sRun, iThreads, 1);
+   }
+
+   pthread_mutex_destroy(&oLock);
+   SymTable_free(oPlain);
+   SymTable_free(oReadMostly);
+   freeKeys(sRun.ppcKeys, iBindingCount);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Time putting iBindingCount bindings into a table that rehashes on
+   1, 2, 4, and 8 threads each time it grows. */
+
+static void benchParallelResize(int iBindingCount)
+{
+   SymTable_T oSymTable;
+   char **ppcKeys;
+   double dStart;
+   size_t uThreads;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Bulk load of %d bindings with parallel resizes.\n",
+      iBindingCount);
+   fflush(stdout);
+
+   ppcKeys = makeKeys(iBindingCount);
+   for (uThreads = 1; uThreads <= MAX_THREADS; uThreads *= 2)
+   {
+      oSymTable = SymTable_new();
+      assert(oSymTable != NULL);
+      SymTable_setResizeThreads(oSymTable, uThreads);
+
+      dStart = getSeconds();
+      for (i = 0; i < iBindingCount; i++)
+         SymTable_put(oSymTable, ppcKeys[i], ppcKeys[i]);
+      printf("%2d resize threads  %8.3f seconds\n", (int)uThreads,
+         getSeconds() - dStart);
+      fflush(stdout);
+
+      SymTable_free(oSymTable);
+   }
+   freeKeys(ppcKeys, iBindingCount);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* One writer thread of a write-heavy run. The thread either uses a
+   SymTableFC or an ordinary table under psLock, and works on the
+   keys ppcKeys[iFirst .. iFirst + KEYS_PER_WRITER). */
+
+struct WriterWork
+{
+   SymTableFC_T oSymTableFC;
+   SymTable_T oSymTable;
+   pthread_mutex_t *psLock;
+   char **ppcKeys;
+   int iFirst;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Put, replace, and remove every key of the writer described by
+   pvArg (a struct WriterWork), WRITER_ROUNDS times over. */
+
+static void *writeHeavyThread(void *pvArg)
+{
+   struct WriterWork *psWork = (struct WriterWork*)pvArg;
+   const char *pcKey;
+   int iRound;
+   int i;
+
+   for (iRound = 0; iRound < WRITER_ROUNDS; iRound++)
+      for (i = 0; i < KEYS_PER_WRITER; i++)
+      {
+         pcKey = psWork->ppcKeys[psWork->iFirst + i];
+         if (psWork->oSymTableFC != NULL)
+         {
+            SymTableFC_put(psWork->oSymTableFC, pcKey, pcKey);
+            SymTableFC_replace(psWork->oSymTableFC, pcKey, psWork);
+            if (i % 2 == 0)
+               SymTableFC_remove(psWork->oSymTableFC, pcKey);
+         }
+         else
+         {
+            pthread_mutex_lock(psWork->psLock);
+            SymTable_put(psWork->oSymTable, pcKey, pcKey);
+            pthread_mutex_unlock(psWork->psLock);
+            pthread_mutex_lock(psWork->psLock);
+            SymTable_replace(psWork->oSymTable, pcKey, psWork);
+            pthread_mutex_unlock(psWork->psLock);
+            if (i % 2 == 0)
+            {
+               pthread_mutex_lock(psWork->psLock);
+               SymTable_remove(psWork->oSymTable, pcKey);
+               pthread_mutex_unlock(psWork->psLock);
+            }
+         }
+      }
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Compare a SymTableFC with an ordinary table behind a mutex when 1,
+   2, 4, and 8 threads do nothing but put, replace, and remove. */
+
+static void benchWriteHeavy(void)
+{
+   pthread_t aThreads[MAX_THREADS];
+   struct WriterWork asWork[MAX_THREADS];
+   pthread_mutex_t oLock;
+   char **ppcKeys;
+   double dStart;
+   double dElapsed;
+   int iThreads;
+   int iFlatCombining;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Write-heavy access, %d keys per thread, %d rounds.\n",
+      (int)KEYS_PER_WRITER, (int)WRITER_ROUNDS);
+   fflush(stdout);
+
+   ppcKeys = makeKeys(KEYS_PER_WRITER * MAX_THREADS);
+   pthread_mutex_init(&oLock, NULL);
+
+   for (iThreads = 1; iThreads <= MAX_THREADS; iThreads *= 2)
+      for (iFlatCombining = 1; iFlatCombining >= 0; iFlatCombining--)
+      {
+         SymTableFC_T oSymTableFC = NULL;
+         SymTable_T oSymTable = NULL;
+
+         if (iFlatCombining)
+            oSymTableFC = SymTableFC_new();
+         else
+            oSymTable = SymTable_new();
+         assert(oSymTableFC != NULL || oSymTable != NULL);
+
+         dStart = getSeconds();
+         for (i = 0; i < iThreads; i++)
+         {
+            asWork[i].oSymTableFC = oSymTableFC;
+            asWork[i].oSymTable = oSymTable;
+            asWork[i].psLock = &oLock;
+            asWork[i].ppcKeys = ppcKeys;
+            asWork[i].iFirst = i * KEYS_PER_WRITER;
+            pthread_create(&aThreads[i], NULL, writeHeavyThread,
+               &asWork[i]);
+         }
+         for (i = 0; i < iThreads; i++)
+            pthread_join(aThreads[i], NULL);
+         dElapsed = getSeconds() - dStart;
+
+         printf("%-28s %2d threads  %8.2f Mops/s\n",
+            iFlatCombining ? "flat combining" : "ordinary + mutex",
+            iThreads, (double)iThreads * WRITER_ROUNDS *
+            KEYS_PER_WRITER * 2.5 / dElapsed / 1e6);
+         fflush(stdout);
+
+         if (oSymTableFC != NULL)
+            SymTableFC_free(oSymTableFC);
+         if (oSymTable != NULL)
+            SymTable_free(oSymTable);
+      }
+
+   pthread_mutex_destroy(&oLock);
+   freeKeys(ppcKeys, KEYS_PER_WRITER * MAX_THREADS);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Benchmark the thread-safe ways of sharing a SymTable. argv[1] is
+   the number of bindings in each benchmarked table. Exit with
+   EXIT_FAILURE if argv[1] is missing or not a positive number.
+   Otherwise return 0. */
+
+int main(int argc, char *argv[])
+{
+   int iBindingCount;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s bindingcount\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+
+   if (sscanf(argv[1], "%d", &iBindingCount) != 1 || iBindingCount <= 0)
+   {
+      fprintf(stderr, "bindingcount must be a positive number\n");
+      exit(EXIT_FAILURE);
+   }
+
+   benchReaderScaling(iBindingCount);
+   benchParallelResize(iBindingCount);
+   benchWriteHeavy();
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
@@ -0,0 +1,1053 @@
+/*--------------------------------------------------------------------*/
+/* symtableart.c                                                      */
+/* Adaptive radix tree with path compression                          */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "symtable.h"
+#include "symtableordered.h"
+
+/*
+ * SSE2_INTRINSICS: 1 where a Node16 can be searched with SSE2, which
+ * every x86-64 CPU has, so no run-time check is needed.
+ */
+#if defined(__GNUC__) && defined(__SSE2__)
+#define SSE2_INTRINSICS 1
+#include <emmintrin.h>
+#else
+#define SSE2_INTRINSICS 0
+#endif
+
+/*
+ * NODE4, NODE16, NODE48, NODE256: The kinds of inner node, named after
+ * the most children each holds. A node grows into the next kind when
+ * it is full, and shrinks into the previous one when it falls to the
+ * matching *_SHRINK count, well below that kind's size so that a put
+ * and a remove in turn do not resize each time.
+ */
+#define NODE4 0
+#define NODE16 1
+#define NODE48 2
+#define NODE256 3
+
+#define NODE16_SHRINK 3
+#define NODE48_SHRINK 12
+#define NODE256_SHRINK 40
+
+/*
+ * MAP_STACK_BYTES: Keys shorter than this are rebuilt for *pfApply in
+ * a buffer on the stack; longer ones need one from malloc.
+ */
+#define MAP_STACK_BYTES 256
+
+/*
+ * SymTableEntry: One binding, the leaf of the tree. It holds only the
+ * part of the key that the path to it does not spell, its suffix, at
+ * the end of the entry's own allocation.
+ */
+struct SymTableEntry {
+    /* The value */
+    const void *pvValue;
+
+    /* The suffix's length, 0 once the '\0' itself is on the path */
+    uint32_t suffixLength;
+
+    /* The rest of the key, with its terminating '\0' */
+    unsigned char aucSuffix[];
+};
+
+/*
+ * Node: What every inner node begins with. A child pointer with its
+ * lowest bit set is a SymTableEntry instead, which malloc's alignment
+ * leaves free to mark.
+ *
+ * A key is walked one byte per level, its terminating '\0' included,
+ * so no key is a prefix of another and every binding is a leaf. The
+ * bytes that all keys under a node share past its parent's are kept
+ * once, as the node's prefix, stored right after the node's struct in
+ * the same allocation. A prefix never holds '\0'. A leaf at depth d,
+ * reached by d bytes of prefixes and child bytes, keeps the key's
+ * bytes from d on, so every byte of a key is stored once on its path.
+ */
+struct Node {
+    /* NODE4, NODE16, NODE48 or NODE256 */
+    unsigned char type;
+
+    /* Number of children */
+    uint16_t count;
+
+    /* Length of the prefix */
+    uint32_t prefixLength;
+};
+
+/*
+ * Node4, Node16: Up to 4 or 16 children, with the key byte of each in
+ * increasing order.
+ */
+struct Node4 {
+    struct Node sNode;
+    unsigned char aucKeys[4];
+    struct Node *apsChildren[4];
+};
+
+struct Node16 {
+    struct Node sNode;
+    unsigned char aucKeys[16];
+    struct Node *apsChildren[16];
+};
+
+/*
+ * Node48: Up to 48 children, found through a 256-byte index: entry b
+ * is one more than the slot of the child for byte b, or 0 if there is
+ * none. Unused slots are NULL.
+ */
+struct Node48 {
+    struct Node sNode;
+    unsigned char aucSlots[256];
+    struct Node *apsChildren[48];
+};
+
+/*
+ * Node256: A child, or NULL, for each byte.
+ */
+struct Node256 {
+    struct Node sNode;
+    struct Node *apsChildren[256];
+};
+
+/*
+ * SymTable: An adaptive radix tree.
+ */
+struct SymTable {
+    /* The root: NULL, a single leaf or an inner node */
+    struct Node *psRoot;
+
+    /* Total number of bindings in the table */
+    size_t nodeQuantity;
+
+    /* The length of the longest key ever put, which bounds the buffer
+       that the map functions rebuild keys in */
+    size_t maxKeyLength;
+
+    /* A buffer of maxKeyLength + 1 bytes once that is MAP_STACK_BYTES
+       or more, for a map that finds memory insufficient */
+    char *pcSpareKey;
+};
+
+/*
+ * The size of each kind of node, before its prefix.
+ */
+static const size_t auNodeSizes[] = {
+    sizeof(struct Node4), sizeof(struct Node16),
+    sizeof(struct Node48), sizeof(struct Node256)
+};
+
+/*
+ * Returns 1 if a child pointer is a leaf, 0 if it is an inner node.
+ */
+static int symtableart_isLeaf(const struct Node *psNode) {
+    return ((uintptr_t)psNode & 1) != 0;
+}
+
+/*
+ * Gives the entry that a leaf pointer marks.
+ */
+static struct SymTableEntry *symtableart_entry(const struct Node *psNode) {
+    return (struct SymTableEntry*)((uintptr_t)psNode - 1);
+}
+
+/*
+ * Gives the child pointer that marks an entry as a leaf.
+ */
+static struct Node *symtableart_leaf(struct SymTableEntry *psEntry) {
+    return (struct Node*)((uintptr_t)psEntry + 1);
+}
+
+/*
+ * Gives a node's prefix.
+ */
+static unsigned char *symtableart_prefix(struct Node *psNode) {
+    return (unsigned char*)psNode + auNodeSizes[psNode->type];
+}
+
+/*
+ * Allocates an entry binding the key whose suffix is the
+ * `suffixLength` bytes at `pucSuffix` to `pvValue`.
+ * Returns the entry, or NULL if memory is insufficient.
+ */
+static struct SymTableEntry *symtableart_newEntry(const unsigned char *pucSuffix, size_t suffixLength,
+                                                  const void *pvValue) {
+    struct SymTableEntry *psEntry =
+        (struct SymTableEntry*)malloc(offsetof(struct SymTableEntry, aucSuffix) + suffixLength);
+
+    if (psEntry == NULL) return NULL;
+    psEntry->pvValue = pvValue;
+    psEntry->suffixLength = (uint32_t)suffixLength;
+    memcpy(psEntry->aucSuffix, pucSuffix, suffixLength);
+    return psEntry;
+}
+
+/*
+ * Returns 1 if the entry of a leaf at depth `depth` holds the key
+ * `pucKey`, of length `keyLength`, and 0 otherwise.
+ */
+static int symtableart_leafMatches(const struct SymTableEntry *psEntry, const unsigned char *pucKey,
+                                   size_t keyLength, size_t depth) {
+    return psEntry->suffixLength == keyLength + 1 - depth &&
+           memcmp(psEntry->aucSuffix, pucKey + depth, psEntry->suffixLength) == 0;
+}
+
+/*
+ * Allocates an inner node of kind `type` with no children and the
+ * `prefixLength` bytes at `pucPrefix` as its prefix.
+ * Returns the node, or NULL if memory is insufficient.
+ */
+static struct Node *symtableart_newNode(unsigned char type, const unsigned char *pucPrefix, size_t prefixLength) {
+    struct Node *psNode = (struct Node*)malloc(auNodeSizes[type] + prefixLength);
+
+    if (psNode == NULL) return NULL;
+    psNode->type = type;
+    psNode->count = 0;
+    psNode->prefixLength = (uint32_t)prefixLength;
+    memcpy(symtableart_prefix(psNode), pucPrefix, prefixLength);
+    if (type == NODE16) {
+        /* A vector search reads all 16 key bytes */
+        memset(((struct Node16*)psNode)->aucKeys, 0, 16);
+    } else if (type == NODE48) {
+        memset(((struct Node48*)psNode)->aucSlots, 0, 256);
+        memset(((struct Node48*)psNode)->apsChildren, 0, sizeof(((struct Node48*)psNode)->apsChildren));
+    } else if (type == NODE256) {
+        memset(((struct Node256*)psNode)->apsChildren, 0, sizeof(((struct Node256*)psNode)->apsChildren));
+    }
+    return psNode;
+}
+
+/*
+ * Finds the child of an inner node for byte `key`.
+ * Returns a pointer to the child's slot, or NULL if there is none.
+ */
+static struct Node **symtableart_findChild(struct Node *psNode, unsigned char key) {
+    unsigned int i;
+
+    switch (psNode->type) {
+    case NODE4: {
+        struct Node4 *psNode4 = (struct Node4*)psNode;
+        for (i = 0; i < psNode->count; i++) {
+            if (psNode4->aucKeys[i] == key) return &psNode4->apsChildren[i];
+        }
+        return NULL;
+    }
+    case NODE16: {
+        struct Node16 *psNode16 = (struct Node16*)psNode;
+#if SSE2_INTRINSICS
+        /* Compare the byte with all 16 keys at once; the mask drops the
+           unused ones */
+        __m128i keys = _mm_loadu_si128((const __m128i*)psNode16->aucKeys);
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(keys, _mm_set1_epi8((char)key)));
+        mask &= (1u << psNode->count) - 1;
+        return mask != 0 ? &psNode16->apsChildren[__builtin_ctz(mask)] : NULL;
+#else
+        for (i = 0; i < psNode->count; i++) {
+            if (psNode16->aucKeys[i] == key) return &psNode16->apsChildren[i];
+        }
+        return NULL;
+#endif
+    }
+    case NODE48: {
+        struct Node48 *psNode48 = (struct Node48*)psNode;
+        i = psNode48->aucSlots[key];
+        return i != 0 ? &psNode48->apsChildren[i - 1] : NULL;
+    }
+    default: {
+        struct Node256 *psNode256 = (struct Node256*)psNode;
+        return psNode256->apsChildren[key] != NULL ? &psNode256->apsChildren[key] : NULL;
+    }
+    }
+}
+
+/*
+ * Gives the next child of an inner node in increasing order of key
+ * bytes, starting the search at position *puPos, which begins at 0.
+ * Stores the child's byte in *pucKey and advances *puPos past it.
+ * Returns the child, or NULL after the last one.
+ */
+static struct Node *symtableart_nextChild(struct Node *psNode, unsigned int *puPos, unsigned char *pucKey) {
+    unsigned int i = *puPos;
+
+    switch (psNode->type) {
+    case NODE4:
+    case NODE16: {
+        /* Node4 and Node16 differ only in their arrays' sizes */
+        const unsigned char *aucKeys = psNode->type == NODE4 ?
+            ((struct Node4*)psNode)->aucKeys : ((struct Node16*)psNode)->aucKeys;
+        struct Node **apsChildren = psNode->type == NODE4 ?
+            ((struct Node4*)psNode)->apsChildren : ((struct Node16*)psNode)->apsChildren;
+        if (i >= psNode->count) return NULL;
+        *pucKey = aucKeys[i];
+        *puPos = i + 1;
+        return apsChildren[i];
+    }
+    case NODE48: {
+        struct Node48 *psNode48 = (struct Node48*)psNode;
+        for (; i < 256; i++) {
+            if (psNode48->aucSlots[i] != 0) {
+                *pucKey = (unsigned char)i;
+                *puPos = i + 1;
+                return psNode48->apsChildren[psNode48->aucSlots[i] - 1];
+            }
+        }
+        return NULL;
+    }
+    default: {
+        struct Node256 *psNode256 = (struct Node256*)psNode;
+        for (; i < 256; i++) {
+            if (psNode256->apsChildren[i] != NULL) {
+                *pucKey = (unsigned char)i;
+                *puPos = i + 1;
+                return psNode256->apsChildren[i];
+            }
+        }
+        return NULL;
+    }
+    }
+}
+
+/*
+ * Moves the children of an inner node into a new node of kind `type`,
+ * which has room for them, and frees the old node.
+ * Returns the new node, or NULL if memory is insufficient, in which
+ * case the old node is left as it was.
+ */
+static struct Node *symtableart_resize(struct Node *psNode, unsigned char type) {
+    struct Node *psNew;
+    struct Node *psChild;
+    unsigned int pos = 0, i = 0;
+    unsigned char key;
+
+    psNew = symtableart_newNode(type, symtableart_prefix(psNode), psNode->prefixLength);
+    if (psNew == NULL) return NULL;
+    while ((psChild = symtableart_nextChild(psNode, &pos, &key)) != NULL) {
+        switch (type) {
+        case NODE4:
+            ((struct Node4*)psNew)->aucKeys[i] = key;
+            ((struct Node4*)psNew)->apsChildren[i] = psChild;
+            break;
+        case NODE16:
+            ((struct Node16*)psNew)->aucKeys[i] = key;
+            ((struct Node16*)psNew)->apsChildren[i] = psChild;
+            break;
+        case NODE48:
+            ((struct Node48*)psNew)->aucSlots[key] = (unsigned char)(i + 1);
+            ((struct Node48*)psNew)->apsChildren[i] = psChild;
+            break;
+        default:
+            ((struct Node256*)psNew)->apsChildren[key] = psChild;
+            break;
+        }
+        i++;
+    }
+    psNew->count = psNode->count;
+    free(psNode);
+    return psNew;
+}
+
+/*
+ * Adds `psChild` under byte `key` to the inner node at *ppsRef, which
+ * has no child for that byte. A full node grows into the next kind
+ * first, replacing *ppsRef.
+ * Returns 1 on success, or 0 if memory is insufficient, in which case
+ * nothing changes.
+ */
+static int symtableart_addChild(struct Node **ppsRef, unsigned char key, struct Node *psChild) {
+    struct Node *psNode = *ppsRef;
+    static const unsigned int auCapacities[] = {4, 16, 48, 256};
+    unsigned int i;
+
+    if (psNode->count == auCapacities[psNode->type]) {
+        psNode = symtableart_resize(psNode, (unsigned char)(psNode->type + 1));
+        if (psNode == NULL) return 0;
+        *ppsRef = psNode;
+    }
+
+    switch (psNode->type) {
+    case NODE4:
+    case NODE16: {
+        unsigned char *aucKeys = psNode->type == NODE4 ?
+            ((struct Node4*)psNode)->aucKeys : ((struct Node16*)psNode)->aucKeys;
+        struct Node **apsChildren = psNode->type == NODE4 ?
+            ((struct Node4*)psNode)->apsChildren : ((struct Node16*)psNode)->apsChildren;
+        for (i = 0; i < psNode->count && aucKeys[i] < key; i++);
+        memmove(aucKeys + i + 1, aucKeys + i, psNode->count - i);
+        memmove(apsChildren + i + 1, apsChildren + i, (psNode->count - i) * sizeof(struct Node*));
+        aucKeys[i] = key;
+        apsChildren[i] = psChild;
+        break;
+    }
+    case NODE48: {
+        struct Node48 *psNode48 = (struct Node48*)psNode;
+        for (i = 0; psNode48->apsChildren[i] != NULL; i++);
+        psNode48->apsChildren[i] = psChild;
+        psNode48->aucSlots[key] = (unsigned char)(i + 1);
+        break;
+    }
+    default:
+        ((struct Node256*)psNode)->apsChildren[key] = psChild;
+        break;
+    }
+    psNode->count++;
+    return 1;
+}
+
+/*
+ * Removes the child under byte `key` from the inner node at *ppsRef,
+ * then shrinks the node into a smaller kind if it has few enough
+ * children left. A Node4 left with one child is replaced by that
+ * child, the node's prefix and the child's byte going in front of the
+ * child's own prefix; one left with none is freed and *ppsRef set to
+ * NULL. Shrinking is skipped if memory for it is insufficient, which
+ * leaves a valid, if roomier, node.
+ */
+static void symtableart_removeChild(struct Node **ppsRef, unsigned char key) {
+    struct Node *psNode = *ppsRef;
+    struct Node *psNew;
+    unsigned int i;
+
+    switch (psNode->type) {
+    case NODE4:
+    case NODE16: {
+        unsigned char *aucKeys = psNode->type == NODE4 ?
+            ((struct Node4*)psNode)->aucKeys : ((struct Node16*)psNode)->aucKeys;
+        struct Node **apsChildren = psNode->type == NODE4 ?
+            ((struct Node4*)psNode)->apsChildren : ((struct Node16*)psNode)->apsChildren;
+        for (i = 0; aucKeys[i] != key; i++);
+        memmove(aucKeys + i, aucKeys + i + 1, psNode->count - 1 - i);
+        memmove(apsChildren + i, apsChildren + i + 1, (psNode->count - 1 - i) * sizeof(struct Node*));
+        break;
+    }
+    case NODE48: {
+        struct Node48 *psNode48 = (struct Node48*)psNode;
+        psNode48->apsChildren[psNode48->aucSlots[key] - 1] = NULL;
+        psNode48->aucSlots[key] = 0;
+        break;
+    }
+    default:
+        ((struct Node256*)psNode)->apsChildren[key] = NULL;
+        break;
+    }
+    psNode->count--;
+
+    if (psNode->type == NODE4 && psNode->count <= 1) {
+        struct Node4 *psNode4 = (struct Node4*)psNode;
+        struct Node *psChild = psNode4->apsChildren[0];
+        size_t prefixLength;
+
+        if (psNode->count == 0) {
+            /* Only a Node4 that could not be merged into its child
+               before gets here */
+            free(psNode);
+            *ppsRef = NULL;
+            return;
+        }
+        if (symtableart_isLeaf(psChild)) {
+            /* The leaf moves up past the node's prefix and its byte,
+               which go in front of its suffix */
+            struct SymTableEntry *psEntry = symtableart_entry(psChild);
+            size_t suffixLength = psNode->prefixLength + 1 + psEntry->suffixLength;
+            psEntry = (struct SymTableEntry*)realloc(psEntry, offsetof(struct SymTableEntry, aucSuffix) +
+                                                              suffixLength);
+            if (psEntry == NULL) return;
+            memmove(psEntry->aucSuffix + psNode->prefixLength + 1, psEntry->aucSuffix, psEntry->suffixLength);
+            memcpy(psEntry->aucSuffix, symtableart_prefix(psNode), psNode->prefixLength);
+            psEntry->aucSuffix[psNode->prefixLength] = psNode4->aucKeys[0];
+            psEntry->suffixLength = (uint32_t)suffixLength;
+            psChild = symtableart_leaf(psEntry);
+        } else {
+            prefixLength = psNode->prefixLength + 1 + psChild->prefixLength;
+            psChild = (struct Node*)realloc(psChild, auNodeSizes[psChild->type] + prefixLength);
+            if (psChild == NULL) return;
+            memmove(symtableart_prefix(psChild) + psNode->prefixLength + 1, symtableart_prefix(psChild),
+                    psChild->prefixLength);
+            memcpy(symtableart_prefix(psChild), symtableart_prefix(psNode), psNode->prefixLength);
+            symtableart_prefix(psChild)[psNode->prefixLength] = psNode4->aucKeys[0];
+            psChild->prefixLength = (uint32_t)prefixLength;
+        }
+        free(psNode);
+        *ppsRef = psChild;
+        return;
+    }
+
+    psNew = NULL;
+    if (psNode->type == NODE16 && psNode->count <= NODE16_SHRINK) {
+        psNew = symtableart_resize(psNode, NODE4);
+    } else if (psNode->type == NODE48 && psNode->count <= NODE48_SHRINK) {
+        psNew = symtableart_resize(psNode, NODE16);
+    } else if (psNode->type == NODE256 && psNode->count <= NODE256_SHRINK) {
+        psNew = symtableart_resize(psNode, NODE48);
+    }
+    if (psNew != NULL) *ppsRef = psNew;
+}
+
+/*
+ * Finds the entry that holds a key. A leaf holds only the end of its
+ * key, so every prefix on the way down is compared; one longer than
+ * what is left of the key ends the search without reading past it.
+ * Returns the entry, or NULL if the table has no such key.
+ */
+static struct SymTableEntry *symtableart_find(SymTable_T oSymTable, const char *pcKey) {
+    const unsigned char *pucKey = (const unsigned char*)pcKey;
+    struct Node *psNode = oSymTable->psRoot;
+    struct Node **ppsChild;
+    size_t keyLength = strlen(pcKey);
+    size_t depth = 0;
+
+    while (psNode != NULL) {
+        if (symtableart_isLeaf(psNode)) {
+            struct SymTableEntry *psEntry = symtableart_entry(psNode);
+            return symtableart_leafMatches(psEntry, pucKey, keyLength, depth) ? psEntry : NULL;
+        }
+        if (keyLength - depth < psNode->prefixLength ||
+            memcmp(symtableart_prefix(psNode), pucKey + depth, psNode->prefixLength) != 0) {
+            return NULL;
+        }
+        depth += psNode->prefixLength;
+        ppsChild = symtableart_findChild(psNode, (unsigned char)pcKey[depth]);
+        if (ppsChild == NULL) return NULL;
+        psNode = *ppsChild;
+        depth++;
+    }
+    return NULL;
+}
+
+/*
+ * Removes the binding for `pcKey` from the subtree at *ppsRef, whose
+ * keys share their first `depth` bytes with `pcKey`, and removes
+ * inner nodes that it leaves empty or with a single child.
+ * Returns the removed entry, which the caller frees, or NULL if the
+ * subtree has no such key.
+ */
+static struct SymTableEntry *symtableart_removeFrom(struct Node **ppsRef, const char *pcKey, size_t keyLength,
+                                                    size_t depth) {
+    struct Node *psNode = *ppsRef;
+    struct SymTableEntry *psEntry;
+    struct Node **ppsChild;
+    unsigned char key;
+
+    if (symtableart_isLeaf(psNode)) {
+        psEntry = symtableart_entry(psNode);
+        if (!symtableart_leafMatches(psEntry, (const unsigned char*)pcKey, keyLength, depth)) return NULL;
+        *ppsRef = NULL;
+        return psEntry;
+    }
+    if (keyLength - depth < psNode->prefixLength ||
+        memcmp(symtableart_prefix(psNode), pcKey + depth, psNode->prefixLength) != 0) {
+        return NULL;
+    }
+    depth += psNode->prefixLength;
+    key = (unsigned char)pcKey[depth];
+    ppsChild = symtableart_findChild(psNode, key);
+    if (ppsChild == NULL) return NULL;
+
+    psEntry = symtableart_removeFrom(ppsChild, pcKey, keyLength, depth + 1);
+    if (psEntry != NULL && *ppsChild == NULL) symtableart_removeChild(ppsRef, key);
+    return psEntry;
+}
+
+/*
+ * Frees a subtree: its entries and nodes.
+ */
+static void symtableart_freeNode(struct Node *psNode) {
+    struct Node *psChild;
+    unsigned int pos = 0;
+    unsigned char key;
+
+    if (symtableart_isLeaf(psNode)) {
+        free(symtableart_entry(psNode));
+        return;
+    }
+    while ((psChild = symtableart_nextChild(psNode, &pos, &key)) != NULL) {
+        symtableart_freeNode(psChild);
+    }
+    free(psNode);
+}
+
+/*
+ * Gives a buffer that holds the longest key of the table, for the map
+ * functions to rebuild keys in: `acStack`, of MAP_STACK_BYTES, if it
+ * is big enough, or else a new allocation. If memory for that is
+ * insufficient, the table's spare buffer stands in; only a map run
+ * from inside another's *pfApply could then be using it too.
+ */
+static char *symtableart_getKeyBuffer(SymTable_T oSymTable, char *acStack) {
+    char *pcBuffer;
+
+    if (oSymTable->maxKeyLength < MAP_STACK_BYTES) return acStack;
+    pcBuffer = (char*)malloc(oSymTable->maxKeyLength + 1);
+    return pcBuffer != NULL ? pcBuffer : oSymTable->pcSpareKey;
+}
+
+/*
+ * Frees a buffer from symtableart_getKeyBuffer, if it was allocated.
+ */
+static void symtableart_freeKeyBuffer(SymTable_T oSymTable, char *pcBuffer, char *acStack) {
+    if (pcBuffer != acStack && pcBuffer != oSymTable->pcSpareKey) free(pcBuffer);
+}
+
+/*
+ * Writes the key of a leaf into `pcKey`, whose first `depth` bytes
+ * already hold the path to it. The suffix ends with the key's '\0',
+ * unless the path does.
+ */
+static void symtableart_spellKey(const struct SymTableEntry *psEntry, char *pcKey, size_t depth) {
+    memcpy(pcKey + depth, psEntry->aucSuffix, psEntry->suffixLength);
+}
+
+/*
+ * Applies *pfApply to every binding of a subtree in increasing order
+ * of keys. The keys of the subtree share their first `depth` bytes,
+ * which `pcKey` holds; the key of each binding is rebuilt after them.
+ */
+static void symtableart_mapNode(struct Node *psNode, char *pcKey, size_t depth,
+                                void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+                                const void *pvExtra) {
+    struct Node *psChild;
+    unsigned int pos = 0;
+    unsigned char key;
+
+    if (symtableart_isLeaf(psNode)) {
+        struct SymTableEntry *psEntry = symtableart_entry(psNode);
+        symtableart_spellKey(psEntry, pcKey, depth);
+        (*pfApply)(pcKey, (void*)psEntry->pvValue, (void*)pvExtra);
+        return;
+    }
+    memcpy(pcKey + depth, symtableart_prefix(psNode), psNode->prefixLength);
+    depth += psNode->prefixLength;
+    while ((psChild = symtableart_nextChild(psNode, &pos, &key)) != NULL) {
+        pcKey[depth] = (char)key;
+        symtableart_mapNode(psChild, pcKey, depth + 1, pfApply, pvExtra);
+    }
+}
+
+/*
+ * RangeQuery: The bounds and callback of a SymTable_mapRange call.
+ */
+struct RangeQuery {
+    /* The bounds, or NULL for an open end */
+    const unsigned char *pucLow;
+    const unsigned char *pucHigh;
+
+    /* Where the keys are rebuilt */
+    char *pcKey;
+
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra);
+    const void *pvExtra;
+};
+
+/*
+ * Applies the range query's callback to the bindings of a subtree
+ * whose keys lie in its range, in increasing order of keys. The keys
+ * of the subtree share their first `depth` bytes. `onLow` is 1 if
+ * those bytes are also the first bytes of the low bound, so that keys
+ * below it may be in the subtree, and `onHigh` likewise for the high
+ * bound; once a path leaves a bound, the bound need not be checked
+ * again below it.
+ * Returns 1 once a key at or past the high bound is reached, which
+ * ends the whole query, and 0 otherwise.
+ */
+static int symtableart_mapRangeNode(struct Node *psNode, size_t depth, int onLow, int onHigh,
+                                    const struct RangeQuery *psQuery) {
+    const unsigned char *pucLow = psQuery->pucLow;
+    const unsigned char *pucHigh = psQuery->pucHigh;
+    const unsigned char *pucPrefix;
+    struct Node *psChild;
+    unsigned int pos = 0;
+    unsigned char key;
+    size_t i;
+
+    if (symtableart_isLeaf(psNode)) {
+        struct SymTableEntry *psEntry = symtableart_entry(psNode);
+        symtableart_spellKey(psEntry, psQuery->pcKey, depth);
+        if (onLow && strcmp(psQuery->pcKey, (const char*)pucLow) < 0) return 0;
+        if (onHigh && strcmp(psQuery->pcKey, (const char*)pucHigh) >= 0) return 1;
+        (*psQuery->pfApply)(psQuery->pcKey, (void*)psEntry->pvValue, (void*)psQuery->pvExtra);
+        return 0;
+    }
+
+    /* A bound that ends inside the prefix has '\0' where the prefix
+       has a larger byte, so neither loop reads past it */
+    pucPrefix = symtableart_prefix(psNode);
+    for (i = 0; onLow && i < psNode->prefixLength; i++) {
+        if (pucPrefix[i] < pucLow[depth + i]) return 0;
+        if (pucPrefix[i] > pucLow[depth + i]) onLow = 0;
+    }
+    for (i = 0; onHigh && i < psNode->prefixLength; i++) {
+        if (pucPrefix[i] > pucHigh[depth + i]) return 1;
+        if (pucPrefix[i] < pucHigh[depth + i]) onHigh = 0;
+    }
+    memcpy(psQuery->pcKey + depth, pucPrefix, psNode->prefixLength);
+    depth += psNode->prefixLength;
+
+    while ((psChild = symtableart_nextChild(psNode, &pos, &key)) != NULL) {
+        int childOnLow = onLow, childOnHigh = onHigh;
+        if (onLow) {
+            if (key < pucLow[depth]) continue;
+            childOnLow = key == pucLow[depth];
+        }
+        if (onHigh) {
+            if (key > pucHigh[depth]) return 1;
+            childOnHigh = key == pucHigh[depth];
+        }
+        psQuery->pcKey[depth] = (char)key;
+        if (symtableart_mapRangeNode(psChild, depth + 1, childOnLow, childOnHigh, psQuery)) return 1;
+    }
+    return 0;
+}
+
+/* Sets up a new, empty symbol table: a tree with no root yet.
+   Returns a pointer to the table or NULL if there's an allocation
+   issue. */
+SymTable_T SymTable_new(void) {
+    SymTable_T oSymTable;
+
+    oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+    if (oSymTable == NULL) return NULL;
+
+    oSymTable->psRoot = NULL;
+    oSymTable->nodeQuantity = 0;
+    oSymTable->maxKeyLength = 0;
+    oSymTable->pcSpareKey = NULL;
+    return oSymTable;
+}
+
+/* Returns the number of bindings in the table.
+   Arguments -> `oSymTable`: the symbol table */
+size_t SymTable_getLength(SymTable_T oSymTable) {
+    assert(oSymTable != NULL);
+    return oSymTable->nodeQuantity;
+}
+
+/* Releases every entry and node, and the table.
+   Arguments -> `oSymTable`: the symbol table to be freed */
+void SymTable_free(SymTable_T oSymTable) {
+    assert(oSymTable != NULL);
+
+    if (oSymTable->psRoot != NULL) symtableart_freeNode(oSymTable->psRoot);
+    free(oSymTable->pcSpareKey);
+    free(oSymTable);
+}
+
+/*
+ * Adds a new key-value pair to the symbol table if the key doesn't already exist.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `pcKey`: string key to add
+ *   - `pvValue`: the value associated with `pcKey`
+ * Walks down while the key matches. Where it first differs from a
+ * leaf's suffix or from a node's prefix, a new Node4 takes the shared
+ * bytes as its prefix and gets the old subtree and the new leaf as its
+ * children, and an old leaf drops the bytes that are now on its path;
+ * where a node just lacks the key's next byte, the leaf is added to
+ * it.
+ * Returns 1 on success, 0 on failure or if the key exists.
+ */
+int SymTable_put(SymTable_T oSymTable, const char *pcKey, const void *pvValue) {
+    struct Node **ppsRef = &oSymTable->psRoot;
+    struct Node **ppsChild;
+    struct SymTableEntry *psNewEntry;
+    struct Node *psNode;
+    struct Node4 *psSplit;
+    const unsigned char *pucKey = (const unsigned char*)pcKey;
+    const unsigned char *pucPrefix;
+    unsigned char oldKey;
+    size_t keyLength, depth = 0, common;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    keyLength = strlen(pcKey);
+    if (keyLength > oSymTable->maxKeyLength) {
+        /* Keep a spare buffer for the map functions to fall back on */
+        if (keyLength >= MAP_STACK_BYTES) {
+            char *pcSpareKey = (char*)realloc(oSymTable->pcSpareKey, keyLength + 1);
+            if (pcSpareKey == NULL) return 0;
+            oSymTable->pcSpareKey = pcSpareKey;
+        }
+        oSymTable->maxKeyLength = keyLength;
+    }
+
+    for (;;) {
+        psNode = *ppsRef;
+        if (psNode == NULL) {
+            /* Only an empty table's root */
+            psNewEntry = symtableart_newEntry(pucKey, keyLength + 1, pvValue);
+            if (psNewEntry == NULL) return 0;
+            *ppsRef = symtableart_leaf(psNewEntry);
+            break;
+        }
+
+        if (symtableart_isLeaf(psNode)) {
+            const unsigned char *pucOld = symtableart_entry(psNode)->aucSuffix;
+            if (symtableart_leafMatches(symtableart_entry(psNode), pucKey, keyLength, depth)) return 0;
+            /* The keys differ by their '\0' at the latest, so the old
+               one's is still in its suffix */
+            for (common = 0; pucKey[depth + common] == pucOld[common]; common++);
+            pucPrefix = pucKey + depth;
+            oldKey = pucOld[common];
+        } else {
+            pucPrefix = symtableart_prefix(psNode);
+            for (common = 0; common < psNode->prefixLength && pucPrefix[common] == pucKey[depth + common]; common++);
+            if (common == psNode->prefixLength) {
+                depth += common;
+                ppsChild = symtableart_findChild(psNode, pucKey[depth]);
+                if (ppsChild != NULL) {
+                    ppsRef = ppsChild;
+                    depth++;
+                    continue;
+                }
+                psNewEntry = symtableart_newEntry(pucKey + depth + 1, keyLength - depth, pvValue);
+                if (psNewEntry == NULL) return 0;
+                if (!symtableart_addChild(ppsRef, pucKey[depth], symtableart_leaf(psNewEntry))) {
+                    free(psNewEntry);
+                    return 0;
+                }
+                break;
+            }
+            oldKey = pucPrefix[common];
+        }
+
+        /* Split at the first differing byte */
+        psSplit = (struct Node4*)symtableart_newNode(NODE4, pucPrefix, common);
+        psNewEntry = symtableart_newEntry(pucKey + depth + common + 1, keyLength - depth - common, pvValue);
+        if (psSplit == NULL || psNewEntry == NULL) {
+            free(psSplit);
+            free(psNewEntry);
+            return 0;
+        }
+        if (symtableart_isLeaf(psNode)) {
+            /* The old leaf moves down past the shared bytes and its own
+               byte, which leave its suffix; if giving back the room
+               fails, it keeps the larger block */
+            struct SymTableEntry *psEntry = symtableart_entry(psNode);
+            struct SymTableEntry *psSmaller;
+            psEntry->suffixLength -= (uint32_t)(common + 1);
+            memmove(psEntry->aucSuffix, psEntry->aucSuffix + common + 1, psEntry->suffixLength);
+            psSmaller = (struct SymTableEntry*)realloc(psEntry, offsetof(struct SymTableEntry, aucSuffix) +
+                                                                psEntry->suffixLength);
+            if (psSmaller != NULL) psNode = symtableart_leaf(psSmaller);
+        } else {
+            /* The old node keeps what follows the differing byte */
+            psNode->prefixLength -= (uint32_t)(common + 1);
+            memmove(symtableart_prefix(psNode), pucPrefix + common + 1, psNode->prefixLength);
+        }
+        if (oldKey < pucKey[depth + common]) {
+            psSplit->aucKeys[0] = oldKey;
+            psSplit->apsChildren[0] = psNode;
+            psSplit->aucKeys[1] = pucKey[depth + common];
+            psSplit->apsChildren[1] = symtableart_leaf(psNewEntry);
+        } else {
+            psSplit->aucKeys[0] = pucKey[depth + common];
+            psSplit->apsChildren[0] = symtableart_leaf(psNewEntry);
+            psSplit->aucKeys[1] = oldKey;
+            psSplit->apsChildren[1] = psNode;
+        }
+        psSplit->sNode.count = 2;
+        *ppsRef = &psSplit->sNode;
+        break;
+    }
+
+    oSymTable->nodeQuantity++;
+    return 1;
+}
+
+/*
+ * Replaces the value of an existing key in the table.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `pcKey`: the key whose value we want to update
+ *   - `pvValue`: the new value to store
+ * Returns the old value, or NULL if the key doesn't exist.
+ */
+void *SymTable_replace(SymTable_T oSymTable, const char *pcKey, const void *pvValue) {
+    struct SymTableEntry *psEntry;
+    void *oldValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    psEntry = symtableart_find(oSymTable, pcKey);
+    if (psEntry == NULL) return NULL;
+    oldValue = (void*)psEntry->pvValue;
+    psEntry->pvValue = pvValue;
+    return oldValue;
+}
+
+/*
+ * Checks if a key exists in the table.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `pcKey`: the key to look for
+ * Returns 1 if the key is found, 0 if not.
+ */
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey) {
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    return symtableart_find(oSymTable, pcKey) != NULL;
+}
+
+/*
+ * Gets the value associated with a given key.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `pcKey`: the key to look for
+ * Returns the value if the key is found, NULL if not.
+ */
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey) {
+    struct SymTableEntry *psEntry;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    psEntry = symtableart_find(oSymTable, pcKey);
+    return psEntry != NULL ? (void*)psEntry->pvValue : NULL;
+}
+
+/*
+ * Removes a key-value pair from the table.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `pcKey`: the key to remove
+ * Nodes shrink into smaller kinds as they lose children, and a Node4
+ * left with one child gives way to it.
+ * Returns the value of the removed binding, or NULL if the key doesn't
+ * exist.
+ */
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey) {
+    struct SymTableEntry *psEntry;
+    void *oldValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    if (oSymTable->psRoot == NULL) return NULL;
+    psEntry = symtableart_removeFrom(&oSymTable->psRoot, pcKey, strlen(pcKey), 0);
+    if (psEntry == NULL) return NULL;
+
+    oldValue = (void*)psEntry->pvValue;
+    free(psEntry);
+    oSymTable->nodeQuantity--;
+    return oldValue;
+}
+
+/*
+ * SymTable_map:
+ * Applies the given function *pfApply to each key-value pair in the SymTable,
+ * in increasing order of keys.
+ * Parameters:
+ *   oSymTable - A pointer to the SymTable.
+ *   pfApply - A pointer to a function that takes three parameters:
+ *     - The key (const char *)
+ *     - The value (void *)
+ *     - An extra parameter provided by the caller (void *)
+ *   pvExtra - A pointer to the extra parameter that will be passed to *pfApply.
+ */
+void SymTable_map(SymTable_T oSymTable,
+                  void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+                  const void *pvExtra) {
+    char acStack[MAP_STACK_BYTES];
+    char *pcKey;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    if (oSymTable->psRoot == NULL) return;
+    pcKey = symtableart_getKeyBuffer(oSymTable, acStack);
+    symtableart_mapNode(oSymTable->psRoot, pcKey, 0, pfApply, pvExtra);
+    symtableart_freeKeyBuffer(oSymTable, pcKey, acStack);
+}
+
+/*
+ * Applies *pfApply to the bindings whose keys lie in [pcLow, pcHigh).
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `pcLow`, `pcHigh`: the ends of the range, NULL for an open end
+ *   - `pfApply`, `pvExtra`: as for SymTable_map
+ * Walks in order, but only into subtrees whose paths can lead to a key
+ * in the range.
+ */
+void SymTable_mapRange(SymTable_T oSymTable, const char *pcLow, const char *pcHigh,
+                       void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+                       const void *pvExtra) {
+    struct RangeQuery sQuery;
+    char acStack[MAP_STACK_BYTES];
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    if (oSymTable->psRoot == NULL) return;
+    sQuery.pucLow = (const unsigned char*)pcLow;
+    sQuery.pucHigh = (const unsigned char*)pcHigh;
+    sQuery.pcKey = symtableart_getKeyBuffer(oSymTable, acStack);
+    sQuery.pfApply = pfApply;
+    sQuery.pvExtra = pvExtra;
+    (void)symtableart_mapRangeNode(oSymTable->psRoot, 0, pcLow != NULL, pcHigh != NULL, &sQuery);
+    symtableart_freeKeyBuffer(oSymTable, sQuery.pcKey, acStack);
+}
+
+/*
+ * Applies *pfApply to the bindings whose keys begin with `pcPrefix`.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `pcPrefix`: the prefix
+ *   - `pfApply`, `pvExtra`: as for SymTable_map
+ * Follows the prefix down to the first node whose path covers it, and
+ * maps that node's whole subtree.
+ */
+void SymTable_mapPrefix(SymTable_T oSymTable, const char *pcPrefix,
+                        void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+                        const void *pvExtra) {
+    struct Node *psNode;
+    struct Node **ppsChild;
+    const unsigned char *pucPrefix = (const unsigned char*)pcPrefix;
+    char acStack[MAP_STACK_BYTES];
+    char *pcKey;
+    size_t prefixLength, depth = 0, i;
+
+    assert(oSymTable != NULL);
+    assert(pcPrefix != NULL);
+    assert(pfApply != NULL);
+
+    /* `depth` stays where psNode's path begins, so it never passes
+       the end of the prefix */
+    prefixLength = strlen(pcPrefix);
+    psNode = oSymTable->psRoot;
+    while (psNode != NULL && !symtableart_isLeaf(psNode) && depth < prefixLength) {
+        const unsigned char *pucNodePrefix = symtableart_prefix(psNode);
+        for (i = 0; i < psNode->prefixLength && depth + i < prefixLength; i++) {
+            if (pucNodePrefix[i] != pucPrefix[depth + i]) return;
+        }
+        if (depth + psNode->prefixLength >= prefixLength) break;
+        ppsChild = symtableart_findChild(psNode, pucPrefix[depth + psNode->prefixLength]);
+        if (ppsChild == NULL) return;
+        depth += psNode->prefixLength + 1;
+        psNode = *ppsChild;
+    }
+    if (psNode == NULL) return;
+    if (symtableart_isLeaf(psNode)) {
+        /* The suffix holds the key's '\0', which the prefix cannot
+           match, unless the prefix is already spent */
+        const struct SymTableEntry *psEntry = symtableart_entry(psNode);
+        if (psEntry->suffixLength < prefixLength - depth ||
+            memcmp(psEntry->aucSuffix, pucPrefix + depth, prefixLength - depth) != 0) {
+            return;
+        }
+    }
+    pcKey = symtableart_getKeyBuffer(oSymTable, acStack);
+    memcpy(pcKey, pcPrefix, depth);
+    symtableart_mapNode(psNode, pcKey, depth, pfApply, pvExtra);
+    symtableart_freeKeyBuffer(oSymTable, pcKey, acStack);
+}
@@ -0,0 +1,899 @@
+/*--------------------------------------------------------------------*/
+/* symtablebtree.c                                                    */
+/* B+tree with wide nodes: keys kept in strcmp order                  */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "symtable.h"
+#include "symtablebtree.h"
+#include "symtableeytzinger.h"
+#include "symtableordered.h"
+
+/*
+ * NODE_SLOTS: The most bindings in a leaf, and the most children of an
+ * inner node. A leaf's key prefixes then take four cache lines, of
+ * which a binary search reads at most five words, and a tree of a
+ * million bindings is four or five levels deep.
+ */
+#define NODE_SLOTS 32
+
+/*
+ * MIN_SLOTS: A node other than the root with this few bindings or
+ * children is refilled from a sibling before a remove descends into
+ * it, so that the remove can take one away. Two such nodes fit in one,
+ * which is what lets them merge.
+ */
+#define MIN_SLOTS (NODE_SLOTS / 2 - 1)
+
+/*
+ * PREFIX_BYTES: How many leading bytes of each key a node keeps next
+ * to its pointer. Comparing those as one integer settles most
+ * comparisons without following the pointer.
+ */
+#define PREFIX_BYTES 8
+
+/*
+ * SymTableEntry: One binding. The key is stored at the end of the
+ * entry's own allocation.
+ */
+struct SymTableEntry {
+    /* The value */
+    const void *pvValue;
+
+    /* The key's length */
+    size_t keyLength;
+
+    /* The key and its terminating '\0' */
+    char acKey[];
+};
+
+/*
+ * Node: What leaves and inner nodes begin with, so that a pointer to
+ * either can be told apart and then cast to the right one.
+ */
+struct Node {
+    /* 1 for a Leaf, 0 for an Inner */
+    unsigned int isLeaf;
+
+    /* Bindings in a leaf, children of an inner node */
+    unsigned int count;
+};
+
+/*
+ * Leaf: Up to NODE_SLOTS bindings in increasing order of keys, with
+ * the prefix of each key beside it. The leaves form a list in key
+ * order, which is what SymTable_map and range queries walk.
+ */
+struct Leaf {
+    struct Node sNode;
+
+    /* The first PREFIX_BYTES bytes of each key, big-endian and padded
+       with zeros, so that integer order is strcmp order */
+    uint64_t aPrefixes[NODE_SLOTS];
+
+    /* The bindings */
+    struct SymTableEntry *apsEntries[NODE_SLOTS];
+
+    /* The leaf with the next larger keys, or NULL */
+    struct Leaf *psNext;
+};
+
+/*
+ * Inner: Up to NODE_SLOTS children and the separators between them.
+ * Every key under child i is less than separator i, and every key under
+ * child i + 1 is at least separator i. A separator is a copy of a key
+ * owned by the node, so it stays valid when that key is removed.
+ */
+struct Inner {
+    struct Node sNode;
+
+    /* The prefixes of the separators */
+    uint64_t aPrefixes[NODE_SLOTS - 1];
+
+    /* The separators, `count` - 1 of them */
+    char *apcSeparators[NODE_SLOTS - 1];
+
+    /* The children */
+    struct Node *apsChildren[NODE_SLOTS];
+};
+
+/*
+ * SymTable: A B+tree. Every leaf is at the same depth.
+ */
+struct SymTable {
+    /* A Leaf while the table fits in one, an Inner after; NULL once
+       the table is frozen */
+    struct Node *psRoot;
+
+    /* NULL until SymTable_freeze; then every binding lives here */
+    SymTableEytzinger_T oFrozen;
+
+    /* Total number of bindings in the table */
+    size_t nodeQuantity;
+};
+
+/*
+ * SearchKey: A key being looked for, with its length and prefix worked
+ * out once for the whole descent.
+ */
+struct SearchKey {
+    const char *pcKey;
+    size_t keyLength;
+    uint64_t prefix;
+};
+
+/*
+ * Gives the prefix of a key: its first PREFIX_BYTES bytes as a
+ * big-endian integer, with zeros past its end.
+ */
+static uint64_t symtablebtree_prefix(const char *pcKey, size_t keyLength) {
+    uint64_t prefix = 0;
+    size_t i;
+
+    for (i = 0; i < PREFIX_BYTES; i++) {
+        prefix = (prefix << 8) | (i < keyLength ? (unsigned char)pcKey[i] : 0);
+    }
+    return prefix;
+}
+
+/*
+ * Fills in a SearchKey for `pcKey`.
+ */
+static void symtablebtree_makeKey(struct SearchKey *psKey, const char *pcKey) {
+    psKey->pcKey = pcKey;
+    psKey->keyLength = strlen(pcKey);
+    psKey->prefix = symtablebtree_prefix(pcKey, psKey->keyLength);
+}
+
+/*
+ * Compares a key being looked for with a stored key whose prefix is
+ * `prefix`, in the order of strcmp.
+ * Returns a negative number, zero or a positive number as the key is
+ * less than, equal to or greater than `pcOther`. Keys hold no '\0', so
+ * equal prefixes mean the same length if either key is shorter than a
+ * prefix, and otherwise only the bytes past the prefix remain.
+ */
+static int symtablebtree_compare(const struct SearchKey *psKey, uint64_t prefix, const char *pcOther) {
+    if (psKey->prefix != prefix) return psKey->prefix < prefix ? -1 : 1;
+    if (psKey->keyLength < PREFIX_BYTES) return 0;
+    return strcmp(psKey->pcKey + PREFIX_BYTES, pcOther + PREFIX_BYTES);
+}
+
+/*
+ * Gives the index of the first binding of a leaf whose key is at least
+ * the key being looked for, or the leaf's count if there is none.
+ */
+static unsigned int symtablebtree_lowerBound(const struct Leaf *psLeaf, const struct SearchKey *psKey) {
+    unsigned int low = 0, high = psLeaf->sNode.count, middle;
+
+    while (low < high) {
+        middle = (low + high) / 2;
+        if (symtablebtree_compare(psKey, psLeaf->aPrefixes[middle], psLeaf->apsEntries[middle]->acKey) > 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+/*
+ * Gives the index of the child of an inner node under which the key
+ * being looked for belongs: the number of separators not greater than
+ * the key.
+ */
+static unsigned int symtablebtree_childIndex(const struct Inner *psInner, const struct SearchKey *psKey) {
+    unsigned int low = 0, high = psInner->sNode.count - 1, middle;
+
+    while (low < high) {
+        middle = (low + high) / 2;
+        if (symtablebtree_compare(psKey, psInner->aPrefixes[middle], psInner->apcSeparators[middle]) >= 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+/*
+ * Gives the leaf under which the key being looked for belongs.
+ */
+static struct Leaf *symtablebtree_findLeaf(SymTable_T oSymTable, const struct SearchKey *psKey) {
+    struct Node *psNode = oSymTable->psRoot;
+
+    while (!psNode->isLeaf) {
+        const struct Inner *psInner = (const struct Inner*)psNode;
+        psNode = psInner->apsChildren[symtablebtree_childIndex(psInner, psKey)];
+    }
+    return (struct Leaf*)psNode;
+}
+
+/*
+ * Finds the entry that holds a key.
+ * Returns the entry, or NULL if the table has no such key.
+ */
+static struct SymTableEntry *symtablebtree_find(SymTable_T oSymTable, const char *pcKey) {
+    struct SearchKey sKey;
+    struct Leaf *psLeaf;
+    unsigned int i;
+
+    symtablebtree_makeKey(&sKey, pcKey);
+    psLeaf = symtablebtree_findLeaf(oSymTable, &sKey);
+    i = symtablebtree_lowerBound(psLeaf, &sKey);
+    if (i < psLeaf->sNode.count &&
+        symtablebtree_compare(&sKey, psLeaf->aPrefixes[i], psLeaf->apsEntries[i]->acKey) == 0) {
+        return psLeaf->apsEntries[i];
+    }
+    return NULL;
+}
+
+/*
+ * Allocates an empty leaf, or an empty inner node if `isLeaf` is 0.
+ * Returns NULL if memory is insufficient.
+ */
+static struct Node *symtablebtree_newNode(unsigned int isLeaf) {
+    struct Node *psNode;
+
+    if (isLeaf) {
+        struct Leaf *psLeaf = (struct Leaf*)malloc(sizeof(struct Leaf));
+        if (psLeaf == NULL) return NULL;
+        psLeaf->psNext = NULL;
+        psNode = &psLeaf->sNode;
+    } else {
+        struct Inner *psInner = (struct Inner*)malloc(sizeof(struct Inner));
+        if (psInner == NULL) return NULL;
+        psNode = &psInner->sNode;
+    }
+    psNode->isLeaf = isLeaf;
+    psNode->count = 0;
+    return psNode;
+}
+
+/*
+ * Copies the key of an entry, to serve as a separator.
+ * Returns the copy, or NULL if memory is insufficient.
+ */
+static char *symtablebtree_copyKey(const struct SymTableEntry *psEntry) {
+    char *pcCopy = (char*)malloc(psEntry->keyLength + 1);
+
+    if (pcCopy != NULL) memcpy(pcCopy, psEntry->acKey, psEntry->keyLength + 1);
+    return pcCopy;
+}
+
+/*
+ * Splits the full child `c` of an inner node that has room for one more
+ * child. The upper half of the child moves to a new right sibling. A
+ * leaf's split copies the right half's first key up as the separator;
+ * an inner node's split moves its middle separator up instead.
+ * Returns 1 on success, or 0 if memory is insufficient, in which case
+ * nothing changes.
+ */
+static int symtablebtree_splitChild(struct Inner *psParent, unsigned int c) {
+    struct Node *psChild = psParent->apsChildren[c];
+    struct Node *psRight;
+    unsigned int half = NODE_SLOTS / 2;
+    unsigned int count = psChild->count;
+    char *pcSeparator;
+    uint64_t prefix;
+
+    psRight = symtablebtree_newNode(psChild->isLeaf);
+    if (psRight == NULL) return 0;
+
+    if (psChild->isLeaf) {
+        struct Leaf *psLeft = (struct Leaf*)psChild;
+        struct Leaf *psNewLeaf = (struct Leaf*)psRight;
+
+        pcSeparator = symtablebtree_copyKey(psLeft->apsEntries[half]);
+        if (pcSeparator == NULL) {
+            free(psNewLeaf);
+            return 0;
+        }
+        prefix = psLeft->aPrefixes[half];
+        memcpy(psNewLeaf->aPrefixes, psLeft->aPrefixes + half, (count - half) * sizeof(uint64_t));
+        memcpy(psNewLeaf->apsEntries, psLeft->apsEntries + half, (count - half) * sizeof(struct SymTableEntry*));
+        psNewLeaf->psNext = psLeft->psNext;
+        psLeft->psNext = psNewLeaf;
+    } else {
+        struct Inner *psLeft = (struct Inner*)psChild;
+        struct Inner *psNewInner = (struct Inner*)psRight;
+
+        /* Children [half, count) move right, and the separator between
+           the halves moves up */
+        pcSeparator = psLeft->apcSeparators[half - 1];
+        prefix = psLeft->aPrefixes[half - 1];
+        memcpy(psNewInner->apsChildren, psLeft->apsChildren + half, (count - half) * sizeof(struct Node*));
+        memcpy(psNewInner->apcSeparators, psLeft->apcSeparators + half, (count - 1 - half) * sizeof(char*));
+        memcpy(psNewInner->aPrefixes, psLeft->aPrefixes + half, (count - 1 - half) * sizeof(uint64_t));
+    }
+    psRight->count = count - half;
+    psChild->count = half;
+
+    /* The separator goes in at `c`, the new child right after it */
+    memmove(psParent->apcSeparators + c + 1, psParent->apcSeparators + c,
+            (psParent->sNode.count - 1 - c) * sizeof(char*));
+    memmove(psParent->aPrefixes + c + 1, psParent->aPrefixes + c,
+            (psParent->sNode.count - 1 - c) * sizeof(uint64_t));
+    memmove(psParent->apsChildren + c + 2, psParent->apsChildren + c + 1,
+            (psParent->sNode.count - 1 - c) * sizeof(struct Node*));
+    psParent->apcSeparators[c] = pcSeparator;
+    psParent->aPrefixes[c] = prefix;
+    psParent->apsChildren[c + 1] = psRight;
+    psParent->sNode.count++;
+    return 1;
+}
+
+/*
+ * Moves the last binding or child of child `c` - 1 to the front of
+ * child `c`. For leaves, the moved key becomes the separator between
+ * them; for inner nodes, the separators rotate through the parent.
+ * Returns 1 on success, or 0 if memory for the leaves' new separator
+ * is insufficient, in which case nothing changes.
+ */
+static int symtablebtree_borrowFromLeft(struct Inner *psParent, unsigned int c) {
+    struct Node *psLeftNode = psParent->apsChildren[c - 1];
+    struct Node *psChildNode = psParent->apsChildren[c];
+    unsigned int last = psLeftNode->count - 1;
+
+    if (psChildNode->isLeaf) {
+        struct Leaf *psLeft = (struct Leaf*)psLeftNode;
+        struct Leaf *psChild = (struct Leaf*)psChildNode;
+        char *pcSeparator = symtablebtree_copyKey(psLeft->apsEntries[last]);
+
+        if (pcSeparator == NULL) return 0;
+        memmove(psChild->aPrefixes + 1, psChild->aPrefixes, psChildNode->count * sizeof(uint64_t));
+        memmove(psChild->apsEntries + 1, psChild->apsEntries, psChildNode->count * sizeof(struct SymTableEntry*));
+        psChild->aPrefixes[0] = psLeft->aPrefixes[last];
+        psChild->apsEntries[0] = psLeft->apsEntries[last];
+        free(psParent->apcSeparators[c - 1]);
+        psParent->apcSeparators[c - 1] = pcSeparator;
+        psParent->aPrefixes[c - 1] = psChild->aPrefixes[0];
+    } else {
+        struct Inner *psLeft = (struct Inner*)psLeftNode;
+        struct Inner *psChild = (struct Inner*)psChildNode;
+
+        memmove(psChild->apcSeparators + 1, psChild->apcSeparators, (psChildNode->count - 1) * sizeof(char*));
+        memmove(psChild->aPrefixes + 1, psChild->aPrefixes, (psChildNode->count - 1) * sizeof(uint64_t));
+        memmove(psChild->apsChildren + 1, psChild->apsChildren, psChildNode->count * sizeof(struct Node*));
+        psChild->apsChildren[0] = psLeft->apsChildren[last];
+        psChild->apcSeparators[0] = psParent->apcSeparators[c - 1];
+        psChild->aPrefixes[0] = psParent->aPrefixes[c - 1];
+        psParent->apcSeparators[c - 1] = psLeft->apcSeparators[last - 1];
+        psParent->aPrefixes[c - 1] = psLeft->aPrefixes[last - 1];
+    }
+    psLeftNode->count--;
+    psChildNode->count++;
+    return 1;
+}
+
+/*
+ * Moves the first binding or child of child `c` + 1 to the end of
+ * child `c`, the mirror image of symtablebtree_borrowFromLeft.
+ * Returns 1 on success, or 0 if memory for the leaves' new separator
+ * is insufficient, in which case nothing changes.
+ */
+static int symtablebtree_borrowFromRight(struct Inner *psParent, unsigned int c) {
+    struct Node *psChildNode = psParent->apsChildren[c];
+    struct Node *psRightNode = psParent->apsChildren[c + 1];
+    unsigned int end = psChildNode->count;
+
+    if (psChildNode->isLeaf) {
+        struct Leaf *psChild = (struct Leaf*)psChildNode;
+        struct Leaf *psRight = (struct Leaf*)psRightNode;
+        char *pcSeparator = symtablebtree_copyKey(psRight->apsEntries[1]);
+
+        if (pcSeparator == NULL) return 0;
+        psChild->aPrefixes[end] = psRight->aPrefixes[0];
+        psChild->apsEntries[end] = psRight->apsEntries[0];
+        memmove(psRight->aPrefixes, psRight->aPrefixes + 1, (psRightNode->count - 1) * sizeof(uint64_t));
+        memmove(psRight->apsEntries, psRight->apsEntries + 1,
+                (psRightNode->count - 1) * sizeof(struct SymTableEntry*));
+        free(psParent->apcSeparators[c]);
+        psParent->apcSeparators[c] = pcSeparator;
+        psParent->aPrefixes[c] = psRight->aPrefixes[0];
+    } else {
+        struct Inner *psChild = (struct Inner*)psChildNode;
+        struct Inner *psRight = (struct Inner*)psRightNode;
+
+        psChild->apsChildren[end] = psRight->apsChildren[0];
+        psChild->apcSeparators[end - 1] = psParent->apcSeparators[c];
+        psChild->aPrefixes[end - 1] = psParent->aPrefixes[c];
+        psParent->apcSeparators[c] = psRight->apcSeparators[0];
+        psParent->aPrefixes[c] = psRight->aPrefixes[0];
+        memmove(psRight->apcSeparators, psRight->apcSeparators + 1, (psRightNode->count - 2) * sizeof(char*));
+        memmove(psRight->aPrefixes, psRight->aPrefixes + 1, (psRightNode->count - 2) * sizeof(uint64_t));
+        memmove(psRight->apsChildren, psRight->apsChildren + 1, (psRightNode->count - 1) * sizeof(struct Node*));
+    }
+    psRightNode->count--;
+    psChildNode->count++;
+    return 1;
+}
+
+/*
+ * Merges child `c` + 1 into child `c` and removes it and the separator
+ * between them from the parent. Leaves drop that separator; inner
+ * nodes take it down between their two halves.
+ */
+static void symtablebtree_merge(struct Inner *psParent, unsigned int c) {
+    struct Node *psChildNode = psParent->apsChildren[c];
+    struct Node *psRightNode = psParent->apsChildren[c + 1];
+    unsigned int end = psChildNode->count;
+
+    if (psChildNode->isLeaf) {
+        struct Leaf *psChild = (struct Leaf*)psChildNode;
+        struct Leaf *psRight = (struct Leaf*)psRightNode;
+
+        memcpy(psChild->aPrefixes + end, psRight->aPrefixes, psRightNode->count * sizeof(uint64_t));
+        memcpy(psChild->apsEntries + end, psRight->apsEntries, psRightNode->count * sizeof(struct SymTableEntry*));
+        psChild->psNext = psRight->psNext;
+        free(psParent->apcSeparators[c]);
+    } else {
+        struct Inner *psChild = (struct Inner*)psChildNode;
+        struct Inner *psRight = (struct Inner*)psRightNode;
+
+        psChild->apcSeparators[end - 1] = psParent->apcSeparators[c];
+        psChild->aPrefixes[end - 1] = psParent->aPrefixes[c];
+        memcpy(psChild->apcSeparators + end, psRight->apcSeparators, (psRightNode->count - 1) * sizeof(char*));
+        memcpy(psChild->aPrefixes + end, psRight->aPrefixes, (psRightNode->count - 1) * sizeof(uint64_t));
+        memcpy(psChild->apsChildren + end, psRight->apsChildren, psRightNode->count * sizeof(struct Node*));
+    }
+    psChildNode->count += psRightNode->count;
+    free(psRightNode);
+
+    memmove(psParent->apcSeparators + c, psParent->apcSeparators + c + 1,
+            (psParent->sNode.count - 2 - c) * sizeof(char*));
+    memmove(psParent->aPrefixes + c, psParent->aPrefixes + c + 1,
+            (psParent->sNode.count - 2 - c) * sizeof(uint64_t));
+    memmove(psParent->apsChildren + c + 1, psParent->apsChildren + c + 2,
+            (psParent->sNode.count - 2 - c) * sizeof(struct Node*));
+    psParent->sNode.count--;
+}
+
+/*
+ * Gives child `c` of an inner node, which has MIN_SLOTS bindings or
+ * children or fewer, at least one more: borrowed from a sibling that
+ * can spare one, or else by merging with a sibling. The left sibling
+ * is tried first.
+ * Returns the index of the child that now holds what child `c` held. If
+ * memory for a borrowed leaf separator is insufficient, the child is
+ * left as it was; the tree stays valid, just less full.
+ */
+static unsigned int symtablebtree_refill(struct Inner *psParent, unsigned int c) {
+    if (c > 0) {
+        if (psParent->apsChildren[c - 1]->count > MIN_SLOTS) {
+            (void)symtablebtree_borrowFromLeft(psParent, c);
+            return c;
+        }
+        symtablebtree_merge(psParent, c - 1);
+        return c - 1;
+    }
+    if (psParent->apsChildren[c + 1]->count > MIN_SLOTS) {
+        (void)symtablebtree_borrowFromRight(psParent, c);
+        return c;
+    }
+    symtablebtree_merge(psParent, c);
+    return c;
+}
+
+/*
+ * Frees a subtree: its entries, separators and nodes.
+ */
+static void symtablebtree_freeNode(struct Node *psNode) {
+    unsigned int i;
+
+    if (psNode->isLeaf) {
+        struct Leaf *psLeaf = (struct Leaf*)psNode;
+        for (i = 0; i < psNode->count; i++) {
+            free(psLeaf->apsEntries[i]);
+        }
+    } else {
+        struct Inner *psInner = (struct Inner*)psNode;
+        for (i = 0; i < psNode->count; i++) {
+            if (i > 0) free(psInner->apcSeparators[i - 1]);
+            symtablebtree_freeNode(psInner->apsChildren[i]);
+        }
+    }
+    free(psNode);
+}
+
+/* Sets up a new, empty symbol table: a tree of one empty leaf.
+   Returns a pointer to the table or NULL if there's an allocation
+   issue. */
+SymTable_T SymTable_new(void) {
+    SymTable_T oSymTable;
+
+    oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+    if (oSymTable == NULL) return NULL;
+
+    oSymTable->psRoot = symtablebtree_newNode(1);
+    if (oSymTable->psRoot == NULL) {
+        free(oSymTable);
+        return NULL;
+    }
+    oSymTable->oFrozen = NULL;
+    oSymTable->nodeQuantity = 0;
+    return oSymTable;
+}
+
+/* Returns the number of bindings in the table.
+   Arguments -> `oSymTable`: the symbol table */
+size_t SymTable_getLength(SymTable_T oSymTable) {
+    assert(oSymTable != NULL);
+    return oSymTable->nodeQuantity;
+}
+
+/* Releases every entry, separator and node, and the table.
+   Arguments -> `oSymTable`: the symbol table to be freed */
+void SymTable_free(SymTable_T oSymTable) {
+    assert(oSymTable != NULL);
+
+    if (oSymTable->oFrozen != NULL) {
+        SymTableEytzinger_free(oSymTable->oFrozen);
+    } else {
+        symtablebtree_freeNode(oSymTable->psRoot);
+    }
+    free(oSymTable);
+}
+
+/*
+ * Adds a new key-value pair to the symbol table if the key doesn't already exist.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `pcKey`: string key to add
+ *   - `pvValue`: the value associated with `pcKey`
+ * Splits every full node on the way down, the root included, so that
+ * the leaf has room and a split never has to climb back up. A split
+ * that runs out of memory leaves a valid tree behind.
+ * Returns 1 on success, 0 on failure, if the key exists or if the
+ * table is frozen.
+ */
+int SymTable_put(SymTable_T oSymTable, const char *pcKey, const void *pvValue) {
+    struct SearchKey sKey;
+    struct SymTableEntry *psNewEntry;
+    struct Node *psNode;
+    struct Leaf *psLeaf;
+    unsigned int c, i;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    if (oSymTable->oFrozen != NULL) return 0;
+
+    symtablebtree_makeKey(&sKey, pcKey);
+
+    /* A full root gets a new root above it, then splits like any
+       other full child */
+    if (oSymTable->psRoot->count == NODE_SLOTS) {
+        struct Inner *psNewRoot = (struct Inner*)symtablebtree_newNode(0);
+        if (psNewRoot == NULL) return 0;
+        psNewRoot->apsChildren[0] = oSymTable->psRoot;
+        psNewRoot->sNode.count = 1;
+        if (!symtablebtree_splitChild(psNewRoot, 0)) {
+            free(psNewRoot);
+            return 0;
+        }
+        oSymTable->psRoot = &psNewRoot->sNode;
+    }
+
+    psNode = oSymTable->psRoot;
+    while (!psNode->isLeaf) {
+        struct Inner *psInner = (struct Inner*)psNode;
+        c = symtablebtree_childIndex(psInner, &sKey);
+        if (psInner->apsChildren[c]->count == NODE_SLOTS) {
+            if (!symtablebtree_splitChild(psInner, c)) return 0;
+            if (symtablebtree_compare(&sKey, psInner->aPrefixes[c], psInner->apcSeparators[c]) >= 0) c++;
+        }
+        psNode = psInner->apsChildren[c];
+    }
+
+    psLeaf = (struct Leaf*)psNode;
+    i = symtablebtree_lowerBound(psLeaf, &sKey);
+    if (i < psNode->count &&
+        symtablebtree_compare(&sKey, psLeaf->aPrefixes[i], psLeaf->apsEntries[i]->acKey) == 0) {
+        return 0;
+    }
+
+    psNewEntry = (struct SymTableEntry*)malloc(sizeof(struct SymTableEntry) + sKey.keyLength + 1);
+    if (psNewEntry == NULL) return 0;
+    memcpy(psNewEntry->acKey, pcKey, sKey.keyLength + 1);
+    psNewEntry->keyLength = sKey.keyLength;
+    psNewEntry->pvValue = pvValue;
+
+    memmove(psLeaf->aPrefixes + i + 1, psLeaf->aPrefixes + i, (psNode->count - i) * sizeof(uint64_t));
+    memmove(psLeaf->apsEntries + i + 1, psLeaf->apsEntries + i,
+            (psNode->count - i) * sizeof(struct SymTableEntry*));
+    psLeaf->aPrefixes[i] = sKey.prefix;
+    psLeaf->apsEntries[i] = psNewEntry;
+    psNode->count++;
+    oSymTable->nodeQuantity++;
+    return 1;
+}
+
+/*
+ * Replaces the value of an existing key in the table.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `pcKey`: the key whose value we want to update
+ *   - `pvValue`: the new value to store
+ * Returns the old value, or NULL if the key doesn't exist or the table
+ * is frozen.
+ */
+void *SymTable_replace(SymTable_T oSymTable, const char *pcKey, const void *pvValue) {
+    struct SymTableEntry *psEntry;
+    void *oldValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    if (oSymTable->oFrozen != NULL) return NULL;
+    psEntry = symtablebtree_find(oSymTable, pcKey);
+    if (psEntry == NULL) return NULL;
+    oldValue = (void*)psEntry->pvValue;
+    psEntry->pvValue = pvValue;
+    return oldValue;
+}
+
+/*
+ * Checks if a key exists in the table.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `pcKey`: the key to look for
+ * Returns 1 if the key is found, 0 if not.
+ */
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey) {
+    void *pvValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    if (oSymTable->oFrozen != NULL) {
+        return SymTableEytzinger_find(oSymTable->oFrozen, pcKey, strlen(pcKey), &pvValue);
+    }
+    return symtablebtree_find(oSymTable, pcKey) != NULL;
+}
+
+/*
+ * Gets the value associated with a given key.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `pcKey`: the key to look for
+ * Returns the value if the key is found, NULL if not.
+ */
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey) {
+    struct SymTableEntry *psEntry;
+    void *pvValue = NULL;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    if (oSymTable->oFrozen != NULL) {
+        (void)SymTableEytzinger_find(oSymTable->oFrozen, pcKey, strlen(pcKey), &pvValue);
+        return pvValue;
+    }
+    psEntry = symtablebtree_find(oSymTable, pcKey);
+    return psEntry != NULL ? (void*)psEntry->pvValue : NULL;
+}
+
+/*
+ * Removes a key-value pair from the table.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `pcKey`: the key to remove
+ * Refills every node with MIN_SLOTS bindings or children on the way
+ * down, so that the leaf can lose one without the tree going out of
+ * balance. A root left with a single child is replaced by it.
+ * Returns the value of the removed binding, or NULL if the key doesn't
+ * exist or the table is frozen.
+ */
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey) {
+    struct SearchKey sKey;
+    struct Node *psNode;
+    struct Leaf *psLeaf;
+    void *oldValue;
+    unsigned int c, i;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    if (oSymTable->oFrozen != NULL) return NULL;
+
+    symtablebtree_makeKey(&sKey, pcKey);
+
+    psNode = oSymTable->psRoot;
+    while (!psNode->isLeaf) {
+        struct Inner *psInner = (struct Inner*)psNode;
+        c = symtablebtree_childIndex(psInner, &sKey);
+        if (psInner->apsChildren[c]->count <= MIN_SLOTS) {
+            c = symtablebtree_refill(psInner, c);
+        }
+        psNode = psInner->apsChildren[c];
+        if (psInner->sNode.count == 1) {
+            /* Only the root can lose all but one child */
+            assert(&psInner->sNode == oSymTable->psRoot);
+            oSymTable->psRoot = psNode;
+            free(psInner);
+        }
+    }
+
+    psLeaf = (struct Leaf*)psNode;
+    i = symtablebtree_lowerBound(psLeaf, &sKey);
+    if (i == psNode->count ||
+        symtablebtree_compare(&sKey, psLeaf->aPrefixes[i], psLeaf->apsEntries[i]->acKey) != 0) {
+        return NULL;
+    }
+
+    oldValue = (void*)psLeaf->apsEntries[i]->pvValue;
+    free(psLeaf->apsEntries[i]);
+    memmove(psLeaf->aPrefixes + i, psLeaf->aPrefixes + i + 1, (psNode->count - 1 - i) * sizeof(uint64_t));
+    memmove(psLeaf->apsEntries + i, psLeaf->apsEntries + i + 1,
+            (psNode->count - 1 - i) * sizeof(struct SymTableEntry*));
+    psNode->count--;
+    oSymTable->nodeQuantity--;
+    return oldValue;
+}
+
+/*
+ * SymTable_map:
+ * Applies the given function *pfApply to each key-value pair in the SymTable,
+ * in increasing order of keys.
+ * Parameters:
+ *   oSymTable - A pointer to the SymTable.
+ *   pfApply - A pointer to a function that takes three parameters:
+ *     - The key (const char *)
+ *     - The value (void *)
+ *     - An extra parameter provided by the caller (void *)
+ *   pvExtra - A pointer to the extra parameter that will be passed to *pfApply.
+ */
+void SymTable_map(SymTable_T oSymTable,
+                  void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+                  const void *pvExtra) {
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    SymTable_mapRange(oSymTable, NULL, NULL, pfApply, pvExtra);
+}
+
+/*
+ * Applies *pfApply to the bindings whose keys lie in [pcLow, pcHigh).
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `pcLow`, `pcHigh`: the ends of the range, NULL for an open end
+ *   - `pfApply`, `pvExtra`: as for SymTable_map
+ * Descends once to the first key at least `pcLow`, then walks the leaf
+ * list until a key reaches `pcHigh`.
+ */
+void SymTable_mapRange(SymTable_T oSymTable, const char *pcLow, const char *pcHigh,
+                       void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+                       const void *pvExtra) {
+    struct SearchKey sLow;
+    struct SearchKey sHigh = {NULL, 0, 0};
+    const struct Leaf *psLeaf;
+    unsigned int i = 0;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    if (oSymTable->oFrozen != NULL) {
+        SymTableEytzinger_mapRange(oSymTable->oFrozen, pcLow, pcHigh, pfApply, pvExtra);
+        return;
+    }
+
+    if (pcLow != NULL) {
+        symtablebtree_makeKey(&sLow, pcLow);
+        psLeaf = symtablebtree_findLeaf(oSymTable, &sLow);
+        i = symtablebtree_lowerBound(psLeaf, &sLow);
+    } else {
+        const struct Node *psNode = oSymTable->psRoot;
+        while (!psNode->isLeaf) {
+            psNode = ((const struct Inner*)psNode)->apsChildren[0];
+        }
+        psLeaf = (const struct Leaf*)psNode;
+    }
+    if (pcHigh != NULL) symtablebtree_makeKey(&sHigh, pcHigh);
+
+    for (; psLeaf != NULL; psLeaf = psLeaf->psNext, i = 0) {
+        for (; i < psLeaf->sNode.count; i++) {
+            const struct SymTableEntry *psEntry = psLeaf->apsEntries[i];
+            if (pcHigh != NULL && symtablebtree_compare(&sHigh, psLeaf->aPrefixes[i], psEntry->acKey) <= 0) {
+                return;
+            }
+            (*pfApply)(psEntry->acKey, (void*)psEntry->pvValue, (void*)pvExtra);
+        }
+    }
+}
+
+/*
+ * Applies *pfApply to the bindings whose keys begin with `pcPrefix`.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `pcPrefix`: the prefix
+ *   - `pfApply`, `pvExtra`: as for SymTable_map
+ * The keys with a prefix are contiguous in key order and start at the
+ * prefix itself, so this walks from there until a key lacks it.
+ */
+void SymTable_mapPrefix(SymTable_T oSymTable, const char *pcPrefix,
+                        void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+                        const void *pvExtra) {
+    struct SearchKey sPrefix;
+    const struct Leaf *psLeaf;
+    unsigned int i;
+
+    assert(oSymTable != NULL);
+    assert(pcPrefix != NULL);
+    assert(pfApply != NULL);
+
+    if (oSymTable->oFrozen != NULL) {
+        SymTableEytzinger_mapPrefix(oSymTable->oFrozen, pcPrefix, pfApply, pvExtra);
+        return;
+    }
+
+    symtablebtree_makeKey(&sPrefix, pcPrefix);
+    psLeaf = symtablebtree_findLeaf(oSymTable, &sPrefix);
+    i = symtablebtree_lowerBound(psLeaf, &sPrefix);
+
+    for (; psLeaf != NULL; psLeaf = psLeaf->psNext, i = 0) {
+        for (; i < psLeaf->sNode.count; i++) {
+            const struct SymTableEntry *psEntry = psLeaf->apsEntries[i];
+            if (psEntry->keyLength < sPrefix.keyLength ||
+                memcmp(psEntry->acKey, pcPrefix, sPrefix.keyLength) != 0) {
+                return;
+            }
+            (*pfApply)(psEntry->acKey, (void*)psEntry->pvValue, (void*)pvExtra);
+        }
+    }
+}
+
+/*
+ * Turns the table into its immutable form.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ * Walks the leaf list to collect the bindings in key order, lays them
+ * out in Eytzinger order, then frees the tree.
+ * Returns 1 on success, or 0 if memory is insufficient, in which case
+ * the table is unchanged and still mutable.
+ */
+int SymTable_freeze(SymTable_T oSymTable) {
+    const char **apcKeys;
+    const void **apvValues;
+    const struct Node *psNode;
+    const struct Leaf *psLeaf;
+    size_t count = 0;
+    unsigned int i;
+
+    assert(oSymTable != NULL);
+
+    if (oSymTable->oFrozen != NULL) return 1;
+
+    apcKeys = (const char**)malloc((oSymTable->nodeQuantity + 1) * sizeof(const char*));
+    apvValues = (const void**)malloc((oSymTable->nodeQuantity + 1) * sizeof(const void*));
+    if (apcKeys == NULL || apvValues == NULL) {
+        free(apcKeys);
+        free(apvValues);
+        return 0;
+    }
+    for (psNode = oSymTable->psRoot; !psNode->isLeaf;) {
+        psNode = ((const struct Inner*)psNode)->apsChildren[0];
+    }
+    for (psLeaf = (const struct Leaf*)psNode; psLeaf != NULL; psLeaf = psLeaf->psNext) {
+        for (i = 0; i < psLeaf->sNode.count; i++) {
+            apcKeys[count] = psLeaf->apsEntries[i]->acKey;
+            apvValues[count] = psLeaf->apsEntries[i]->pvValue;
+            count++;
+        }
+    }
+    assert(count == oSymTable->nodeQuantity);
+
+    /* The arrays copy the keys, so the tree can go once they exist */
+    oSymTable->oFrozen = SymTableEytzinger_new(apcKeys, apvValues, count);
+    free(apcKeys);
+    free(apvValues);
+    if (oSymTable->oFrozen == NULL) return 0;
+
+    symtablebtree_freeNode(oSymTable->psRoot);
+    oSymTable->psRoot = NULL;
+    return 1;
+}
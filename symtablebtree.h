@@ -0,0 +1,28 @@
+/*--------------------------------------------------------------------*/
+/* symtablebtree.h                                                    */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#ifndef SymTableBTree_INCLUDED
+#define SymTableBTree_INCLUDED
+#include "symtable.h"
+#include "symtableordered.h"
+
+/* Extensions to the SymTable ADT that only the B+tree implementation
+(symtablebtree.c) provides. */
+
+/* Makes oSymTable immutable, for ordered tables that are filled once
+and then only read. Its bindings move into sorted flat arrays in
+Eytzinger order (see symtableeytzinger.h): a lookup is a branch-free
+binary search over packed key prefixes, and the table keeps no node,
+entry or separator per binding. From then on SymTable_put,
+SymTable_replace and SymTable_remove change nothing and report failure
+as for an absent or present key: 0, NULL and NULL. Lookups,
+SymTable_map, SymTable_mapRange, SymTable_mapPrefix and
+SymTable_getLength work as before, in the same order. Returns 1 (TRUE)
+on success, or if oSymTable was already frozen. Returns 0 (FALSE) if
+memory is insufficient, leaving oSymTable unchanged and mutable. */
+
+int SymTable_freeze(SymTable_T oSymTable);
+
+#endif
@@ -0,0 +1,586 @@
+/*--------------------------------------------------------------------*/
+/* symtablecuckoo.c                                                   */
+/* Bucketized cuckoo hash table: every lookup probes two buckets      */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include "symtable.h"
+#include "symtablecuckoo.h"
+#include "symtablehashfn.h"
+
+/*
+ * SLOTS_PER_BUCKET: Entries per bucket. Four 16-byte slots fill one
+ * 64-byte cache line, so a probe of a bucket is a single cache miss.
+ */
+#define SLOTS_PER_BUCKET 4
+
+/*
+ * INITIAL_BUCKET_COUNT: Buckets in a new table. The count is always a
+ * power of two so that a bucket index is a mask of the hash.
+ */
+#define INITIAL_BUCKET_COUNT 128
+
+/*
+ * MAX_LOAD_FACTOR: The fraction of slots that may be full before a put
+ * doubles the table. Four-way buckets fill to about 95% before
+ * displacement walks start failing; staying below that keeps the walks
+ * short.
+ */
+#define MAX_LOAD_FACTOR 0.9
+
+/*
+ * MAX_DISPLACEMENTS: How many entries a put may move to their other
+ * bucket before it gives up and stashes the entry left without a slot.
+ * The walk is undone if the stash is full.
+ */
+#define MAX_DISPLACEMENTS 256
+
+/*
+ * STASH_SIZE: Entries kept outside the buckets. A lookup scans the
+ * stash only when it is not empty, which with a good seed is almost
+ * never, and never scans more than STASH_SIZE entries: a put that
+ * would need more rebuilds the table under a new seed, or fails.
+ */
+#define STASH_SIZE 8
+
+/*
+ * SEEDS_PER_SIZE: How many new seeds a rebuild tries at one size before
+ * it doubles the table.
+ */
+#define SEEDS_PER_SIZE 4
+
+/*
+ * MAX_REBUILD_SEEDS: How many seeds one rebuild tries in all, so at
+ * most four times the size it started with. Keys that share their
+ * whole hash under every seed would otherwise double the table until
+ * memory ran out; no more of them fit than two buckets and the stash
+ * hold. A table that did not choose its hash function moves to SipHash
+ * after the first SEEDS_PER_SIZE seeds, as symtablehash.c does when it
+ * reseeds.
+ */
+#define MAX_REBUILD_SEEDS (3 * SEEDS_PER_SIZE)
+
+/*
+ * SymTableEntry: One binding. The key is stored at the end of the
+ * entry's own allocation.
+ */
+struct SymTableEntry {
+    /* The value */
+    const void *pvValue;
+
+    /* The key's length */
+    size_t keyLength;
+
+    /* The key and its terminating '\0' */
+    char acKey[];
+};
+
+/*
+ * CuckooSlot: A place for one entry. The entry's full hash is kept in
+ * the slot, so that a probe rejects other keys without touching their
+ * entries and a displacement finds the entry's other bucket without
+ * rehashing its key.
+ */
+struct CuckooSlot {
+    /* The entry's hash under the table's seed */
+    uint64_t hash;
+
+    /* The entry, or NULL for an empty slot */
+    struct SymTableEntry *psEntry;
+};
+
+/*
+ * CuckooBucket: The slots that one bucket index selects.
+ */
+struct CuckooBucket {
+    struct CuckooSlot slots[SLOTS_PER_BUCKET];
+};
+
+/*
+ * SymTable: A power-of-two array of buckets and a small stash. Every
+ * key lives in one of two buckets chosen by its hash, or in the stash.
+ */
+struct SymTable {
+    /* Array of buckets */
+    struct CuckooBucket *buckets;
+
+    /* Number of buckets minus one */
+    size_t bucketMask;
+
+    /* Total number of entries in the table */
+    size_t nodeQuantity;
+
+    /* The hash function and the seed passed to it */
+    SymTableHashFn_T pfHash;
+    uint64_t hashSeed;
+
+    /* 1 if a rebuild that runs short of seeds moves the table to
+       SipHash, which is the case unless the client chose *pfHash */
+    int rehashToSipHash;
+
+    /* Entries that found no slot in either of their buckets */
+    struct CuckooSlot stash[STASH_SIZE];
+    size_t stashCount;
+
+    /* Advanced by every displacement to pick which slot is evicted, so
+       that repeated walks do not cycle through the same entries */
+    size_t evictionCursor;
+};
+
+/*
+ * Hashes a key with the table's seed.
+ */
+static uint64_t symtablecuckoo_hash(SymTable_T oSymTable, const char *pcKey, size_t keyLength) {
+    return (*oSymTable->pfHash)(pcKey, keyLength, oSymTable->hashSeed);
+}
+
+/*
+ * Gives the first bucket a hash selects.
+ */
+static size_t symtablecuckoo_firstBucket(SymTable_T oSymTable, uint64_t hash) {
+    return (size_t)hash & oSymTable->bucketMask;
+}
+
+/*
+ * Gives the bucket a hash selects other than `bucket`. The second
+ * bucket is the first one XORed with an odd value taken from the high
+ * half of the hash, so the two always differ and each one leads back
+ * to the other.
+ */
+static size_t symtablecuckoo_otherBucket(SymTable_T oSymTable, uint64_t hash, size_t bucket) {
+    return (bucket ^ ((size_t)(hash >> 32) | 1)) & oSymTable->bucketMask;
+}
+
+/*
+ * Tells whether a slot holds a key.
+ */
+static int symtablecuckoo_slotMatches(const struct CuckooSlot *psSlot, uint64_t hash,
+                                      const char *pcKey, size_t keyLength) {
+    return psSlot->psEntry != NULL && psSlot->hash == hash &&
+           psSlot->psEntry->keyLength == keyLength &&
+           memcmp(psSlot->psEntry->acKey, pcKey, keyLength) == 0;
+}
+
+/*
+ * Finds the slot that holds a key.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `pcKey`, `keyLength`: the key and strlen(pcKey)
+ *   - `hash`: the key's hash under the table's seed
+ * Probes the key's two buckets and then, if it is not empty, the
+ * stash: at most 2 * SLOTS_PER_BUCKET + STASH_SIZE slots.
+ * Returns the slot, or NULL if the table has no such key.
+ */
+static struct CuckooSlot *symtablecuckoo_find(SymTable_T oSymTable, const char *pcKey, size_t keyLength,
+                                              uint64_t hash) {
+    size_t first = symtablecuckoo_firstBucket(oSymTable, hash);
+    size_t second = symtablecuckoo_otherBucket(oSymTable, hash, first);
+    struct CuckooSlot *psSlots;
+    size_t i;
+
+    psSlots = oSymTable->buckets[first].slots;
+    for (i = 0; i < SLOTS_PER_BUCKET; i++) {
+        if (symtablecuckoo_slotMatches(&psSlots[i], hash, pcKey, keyLength)) return &psSlots[i];
+    }
+    psSlots = oSymTable->buckets[second].slots;
+    for (i = 0; i < SLOTS_PER_BUCKET; i++) {
+        if (symtablecuckoo_slotMatches(&psSlots[i], hash, pcKey, keyLength)) return &psSlots[i];
+    }
+    for (i = 0; i < oSymTable->stashCount; i++) {
+        if (symtablecuckoo_slotMatches(&oSymTable->stash[i], hash, pcKey, keyLength)) {
+            return &oSymTable->stash[i];
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Finds the slot that holds a key, hashing the key first.
+ */
+static struct CuckooSlot *symtablecuckoo_findKey(SymTable_T oSymTable, const char *pcKey) {
+    size_t keyLength = strlen(pcKey);
+
+    return symtablecuckoo_find(oSymTable, pcKey, keyLength, symtablecuckoo_hash(oSymTable, pcKey, keyLength));
+}
+
+/*
+ * Stores a slot's contents in an empty slot of `bucket`.
+ * Returns 1 if the bucket had room, 0 otherwise.
+ */
+static int symtablecuckoo_fillBucket(SymTable_T oSymTable, size_t bucket, struct CuckooSlot sSlot) {
+    struct CuckooSlot *psSlots = oSymTable->buckets[bucket].slots;
+    size_t i;
+
+    for (i = 0; i < SLOTS_PER_BUCKET; i++) {
+        if (psSlots[i].psEntry == NULL) {
+            psSlots[i] = sSlot;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Places an entry in one of its two buckets, or else in the stash.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `sSlot`: the entry and its hash under the table's seed
+ * When both buckets are full, an entry is evicted and moved to its
+ * other bucket, which may evict another, up to MAX_DISPLACEMENTS
+ * times. The entry left over when the walk gives up need not be the
+ * one passed in; it goes to the stash. If the stash is full, the walk
+ * is undone, moving every evicted entry back, so the table is as it
+ * was.
+ * Returns 1 if the entry was placed, 0 otherwise.
+ */
+static int symtablecuckoo_place(SymTable_T oSymTable, struct CuckooSlot sSlot) {
+    struct CuckooSlot *apsVictims[MAX_DISPLACEMENTS];
+    struct CuckooSlot sCarried;
+    size_t bucket = symtablecuckoo_firstBucket(oSymTable, sSlot.hash);
+    size_t displacements;
+
+    if (symtablecuckoo_fillBucket(oSymTable, bucket, sSlot)) return 1;
+    bucket = symtablecuckoo_otherBucket(oSymTable, sSlot.hash, bucket);
+    if (symtablecuckoo_fillBucket(oSymTable, bucket, sSlot)) return 1;
+
+    for (displacements = 0; displacements < MAX_DISPLACEMENTS; displacements++) {
+        struct CuckooSlot *psVictim =
+            &oSymTable->buckets[bucket].slots[oSymTable->evictionCursor++ % SLOTS_PER_BUCKET];
+        struct CuckooSlot sVictim = *psVictim;
+
+        apsVictims[displacements] = psVictim;
+        *psVictim = sSlot;
+        sSlot = sVictim;
+        bucket = symtablecuckoo_otherBucket(oSymTable, sSlot.hash, bucket);
+        if (symtablecuckoo_fillBucket(oSymTable, bucket, sSlot)) return 1;
+    }
+
+    if (oSymTable->stashCount < STASH_SIZE) {
+        oSymTable->stash[oSymTable->stashCount++] = sSlot;
+        return 1;
+    }
+    while (displacements > 0) {
+        displacements--;
+        sCarried = *apsVictims[displacements];
+        *apsVictims[displacements] = sSlot;
+        sSlot = sCarried;
+    }
+    return 0;
+}
+
+/*
+ * Places the entries of `slotCount` slots in a table under construction,
+ * rehashing each key with that table's function and seed.
+ * Returns 1 if every entry was placed, or 0 if one was not.
+ */
+static int symtablecuckoo_moveSlots(SymTable_T oNewSymTable, const struct CuckooSlot *psSlots,
+                                    size_t slotCount) {
+    struct CuckooSlot sSlot;
+    size_t i;
+
+    for (i = 0; i < slotCount; i++) {
+        sSlot = psSlots[i];
+        if (sSlot.psEntry == NULL) continue;
+
+        sSlot.hash = symtablecuckoo_hash(oNewSymTable, sSlot.psEntry->acKey, sSlot.psEntry->keyLength);
+        if (!symtablecuckoo_place(oNewSymTable, sSlot)) return 0;
+    }
+    return 1;
+}
+
+/*
+ * Builds a new bucket array and places every entry of a table in it.
+ * Arguments:
+ *   - `oSymTable`: the symbol table, left unchanged
+ *   - `psNew`: receives the new buckets and stash
+ *   - `bucketCount`: the new size, a power of two
+ *   - `pfHash`: the new hash function, called with a fresh seed
+ *   - `psExtra`: NULL, or an entry not yet in the table to place too
+ * Returns 1 if every entry was placed, 0 if one was not, or -1 if
+ * memory is insufficient; in the last two cases `psNew` holds nothing.
+ */
+static int symtablecuckoo_build(SymTable_T oSymTable, struct SymTable *psNew, size_t bucketCount,
+                                SymTableHashFn_T pfHash, const struct CuckooSlot *psExtra) {
+    size_t i;
+    int isPlaced;
+
+    psNew->buckets = (struct CuckooBucket*)calloc(bucketCount, sizeof(struct CuckooBucket));
+    if (psNew->buckets == NULL) return -1;
+    psNew->bucketMask = bucketCount - 1;
+    psNew->pfHash = pfHash;
+    psNew->hashSeed = SymTableHash_randomSeed();
+    psNew->stashCount = 0;
+    psNew->evictionCursor = 0;
+
+    isPlaced = symtablecuckoo_moveSlots(psNew, oSymTable->stash, oSymTable->stashCount);
+    if (isPlaced && psExtra != NULL) {
+        isPlaced = symtablecuckoo_moveSlots(psNew, psExtra, 1);
+    }
+    for (i = 0; i <= oSymTable->bucketMask && isPlaced; i++) {
+        isPlaced = symtablecuckoo_moveSlots(psNew, oSymTable->buckets[i].slots, SLOTS_PER_BUCKET);
+    }
+    if (!isPlaced) free(psNew->buckets);
+    return isPlaced;
+}
+
+/*
+ * Moves every entry into a new bucket array under a new seed.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `bucketCount`: the size to try first, a power of two
+ *   - `psExtra`: NULL, or an entry not yet in the table to place too
+ * A seed that would overfill the stash is abandoned for another, and
+ * after SEEDS_PER_SIZE seeds the size doubles. If MAX_REBUILD_SEEDS
+ * seeds all fail, no seed will do: the keys share their hashes under
+ * every seed, and more of them than two buckets and the stash hold.
+ * The table is unchanged until a rebuild succeeds.
+ * Returns 1 on success, or 0 if no seed will do or memory is
+ * insufficient.
+ */
+static int symtablecuckoo_rebuild(SymTable_T oSymTable, size_t bucketCount,
+                                  const struct CuckooSlot *psExtra) {
+    struct SymTable sNew;
+    SymTableHashFn_T pfHash = oSymTable->pfHash;
+    size_t attempt;
+    int isPlaced = 0;
+
+    for (attempt = 1; attempt <= MAX_REBUILD_SEEDS && isPlaced == 0; attempt++) {
+        if (attempt > SEEDS_PER_SIZE && oSymTable->rehashToSipHash) pfHash = SymTableHash_siphash;
+        isPlaced = symtablecuckoo_build(oSymTable, &sNew, bucketCount, pfHash, psExtra);
+        if (attempt % SEEDS_PER_SIZE == 0) bucketCount *= 2;
+    }
+    if (isPlaced != 1) return 0;
+
+    free(oSymTable->buckets);
+    oSymTable->buckets = sNew.buckets;
+    oSymTable->bucketMask = sNew.bucketMask;
+    oSymTable->pfHash = sNew.pfHash;
+    oSymTable->hashSeed = sNew.hashSeed;
+    memcpy(oSymTable->stash, sNew.stash, sNew.stashCount * sizeof(struct CuckooSlot));
+    oSymTable->stashCount = sNew.stashCount;
+    if (pfHash == SymTableHash_siphash) oSymTable->rehashToSipHash = 0;
+    return 1;
+}
+
+/* Sets up a new, empty symbol table hashed with SymTableHash_wyhash.
+   Returns a pointer to the table or NULL if there's an allocation issue. */
+SymTable_T SymTable_new(void) {
+    SymTable_T oSymTable;
+
+    oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+    if (oSymTable == NULL) return NULL;
+
+    oSymTable->buckets = (struct CuckooBucket*)calloc(INITIAL_BUCKET_COUNT, sizeof(struct CuckooBucket));
+    if (oSymTable->buckets == NULL) {
+        free(oSymTable);
+        return NULL;
+    }
+    oSymTable->bucketMask = INITIAL_BUCKET_COUNT - 1;
+    oSymTable->nodeQuantity = 0;
+    oSymTable->pfHash = SymTableHash_wyhash;
+    oSymTable->hashSeed = SymTableHash_randomSeed();
+    oSymTable->rehashToSipHash = 1;
+    oSymTable->stashCount = 0;
+    oSymTable->evictionCursor = 0;
+    return oSymTable;
+}
+
+/* Sets up a new, empty symbol table that hashes keys with `pfHash`.
+   Returns a pointer to the table or NULL if there's an allocation issue. */
+SymTable_T SymTable_newWithHash(SymTableHashFn_T pfHash) {
+    SymTable_T oSymTable;
+
+    assert(pfHash != NULL);
+
+    oSymTable = SymTable_new();
+    if (oSymTable == NULL) return NULL;
+
+    oSymTable->pfHash = pfHash;
+    oSymTable->rehashToSipHash = 0;
+    return oSymTable;
+}
+
+/* Returns the number of bindings in the table.
+   Arguments -> `oSymTable`: the symbol table */
+size_t SymTable_getLength(SymTable_T oSymTable) {
+    assert(oSymTable != NULL);
+    return oSymTable->nodeQuantity;
+}
+
+/* Releases every entry, the buckets and the table itself.
+   Arguments -> `oSymTable`: the symbol table to be freed */
+void SymTable_free(SymTable_T oSymTable) {
+    size_t i, j;
+
+    assert(oSymTable != NULL);
+
+    for (i = 0; i <= oSymTable->bucketMask; i++) {
+        for (j = 0; j < SLOTS_PER_BUCKET; j++) {
+            free(oSymTable->buckets[i].slots[j].psEntry);
+        }
+    }
+    for (i = 0; i < oSymTable->stashCount; i++) {
+        free(oSymTable->stash[i].psEntry);
+    }
+    free(oSymTable->buckets);
+    free(oSymTable);
+}
+
+/*
+ * Adds a new key-value pair to the symbol table if the key doesn't already exist.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `pcKey`: string key to add
+ *   - `pvValue`: the value associated with `pcKey`
+ * Doubles the table first once it is MAX_LOAD_FACTOR full. The key is
+ * hashed once, and again only if a rebuild changes the seed. An entry
+ * that neither its buckets nor the stash can take is placed by a
+ * rebuild under a new seed, and the put fails if no seed will do.
+ * Returns 1 on success, 0 on failure or if the key exists.
+ */
+int SymTable_put(SymTable_T oSymTable, const char *pcKey, const void *pvValue) {
+    size_t keyLength;
+    size_t bucketCount;
+    struct SymTableEntry *psEntry;
+    struct CuckooSlot sSlot;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    keyLength = strlen(pcKey);
+    sSlot.hash = symtablecuckoo_hash(oSymTable, pcKey, keyLength);
+    if (symtablecuckoo_find(oSymTable, pcKey, keyLength, sSlot.hash) != NULL) return 0;
+
+    bucketCount = oSymTable->bucketMask + 1;
+    if ((double)(oSymTable->nodeQuantity + 1) > MAX_LOAD_FACTOR * (double)(bucketCount * SLOTS_PER_BUCKET) &&
+        symtablecuckoo_rebuild(oSymTable, bucketCount * 2, NULL)) {
+        /* A failed grow leaves a table that can still take entries */
+        sSlot.hash = symtablecuckoo_hash(oSymTable, pcKey, keyLength);
+    }
+
+    psEntry = (struct SymTableEntry*)malloc(sizeof(struct SymTableEntry) + keyLength + 1);
+    if (psEntry == NULL) return 0;
+    memcpy(psEntry->acKey, pcKey, keyLength + 1);
+    psEntry->keyLength = keyLength;
+    psEntry->pvValue = pvValue;
+
+    sSlot.psEntry = psEntry;
+    if (!symtablecuckoo_place(oSymTable, sSlot) &&
+        !symtablecuckoo_rebuild(oSymTable, oSymTable->bucketMask + 1, &sSlot)) {
+        free(psEntry);
+        return 0;
+    }
+    oSymTable->nodeQuantity++;
+    return 1;
+}
+
+/*
+ * Replaces the value of an existing key in the table.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `pcKey`: the key whose value we want to update
+ *   - `pvValue`: the new value to store
+ * Returns the old value, or NULL if the key doesn't exist.
+ */
+void *SymTable_replace(SymTable_T oSymTable, const char *pcKey, const void *pvValue) {
+    struct CuckooSlot *psSlot;
+    void *oldValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    psSlot = symtablecuckoo_findKey(oSymTable, pcKey);
+    if (psSlot == NULL) return NULL;
+
+    oldValue = (void*)psSlot->psEntry->pvValue;
+    psSlot->psEntry->pvValue = pvValue;
+    return oldValue;
+}
+
+/* Checks whether the table has a key.
+   Arguments -> `oSymTable`: the symbol table
+                `pcKey`: the key to look for
+   Returns 1 if the key is found, 0 otherwise. */
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey) {
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    return symtablecuckoo_findKey(oSymTable, pcKey) != NULL;
+}
+
+/* Gets the value associated with a key.
+   Arguments -> `oSymTable`: the symbol table
+                `pcKey`: the key whose value we want to retrieve
+   Returns the value, or NULL if the key isn't found. */
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey) {
+    struct CuckooSlot *psSlot;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    psSlot = symtablecuckoo_findKey(oSymTable, pcKey);
+    return psSlot != NULL ? (void*)psSlot->psEntry->pvValue : NULL;
+}
+
+/*
+ * Removes a key and its value from the table.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `pcKey`: the key to be removed
+ * A stashed entry's slot is filled with the last stashed entry, so the
+ * stash stays packed.
+ * Returns the removed value, or NULL if the key isn't found.
+ */
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey) {
+    struct CuckooSlot *psSlot;
+    void *oldValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    psSlot = symtablecuckoo_findKey(oSymTable, pcKey);
+    if (psSlot == NULL) return NULL;
+
+    oldValue = (void*)psSlot->psEntry->pvValue;
+    free(psSlot->psEntry);
+    if (psSlot >= oSymTable->stash && psSlot < oSymTable->stash + STASH_SIZE) {
+        *psSlot = oSymTable->stash[--oSymTable->stashCount];
+    } else {
+        psSlot->psEntry = NULL;
+    }
+    oSymTable->nodeQuantity--;
+    return oldValue;
+}
+
+/*
+ * Applies the given function *pfApply to each key-value pair in the table.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `pfApply`: called as (*pfApply)(pcKey, pvValue, pvExtra)
+ *   - `pvExtra`: passed through to every call
+ */
+void SymTable_map(SymTable_T oSymTable,
+                  void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+                  const void *pvExtra) {
+    struct SymTableEntry *psEntry;
+    size_t i, j;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    for (i = 0; i <= oSymTable->bucketMask; i++) {
+        for (j = 0; j < SLOTS_PER_BUCKET; j++) {
+            psEntry = oSymTable->buckets[i].slots[j].psEntry;
+            if (psEntry != NULL) {
+                (*pfApply)(psEntry->acKey, (void*)psEntry->pvValue, (void*)pvExtra);
+            }
+        }
+    }
+    for (i = 0; i < oSymTable->stashCount; i++) {
+        psEntry = oSymTable->stash[i].psEntry;
+        (*pfApply)(psEntry->acKey, (void*)psEntry->pvValue, (void*)pvExtra);
+    }
+}
@@ -0,0 +1,30 @@
+/*--------------------------------------------------------------------*/
+/* symtablecuckoo.h                                                   */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#ifndef SymTableCuckoo_INCLUDED
+#define SymTableCuckoo_INCLUDED
+#include "symtable.h"
+#include "symtablehashfn.h"
+
+/* Extensions to the SymTable ADT that only the bucketized cuckoo
+implementation (symtablecuckoo.c) provides. That implementation keeps
+each key in one of two four-slot buckets chosen by its hash, or in an
+eight-slot stash, so a lookup compares at most 16 slots whatever the
+keys. A put that would overfill the stash rebuilds the table under a
+new seed. A table created by SymTable_new hashes with
+SymTableHash_wyhash and moves to SymTableHash_siphash if several seeds
+in a row fail. Keys whose hashes no seed tells apart, as with
+SymTableHash_legacy, SymTableHash_crc32c or a client's function, fit
+only 16 at a time; a put of one more fails, after trying a dozen
+seeds, and leaves the table unchanged. */
+
+/* Returns a SymTable containing no bindings whose keys are hashed with
+*pfHash, for example one of the functions declared in
+symtablehashfn.h. Rebuilds keep *pfHash. Returns NULL if memory is
+insufficient. */
+
+SymTable_T SymTable_newWithHash(SymTableHashFn_T pfHash);
+
+#endif
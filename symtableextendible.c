@@ -0,0 +1,601 @@
+/*--------------------------------------------------------------------*/
+/* symtableextendible.c                                               */
+/* Extendible hashing: page-sized buckets under a doubling directory  */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include "symtable.h"
+#include "symtableextendible.h"
+#include "symtablehashfn.h"
+
+/*
+ * BUCKET_SIZE: Bytes in one bucket, header included: one page. Buckets
+ * are allocated on page boundaries, so each one can be mapped, written
+ * back or locked on its own.
+ */
+#define BUCKET_SIZE 4096
+
+/*
+ * MAX_DEPTH: The most hash bits the directory may use. A split that
+ * would leave nearly every binding of a full bucket on the new key's
+ * side is never made, so keys with equal hashes, however many, go to
+ * overflow pages instead of doubling the directory; this bound only
+ * matters for keys whose hashes agree in their low 48 bits alone.
+ */
+#define MAX_DEPTH 48
+
+/*
+ * SymTableEntry: One binding. The key is stored at the end of the
+ * entry's own allocation.
+ */
+struct SymTableEntry {
+    /* The value */
+    const void *pvValue;
+
+    /* The key's length, compared before any of its bytes */
+    size_t keyLength;
+
+    /* The key and its terminating '\0' */
+    char acKey[];
+};
+
+/*
+ * Slot: One place in a bucket. Keeping the full hash next to the
+ * pointer lets a lookup skip other keys, and a split place every
+ * binding, without reading any entry.
+ */
+struct Slot {
+    uint64_t hash;
+    struct SymTableEntry *psEntry;
+};
+
+/*
+ * BUCKET_SLOTS: Slots that fit in a bucket after its header.
+ */
+#define BUCKET_SLOTS ((BUCKET_SIZE - 2 * sizeof(unsigned int) - sizeof(void*)) / sizeof(struct Slot))
+
+/*
+ * MIN_SPLIT_MOVES: The fewest bindings a split must move off the new
+ * key's side to be worth doubling the directory for. A bucket of keys
+ * with random hashes moves about half of its page, so only a bucket
+ * crowded with equal hashes falls short, and it grows a page instead.
+ */
+#define MIN_SPLIT_MOVES (BUCKET_SLOTS / 4)
+
+/*
+ * Bucket: A page of slots. The bucket holds exactly the keys whose
+ * hashes end in the same `localDepth` bits; its bindings fill
+ * `slots[0]` to `slots[count - 1]`. When no split can make room, as
+ * for more keys with equal hashes than a page holds, the bucket
+ * continues in a chain of overflow pages. Every page of a chain but
+ * the last is full.
+ */
+struct Bucket {
+    unsigned int localDepth;
+    unsigned int count;
+    struct Bucket *psOverflow;
+    struct Slot slots[BUCKET_SLOTS];
+};
+
+/*
+ * SymTable: An extendible hash table. Entry i of the directory points
+ * to the bucket for hashes whose low `globalDepth` bits are i; a
+ * bucket whose local depth is d < `globalDepth` is shared by the
+ * 2^(`globalDepth` - d) entries that agree in their low d bits.
+ */
+struct SymTable {
+    /* 2^globalDepth bucket pointers */
+    struct Bucket **directory;
+    unsigned int globalDepth;
+
+    /* Number of distinct buckets, overflow pages included */
+    size_t bucketCount;
+
+    /* Total number of bindings in the table */
+    size_t nodeQuantity;
+
+    /* The hash function and the seed passed to it */
+    SymTableHashFn_T pfHash;
+    uint64_t hashSeed;
+};
+
+/*
+ * Allocates an empty, page-aligned bucket with the given local depth.
+ * Returns NULL if memory is insufficient.
+ */
+static struct Bucket *symtableextendible_newBucket(unsigned int localDepth) {
+    void *pvBucket;
+
+    if (posix_memalign(&pvBucket, BUCKET_SIZE, sizeof(struct Bucket)) != 0) return NULL;
+    ((struct Bucket*)pvBucket)->localDepth = localDepth;
+    ((struct Bucket*)pvBucket)->count = 0;
+    ((struct Bucket*)pvBucket)->psOverflow = NULL;
+    return (struct Bucket*)pvBucket;
+}
+
+/*
+ * Frees a bucket and its overflow pages, but not their entries.
+ */
+static void symtableextendible_freeBucket(struct Bucket *psBucket) {
+    struct Bucket *psNext;
+
+    while (psBucket != NULL) {
+        psNext = psBucket->psOverflow;
+        free(psBucket);
+        psBucket = psNext;
+    }
+}
+
+/*
+ * Gives the number of entries in the directory.
+ */
+static size_t symtableextendible_getDirectorySize(SymTable_T oSymTable) {
+    return (size_t)1 << oSymTable->globalDepth;
+}
+
+/*
+ * Gives the bucket a hash selects.
+ */
+static struct Bucket *symtableextendible_bucket(SymTable_T oSymTable, uint64_t hash) {
+    return oSymTable->directory[(size_t)hash & (symtableextendible_getDirectorySize(oSymTable) - 1)];
+}
+
+/*
+ * Tells whether directory entry `index` is the first of those that
+ * point to its bucket. Each bucket is first reached at the index that
+ * spells its own low bits, which is below 2^localDepth; walking the
+ * directory and acting only on such entries visits every bucket once.
+ */
+static int symtableextendible_isFirstEntry(SymTable_T oSymTable, size_t index) {
+    return index < ((size_t)1 << oSymTable->directory[index]->localDepth);
+}
+
+/*
+ * Hashes a key with the table's seed.
+ */
+static uint64_t symtableextendible_hash(SymTable_T oSymTable, const char *pcKey, size_t keyLength) {
+    return (*oSymTable->pfHash)(pcKey, keyLength, oSymTable->hashSeed);
+}
+
+/*
+ * Finds the slot that holds a key.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `pcKey`, `keyLength`, `hash`: the key, strlen(pcKey) and its hash
+ *   - `ppsBucket`: if not NULL, receives the bucket the key belongs in
+ * Returns the slot, or NULL if the table has no such key.
+ */
+static struct Slot *symtableextendible_find(SymTable_T oSymTable, const char *pcKey, size_t keyLength,
+                                            uint64_t hash, struct Bucket **ppsBucket) {
+    struct Bucket *psBucket = symtableextendible_bucket(oSymTable, hash);
+    struct Bucket *psPage;
+    unsigned int i;
+
+    if (ppsBucket != NULL) *ppsBucket = psBucket;
+    for (psPage = psBucket; psPage != NULL; psPage = psPage->psOverflow) {
+        for (i = 0; i < psPage->count; i++) {
+            struct Slot *psSlot = &psPage->slots[i];
+            if (psSlot->hash == hash && psSlot->psEntry->keyLength == keyLength &&
+                memcmp(psSlot->psEntry->acKey, pcKey, keyLength) == 0) {
+                return psSlot;
+            }
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Doubles the directory. The new upper half is a copy of the lower
+ * half, so every hash still reaches the same bucket; no bucket and no
+ * binding moves.
+ * Returns 1 on success, or 0 if memory is insufficient, in which case
+ * the table is unchanged.
+ */
+static int symtableextendible_doubleDirectory(SymTable_T oSymTable) {
+    size_t directorySize = symtableextendible_getDirectorySize(oSymTable);
+    struct Bucket **directory;
+
+    if (oSymTable->globalDepth == MAX_DEPTH) return 0;
+    directory = (struct Bucket**)realloc(oSymTable->directory,
+                                         2 * directorySize * sizeof(struct Bucket*));
+    if (directory == NULL) return 0;
+    memcpy(directory + directorySize, directory, directorySize * sizeof(struct Bucket*));
+    oSymTable->directory = directory;
+    oSymTable->globalDepth++;
+    return 1;
+}
+
+/*
+ * Tells whether splitting a full bucket would make room for a key:
+ * whether at least MIN_SPLIT_MOVES of its bindings, overflow pages
+ * included, differ from the key's hash in the next bit, and so would
+ * move out of the key's half, and as many stay with the key. A split
+ * that moves nothing only doubles the directory, and keys with equal
+ * hashes would double it until memory ran out; one that moves a few
+ * keys at a time would deepen the bucket with every few puts. One that
+ * keeps only a few keys does the same from the other side: it parts a
+ * crowd of equal hashes from the handful of other keys that share its
+ * bucket, again and again as more arrive, deepening the bucket far
+ * past what those other keys alone would need.
+ */
+static int symtableextendible_splitHelps(const struct Bucket *psBucket, uint64_t hash) {
+    unsigned int depth = psBucket->localDepth;
+    const struct Bucket *psPage;
+    size_t moving = 0, staying = 0;
+    unsigned int i;
+
+    if (depth == MAX_DEPTH) return 0;
+    for (psPage = psBucket; psPage != NULL; psPage = psPage->psOverflow) {
+        for (i = 0; i < psPage->count; i++) {
+            moving += ((psPage->slots[i].hash ^ hash) >> depth) & 1;
+        }
+        staying += psPage->count;
+    }
+    staying -= moving;
+    return moving >= MIN_SPLIT_MOVES && staying >= MIN_SPLIT_MOVES;
+}
+
+/*
+ * Splits a full bucket in two by the next bit of its hashes, doubling
+ * the directory if the bucket already uses all of its bits. Only this
+ * bucket's bindings move, and only the directory entries that pointed
+ * to it change. The bindings that stay are packed into the front of
+ * the bucket's pages, and pages left empty are freed.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `psBucket`: the bucket to split
+ *   - `hash`: any hash that selects `psBucket`
+ * Every page the split needs is allocated, and the directory doubled,
+ * before any binding moves.
+ * Returns 1 on success, or 0 if memory is insufficient, in which case
+ * the table is unchanged.
+ */
+static int symtableextendible_splitBucket(SymTable_T oSymTable, struct Bucket *psBucket, uint64_t hash) {
+    unsigned int depth = psBucket->localDepth;
+    struct Bucket *psNewBucket = NULL;
+    struct Bucket *psPage, *psKept, *psMoved, *psNext;
+    size_t moving = 0, pages, directorySize, index;
+    unsigned int kept = 0;
+    unsigned int i;
+
+    for (psPage = psBucket; psPage != NULL; psPage = psPage->psOverflow) {
+        for (i = 0; i < psPage->count; i++) {
+            moving += (psPage->slots[i].hash >> depth) & 1;
+        }
+    }
+    for (pages = moving == 0 ? 1 : (moving + BUCKET_SLOTS - 1) / BUCKET_SLOTS; pages > 0; pages--) {
+        psPage = symtableextendible_newBucket(depth + 1);
+        if (psPage == NULL) {
+            symtableextendible_freeBucket(psNewBucket);
+            return 0;
+        }
+        psPage->psOverflow = psNewBucket;
+        psNewBucket = psPage;
+        oSymTable->bucketCount++;
+    }
+    if (depth == oSymTable->globalDepth && !symtableextendible_doubleDirectory(oSymTable)) {
+        for (psPage = psNewBucket; psPage != NULL; psPage = psPage->psOverflow) oSymTable->bucketCount--;
+        symtableextendible_freeBucket(psNewBucket);
+        return 0;
+    }
+
+    /* Writing never overtakes reading, so the kept bindings can be
+       packed in place */
+    psKept = psBucket;
+    psMoved = psNewBucket;
+    for (psPage = psBucket; psPage != NULL; psPage = psPage->psOverflow) {
+        for (i = 0; i < psPage->count; i++) {
+            if ((psPage->slots[i].hash >> depth) & 1) {
+                if (psMoved->count == BUCKET_SLOTS) psMoved = psMoved->psOverflow;
+                psMoved->slots[psMoved->count++] = psPage->slots[i];
+            } else {
+                if (kept == BUCKET_SLOTS) {
+                    psKept->count = kept;
+                    psKept = psKept->psOverflow;
+                    kept = 0;
+                }
+                psKept->slots[kept++] = psPage->slots[i];
+            }
+        }
+    }
+    psKept->count = kept;
+    psNext = psKept->psOverflow;
+    psKept->psOverflow = NULL;
+    for (psPage = psNext; psPage != NULL; psPage = psPage->psOverflow) oSymTable->bucketCount--;
+    symtableextendible_freeBucket(psNext);
+    psBucket->localDepth = depth + 1;
+
+    /* The entries that end in the bucket's old bits, then a 1 */
+    directorySize = symtableextendible_getDirectorySize(oSymTable);
+    for (index = ((size_t)hash & (((size_t)1 << depth) - 1)) | ((size_t)1 << depth);
+         index < directorySize; index += (size_t)1 << (depth + 1)) {
+        oSymTable->directory[index] = psNewBucket;
+    }
+    return 1;
+}
+
+/* Sets up a new, empty symbol table hashed with SymTableHash_wyhash:
+   one bucket and a one-entry directory. Returns a pointer to the table
+   or NULL if there's an allocation issue. */
+SymTable_T SymTable_new(void) {
+    SymTable_T oSymTable;
+
+    oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+    if (oSymTable == NULL) return NULL;
+
+    oSymTable->directory = (struct Bucket**)malloc(sizeof(struct Bucket*));
+    if (oSymTable->directory == NULL) {
+        free(oSymTable);
+        return NULL;
+    }
+    oSymTable->directory[0] = symtableextendible_newBucket(0);
+    if (oSymTable->directory[0] == NULL) {
+        free(oSymTable->directory);
+        free(oSymTable);
+        return NULL;
+    }
+    oSymTable->globalDepth = 0;
+    oSymTable->bucketCount = 1;
+    oSymTable->nodeQuantity = 0;
+    oSymTable->pfHash = SymTableHash_wyhash;
+    oSymTable->hashSeed = SymTableHash_randomSeed();
+    return oSymTable;
+}
+
+/* Sets up a new, empty symbol table that hashes keys with `pfHash`.
+   Returns a pointer to the table or NULL if there's an allocation issue. */
+SymTable_T SymTable_newWithHash(SymTableHashFn_T pfHash) {
+    SymTable_T oSymTable;
+
+    assert(pfHash != NULL);
+
+    oSymTable = SymTable_new();
+    if (oSymTable == NULL) return NULL;
+
+    oSymTable->pfHash = pfHash;
+    return oSymTable;
+}
+
+/* Returns the number of bindings in the table.
+   Arguments -> `oSymTable`: the symbol table */
+size_t SymTable_getLength(SymTable_T oSymTable) {
+    assert(oSymTable != NULL);
+    return oSymTable->nodeQuantity;
+}
+
+/* Releases every entry, every bucket, the directory and the table.
+   Arguments -> `oSymTable`: the symbol table to be freed */
+void SymTable_free(SymTable_T oSymTable) {
+    size_t index;
+    unsigned int i;
+
+    assert(oSymTable != NULL);
+
+    /* Walking down, a bucket's first entry is the last one to reach it,
+       so no entry is read after its bucket is freed */
+    for (index = symtableextendible_getDirectorySize(oSymTable); index-- > 0;) {
+        struct Bucket *psBucket = oSymTable->directory[index];
+        struct Bucket *psPage;
+        if (!symtableextendible_isFirstEntry(oSymTable, index)) continue;
+        for (psPage = psBucket; psPage != NULL; psPage = psPage->psOverflow) {
+            for (i = 0; i < psPage->count; i++) {
+                free(psPage->slots[i].psEntry);
+            }
+        }
+        symtableextendible_freeBucket(psBucket);
+    }
+    free(oSymTable->directory);
+    free(oSymTable);
+}
+
+/*
+ * Adds a new key-value pair to the symbol table if the key doesn't already exist.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `pcKey`: string key to add
+ *   - `pvValue`: the value associated with `pcKey`
+ * A put into a full bucket splits that bucket, and only that one,
+ * until the key's half has room. If a split would leave all but a few
+ * bindings on the key's side, the bucket gains an overflow page
+ * instead.
+ * Returns 1 on success, 0 on failure or if the key exists.
+ */
+int SymTable_put(SymTable_T oSymTable, const char *pcKey, const void *pvValue) {
+    size_t keyLength;
+    uint64_t hash;
+    struct SymTableEntry *psNewEntry;
+    struct Bucket *psBucket, *psPage;
+    struct Slot *psSlot;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    keyLength = strlen(pcKey);
+    hash = symtableextendible_hash(oSymTable, pcKey, keyLength);
+    if (symtableextendible_find(oSymTable, pcKey, keyLength, hash, &psBucket) != NULL) return 0;
+
+    psNewEntry = (struct SymTableEntry*)malloc(sizeof(struct SymTableEntry) + keyLength + 1);
+    if (psNewEntry == NULL) return 0;
+    memcpy(psNewEntry->acKey, pcKey, keyLength + 1);
+    psNewEntry->keyLength = keyLength;
+    psNewEntry->pvValue = pvValue;
+
+    for (;;) {
+        for (psPage = psBucket; psPage->psOverflow != NULL; psPage = psPage->psOverflow);
+        if (psPage->count < BUCKET_SLOTS) break;
+
+        if (!symtableextendible_splitHelps(psBucket, hash)) {
+            psPage->psOverflow = symtableextendible_newBucket(psBucket->localDepth);
+            psPage = psPage->psOverflow;
+            if (psPage != NULL) oSymTable->bucketCount++;
+            break;
+        }
+        if (!symtableextendible_splitBucket(oSymTable, psBucket, hash)) {
+            psPage = NULL;
+            break;
+        }
+        psBucket = symtableextendible_bucket(oSymTable, hash);
+    }
+    if (psPage == NULL) {
+        free(psNewEntry);
+        return 0;
+    }
+
+    psSlot = &psPage->slots[psPage->count++];
+    psSlot->hash = hash;
+    psSlot->psEntry = psNewEntry;
+    oSymTable->nodeQuantity++;
+    return 1;
+}
+
+/*
+ * Replaces the value of an existing key in the table.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `pcKey`: the key whose value we want to update
+ *   - `pvValue`: the new value to store
+ * Returns the old value, or NULL if the key doesn't exist.
+ */
+void *SymTable_replace(SymTable_T oSymTable, const char *pcKey, const void *pvValue) {
+    struct Slot *psSlot;
+    size_t keyLength;
+    void *oldValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    keyLength = strlen(pcKey);
+    psSlot = symtableextendible_find(oSymTable, pcKey, keyLength,
+                                     symtableextendible_hash(oSymTable, pcKey, keyLength), NULL);
+    if (psSlot == NULL) return NULL;
+
+    oldValue = (void*)psSlot->psEntry->pvValue;
+    psSlot->psEntry->pvValue = pvValue;
+    return oldValue;
+}
+
+/* Checks whether the table has a key.
+   Arguments -> `oSymTable`: the symbol table
+                `pcKey`: the key to look for
+   Returns 1 if the key is found, 0 otherwise. */
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey) {
+    size_t keyLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    keyLength = strlen(pcKey);
+    return symtableextendible_find(oSymTable, pcKey, keyLength,
+                                   symtableextendible_hash(oSymTable, pcKey, keyLength), NULL) != NULL;
+}
+
+/* Gets the value associated with a key.
+   Arguments -> `oSymTable`: the symbol table
+                `pcKey`: the key whose value we want to retrieve
+   Returns the value, or NULL if the key isn't found. */
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey) {
+    struct Slot *psSlot;
+    size_t keyLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    keyLength = strlen(pcKey);
+    psSlot = symtableextendible_find(oSymTable, pcKey, keyLength,
+                                     symtableextendible_hash(oSymTable, pcKey, keyLength), NULL);
+    return psSlot != NULL ? (void*)psSlot->psEntry->pvValue : NULL;
+}
+
+/*
+ * Removes a key and its value from the table.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `pcKey`: the key to be removed
+ * The last slot of the bucket's last page moves into the hole, and an
+ * overflow page left empty is freed. Buckets are never merged back; a table keeps the
+ * size it grew to.
+ * Returns the removed value, or NULL if the key isn't found.
+ */
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey) {
+    struct Bucket *psBucket, *psLast, *psPrevious = NULL;
+    struct Slot *psSlot;
+    size_t keyLength;
+    uint64_t hash;
+    void *oldValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    keyLength = strlen(pcKey);
+    hash = symtableextendible_hash(oSymTable, pcKey, keyLength);
+    psSlot = symtableextendible_find(oSymTable, pcKey, keyLength, hash, &psBucket);
+    if (psSlot == NULL) return NULL;
+
+    oldValue = (void*)psSlot->psEntry->pvValue;
+    free(psSlot->psEntry);
+    for (psLast = psBucket; psLast->psOverflow != NULL; psLast = psLast->psOverflow) psPrevious = psLast;
+    *psSlot = psLast->slots[--psLast->count];
+    if (psLast->count == 0 && psPrevious != NULL) {
+        psPrevious->psOverflow = NULL;
+        free(psLast);
+        oSymTable->bucketCount--;
+    }
+    oSymTable->nodeQuantity--;
+    return oldValue;
+}
+
+/*
+ * Applies the given function *pfApply to each key-value pair in the table.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `pfApply`: called as (*pfApply)(pcKey, pvValue, pvExtra)
+ *   - `pvExtra`: passed through to every call
+ */
+void SymTable_map(SymTable_T oSymTable,
+                  void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+                  const void *pvExtra) {
+    size_t directorySize;
+    size_t index;
+    unsigned int i;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    directorySize = symtableextendible_getDirectorySize(oSymTable);
+    for (index = 0; index < directorySize; index++) {
+        struct Bucket *psPage;
+        if (!symtableextendible_isFirstEntry(oSymTable, index)) continue;
+        for (psPage = oSymTable->directory[index]; psPage != NULL; psPage = psPage->psOverflow) {
+            for (i = 0; i < psPage->count; i++) {
+                struct SymTableEntry *psEntry = psPage->slots[i].psEntry;
+                (*pfApply)(psEntry->acKey, (void*)psEntry->pvValue, (void*)pvExtra);
+            }
+        }
+    }
+}
+
+/*
+ * Reports how much of the table's bucket space is in use.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `puBucketCount`: receives the number of buckets, overflow pages
+ *     included
+ *   - `puSlotCount`: receives the number of bindings they have room for
+ *   - `puDirectorySize`: receives the number of directory entries
+ */
+void SymTable_getSpaceUsage(SymTable_T oSymTable, size_t *puBucketCount,
+                            size_t *puSlotCount, size_t *puDirectorySize) {
+    assert(oSymTable != NULL);
+    assert(puBucketCount != NULL);
+    assert(puSlotCount != NULL);
+    assert(puDirectorySize != NULL);
+
+    *puBucketCount = oSymTable->bucketCount;
+    *puSlotCount = oSymTable->bucketCount * BUCKET_SLOTS;
+    *puDirectorySize = symtableextendible_getDirectorySize(oSymTable);
+}
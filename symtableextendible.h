@@ -0,0 +1,39 @@
+/*--------------------------------------------------------------------*/
+/* symtableextendible.h                                               */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#ifndef SymTableExtendible_INCLUDED
+#define SymTableExtendible_INCLUDED
+#include "symtable.h"
+#include "symtablehashfn.h"
+
+/* Extensions to the SymTable ADT that only the extendible hashing
+implementation (symtableextendible.c) provides. That implementation
+keeps its bindings in page-sized buckets reached through a directory
+indexed by the low bits of each key's hash. A full bucket splits in
+two, and only the directory entries that point to it change; the
+directory doubles when a bucket that it addresses with every one of
+its bits splits. A full bucket whose bindings a split would not part,
+such as more keys with equal hashes than a page holds, grows a chain of
+overflow pages instead, so the directory stays the size the other keys
+need. */
+
+/* Returns a SymTable containing no bindings whose keys are hashed with
+*pfHash, for example one of the functions declared in symtablehashfn.h,
+instead of SymTableHash_wyhash. Returns NULL if memory is
+insufficient. */
+
+SymTable_T SymTable_newWithHash(SymTableHashFn_T pfHash);
+
+/* Stores in *puBucketCount the number of buckets of oSymTable,
+overflow pages included, in
+*puSlotCount the number of bindings those buckets have room for, and
+in *puDirectorySize the number of entries in its directory. The share
+of the buckets' space in use is SymTable_getLength(oSymTable) divided
+by *puSlotCount. */
+
+void SymTable_getSpaceUsage(SymTable_T oSymTable, size_t *puBucketCount,
+   size_t *puSlotCount, size_t *puDirectorySize);
+
+#endif
@@ -0,0 +1,391 @@
+/*--------------------------------------------------------------------*/
+/* symtableeytzinger.c                                                */
+/* Sorted flat arrays in Eytzinger order for frozen ordered tables    */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "symtableeytzinger.h"
+
+/*
+ * Slot k of the implicit tree has children 2k and 2k + 1, and the
+ * root is slot 1. A search that goes left at every step from slot k
+ * reaches slot 16k four steps later, and one that goes right 16k + 15,
+ * so the sixteen slots that the search may read four steps on are
+ * 16k .. 16k + 15: two cache lines of words, fetched while the four
+ * steps in between run.
+ */
+
+/*
+ * Each slot also keeps a word that settles most comparisons of a
+ * search without touching the key. Every key under slot k lies between
+ * the two keys of its ancestors that bound the subtree, and so does any
+ * key that a search brings to slot k, so all of them begin with the
+ * bytes that those two bounds share. The word skips those bytes and
+ * holds the next PREFIX_BYTES bytes of the slot's key, big-endian and
+ * padded with zeros, above the number of bytes skipped. Keys that share
+ * a long namespace then still differ in their words.
+ */
+
+/*
+ * PREFIX_BYTES: How many bytes of each key a word holds.
+ */
+#define PREFIX_BYTES 7
+
+/*
+ * MAX_SKIP: The most bytes a word skips, all that its low byte holds.
+ * Skipping fewer bytes than the bounds share is still correct.
+ */
+#define MAX_SKIP 255
+
+/*
+ * PREFETCH_STRIDE: A search at slot k fetches the words from slot
+ * PREFETCH_STRIDE * k on, the lines it will read four steps on.
+ */
+#define PREFETCH_STRIDE 16
+
+/*
+ * CACHE_LINE: The array of words starts on a boundary of this many
+ * bytes, so that each group of PREFETCH_STRIDE slots is whole lines.
+ */
+#define CACHE_LINE 64
+
+#if defined(__GNUC__)
+#define PREFETCH(pvAddress) __builtin_prefetch(pvAddress)
+#else
+#define PREFETCH(pvAddress) ((void)(pvAddress))
+#endif
+
+/*
+ * SymTableEytzinger: The bindings in three parallel arrays indexed by
+ * slot, from 1 to `keyCount`; slot 0 of each is unused.
+ */
+struct SymTableEytzinger {
+    /* Number of bindings */
+    size_t keyCount;
+
+    /* The word of each slot. Aligned to CACHE_LINE within the block
+       at `pvWordBlock`. */
+    uint64_t *aWords;
+    void *pvWordBlock;
+
+    /* The keys, in `keyBytes`, and the values */
+    const char **apcKeys;
+    const void **apvValues;
+
+    /* The keys and their terminating '\0's, in increasing order */
+    char *keyBytes;
+    size_t keyByteCount;
+};
+
+/*
+ * SearchKey: A key being looked for, with its length worked out once
+ * for the whole search.
+ */
+struct SearchKey {
+    const char *pcKey;
+    size_t keyLength;
+};
+
+/*
+ * Gives the word of a key that skips `skip` bytes: the PREFIX_BYTES
+ * bytes after them as a big-endian integer, with zeros past the key's
+ * end, shifted above `skip`. The key must be at least `skip` bytes
+ * long. Words that skip the same bytes are in strcmp order.
+ */
+static uint64_t symtableeytzinger_word(const char *pcKey, size_t keyLength, size_t skip) {
+    uint64_t word = 0;
+    size_t i;
+
+    for (i = skip; i < skip + PREFIX_BYTES; i++) {
+        word = (word << 8) | (i < keyLength ? (unsigned char)pcKey[i] : 0);
+    }
+    return (word << 8) | skip;
+}
+
+/*
+ * Fills in a SearchKey for the `keyLength` bytes at `pcKey`.
+ */
+static void symtableeytzinger_makeKey(struct SearchKey *psKey, const char *pcKey, size_t keyLength) {
+    psKey->pcKey = pcKey;
+    psKey->keyLength = keyLength;
+}
+
+/*
+ * Compares a key that a search has brought to a slot with the slot's
+ * key `pcOther`, whose word is `word`, in the order of strcmp.
+ * Returns a negative number, zero or a positive number as the key is
+ * less than, equal to or greater than `pcOther`. Both keys begin with
+ * the bytes that the word skips. Keys hold no '\0', so equal words
+ * mean the same length if either key ends within them, and otherwise
+ * only the bytes past them remain.
+ */
+static int symtableeytzinger_compare(const struct SearchKey *psKey, uint64_t word, const char *pcOther) {
+    size_t skip = (size_t)(word & 0xff);
+    uint64_t keyWord = symtableeytzinger_word(psKey->pcKey, psKey->keyLength, skip);
+
+    if (keyWord != word) return keyWord < word ? -1 : 1;
+    if (psKey->keyLength < skip + PREFIX_BYTES) return 0;
+    return strcmp(psKey->pcKey + skip + PREFIX_BYTES, pcOther + skip + PREFIX_BYTES);
+}
+
+/*
+ * Gives how many leading bytes two keys share, at most MAX_SKIP.
+ */
+static size_t symtableeytzinger_shared(const char *pcKey, const char *pcOther) {
+    size_t i;
+
+    for (i = 0; i < MAX_SKIP && pcKey[i] != '\0' && pcKey[i] == pcOther[i]; i++) {
+    }
+    return i;
+}
+
+/*
+ * Climbs from slot `k` past every ancestor of which it is the right
+ * child, and then to one more parent: the slot at which a search that
+ * ended below `k` last went left, or 0 if it never did.
+ */
+static size_t symtableeytzinger_climb(size_t k) {
+#if defined(__GNUC__)
+    return k >> (__builtin_ctzll((unsigned long long)~k) + 1);
+#else
+    while (k & 1) k >>= 1;
+    return k >> 1;
+#endif
+}
+
+/*
+ * Gives the slot of the smallest key, or 0 if there are no keys.
+ */
+static size_t symtableeytzinger_first(size_t keyCount) {
+    size_t k = 1;
+
+    if (keyCount == 0) return 0;
+    while (2 * k <= keyCount) k *= 2;
+    return k;
+}
+
+/*
+ * Gives the slot of the next larger key after the one at slot `k`, or
+ * 0 if that is the largest: the leftmost slot under its right child,
+ * or else the ancestor from which it lies to the left.
+ */
+static size_t symtableeytzinger_next(size_t k, size_t keyCount) {
+    if (2 * k + 1 <= keyCount) {
+        k = 2 * k + 1;
+        while (2 * k <= keyCount) k *= 2;
+        return k;
+    }
+    return symtableeytzinger_climb(k);
+}
+
+/*
+ * Gives the slot of the smallest key that is at least the key being
+ * looked for, or 0 if there is none.
+ * Every step goes to a child by adding the outcome of a comparison, so
+ * that only a comparison that the words leave tied branches on the
+ * data; the search is as long for every key.
+ */
+static size_t symtableeytzinger_lowerBound(SymTableEytzinger_T oSymTableEytzinger,
+                                           const struct SearchKey *psKey) {
+    const uint64_t *aWords = oSymTableEytzinger->aWords;
+    size_t k = 1;
+
+    while (k <= oSymTableEytzinger->keyCount) {
+        /* The address may lie past the end of the array near the
+           bottom of the tree; a prefetch of it is harmless */
+        PREFETCH((const void*)((uintptr_t)aWords + PREFETCH_STRIDE * k * sizeof(uint64_t)));
+        PREFETCH((const void*)((uintptr_t)aWords + PREFETCH_STRIDE * k * sizeof(uint64_t) + CACHE_LINE));
+        k = 2 * k + (symtableeytzinger_compare(psKey, aWords[k], oSymTableEytzinger->apcKeys[k]) > 0);
+    }
+    return symtableeytzinger_climb(k);
+}
+
+/* Lays out `uCount` distinct keys, given in increasing order, in
+   Eytzinger order by walking the slots in order once, then works out
+   each slot's word from the top down, passing each child the bounds
+   of its subtree.
+   Returns the bindings, or NULL if memory is insufficient. */
+SymTableEytzinger_T SymTableEytzinger_new(const char *const apcKeys[], const void *const apvValues[],
+                                          size_t uCount) {
+    SymTableEytzinger_T oSymTableEytzinger;
+    size_t *auLow, *auHigh;
+    char *pcNextByte;
+    size_t keyLength, skip;
+    size_t i, k;
+
+    assert(uCount == 0 || (apcKeys != NULL && apvValues != NULL));
+
+    oSymTableEytzinger = (SymTableEytzinger_T)calloc(1, sizeof(struct SymTableEytzinger));
+    if (oSymTableEytzinger == NULL) return NULL;
+    oSymTableEytzinger->keyCount = uCount;
+    for (i = 0; i < uCount; i++) {
+        assert(i == 0 || strcmp(apcKeys[i - 1], apcKeys[i]) < 0);
+        oSymTableEytzinger->keyByteCount += strlen(apcKeys[i]) + 1;
+    }
+
+    oSymTableEytzinger->pvWordBlock = malloc((uCount + 1) * sizeof(uint64_t) + CACHE_LINE - 1);
+    oSymTableEytzinger->apcKeys = (const char**)malloc((uCount + 1) * sizeof(const char*));
+    oSymTableEytzinger->apvValues = (const void**)malloc((uCount + 1) * sizeof(const void*));
+    oSymTableEytzinger->keyBytes = (char*)malloc(oSymTableEytzinger->keyByteCount + 1);
+    auLow = (size_t*)malloc((2 * uCount + 2) * sizeof(size_t));
+    auHigh = (size_t*)malloc((2 * uCount + 2) * sizeof(size_t));
+    if (oSymTableEytzinger->pvWordBlock == NULL || oSymTableEytzinger->apcKeys == NULL ||
+        oSymTableEytzinger->apvValues == NULL || oSymTableEytzinger->keyBytes == NULL ||
+        auLow == NULL || auHigh == NULL) {
+        free(auLow);
+        free(auHigh);
+        SymTableEytzinger_free(oSymTableEytzinger);
+        return NULL;
+    }
+    oSymTableEytzinger->aWords = (uint64_t*)(void*)
+        (((uintptr_t)oSymTableEytzinger->pvWordBlock + CACHE_LINE - 1) & ~(uintptr_t)(CACHE_LINE - 1));
+
+    /* The slots in order hold the keys in order */
+    pcNextByte = oSymTableEytzinger->keyBytes;
+    k = symtableeytzinger_first(uCount);
+    for (i = 0; i < uCount; i++) {
+        keyLength = strlen(apcKeys[i]);
+        memcpy(pcNextByte, apcKeys[i], keyLength + 1);
+        oSymTableEytzinger->apcKeys[k] = pcNextByte;
+        oSymTableEytzinger->apvValues[k] = apvValues[i];
+        pcNextByte += keyLength + 1;
+        k = symtableeytzinger_next(k, uCount);
+    }
+    assert(k == 0);
+
+    /* auLow[k] and auHigh[k] are the slots of the bounds of slot k's
+       subtree, 0 where it is open */
+    auLow[1] = auHigh[1] = 0;
+    for (k = 1; k <= uCount; k++) {
+        const char *pcKey = oSymTableEytzinger->apcKeys[k];
+        skip = 0;
+        if (auLow[k] != 0 && auHigh[k] != 0) {
+            skip = symtableeytzinger_shared(oSymTableEytzinger->apcKeys[auLow[k]],
+                                            oSymTableEytzinger->apcKeys[auHigh[k]]);
+        }
+        oSymTableEytzinger->aWords[k] = symtableeytzinger_word(pcKey, strlen(pcKey), skip);
+        auLow[2 * k] = auLow[k];
+        auHigh[2 * k] = k;
+        auLow[2 * k + 1] = k;
+        auHigh[2 * k + 1] = auHigh[k];
+    }
+    free(auLow);
+    free(auHigh);
+    return oSymTableEytzinger;
+}
+
+/* Releases the arrays and the key buffer.
+   Arguments -> `oSymTableEytzinger`: the bindings to be freed */
+void SymTableEytzinger_free(SymTableEytzinger_T oSymTableEytzinger) {
+    assert(oSymTableEytzinger != NULL);
+
+    free(oSymTableEytzinger->pvWordBlock);
+    free(oSymTableEytzinger->apcKeys);
+    free(oSymTableEytzinger->apvValues);
+    free(oSymTableEytzinger->keyBytes);
+    free(oSymTableEytzinger);
+}
+
+/* Returns the number of bindings.
+   Arguments -> `oSymTableEytzinger`: the bindings */
+size_t SymTableEytzinger_getLength(SymTableEytzinger_T oSymTableEytzinger) {
+    assert(oSymTableEytzinger != NULL);
+    return oSymTableEytzinger->keyCount;
+}
+
+/*
+ * Looks up a key: one search down the implicit tree, then one
+ * comparison with the key it ends at.
+ * Arguments:
+ *   - `oSymTableEytzinger`: the bindings
+ *   - `pcKey`, `uLength`: the key and its length
+ *   - `ppvValue`: receives the value when the key is found
+ * Returns 1 if the key is found, 0 otherwise.
+ */
+int SymTableEytzinger_find(SymTableEytzinger_T oSymTableEytzinger, const char *pcKey, size_t uLength,
+                           void **ppvValue) {
+    struct SearchKey sKey;
+    size_t k;
+
+    assert(oSymTableEytzinger != NULL);
+    assert(pcKey != NULL);
+    assert(ppvValue != NULL);
+
+    symtableeytzinger_makeKey(&sKey, pcKey, uLength);
+    k = symtableeytzinger_lowerBound(oSymTableEytzinger, &sKey);
+    if (k == 0 || strcmp(pcKey, oSymTableEytzinger->apcKeys[k]) != 0) return 0;
+    *ppvValue = (void*)oSymTableEytzinger->apvValues[k];
+    return 1;
+}
+
+/*
+ * Applies *pfApply to the bindings whose keys lie in [pcLow, pcHigh).
+ * Arguments:
+ *   - `oSymTableEytzinger`: the bindings
+ *   - `pcLow`, `pcHigh`: the ends of the range, NULL for an open end
+ *   - `pfApply`: called as (*pfApply)(pcKey, pvValue, pvExtra)
+ *   - `pvExtra`: passed through to every call
+ * Searches once for the first key at least `pcLow`, then steps from
+ * slot to slot in order until a key reaches `pcHigh`. The slots of the
+ * walk need not bound `pcHigh`, so it is compared with strcmp.
+ */
+void SymTableEytzinger_mapRange(SymTableEytzinger_T oSymTableEytzinger, const char *pcLow, const char *pcHigh,
+                                void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+                                const void *pvExtra) {
+    struct SearchKey sLow;
+    size_t k;
+
+    assert(oSymTableEytzinger != NULL);
+    assert(pfApply != NULL);
+
+    if (pcLow != NULL) {
+        symtableeytzinger_makeKey(&sLow, pcLow, strlen(pcLow));
+        k = symtableeytzinger_lowerBound(oSymTableEytzinger, &sLow);
+    } else {
+        k = symtableeytzinger_first(oSymTableEytzinger->keyCount);
+    }
+    for (; k != 0; k = symtableeytzinger_next(k, oSymTableEytzinger->keyCount)) {
+        if (pcHigh != NULL && strcmp(pcHigh, oSymTableEytzinger->apcKeys[k]) <= 0) return;
+        (*pfApply)(oSymTableEytzinger->apcKeys[k], (void*)oSymTableEytzinger->apvValues[k], (void*)pvExtra);
+    }
+}
+
+/*
+ * Applies *pfApply to the bindings whose keys begin with `pcPrefix`.
+ * Arguments:
+ *   - `oSymTableEytzinger`: the bindings
+ *   - `pcPrefix`: the prefix
+ *   - `pfApply`, `pvExtra`: as for SymTableEytzinger_mapRange
+ * The keys with a prefix are contiguous in key order and start at the
+ * prefix itself, so this steps from there until a key lacks it.
+ */
+void SymTableEytzinger_mapPrefix(SymTableEytzinger_T oSymTableEytzinger, const char *pcPrefix,
+                                 void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+                                 const void *pvExtra) {
+    struct SearchKey sPrefix;
+    size_t k;
+
+    assert(oSymTableEytzinger != NULL);
+    assert(pcPrefix != NULL);
+    assert(pfApply != NULL);
+
+    symtableeytzinger_makeKey(&sPrefix, pcPrefix, strlen(pcPrefix));
+    for (k = symtableeytzinger_lowerBound(oSymTableEytzinger, &sPrefix);
+         k != 0 && strncmp(oSymTableEytzinger->apcKeys[k], pcPrefix, sPrefix.keyLength) == 0;
+         k = symtableeytzinger_next(k, oSymTableEytzinger->keyCount)) {
+        (*pfApply)(oSymTableEytzinger->apcKeys[k], (void*)oSymTableEytzinger->apvValues[k], (void*)pvExtra);
+    }
+}
+
+/* Returns the bytes of the header, the three arrays and the keys.
+   Arguments -> `oSymTableEytzinger`: the bindings */
+size_t SymTableEytzinger_getBytes(SymTableEytzinger_T oSymTableEytzinger) {
+    assert(oSymTableEytzinger != NULL);
+    return sizeof(struct SymTableEytzinger) +
+           (oSymTableEytzinger->keyCount + 1) * (sizeof(uint64_t) + sizeof(const char*) + sizeof(const void*)) +
+           CACHE_LINE - 1 + oSymTableEytzinger->keyByteCount + 1;
+}
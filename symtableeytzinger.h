@@ -0,0 +1,69 @@
+/*--------------------------------------------------------------------*/
+/* symtableeytzinger.h                                                */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#ifndef SymTableEytzinger_INCLUDED
+#define SymTableEytzinger_INCLUDED
+#include <stddef.h>
+
+/* A SymTableEytzinger is an immutable set of bindings kept sorted in
+strcmp order, in flat arrays laid out in Eytzinger order: the root of
+an implicit binary search tree first, then its two children, then
+their four, and so on. A search steps from slot k to slot 2k or 2k + 1
+without a branch to mispredict, and the slots it will read a few steps
+ahead sit together, so they are fetched from memory while the current
+ones are compared. A few bytes of each key sit in one array, the
+values in a parallel one, and the keys themselves packed in one
+buffer: there is no node or pointer per binding beyond the key's. */
+
+typedef struct SymTableEytzinger *SymTableEytzinger_T;
+
+/* Returns a SymTableEytzinger that binds each of the uCount keys
+apcKeys[i] to apvValues[i]. The keys must be distinct and in
+increasing strcmp order; they are copied. Returns NULL if memory is
+insufficient. */
+
+SymTableEytzinger_T SymTableEytzinger_new(const char *const apcKeys[],
+   const void *const apvValues[], size_t uCount);
+
+/* Frees all the memory that oSymTableEytzinger occupies. */
+
+void SymTableEytzinger_free(SymTableEytzinger_T oSymTableEytzinger);
+
+/* Returns the number of bindings in oSymTableEytzinger. */
+
+size_t SymTableEytzinger_getLength(SymTableEytzinger_T oSymTableEytzinger);
+
+/* If oSymTableEytzinger binds the uLength bytes at pcKey, a string of
+that length, stores the value in *ppvValue and returns 1 (TRUE).
+Otherwise returns 0 (FALSE) and leaves *ppvValue unchanged. */
+
+int SymTableEytzinger_find(SymTableEytzinger_T oSymTableEytzinger,
+   const char *pcKey, size_t uLength, void **ppvValue);
+
+/* Applies function *pfApply to each binding in oSymTableEytzinger
+whose key is at least pcLow and less than pcHigh, in increasing order
+of keys, passing pvExtra as an extra parameter. A NULL pcLow or pcHigh
+leaves that end of the range open. */
+
+void SymTableEytzinger_mapRange(SymTableEytzinger_T oSymTableEytzinger,
+   const char *pcLow, const char *pcHigh,
+   void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+   const void *pvExtra);
+
+/* Applies function *pfApply to each binding in oSymTableEytzinger
+whose key begins with pcPrefix, in increasing order of keys, passing
+pvExtra as an extra parameter. */
+
+void SymTableEytzinger_mapPrefix(SymTableEytzinger_T oSymTableEytzinger,
+   const char *pcPrefix,
+   void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+   const void *pvExtra);
+
+/* Returns the number of bytes that oSymTableEytzinger occupies, the
+keys included. */
+
+size_t SymTableEytzinger_getBytes(SymTableEytzinger_T oSymTableEytzinger);
+
+#endif
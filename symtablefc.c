@@ -0,0 +1,374 @@
+/*--------------------------------------------------------------------*/
+/* symtablefc.c                                                       */
+/* Flat-combining front end for write-heavy concurrent access         */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include "symtable.h"
+#include "symtablehash.h"
+#include "symtablefc.h"
+
+/*
+ * SLOT_COUNT: Number of publication slots. Threads beyond this many at
+ * once simply take the lock and apply their own request.
+ */
+#define SLOT_COUNT 64
+
+/*
+ * SLOT_PAD_SIZE: Each slot is padded to this many bytes so that a
+ * thread spinning on its own slot does not share a cache line with
+ * another thread's slot.
+ */
+#define SLOT_PAD_SIZE 128
+
+/*
+ * SPINS_BEFORE_YIELD: How many times a waiting thread checks its slot
+ * before giving up the processor.
+ */
+#define SPINS_BEFORE_YIELD 64
+
+/*
+ * Operation: The requests a thread can publish.
+ */
+enum Operation { OP_PUT, OP_REPLACE, OP_CONTAINS, OP_GET, OP_REMOVE };
+
+/*
+ * Slot: One publication slot. A thread claims a free slot, fills in
+ * its request, and sets `isPending`; the combiner applies the request,
+ * stores the result, and clears `isPending`.
+ */
+struct Slot {
+    /* 1 while a thread owns the slot */
+    int isClaimed;
+
+    /* 1 while the request waits for a combiner */
+    int isPending;
+
+    /* The requested operation */
+    enum Operation eOperation;
+
+    /* The request's key */
+    const char *pcKey;
+
+    /* The request's value, for put and replace */
+    const void *pvValue;
+
+    /* Result of put and contains */
+    int iResult;
+
+    /* Result of replace, get, and remove */
+    void *pvResult;
+};
+
+/*
+ * PaddedSlot: A Slot rounded up to SLOT_PAD_SIZE bytes.
+ */
+union PaddedSlot {
+    struct Slot sSlot;
+    char acPad[SLOT_PAD_SIZE];
+};
+
+/*
+ * SymTableFC: The underlying table, the lock held by the combiner,
+ * and the publication slots.
+ */
+struct SymTableFC {
+    /* The table that every request is applied to */
+    SymTable_T oSymTable;
+
+    /* Held by the thread currently combining */
+    pthread_mutex_t combinerLock;
+
+    /* Number of published requests not yet applied */
+    size_t pendingCount;
+
+    /* The publication slots */
+    union PaddedSlot slots[SLOT_COUNT];
+};
+
+/* Sets up a new, empty flat-combining table.
+   Returns a pointer to it, or NULL if there's an allocation issue or
+   its mutex cannot be set up. */
+SymTableFC_T SymTableFC_new(void) {
+    SymTableFC_T oSymTableFC;
+
+    oSymTableFC = (SymTableFC_T)calloc(1, sizeof(struct SymTableFC));
+    if (oSymTableFC == NULL) return NULL;
+
+    oSymTableFC->oSymTable = SymTable_new();
+    if (oSymTableFC->oSymTable == NULL) {
+        free(oSymTableFC);
+        return NULL;
+    }
+    if (pthread_mutex_init(&oSymTableFC->combinerLock, NULL) != 0) {
+        SymTable_free(oSymTableFC->oSymTable);
+        free(oSymTableFC);
+        return NULL;
+    }
+    return oSymTableFC;
+}
+
+/* Releases the underlying table and the front end itself.
+   Arguments -> `oSymTableFC`: the table to be freed */
+void SymTableFC_free(SymTableFC_T oSymTableFC) {
+    assert(oSymTableFC != NULL);
+
+    pthread_mutex_destroy(&oSymTableFC->combinerLock);
+    SymTable_free(oSymTableFC->oSymTable);
+    free(oSymTableFC);
+}
+
+/*
+ * Applies one request to the underlying table and stores its result.
+ * The caller holds the combiner lock.
+ */
+static void symtablefc_apply(SymTable_T oSymTable, struct Slot *psSlot) {
+    switch (psSlot->eOperation) {
+    case OP_PUT:
+        psSlot->iResult = SymTable_put(oSymTable, psSlot->pcKey, psSlot->pvValue);
+        break;
+    case OP_REPLACE:
+        psSlot->pvResult = SymTable_replace(oSymTable, psSlot->pcKey, psSlot->pvValue);
+        break;
+    case OP_CONTAINS:
+        psSlot->iResult = SymTable_contains(oSymTable, psSlot->pcKey);
+        break;
+    case OP_GET:
+        psSlot->pvResult = SymTable_get(oSymTable, psSlot->pcKey);
+        break;
+    case OP_REMOVE:
+        psSlot->pvResult = SymTable_remove(oSymTable, psSlot->pcKey);
+        break;
+    }
+}
+
+/*
+ * Applies every pending request as one batch. The caller holds the
+ * combiner lock. Before any put runs, the table is grown once to fit
+ * all of the batch's puts, so the batch pays for at most one resize.
+ */
+static void symtablefc_combine(SymTableFC_T oSymTableFC) {
+    size_t uPuts = 0;
+    size_t i;
+
+    for (i = 0; i < SLOT_COUNT; i++) {
+        struct Slot *psSlot = &oSymTableFC->slots[i].sSlot;
+        if (__atomic_load_n(&psSlot->isPending, __ATOMIC_ACQUIRE) &&
+            psSlot->eOperation == OP_PUT) {
+            uPuts++;
+        }
+    }
+    if (uPuts > 1) {
+        SymTable_reserve(oSymTableFC->oSymTable,
+                         SymTable_getLength(oSymTableFC->oSymTable) + uPuts);
+    }
+
+    for (i = 0; i < SLOT_COUNT; i++) {
+        struct Slot *psSlot = &oSymTableFC->slots[i].sSlot;
+        if (__atomic_load_n(&psSlot->isPending, __ATOMIC_ACQUIRE)) {
+            symtablefc_apply(oSymTableFC->oSymTable, psSlot);
+            __atomic_fetch_sub(&oSymTableFC->pendingCount, 1, __ATOMIC_RELAXED);
+            __atomic_store_n(&psSlot->isPending, 0, __ATOMIC_RELEASE);
+        }
+    }
+}
+
+/*
+ * Claims a free slot, starting the search at a position derived from
+ * the caller's stack address so that threads tend to keep apart.
+ * Returns the slot, or NULL if every slot is taken.
+ */
+static struct Slot *symtablefc_claimSlot(SymTableFC_T oSymTableFC) {
+    int iStackMarker;
+    size_t uStart = ((size_t)&iStackMarker >> 12) % SLOT_COUNT;
+    size_t i;
+
+    for (i = 0; i < SLOT_COUNT; i++) {
+        struct Slot *psSlot = &oSymTableFC->slots[(uStart + i) % SLOT_COUNT].sSlot;
+        int iExpected = 0;
+        if (!__atomic_load_n(&psSlot->isClaimed, __ATOMIC_RELAXED) &&
+            __atomic_compare_exchange_n(&psSlot->isClaimed, &iExpected, 1, 0,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            return psSlot;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Runs one request through the combining protocol.
+ * Arguments:
+ *   - `oSymTableFC`: the table
+ *   - `psRequest`: the request; its result fields are filled in
+ * If the lock is free the request is applied at once. Otherwise it is
+ * published in a slot and the thread waits until either some combiner
+ * has applied it or this thread gets the lock and combines the whole
+ * batch itself.
+ */
+static void symtablefc_execute(SymTableFC_T oSymTableFC, struct Slot *psRequest) {
+    struct Slot *psSlot;
+    unsigned int uSpins = 0;
+
+    /* Uncontended: apply the request directly, then serve anyone who
+       published while the lock was held */
+    if (pthread_mutex_trylock(&oSymTableFC->combinerLock) == 0) {
+        symtablefc_apply(oSymTableFC->oSymTable, psRequest);
+        if (__atomic_load_n(&oSymTableFC->pendingCount, __ATOMIC_ACQUIRE) != 0) {
+            symtablefc_combine(oSymTableFC);
+        }
+        pthread_mutex_unlock(&oSymTableFC->combinerLock);
+        return;
+    }
+
+    psSlot = symtablefc_claimSlot(oSymTableFC);
+    if (psSlot == NULL) {
+        /* No slot is free: apply the request directly */
+        pthread_mutex_lock(&oSymTableFC->combinerLock);
+        symtablefc_apply(oSymTableFC->oSymTable, psRequest);
+        pthread_mutex_unlock(&oSymTableFC->combinerLock);
+        return;
+    }
+
+    psSlot->eOperation = psRequest->eOperation;
+    psSlot->pcKey = psRequest->pcKey;
+    psSlot->pvValue = psRequest->pvValue;
+    __atomic_fetch_add(&oSymTableFC->pendingCount, 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&psSlot->isPending, 1, __ATOMIC_RELEASE);
+
+    while (__atomic_load_n(&psSlot->isPending, __ATOMIC_ACQUIRE)) {
+        if (pthread_mutex_trylock(&oSymTableFC->combinerLock) == 0) {
+            symtablefc_combine(oSymTableFC);
+            pthread_mutex_unlock(&oSymTableFC->combinerLock);
+        } else if (++uSpins % SPINS_BEFORE_YIELD == 0) {
+            sched_yield();
+        }
+    }
+
+    psRequest->iResult = psSlot->iResult;
+    psRequest->pvResult = psSlot->pvResult;
+    __atomic_store_n(&psSlot->isClaimed, 0, __ATOMIC_RELEASE);
+}
+
+/*
+ * Gives the number of bindings in the table.
+ * Reads the underlying table under the combiner lock.
+ */
+size_t SymTableFC_getLength(SymTableFC_T oSymTableFC) {
+    size_t uLength;
+
+    assert(oSymTableFC != NULL);
+
+    pthread_mutex_lock(&oSymTableFC->combinerLock);
+    uLength = SymTable_getLength(oSymTableFC->oSymTable);
+    pthread_mutex_unlock(&oSymTableFC->combinerLock);
+    return uLength;
+}
+
+/*
+ * Adds a binding through the combiner.
+ * Returns 1 on success, 0 on failure or if the key already exists.
+ */
+int SymTableFC_put(SymTableFC_T oSymTableFC, const char *pcKey, const void *pvValue) {
+    struct Slot sRequest;
+
+    assert(oSymTableFC != NULL);
+    assert(pcKey != NULL);
+
+    sRequest.eOperation = OP_PUT;
+    sRequest.pcKey = pcKey;
+    sRequest.pvValue = pvValue;
+    symtablefc_execute(oSymTableFC, &sRequest);
+    return sRequest.iResult;
+}
+
+/*
+ * Replaces a binding's value through the combiner.
+ * Returns the old value, or NULL if the key doesn't exist.
+ */
+void *SymTableFC_replace(SymTableFC_T oSymTableFC, const char *pcKey, const void *pvValue) {
+    struct Slot sRequest;
+
+    assert(oSymTableFC != NULL);
+    assert(pcKey != NULL);
+
+    sRequest.eOperation = OP_REPLACE;
+    sRequest.pcKey = pcKey;
+    sRequest.pvValue = pvValue;
+    symtablefc_execute(oSymTableFC, &sRequest);
+    return sRequest.pvResult;
+}
+
+/*
+ * Checks for a key through the combiner.
+ * Returns 1 if the key is found, 0 otherwise.
+ */
+int SymTableFC_contains(SymTableFC_T oSymTableFC, const char *pcKey) {
+    struct Slot sRequest;
+
+    assert(oSymTableFC != NULL);
+    assert(pcKey != NULL);
+
+    sRequest.eOperation = OP_CONTAINS;
+    sRequest.pcKey = pcKey;
+    sRequest.pvValue = NULL;
+    symtablefc_execute(oSymTableFC, &sRequest);
+    return sRequest.iResult;
+}
+
+/*
+ * Gets a binding's value through the combiner.
+ * Returns the value, or NULL if the key isn't found.
+ */
+void *SymTableFC_get(SymTableFC_T oSymTableFC, const char *pcKey) {
+    struct Slot sRequest;
+
+    assert(oSymTableFC != NULL);
+    assert(pcKey != NULL);
+
+    sRequest.eOperation = OP_GET;
+    sRequest.pcKey = pcKey;
+    sRequest.pvValue = NULL;
+    symtablefc_execute(oSymTableFC, &sRequest);
+    return sRequest.pvResult;
+}
+
+/*
+ * Removes a binding through the combiner.
+ * Returns the removed value, or NULL if the key isn't found.
+ */
+void *SymTableFC_remove(SymTableFC_T oSymTableFC, const char *pcKey) {
+    struct Slot sRequest;
+
+    assert(oSymTableFC != NULL);
+    assert(pcKey != NULL);
+
+    sRequest.eOperation = OP_REMOVE;
+    sRequest.pcKey = pcKey;
+    sRequest.pvValue = NULL;
+    symtablefc_execute(oSymTableFC, &sRequest);
+    return sRequest.pvResult;
+}
+
+/*
+ * Applies *pfApply to every binding while holding the combiner lock.
+ * Parameters:
+ *   oSymTableFC - A pointer to the table.
+ *   pfApply - The function to call for each key-value pair.
+ *   pvExtra - The extra parameter passed through to *pfApply.
+ */
+void SymTableFC_map(SymTableFC_T oSymTableFC,
+                    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+                    const void *pvExtra) {
+    assert(oSymTableFC != NULL);
+    assert(pfApply != NULL);
+
+    pthread_mutex_lock(&oSymTableFC->combinerLock);
+    SymTable_map(oSymTableFC->oSymTable, pfApply, pvExtra);
+    pthread_mutex_unlock(&oSymTableFC->combinerLock);
+}
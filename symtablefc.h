@@ -0,0 +1,70 @@
+/*--------------------------------------------------------------------*/
+/* symtablefc.h                                                       */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#ifndef SymTableFC_INCLUDED
+#define SymTableFC_INCLUDED
+#include <stddef.h>
+
+/* A SymTableFC is a SymTable that many threads may change at once,
+built with flat combining. A thread publishes its request in a slot;
+whichever thread holds the lock applies every published request in
+one batch, so the lock changes hands once per batch rather than once
+per operation. All functions are safe to call from several threads. */
+
+typedef struct SymTableFC *SymTableFC_T;
+
+/* Returns a SymTableFC containing no bindings. Returns NULL if memory
+is insufficient or a mutex cannot be initialized. */
+
+SymTableFC_T SymTableFC_new(void);
+
+/* Takes in oSymTableFC and frees all the memory that it occupies. No
+other thread may be using oSymTableFC. */
+
+void SymTableFC_free(SymTableFC_T oSymTableFC);
+
+/* Takes in oSymTableFC, returns its number of bindings. */
+
+size_t SymTableFC_getLength(SymTableFC_T oSymTableFC);
+
+/* Returns 1 (TRUE) if oSymTableFC did not contain a binding with key
+pcKey and one was added with value pvValue. Returns 0 (FALSE) if
+either memory is insufficient or the key is already present. */
+
+int SymTableFC_put(SymTableFC_T oSymTableFC,
+   const char *pcKey, const void *pvValue);
+
+/* If oSymTableFC contains a binding with key pcKey, replace its value
+with pvValue and RETURN the previous value. Otherwise, return NULL and
+leave oSymTableFC unchanged. */
+
+void *SymTableFC_replace(SymTableFC_T oSymTableFC,
+   const char *pcKey, const void *pvValue);
+
+/* Returns 1(TRUE) if oSymTableFC contains a binding with a key equal
+to pcKey. Otherwise return 0(FALSE). */
+
+int SymTableFC_contains(SymTableFC_T oSymTableFC, const char *pcKey);
+
+/* Returns the value of the binding within oSymTableFC with a key
+equal to pcKey. Otherwise return NULL. */
+
+void *SymTableFC_get(SymTableFC_T oSymTableFC, const char *pcKey);
+
+/* Removes the binding in oSymTableFC with key == pcKey and RETURNS
+its value. Otherwise, return NULL and leave oSymTableFC untouched. */
+
+void *SymTableFC_remove(SymTableFC_T oSymTableFC, const char *pcKey);
+
+/* Applies function *pfApply to each binding in oSymTableFC, calling
+(*pfApply)(pcKey, pvValue, pvExtra) for each binding. The table is
+locked for the whole walk, so *pfApply must not call back into
+oSymTableFC. */
+
+void SymTableFC_map(SymTableFC_T oSymTableFC,
+   void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+   const void *pvExtra);
+
+#endif
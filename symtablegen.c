@@ -0,0 +1,781 @@
+/*--------------------------------------------------------------------*/
+/* symtablegen.c                                                      */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#include "symtable.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+/*--------------------------------------------------------------------*/
+
+/* symtablegen reads a fixed set of keys and writes C source for a
+   read-only table of them: a minimal perfect hash whose pilots and
+   bindings are static data, so that a lookup needs no allocation and
+   no start-up work. The generated header declares, for a prefix P,
+
+      size_t P_getLength(void);
+      int P_contains(const char *pcKey);
+      void *P_get(const char *pcKey);
+      void P_map(void (*pfApply)(const char *pcKey, void *pvValue,
+         void *pvExtra), const void *pvExtra);
+
+   which behave as the SymTable functions of those names do on a table
+   that is never changed. Given -s, the header also declares
+
+      SymTable_T P_getTable(void);
+
+   which returns the table as a read-only SymTable_T, and the source
+   defines every function of symtable.h around it. No other SymTable
+   can then be linked into the same program, since both would define
+   SymTable_get and the rest; that is why the prefixed functions are
+   the default.
+
+   Each line of the key list holds a key, then optionally white space
+   and a C constant expression for the key's value. A key bound to no
+   expression is bound to its own text. Keys cannot hold white space;
+   empty lines and lines that begin with '#' are skipped. */
+
+/*--------------------------------------------------------------------*/
+
+/* The longest line that the key list may hold. */
+
+enum {MAX_LINE_LENGTH = 4096};
+
+/* Average keys per bucket. Each bucket has one pilot, 16 bits wide
+   unless some pilot needs more. */
+
+enum {BUCKET_KEYS = 3};
+
+/* Pilots are tried for a bucket up to MIN_PILOT_LIMIT or
+   PILOT_LIMIT_PER_KEY times the number of keys, whichever is larger:
+   the last buckets placed each have only a few free slots to find.
+   MAX_SEEDS seeds are tried before giving up. */
+
+enum {MIN_PILOT_LIMIT = 65535};
+enum {PILOT_LIMIT_PER_KEY = 64};
+enum {MAX_SEEDS = 1000};
+
+/* The hash multiplies a key's words in with WORD_MULTIPLIER, starting
+   from HASH_OFFSET xor the seed (see hashKey). The high bits of the last
+   product pick the bucket; the hash xor the bucket's pilot, multiplied
+   by PILOT_MULTIPLIER, picks the slot. A lookup so costs two dependent
+   multiplies past the key's words. The generated code repeats these;
+   keep the two in step. */
+
+#define HASH_OFFSET 0x243f6a8885a308d3ULL
+#define WORD_MULTIPLIER 0x9fb21c651e98df25ULL
+#define PILOT_MULTIPLIER 0xd6e8feb86659fd93ULL
+
+/* An odd constant that spreads the seeds tried. */
+
+#define GOLDEN 0x9e3779b97f4a7c15ULL
+
+/*--------------------------------------------------------------------*/
+
+/* A key read from the key list. */
+
+struct Key
+{
+   /* The key and its length */
+   char *pcKey;
+   size_t uLength;
+
+   /* The C expression for its value, or NULL */
+   char *pcValue;
+
+   /* Its hash under the seed being tried */
+   uint64_t uHash;
+
+   /* The slot it was given */
+   size_t uSlot;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Write pcMessage, about the key list pcFileName, to stderr and exit
+   with EXIT_FAILURE. */
+
+static void fail(const char *pcFileName, const char *pcMessage)
+{
+   fprintf(stderr, "symtablegen: %s: %s\n", pcFileName, pcMessage);
+   exit(EXIT_FAILURE);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a copy of the uLength bytes at pcText, terminated by '\0'.
+   Exit with EXIT_FAILURE if memory is insufficient. */
+
+static char *copyText(const char *pcText, size_t uLength)
+{
+   char *pcCopy = (char*)malloc(uLength + 1);
+   if (pcCopy == NULL)
+   {
+      fprintf(stderr, "symtablegen: insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+   memcpy(pcCopy, pcText, uLength);
+   pcCopy[uLength] = '\0';
+   return pcCopy;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new string of pcText followed by pcSuffix. Exit with
+   EXIT_FAILURE if memory is insufficient. */
+
+static char *appendText(const char *pcText, const char *pcSuffix)
+{
+   char *pcJoined = (char*)malloc(strlen(pcText) + strlen(pcSuffix) + 1);
+   if (pcJoined == NULL)
+   {
+      fprintf(stderr, "symtablegen: insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+   strcpy(pcJoined, pcText);
+   strcat(pcJoined, pcSuffix);
+   return pcJoined;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Read the key list named pcFileName. Store the number of keys in
+   *puCount and return an array of them. Exit with EXIT_FAILURE if the
+   file cannot be read, if a line is too long, if a key appears twice,
+   or if memory is insufficient. */
+
+static struct Key *readKeys(const char *pcFileName, size_t *puCount)
+{
+   char acLine[MAX_LINE_LENGTH + 2];
+   struct Key *psKeys = NULL;
+   size_t uCapacity = 0;
+   size_t uCount = 0;
+   SymTable_T oSeen;
+   FILE *psFile;
+
+   psFile = fopen(pcFileName, "r");
+   if (psFile == NULL)
+      fail(pcFileName, "cannot open");
+   oSeen = SymTable_new();
+   if (oSeen == NULL)
+      fail(pcFileName, "insufficient memory");
+
+   while (fgets(acLine, (int)sizeof(acLine), psFile) != NULL)
+   {
+      size_t uLineLength = strlen(acLine);
+      size_t uKeyLength;
+      char *pcValue;
+
+      if (uLineLength > MAX_LINE_LENGTH)
+         fail(pcFileName, "line too long");
+      while (uLineLength > 0 && (acLine[uLineLength - 1] == '\n' ||
+         acLine[uLineLength - 1] == '\r'))
+         acLine[--uLineLength] = '\0';
+      if (uLineLength == 0 || acLine[0] == '#')
+         continue;
+
+      /* The key ends at the first white space; the value follows */
+      uKeyLength = strcspn(acLine, " \t");
+      pcValue = acLine + uKeyLength;
+      pcValue += strspn(pcValue, " \t");
+      if (uKeyLength == 0)
+         fail(pcFileName, "line begins with white space");
+
+      if (uCount == uCapacity)
+      {
+         uCapacity = uCapacity == 0 ? 64 : 2 * uCapacity;
+         psKeys = (struct Key*)realloc(psKeys,
+            uCapacity * sizeof(struct Key));
+         if (psKeys == NULL)
+            fail(pcFileName, "insufficient memory");
+      }
+      psKeys[uCount].pcKey = copyText(acLine, uKeyLength);
+      psKeys[uCount].uLength = uKeyLength;
+      psKeys[uCount].pcValue = *pcValue == '\0' ? NULL :
+         copyText(pcValue, strlen(pcValue));
+      if (! SymTable_put(oSeen, psKeys[uCount].pcKey, NULL))
+      {
+         fprintf(stderr, "symtablegen: %s: duplicate key %s\n",
+            pcFileName, psKeys[uCount].pcKey);
+         exit(EXIT_FAILURE);
+      }
+      uCount++;
+   }
+
+   if (ferror(psFile))
+      fail(pcFileName, "read error");
+   fclose(psFile);
+   SymTable_free(oSeen);
+   *puCount = uCount;
+   return psKeys;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the four bytes at pucBytes as a little-endian word. Building
+   the word from bytes, rather than loading it, makes the hash the same
+   on every host; compilers fold it into one load where they can. */
+
+static uint64_t read32(const unsigned char *pucBytes)
+{
+   return (uint64_t)pucBytes[0] | (uint64_t)pucBytes[1] << 8 |
+      (uint64_t)pucBytes[2] << 16 | (uint64_t)pucBytes[3] << 24;
+}
+
+/* Return the eight bytes at pucBytes as a little-endian word. */
+
+static uint64_t read64(const unsigned char *pucBytes)
+{
+   return read32(pucBytes) | read32(pucBytes + 4) << 32;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the hash of the uLength bytes at pcKey, uLength at least 1,
+   under uSeed. Like wyhash, it reads a short key as two overlapping
+   words (three bytes if the key is shorter than four), so that its
+   cost does not depend on the length, and a longer key eight bytes at
+   a time, ending with the last eight. The length is mixed in after the
+   last multiply, where two keys of different lengths that reach the
+   same product under one seed will not under another. */
+
+static uint64_t hashKey(const char *pcKey, size_t uLength, uint64_t uSeed)
+{
+   const unsigned char *pucKey = (const unsigned char*)pcKey;
+   uint64_t uHash = HASH_OFFSET ^ uSeed;
+   uint64_t uWord;
+   size_t u;
+
+   if (uLength > 8)
+   {
+      for (u = 0; u + 8 < uLength; u += 8)
+         uHash = (uHash ^ read64(pucKey + u)) * WORD_MULTIPLIER;
+      uWord = read64(pucKey + uLength - 8);
+   }
+   else if (uLength >= 4)
+      uWord = read32(pucKey) << 32 | read32(pucKey + uLength - 4);
+   else
+      uWord = (uint64_t)pucKey[0] << 16 |
+         (uint64_t)pucKey[uLength / 2] << 8 | pucKey[uLength - 1];
+   return ((uHash ^ uWord) * WORD_MULTIPLIER) ^ uLength;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the bucket, among uBucketCount, of a key that hashes to
+   uHash. */
+
+static size_t getBucket(uint64_t uHash, size_t uBucketCount)
+{
+   return (size_t)(((uHash >> 32) * uBucketCount) >> 32);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the slot, among uSlotCount, that pilot uPilot sends a key
+   that hashes to uHash to. */
+
+static size_t getSlot(uint64_t uHash, uint32_t uPilot,
+   size_t uSlotCount)
+{
+   uint64_t uMixed = (uHash ^ uPilot) * PILOT_MULTIPLIER;
+   return (size_t)(((uMixed >> 32) * uSlotCount) >> 32);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The bucket sizes, for compareBucketSizes. */
+
+static const size_t *puSortBucketSizes;
+
+/* Order the buckets that pvFirst and pvSecond point to largest first,
+   for qsort. */
+
+static int compareBucketSizes(const void *pvFirst, const void *pvSecond)
+{
+   size_t uFirst = puSortBucketSizes[*(const size_t*)pvFirst];
+   size_t uSecond = puSortBucketSizes[*(const size_t*)pvSecond];
+   return (uFirst < uSecond) - (uFirst > uSecond);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Try to find, for the uCount keys of psKeys hashed with uSeed, a
+   pilot for each of uBucketCount buckets that gives every key its own
+   slot among uCount. Store the pilots in auPilots and each key's slot
+   in its uSlot. Return 1 (TRUE) on success, 0 (FALSE) if some bucket
+   fits under no pilot. Buckets are placed largest first, while most
+   slots are still free. */
+
+static int findPilots(struct Key *psKeys, size_t uCount,
+   uint64_t uSeed, size_t uBucketCount, uint32_t auPilots[])
+{
+   uint32_t uPilotLimit = MIN_PILOT_LIMIT;
+   size_t *puSizes;
+   size_t *puStarts;
+   size_t *puMembers;
+   size_t *puOrder;
+   unsigned char *pucTaken;
+   size_t uBucket;
+   size_t u;
+   size_t v;
+   int iSuccessful = 1;
+
+   /* One below the largest uint32_t, so that uPilot can pass it */
+   if (uCount > (0xfffffffeUL - MIN_PILOT_LIMIT) / PILOT_LIMIT_PER_KEY)
+      uPilotLimit = 0xfffffffeUL;
+   else if (uCount * PILOT_LIMIT_PER_KEY > uPilotLimit)
+      uPilotLimit = (uint32_t)(uCount * PILOT_LIMIT_PER_KEY);
+
+   puSizes = (size_t*)calloc(uBucketCount, sizeof(size_t));
+   puStarts = (size_t*)calloc(uBucketCount + 1, sizeof(size_t));
+   puMembers = (size_t*)malloc((uCount + 1) * sizeof(size_t));
+   puOrder = (size_t*)malloc(uBucketCount * sizeof(size_t));
+   pucTaken = (unsigned char*)calloc(uCount + 1, 1);
+   if (puSizes == NULL || puStarts == NULL || puMembers == NULL ||
+      puOrder == NULL || pucTaken == NULL)
+   {
+      fprintf(stderr, "symtablegen: insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+
+   /* Group the keys by bucket: bucket b's keys are the indices
+      puMembers[puStarts[b]] up to puMembers[puStarts[b + 1]] */
+   for (u = 0; u < uCount; u++)
+   {
+      psKeys[u].uHash = hashKey(psKeys[u].pcKey, psKeys[u].uLength,
+         uSeed);
+      puSizes[getBucket(psKeys[u].uHash, uBucketCount)]++;
+   }
+   for (uBucket = 0; uBucket < uBucketCount; uBucket++)
+      puStarts[uBucket + 1] = puStarts[uBucket] + puSizes[uBucket];
+   for (u = 0; u < uCount; u++)
+   {
+      uBucket = getBucket(psKeys[u].uHash, uBucketCount);
+      puMembers[puStarts[uBucket] + --puSizes[uBucket]] = u;
+   }
+   for (uBucket = 0; uBucket < uBucketCount; uBucket++)
+   {
+      puSizes[uBucket] = puStarts[uBucket + 1] - puStarts[uBucket];
+      puOrder[uBucket] = uBucket;
+   }
+   puSortBucketSizes = puSizes;
+   qsort(puOrder, uBucketCount, sizeof(size_t), compareBucketSizes);
+
+   for (v = 0; v < uBucketCount && iSuccessful; v++)
+   {
+      uint32_t uPilot;
+      uBucket = puOrder[v];
+      auPilots[uBucket] = 0;
+      if (puSizes[uBucket] == 0)
+         continue;
+
+      for (uPilot = 0; uPilot <= uPilotLimit; uPilot++)
+      {
+         for (u = puStarts[uBucket]; u < puStarts[uBucket + 1]; u++)
+         {
+            struct Key *psKey = &psKeys[puMembers[u]];
+            psKey->uSlot = getSlot(psKey->uHash, uPilot, uCount);
+            if (pucTaken[psKey->uSlot])
+               break;
+            pucTaken[psKey->uSlot] = 1;
+         }
+         if (u == puStarts[uBucket + 1])
+            break;
+
+         /* Free the slots this pilot took before it failed */
+         while (u-- > puStarts[uBucket])
+            pucTaken[psKeys[puMembers[u]].uSlot] = 0;
+      }
+      if (uPilot > uPilotLimit)
+         iSuccessful = 0;
+      else
+         auPilots[uBucket] = uPilot;
+   }
+
+   free(puSizes);
+   free(puStarts);
+   free(puMembers);
+   free(puOrder);
+   free(pucTaken);
+   return iSuccessful;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write the uLength bytes at pcText to psFile as the contents of a C
+   string literal. */
+
+static void writeLiteral(FILE *psFile, const char *pcText, size_t uLength)
+{
+   size_t u;
+
+   for (u = 0; u < uLength; u++)
+   {
+      unsigned char c = (unsigned char)pcText[u];
+      if (c == '"' || c == '\\')
+         fprintf(psFile, "\\%c", c);
+      else if (c < ' ' || c > '~' || c == '?')
+         /* Three octal digits, so a following digit cannot join the
+            escape, and '?' so that no trigraph forms */
+         fprintf(psFile, "\\%03o", c);
+      else
+         putc(c, psFile);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Open pcFileName for writing and write the banner of a generated file
+   to it. Return the file. Exit with EXIT_FAILURE if it cannot be
+   opened. */
+
+static FILE *openOutput(const char *pcFileName, const char *pcKeyFile)
+{
+   FILE *psFile = fopen(pcFileName, "w");
+   if (psFile == NULL)
+      fail(pcFileName, "cannot create");
+   fprintf(psFile, "/* %s: generated by symtablegen from %s. */\n",
+      pcFileName, pcKeyFile);
+   fprintf(psFile, "/* Do not edit; edit the key list and regenerate. */\n\n");
+   return psFile;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write to pcHeaderName the declarations of the lookup functions named
+   with pcPrefix, and of the SymTable_T handle if iAsSymTable. */
+
+static void writeHeader(const char *pcHeaderName, const char *pcKeyFile,
+   const char *pcPrefix, int iAsSymTable)
+{
+   FILE *psFile = openOutput(pcHeaderName, pcKeyFile);
+
+   fprintf(psFile, "#ifndef %s_INCLUDED\n#define %s_INCLUDED\n", pcPrefix,
+      pcPrefix);
+   fprintf(psFile, "#include <stddef.h>\n");
+   if (iAsSymTable)
+      fprintf(psFile, "#include \"symtable.h\"\n");
+   fprintf(psFile, "\n");
+   fprintf(psFile,
+      "/* A read-only table of the keys listed in\n%s.\n"
+      "Each function behaves as the SymTable function of the same name\n"
+      "does on a table that is never changed. */\n\n", pcKeyFile);
+   fprintf(psFile, "size_t %s_getLength(void);\n\n", pcPrefix);
+   fprintf(psFile, "int %s_contains(const char *pcKey);\n\n", pcPrefix);
+   fprintf(psFile, "void *%s_get(const char *pcKey);\n\n", pcPrefix);
+   fprintf(psFile, "void %s_map(void (*pfApply)(const char *pcKey, "
+      "void *pvValue, void *pvExtra),\n   const void *pvExtra);\n\n",
+      pcPrefix);
+   if (iAsSymTable)
+   {
+      fprintf(psFile,
+         "/* Returns the same table as a read-only SymTable_T. This file's\n"
+         "source defines every function of symtable.h, so no other SymTable\n"
+         "may be linked into the same program. SymTable_put,\n"
+         "SymTable_replace and SymTable_remove change nothing and return 0,\n"
+         "NULL and NULL; SymTable_free does nothing; SymTable_new returns\n"
+         "NULL, since no other table can be made. */\n\n");
+      fprintf(psFile, "SymTable_T %s_getTable(void);\n\n", pcPrefix);
+   }
+   fprintf(psFile, "#endif\n");
+   if (fclose(psFile) != 0)
+      fail(pcHeaderName, "write error");
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write to psFile the SymTable_T handle for the table whose lookup
+   functions are named with pcPrefix, and the functions of symtable.h
+   that take it. */
+
+static void writeSymTable(FILE *psFile, const char *pcPrefix)
+{
+   fprintf(psFile,
+      "/* The table that %s_getTable returns. There is only one, so\n"
+      "   every SymTable function checks that it is given this one. */\n\n"
+      "struct SymTable\n{\n   int iReadOnly;\n};\n\n"
+      "static struct SymTable sTable = {1};\n\n", pcPrefix);
+   fprintf(psFile, "SymTable_T %s_getTable(void)\n{\n"
+      "   return &sTable;\n}\n\n", pcPrefix);
+   fprintf(psFile, "SymTable_T SymTable_new(void)\n{\n"
+      "   return NULL;\n}\n\n");
+   fprintf(psFile, "size_t SymTable_getLength(SymTable_T oSymTable)\n{\n"
+      "   assert(oSymTable == &sTable);\n   (void)oSymTable;\n"
+      "   return %s_getLength();\n}\n\n", pcPrefix);
+   fprintf(psFile, "void SymTable_free(SymTable_T oSymTable)\n{\n"
+      "   assert(oSymTable == &sTable);\n   (void)oSymTable;\n}\n\n");
+   fprintf(psFile, "int SymTable_put(SymTable_T oSymTable,\n"
+      "   const char *pcKey, const void *pvValue)\n{\n"
+      "   assert(oSymTable == &sTable);\n   assert(pcKey != NULL);\n"
+      "   (void)oSymTable;\n   (void)pcKey;\n   (void)pvValue;\n"
+      "   return 0;\n}\n\n");
+   fprintf(psFile, "void *SymTable_replace(SymTable_T oSymTable,\n"
+      "   const char *pcKey, const void *pvValue)\n{\n"
+      "   assert(oSymTable == &sTable);\n   assert(pcKey != NULL);\n"
+      "   (void)oSymTable;\n   (void)pcKey;\n   (void)pvValue;\n"
+      "   return NULL;\n}\n\n");
+   fprintf(psFile, "int SymTable_contains(SymTable_T oSymTable, "
+      "const char *pcKey)\n{\n"
+      "   assert(oSymTable == &sTable);\n   assert(pcKey != NULL);\n"
+      "   (void)oSymTable;\n"
+      "   return %s_contains(pcKey);\n}\n\n", pcPrefix);
+   fprintf(psFile, "void *SymTable_get(SymTable_T oSymTable, "
+      "const char *pcKey)\n{\n"
+      "   assert(oSymTable == &sTable);\n   assert(pcKey != NULL);\n"
+      "   (void)oSymTable;\n"
+      "   return %s_get(pcKey);\n}\n\n", pcPrefix);
+   fprintf(psFile, "void *SymTable_remove(SymTable_T oSymTable, "
+      "const char *pcKey)\n{\n"
+      "   assert(oSymTable == &sTable);\n   assert(pcKey != NULL);\n"
+      "   (void)oSymTable;\n   (void)pcKey;\n"
+      "   return NULL;\n}\n\n");
+   fprintf(psFile, "void SymTable_map(SymTable_T oSymTable,\n"
+      "   void (*pfApply)(const char *pcKey, void *pvValue, "
+      "void *pvExtra),\n   const void *pvExtra)\n{\n"
+      "   assert(oSymTable == &sTable);\n   assert(pfApply != NULL);\n"
+      "   (void)oSymTable;\n"
+      "   %s_map(pfApply, pvExtra);\n}\n", pcPrefix);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write to pcSourceName the static data and the lookup functions for
+   the uCount keys of psKeys, each in the slot findPilots gave it,
+   with the uBucketCount pilots of auPilots and the seed uSeed; and,
+   if iAsSymTable, the SymTable_T handle around them. */
+
+static void writeSource(const char *pcSourceName, const char *pcHeaderName,
+   const char *pcKeyFile, const char *pcPrefix, const struct Key *psKeys,
+   size_t uCount, size_t uBucketCount, const uint32_t auPilots[],
+   uint64_t uSeed, int iAsSymTable)
+{
+   FILE *psFile = openOutput(pcSourceName, pcKeyFile);
+   const struct Key **ppsBySlot;
+   size_t uMinLength = (size_t)-1;
+   size_t uMaxLength = 0;
+   uint32_t uMaxPilot = 0;
+   size_t u;
+
+   ppsBySlot = (const struct Key**)malloc((uCount + 1) * sizeof(*ppsBySlot));
+   if (ppsBySlot == NULL)
+      fail(pcSourceName, "insufficient memory");
+   for (u = 0; u < uCount; u++)
+   {
+      ppsBySlot[psKeys[u].uSlot] = &psKeys[u];
+      if (psKeys[u].uLength < uMinLength)
+         uMinLength = psKeys[u].uLength;
+      if (psKeys[u].uLength > uMaxLength)
+         uMaxLength = psKeys[u].uLength;
+   }
+   for (u = 0; u < uBucketCount; u++)
+      if (auPilots[u] > uMaxPilot)
+         uMaxPilot = auPilots[u];
+
+   if (iAsSymTable)
+      fprintf(psFile, "#include <assert.h>\n");
+   fprintf(psFile, "#include <stdint.h>\n#include <string.h>\n");
+   fprintf(psFile, "#include \"%s\"\n\n", pcHeaderName);
+
+   if (uCount == 0)
+   {
+      fprintf(psFile, "size_t %s_getLength(void) { return 0; }\n\n",
+         pcPrefix);
+      fprintf(psFile, "int %s_contains(const char *pcKey) "
+         "{ (void)pcKey; return 0; }\n\n", pcPrefix);
+      fprintf(psFile, "void *%s_get(const char *pcKey) "
+         "{ (void)pcKey; return NULL; }\n\n", pcPrefix);
+      fprintf(psFile, "void %s_map(void (*pfApply)(const char *pcKey, "
+         "void *pvValue, void *pvExtra),\n   const void *pvExtra) "
+         "{ (void)pfApply; (void)pvExtra; }\n", pcPrefix);
+   }
+   else
+   {
+      fprintf(psFile,
+         "/* %lu keys of %lu to %lu bytes, in %lu buckets. */\n\n"
+         "enum {KEY_COUNT = %lu, BUCKET_COUNT = %lu};\n"
+         "enum {MIN_LENGTH = %lu, MAX_LENGTH = %lu};\n\n",
+         (unsigned long)uCount, (unsigned long)uMinLength,
+         (unsigned long)uMaxLength, (unsigned long)uBucketCount,
+         (unsigned long)uCount, (unsigned long)uBucketCount,
+         (unsigned long)uMinLength, (unsigned long)uMaxLength);
+
+      fprintf(psFile, "/* Each bucket's pilot: the value that sends "
+         "every key of the bucket\n   to a slot of its own. */\n\n");
+      fprintf(psFile, "static const uint%d_t auPilots[BUCKET_COUNT] = {",
+         uMaxPilot > 65535 ? 32 : 16);
+      for (u = 0; u < uBucketCount; u++)
+         fprintf(psFile, "%s%s%lu", u == 0 ? "" : ",",
+            u % 12 == 0 ? "\n   " : " ", (unsigned long)auPilots[u]);
+      fprintf(psFile, "\n};\n\n");
+
+      fprintf(psFile, "/* The bindings, each in its key's slot. */\n\n");
+      fprintf(psFile, "static const struct\n{\n   const char *pcKey;\n"
+         "   size_t uLength;\n   const void *pvValue;\n"
+         "} asEntries[KEY_COUNT] =\n{\n");
+      for (u = 0; u < uCount; u++)
+      {
+         const struct Key *psKey = ppsBySlot[u];
+         fprintf(psFile, "   {\"");
+         writeLiteral(psFile, psKey->pcKey, psKey->uLength);
+         fprintf(psFile, "\", %lu, ", (unsigned long)psKey->uLength);
+         if (psKey->pcValue != NULL)
+            fprintf(psFile, "(const void*)(%s)", psKey->pcValue);
+         else
+         {
+            fprintf(psFile, "\"");
+            writeLiteral(psFile, psKey->pcKey, psKey->uLength);
+            fprintf(psFile, "\"");
+         }
+         fprintf(psFile, "}%s\n", u + 1 < uCount ? "," : "");
+      }
+      fprintf(psFile, "};\n\n");
+
+      fprintf(psFile,
+         "/* Return the four or eight bytes at pucBytes as a little-endian\n"
+         "   word. */\n\n"
+         "static uint64_t read32(const unsigned char *pucBytes)\n{\n"
+         "   return (uint64_t)pucBytes[0] | (uint64_t)pucBytes[1] << 8 |\n"
+         "      (uint64_t)pucBytes[2] << 16 | (uint64_t)pucBytes[3] << 24;\n"
+         "}\n\n"
+         "static uint64_t read64(const unsigned char *pucBytes)\n{\n"
+         "   return read32(pucBytes) | read32(pucBytes + 4) << 32;\n}\n\n"
+         "/* Return the slot of pcKey, or KEY_COUNT if pcKey is not a key. */"
+         "\n\n"
+         "static size_t find(const char *pcKey)\n{\n"
+         "   const unsigned char *pucKey = (const unsigned char*)pcKey;\n"
+         "   uint64_t uHash = %lluULL;\n"
+         "   uint64_t uWord;\n"
+         "   size_t uLength = strlen(pcKey);\n"
+         "   size_t uSlot;\n\n"
+         "   if (uLength < MIN_LENGTH || uLength > MAX_LENGTH)\n"
+         "      return KEY_COUNT;\n"
+         "   if (uLength > 8)\n   {\n"
+         "      size_t u;\n"
+         "      for (u = 0; u + 8 < uLength; u += 8)\n"
+         "         uHash = (uHash ^ read64(pucKey + u)) * %lluULL;\n"
+         "      uWord = read64(pucKey + uLength - 8);\n   }\n"
+         "   else if (uLength >= 4)\n"
+         "      uWord = read32(pucKey) << 32 | read32(pucKey + uLength - 4);\n"
+         "   else\n"
+         "      uWord = (uint64_t)pucKey[0] << 16 |\n"
+         "         (uint64_t)pucKey[uLength / 2] << 8 | pucKey[uLength - 1];\n"
+         "   uHash = ((uHash ^ uWord) * %lluULL) ^ uLength;\n\n"
+         "   uSlot = (size_t)(((uHash >> 32) * BUCKET_COUNT) >> 32);\n"
+         "   uHash = (uHash ^ auPilots[uSlot]) * %lluULL;\n"
+         "   uSlot = (size_t)(((uHash >> 32) * KEY_COUNT) >> 32);\n\n"
+         "   if (asEntries[uSlot].uLength != uLength ||\n"
+         "      memcmp(asEntries[uSlot].pcKey, pcKey, uLength) != 0)\n"
+         "      return KEY_COUNT;\n"
+         "   return uSlot;\n}\n\n",
+         (unsigned long long)(HASH_OFFSET ^ uSeed),
+         (unsigned long long)WORD_MULTIPLIER,
+         (unsigned long long)WORD_MULTIPLIER,
+         (unsigned long long)PILOT_MULTIPLIER);
+
+      fprintf(psFile, "size_t %s_getLength(void)\n{\n"
+         "   return KEY_COUNT;\n}\n\n", pcPrefix);
+      fprintf(psFile, "int %s_contains(const char *pcKey)\n{\n"
+         "   return find(pcKey) != KEY_COUNT;\n}\n\n", pcPrefix);
+      fprintf(psFile, "void *%s_get(const char *pcKey)\n{\n"
+         "   size_t uSlot = find(pcKey);\n"
+         "   if (uSlot == KEY_COUNT)\n      return NULL;\n"
+         "   return (void*)asEntries[uSlot].pvValue;\n}\n\n", pcPrefix);
+      fprintf(psFile, "void %s_map(void (*pfApply)(const char *pcKey, "
+         "void *pvValue, void *pvExtra),\n   const void *pvExtra)\n{\n"
+         "   size_t uSlot;\n"
+         "   for (uSlot = 0; uSlot < KEY_COUNT; uSlot++)\n"
+         "      (*pfApply)(asEntries[uSlot].pcKey,\n"
+         "         (void*)asEntries[uSlot].pvValue, (void*)pvExtra);\n}\n",
+         pcPrefix);
+   }
+   if (iAsSymTable)
+   {
+      fprintf(psFile, "\n");
+      writeSymTable(psFile, pcPrefix);
+   }
+
+   free(ppsBySlot);
+   if (fclose(psFile) != 0)
+      fail(pcSourceName, "write error");
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Generate a static table of the keys listed in argv[1]. argv[2] is
+   the prefix of the generated functions, and argv[3] the base name of
+   the generated files: argv[3].c and argv[3].h. If the arguments
+   begin with -s, the generated source also serves the table as a
+   read-only SymTable_T. Exit with EXIT_FAILURE if the arguments are
+   wrong, if the key list cannot be read or holds a key twice, if no
+   seed gives a perfect hash, or if an output file cannot be written.
+   Otherwise return 0. */
+
+int main(int argc, char *argv[])
+{
+   const char *pcProgram = argv[0];
+   int iAsSymTable = 0;
+   struct Key *psKeys;
+   uint32_t *auPilots;
+   char *pcSourceName;
+   char *pcHeaderName;
+   const char *pcHeaderBase;
+   size_t uCount;
+   size_t uBucketCount;
+   uint64_t uSeed = 0;
+   int iSeed;
+   size_t u;
+
+   if (argc == 5 && strcmp(argv[1], "-s") == 0)
+   {
+      iAsSymTable = 1;
+      argc--;
+      argv++;
+   }
+   if (argc != 4)
+   {
+      fprintf(stderr, "Usage: %s [-s] keylist prefix outputbase\n",
+         pcProgram);
+      exit(EXIT_FAILURE);
+   }
+
+   psKeys = readKeys(argv[1], &uCount);
+   uBucketCount = uCount / BUCKET_KEYS + 1;
+   auPilots = (uint32_t*)calloc(uBucketCount, sizeof(uint32_t));
+   if (auPilots == NULL)
+      fail(argv[1], "insufficient memory");
+
+   for (iSeed = 0; iSeed < MAX_SEEDS; iSeed++)
+   {
+      uSeed = (uint64_t)iSeed * GOLDEN;
+      if (findPilots(psKeys, uCount, uSeed, uBucketCount, auPilots))
+         break;
+   }
+   if (iSeed == MAX_SEEDS)
+      fail(argv[1], "no perfect hash found");
+
+   pcSourceName = appendText(argv[3], ".c");
+   pcHeaderName = appendText(argv[3], ".h");
+
+   /* The source includes the header by its name, without directory */
+   pcHeaderBase = strrchr(pcHeaderName, '/');
+   pcHeaderBase = pcHeaderBase == NULL ? pcHeaderName : pcHeaderBase + 1;
+
+   writeHeader(pcHeaderName, argv[1], argv[2], iAsSymTable);
+   writeSource(pcSourceName, pcHeaderBase, argv[1], argv[2], psKeys,
+      uCount, uBucketCount, auPilots, uSeed, iAsSymTable);
+
+   for (u = 0; u < uCount; u++)
+   {
+      free(psKeys[u].pcKey);
+      free(psKeys[u].pcValue);
+   }
+   free(psKeys);
+   free(auPilots);
+   free(pcSourceName);
+   free(pcHeaderName);
+   return 0;
+}
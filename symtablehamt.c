@@ -0,0 +1,712 @@
+/*--------------------------------------------------------------------*/
+/* symtablehamt.c                                                     */
+/* Persistent hash array mapped trie with constant-time cloning       */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "symtable.h"
+#include "symtablehamt.h"
+#include "symtablehashfn.h"
+
+/*
+ * POPCNT_INSTRUCTION: 1 where the compiler may use the CPU's popcount
+ * instruction, as with -mpopcnt or -march=native; elsewhere the bits
+ * are counted with shifts and masks, which is still branch-free.
+ */
+#if defined(__GNUC__) && defined(__POPCNT__)
+#define POPCNT_INSTRUCTION 1
+#else
+#define POPCNT_INSTRUCTION 0
+#endif
+
+/*
+ * LEVEL_BITS: How many bits of a key's hash pick its child at each
+ * level. A node then has up to 32 children, marked in a 32-bit bitmap,
+ * and a table of a million bindings is four or five levels deep.
+ */
+#define LEVEL_BITS 5
+#define LEVEL_MASK ((1u << LEVEL_BITS) - 1)
+
+/*
+ * HASH_BITS: The bits of a hash. A node this many bits or more below
+ * the root is a collision node: its bindings all have the same hash,
+ * and it holds them in no order, to be searched one by one.
+ */
+#define HASH_BITS 64
+
+/*
+ * MAX_DEPTH: The most nodes on a path from the root, the collision
+ * node included.
+ */
+#define MAX_DEPTH ((HASH_BITS + LEVEL_BITS - 1) / LEVEL_BITS + 1)
+
+/*
+ * SymTableEntry: One binding, the leaf of the trie. The key is stored
+ * at the end of the entry's own allocation. Clones share entries as
+ * they share nodes.
+ */
+struct SymTableEntry {
+    /* How many nodes point to the entry */
+    size_t refCount;
+
+    /* The key's hash */
+    uint64_t hash;
+
+    /* The value */
+    const void *pvValue;
+
+    /* The key's length */
+    size_t keyLength;
+
+    /* The key and its terminating '\0' */
+    char acKey[];
+};
+
+/*
+ * Node: An inner node of the trie, holding only the children that
+ * exist, packed in increasing order of the hash bits that pick them.
+ * Bit i of the bitmap is set if the child for bits i exists, and the
+ * child's index is the number of set bits below bit i. A child pointer
+ * with its lowest bit set is a SymTableEntry instead, which malloc's
+ * alignment leaves free to mark.
+ *
+ * A node that no other node or table shares, its reference count 1,
+ * is changed in place; a shared one is copied first. A node other
+ * than the root never holds a single entry and nothing else: a remove
+ * that would leave it so puts the entry in its place.
+ */
+struct Node {
+    /* How many nodes and tables point to the node */
+    size_t refCount;
+
+    /* Which children exist; unused in a collision node */
+    uint32_t bitmap;
+
+    /* Number of children */
+    uint32_t count;
+
+    /* The children */
+    struct Node *apsChildren[];
+};
+
+/*
+ * SymTable: A hash array mapped trie, possibly sharing nodes with
+ * clones.
+ */
+struct SymTable {
+    /* The root, never NULL; it has no children in an empty table */
+    struct Node *psRoot;
+
+    /* Total number of bindings in the table */
+    size_t nodeQuantity;
+
+    /* The hash function and the seed it is given, shared by clones */
+    SymTableHashFn_T pfHash;
+    uint64_t hashSeed;
+};
+
+/*
+ * Returns 1 if a child pointer is a leaf, 0 if it is a node.
+ */
+static int symtablehamt_isLeaf(const struct Node *psNode) {
+    return ((uintptr_t)psNode & 1) != 0;
+}
+
+/*
+ * Gives the entry that a leaf pointer marks.
+ */
+static struct SymTableEntry *symtablehamt_entry(const struct Node *psNode) {
+    return (struct SymTableEntry*)((uintptr_t)psNode - 1);
+}
+
+/*
+ * Gives the child pointer that marks an entry as a leaf.
+ */
+static struct Node *symtablehamt_leaf(struct SymTableEntry *psEntry) {
+    return (struct Node*)((uintptr_t)psEntry + 1);
+}
+
+/*
+ * Counts the set bits of `bits`.
+ */
+static unsigned int symtablehamt_popcount(uint32_t bits) {
+#if POPCNT_INSTRUCTION
+    return (unsigned int)__builtin_popcount(bits);
+#else
+    bits = bits - ((bits >> 1) & 0x55555555u);
+    bits = (bits & 0x33333333u) + ((bits >> 2) & 0x33333333u);
+    bits = (bits + (bits >> 4)) & 0x0f0f0f0fu;
+    return (unsigned int)((bits * 0x01010101u) >> 24);
+#endif
+}
+
+/*
+ * Gives the bitmap bit of the child that a hash picks `shift` bits
+ * below the root.
+ */
+static uint32_t symtablehamt_bit(uint64_t hash, unsigned int shift) {
+    return (uint32_t)1 << ((hash >> shift) & LEVEL_MASK);
+}
+
+/*
+ * Gives the index among a node's children of the child marked by
+ * `bit`, whether or not it exists.
+ */
+static unsigned int symtablehamt_index(const struct Node *psNode, uint32_t bit) {
+    return symtablehamt_popcount(psNode->bitmap & (bit - 1));
+}
+
+/*
+ * Allocates a node with room for `count` children, not yet set.
+ * Returns the node, or NULL if memory is insufficient.
+ */
+static struct Node *symtablehamt_newNode(uint32_t count) {
+    struct Node *psNode = (struct Node*)malloc(sizeof(struct Node) + count * sizeof(struct Node*));
+
+    if (psNode == NULL) return NULL;
+    psNode->refCount = 1;
+    psNode->bitmap = 0;
+    psNode->count = count;
+    return psNode;
+}
+
+/*
+ * Allocates an entry binding `pcKey`, of length `keyLength` and hash
+ * `hash`, to `pvValue`.
+ * Returns the entry, or NULL if memory is insufficient.
+ */
+static struct SymTableEntry *symtablehamt_newEntry(const char *pcKey, size_t keyLength, uint64_t hash,
+                                                   const void *pvValue) {
+    struct SymTableEntry *psEntry = (struct SymTableEntry*)malloc(sizeof(struct SymTableEntry) + keyLength + 1);
+
+    if (psEntry == NULL) return NULL;
+    psEntry->refCount = 1;
+    psEntry->hash = hash;
+    psEntry->pvValue = pvValue;
+    psEntry->keyLength = keyLength;
+    memcpy(psEntry->acKey, pcKey, keyLength + 1);
+    return psEntry;
+}
+
+/*
+ * Adds a reference to a child, node or leaf.
+ */
+static void symtablehamt_retain(struct Node *psChild) {
+    if (symtablehamt_isLeaf(psChild)) {
+        symtablehamt_entry(psChild)->refCount++;
+    } else {
+        psChild->refCount++;
+    }
+}
+
+/*
+ * Drops a reference to a child, node or leaf, freeing it and then
+ * dropping its own references if it was the last.
+ */
+static void symtablehamt_release(struct Node *psChild) {
+    uint32_t i;
+
+    if (symtablehamt_isLeaf(psChild)) {
+        struct SymTableEntry *psEntry = symtablehamt_entry(psChild);
+        if (--psEntry->refCount == 0) free(psEntry);
+        return;
+    }
+    if (--psChild->refCount != 0) return;
+    for (i = 0; i < psChild->count; i++) {
+        symtablehamt_release(psChild->apsChildren[i]);
+    }
+    free(psChild);
+}
+
+/*
+ * Makes the node at `*ppsNode` one that nothing else shares, so that
+ * it can be changed in place: if it is shared, puts a copy in its place
+ * that holds a new reference to each of its children.
+ * Returns 1 on success, or 0 if memory is insufficient, in which case
+ * nothing changes.
+ */
+static int symtablehamt_own(struct Node **ppsNode) {
+    struct Node *psNode = *ppsNode;
+    struct Node *psCopy;
+    uint32_t i;
+
+    if (psNode->refCount == 1) return 1;
+
+    psCopy = symtablehamt_newNode(psNode->count);
+    if (psCopy == NULL) return 0;
+    psCopy->bitmap = psNode->bitmap;
+    memcpy(psCopy->apsChildren, psNode->apsChildren, psNode->count * sizeof(struct Node*));
+    for (i = 0; i < psNode->count; i++) {
+        symtablehamt_retain(psNode->apsChildren[i]);
+    }
+    psNode->refCount--;
+    *ppsNode = psCopy;
+    return 1;
+}
+
+/*
+ * Inserts `psChild` at index `index` among the children of the
+ * unshared node at `*ppsNode`, which may move.
+ * Returns 1 on success, or 0 if memory is insufficient, in which case
+ * nothing changes.
+ */
+static int symtablehamt_insertChild(struct Node **ppsNode, unsigned int index, struct Node *psChild) {
+    struct Node *psNode = *ppsNode;
+
+    assert(psNode->refCount == 1);
+
+    psNode = (struct Node*)realloc(psNode, sizeof(struct Node) + (psNode->count + 1) * sizeof(struct Node*));
+    if (psNode == NULL) return 0;
+    memmove(psNode->apsChildren + index + 1, psNode->apsChildren + index,
+            (psNode->count - index) * sizeof(struct Node*));
+    psNode->apsChildren[index] = psChild;
+    psNode->count++;
+    *ppsNode = psNode;
+    return 1;
+}
+
+/*
+ * Takes the child at index `index` out of the unshared node at
+ * `*ppsNode`, which may move, without dropping the reference to it.
+ */
+static void symtablehamt_eraseChild(struct Node **ppsNode, unsigned int index) {
+    struct Node *psNode = *ppsNode;
+    struct Node *psSmaller;
+
+    assert(psNode->refCount == 1);
+
+    memmove(psNode->apsChildren + index, psNode->apsChildren + index + 1,
+            (psNode->count - index - 1) * sizeof(struct Node*));
+    psNode->count--;
+
+    /* If shrinking fails, the node simply keeps its room */
+    psSmaller = (struct Node*)realloc(psNode, sizeof(struct Node) + psNode->count * sizeof(struct Node*));
+    if (psSmaller != NULL) *ppsNode = psSmaller;
+}
+
+/*
+ * Builds the subtree that holds two leaves whose keys differ but whose
+ * hashes agree on their first `shift` bits: a node for each further
+ * level on which the hashes agree, each with the next as its only
+ * child, then a node with both leaves, a collision node if the hashes
+ * are equal.
+ * Returns the subtree's top node, which takes over the references to
+ * both leaves, or NULL if memory is insufficient.
+ */
+static struct Node *symtablehamt_pair(struct Node *psLeafA, uint64_t hashA, struct Node *psLeafB, uint64_t hashB,
+                                      unsigned int shift) {
+    struct Node *apsNodes[MAX_DEPTH];
+    unsigned int bottom = shift;
+    unsigned int levels, i;
+    uint32_t bitA, bitB;
+
+    while (bottom < HASH_BITS && symtablehamt_bit(hashA, bottom) == symtablehamt_bit(hashB, bottom)) {
+        bottom += LEVEL_BITS;
+    }
+    levels = (bottom - shift) / LEVEL_BITS + 1;
+
+    for (i = 0; i < levels; i++) {
+        apsNodes[i] = symtablehamt_newNode(i + 1 < levels ? 1 : 2);
+        if (apsNodes[i] == NULL) {
+            while (i > 0) free(apsNodes[--i]);
+            return NULL;
+        }
+    }
+    for (i = 0; i + 1 < levels; i++) {
+        apsNodes[i]->bitmap = symtablehamt_bit(hashA, shift + i * LEVEL_BITS);
+        apsNodes[i]->apsChildren[0] = apsNodes[i + 1];
+    }
+
+    apsNodes[levels - 1]->apsChildren[0] = psLeafA;
+    apsNodes[levels - 1]->apsChildren[1] = psLeafB;
+    if (bottom < HASH_BITS) {
+        bitA = symtablehamt_bit(hashA, bottom);
+        bitB = symtablehamt_bit(hashB, bottom);
+        apsNodes[levels - 1]->bitmap = bitA | bitB;
+        if (bitB < bitA) {
+            apsNodes[levels - 1]->apsChildren[0] = psLeafB;
+            apsNodes[levels - 1]->apsChildren[1] = psLeafA;
+        }
+    }
+    return apsNodes[0];
+}
+
+/*
+ * Finds the entry that holds a key.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `pcKey`, `keyLength`, `hash`: the key, its length and its hash
+ * Returns the entry, or NULL if the table has no such key.
+ */
+static struct SymTableEntry *symtablehamt_find(SymTable_T oSymTable, const char *pcKey, size_t keyLength,
+                                               uint64_t hash) {
+    const struct Node *psNode = oSymTable->psRoot;
+    const struct Node *psChild;
+    struct SymTableEntry *psEntry;
+    unsigned int shift;
+    uint32_t bit, i;
+
+    for (shift = 0; shift < HASH_BITS; shift += LEVEL_BITS) {
+        bit = symtablehamt_bit(hash, shift);
+        if ((psNode->bitmap & bit) == 0) return NULL;
+        psChild = psNode->apsChildren[symtablehamt_index(psNode, bit)];
+        if (symtablehamt_isLeaf(psChild)) {
+            psEntry = symtablehamt_entry(psChild);
+            if (psEntry->hash == hash && psEntry->keyLength == keyLength &&
+                memcmp(psEntry->acKey, pcKey, keyLength) == 0) {
+                return psEntry;
+            }
+            return NULL;
+        }
+        psNode = psChild;
+    }
+
+    /* A collision node */
+    for (i = 0; i < psNode->count; i++) {
+        psEntry = symtablehamt_entry(psNode->apsChildren[i]);
+        if (psEntry->keyLength == keyLength && memcmp(psEntry->acKey, pcKey, keyLength) == 0) return psEntry;
+    }
+    return NULL;
+}
+
+/*
+ * Makes every node on the path to an entry unshared, and records where
+ * each hangs.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `psEntry`: an entry of the table
+ *   - `appsPath`: receives, for each node from the root down, the
+ *     pointer that points to it
+ *   - `puIndex`: receives the entry's index in the last node
+ * Returns the number of nodes on the path, or 0 if memory is
+ * insufficient, in which case the path may be partly copied but the
+ * table's bindings are unchanged.
+ */
+static unsigned int symtablehamt_ownPath(SymTable_T oSymTable, const struct SymTableEntry *psEntry,
+                                         struct Node **appsPath[], unsigned int *puIndex) {
+    struct Node **ppsNode = &oSymTable->psRoot;
+    struct Node *psNode;
+    unsigned int depth = 0, shift, index;
+
+    for (shift = 0;; shift += LEVEL_BITS) {
+        if (!symtablehamt_own(ppsNode)) return 0;
+        appsPath[depth++] = ppsNode;
+        psNode = *ppsNode;
+        if (shift >= HASH_BITS) {
+            for (index = 0; symtablehamt_entry(psNode->apsChildren[index]) != psEntry; index++) {
+                assert(index + 1 < psNode->count);
+            }
+            break;
+        }
+        index = symtablehamt_index(psNode, symtablehamt_bit(psEntry->hash, shift));
+        if (symtablehamt_isLeaf(psNode->apsChildren[index])) {
+            assert(symtablehamt_entry(psNode->apsChildren[index]) == psEntry);
+            break;
+        }
+        ppsNode = &psNode->apsChildren[index];
+    }
+    *puIndex = index;
+    return depth;
+}
+
+/*
+ * Applies *pfApply to every binding under a node.
+ */
+static void symtablehamt_mapNode(const struct Node *psNode,
+                                 void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+                                 const void *pvExtra) {
+    const struct SymTableEntry *psEntry;
+    uint32_t i;
+
+    for (i = 0; i < psNode->count; i++) {
+        if (symtablehamt_isLeaf(psNode->apsChildren[i])) {
+            psEntry = symtablehamt_entry(psNode->apsChildren[i]);
+            (*pfApply)(psEntry->acKey, (void*)psEntry->pvValue, (void*)pvExtra);
+        } else {
+            symtablehamt_mapNode(psNode->apsChildren[i], pfApply, pvExtra);
+        }
+    }
+}
+
+/* Sets up a new, empty symbol table whose keys are hashed with
+   *pfHash and a seed of its own.
+   Returns a pointer to the table or NULL if there's an allocation
+   issue. */
+SymTable_T SymTable_newWithHash(SymTableHashFn_T pfHash) {
+    SymTable_T oSymTable;
+
+    assert(pfHash != NULL);
+
+    oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+    if (oSymTable == NULL) return NULL;
+
+    oSymTable->psRoot = symtablehamt_newNode(0);
+    if (oSymTable->psRoot == NULL) {
+        free(oSymTable);
+        return NULL;
+    }
+    oSymTable->nodeQuantity = 0;
+    oSymTable->pfHash = pfHash;
+    oSymTable->hashSeed = SymTableHash_randomSeed();
+    return oSymTable;
+}
+
+/* Sets up a new, empty symbol table hashed with SymTableHash_wyhash.
+   Returns a pointer to the table or NULL if there's an allocation
+   issue. */
+SymTable_T SymTable_new(void) {
+    return SymTable_newWithHash(SymTableHash_wyhash);
+}
+
+/* Gives a second table sharing every node of the first.
+   Arguments -> `oSymTable`: the symbol table to clone
+   Returns the clone, or NULL if there's an allocation issue. */
+SymTable_T SymTable_clone(SymTable_T oSymTable) {
+    SymTable_T oClone;
+
+    assert(oSymTable != NULL);
+
+    oClone = (SymTable_T)malloc(sizeof(struct SymTable));
+    if (oClone == NULL) return NULL;
+    *oClone = *oSymTable;
+    oSymTable->psRoot->refCount++;
+    return oClone;
+}
+
+/* Returns the number of bindings in the table.
+   Arguments -> `oSymTable`: the symbol table */
+size_t SymTable_getLength(SymTable_T oSymTable) {
+    assert(oSymTable != NULL);
+    return oSymTable->nodeQuantity;
+}
+
+/* Drops the table's reference to its root, which frees every node and
+   entry that no clone still shares, and frees the table.
+   Arguments -> `oSymTable`: the symbol table to be freed */
+void SymTable_free(SymTable_T oSymTable) {
+    assert(oSymTable != NULL);
+
+    symtablehamt_release(oSymTable->psRoot);
+    free(oSymTable);
+}
+
+/*
+ * Adds a new key-value pair to the symbol table if the key doesn't already exist.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `pcKey`: string key to add
+ *   - `pvValue`: the value associated with `pcKey`
+ * Copies each shared node on the way down, then puts the new leaf in
+ * the free slot its hash picks, or else pairs it with the leaf already
+ * there in a new subtree.
+ * Returns 1 on success, 0 on failure or if the key exists.
+ */
+int SymTable_put(SymTable_T oSymTable, const char *pcKey, const void *pvValue) {
+    struct SymTableEntry *psEntry;
+    struct Node **ppsNode = &oSymTable->psRoot;
+    struct Node *psNode, *psChild, *psPair;
+    size_t keyLength;
+    uint64_t hash;
+    unsigned int shift, index;
+    uint32_t bit;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    keyLength = strlen(pcKey);
+    hash = (*oSymTable->pfHash)(pcKey, keyLength, oSymTable->hashSeed);
+    if (symtablehamt_find(oSymTable, pcKey, keyLength, hash) != NULL) return 0;
+
+    psEntry = symtablehamt_newEntry(pcKey, keyLength, hash, pvValue);
+    if (psEntry == NULL) return 0;
+
+    for (shift = 0;; shift += LEVEL_BITS) {
+        if (!symtablehamt_own(ppsNode)) break;
+        psNode = *ppsNode;
+
+        if (shift >= HASH_BITS) {
+            if (!symtablehamt_insertChild(ppsNode, psNode->count, symtablehamt_leaf(psEntry))) break;
+            oSymTable->nodeQuantity++;
+            return 1;
+        }
+
+        bit = symtablehamt_bit(hash, shift);
+        index = symtablehamt_index(psNode, bit);
+        if ((psNode->bitmap & bit) == 0) {
+            if (!symtablehamt_insertChild(ppsNode, index, symtablehamt_leaf(psEntry))) break;
+            (*ppsNode)->bitmap |= bit;
+            oSymTable->nodeQuantity++;
+            return 1;
+        }
+
+        psChild = psNode->apsChildren[index];
+        if (symtablehamt_isLeaf(psChild)) {
+            psPair = symtablehamt_pair(psChild, symtablehamt_entry(psChild)->hash, symtablehamt_leaf(psEntry),
+                                       hash, shift + LEVEL_BITS);
+            if (psPair == NULL) break;
+            psNode->apsChildren[index] = psPair;
+            oSymTable->nodeQuantity++;
+            return 1;
+        }
+        ppsNode = &psNode->apsChildren[index];
+    }
+
+    /* Out of memory: nodes copied so far hold the same bindings */
+    free(psEntry);
+    return 0;
+}
+
+/*
+ * Replaces the value of an existing key in the table.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `pcKey`: the key whose value we want to update
+ *   - `pvValue`: the new value to store
+ * Changes the entry in place if nothing else shares it, and otherwise
+ * puts a copy of it in place of the leaf.
+ * Returns the old value, or NULL if the key doesn't exist.
+ */
+void *SymTable_replace(SymTable_T oSymTable, const char *pcKey, const void *pvValue) {
+    struct Node **appsPath[MAX_DEPTH];
+    struct SymTableEntry *psEntry, *psCopy;
+    struct Node *psNode;
+    size_t keyLength;
+    unsigned int depth, index;
+    void *oldValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    keyLength = strlen(pcKey);
+    psEntry = symtablehamt_find(oSymTable, pcKey, keyLength,
+                                (*oSymTable->pfHash)(pcKey, keyLength, oSymTable->hashSeed));
+    if (psEntry == NULL) return NULL;
+    oldValue = (void*)psEntry->pvValue;
+
+    depth = symtablehamt_ownPath(oSymTable, psEntry, appsPath, &index);
+    if (depth == 0) return NULL;
+
+    if (psEntry->refCount == 1) {
+        psEntry->pvValue = pvValue;
+        return oldValue;
+    }
+    psCopy = symtablehamt_newEntry(psEntry->acKey, keyLength, psEntry->hash, pvValue);
+    if (psCopy == NULL) return NULL;
+    psNode = *appsPath[depth - 1];
+    psNode->apsChildren[index] = symtablehamt_leaf(psCopy);
+    psEntry->refCount--;
+    return oldValue;
+}
+
+/*
+ * Checks if a key exists in the table.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `pcKey`: the key to look for
+ * Returns 1 if the key is found, 0 if not.
+ */
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey) {
+    size_t keyLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    keyLength = strlen(pcKey);
+    return symtablehamt_find(oSymTable, pcKey, keyLength,
+                             (*oSymTable->pfHash)(pcKey, keyLength, oSymTable->hashSeed)) != NULL;
+}
+
+/*
+ * Gets the value associated with a given key.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `pcKey`: the key to look for
+ * Returns the value if the key is found, NULL if not.
+ */
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey) {
+    struct SymTableEntry *psEntry;
+    size_t keyLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    keyLength = strlen(pcKey);
+    psEntry = symtablehamt_find(oSymTable, pcKey, keyLength,
+                                (*oSymTable->pfHash)(pcKey, keyLength, oSymTable->hashSeed));
+    return psEntry != NULL ? (void*)psEntry->pvValue : NULL;
+}
+
+/*
+ * Removes a key-value pair from the table.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `pcKey`: the key to remove
+ * Copies each shared node on the path to the leaf and takes the leaf
+ * out. Then, from the bottom up, a node other than the root that is
+ * left with a single leaf is replaced by that leaf, so that the trie
+ * stays as shallow as its keys allow.
+ * Returns the value of the removed binding, or NULL if the key doesn't
+ * exist.
+ */
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey) {
+    struct Node **appsPath[MAX_DEPTH];
+    struct SymTableEntry *psEntry;
+    struct Node *psNode;
+    size_t keyLength;
+    unsigned int depth, index;
+    void *oldValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    keyLength = strlen(pcKey);
+    psEntry = symtablehamt_find(oSymTable, pcKey, keyLength,
+                                (*oSymTable->pfHash)(pcKey, keyLength, oSymTable->hashSeed));
+    if (psEntry == NULL) return NULL;
+    oldValue = (void*)psEntry->pvValue;
+
+    depth = symtablehamt_ownPath(oSymTable, psEntry, appsPath, &index);
+    if (depth == 0) return NULL;
+
+    psNode = *appsPath[depth - 1];
+    if ((depth - 1) * LEVEL_BITS < HASH_BITS) {
+        psNode->bitmap &= ~symtablehamt_bit(psEntry->hash, (depth - 1) * LEVEL_BITS);
+    }
+    symtablehamt_release(psNode->apsChildren[index]);
+    symtablehamt_eraseChild(appsPath[depth - 1], index);
+
+    for (; depth > 1; depth--) {
+        psNode = *appsPath[depth - 1];
+        if (psNode->count != 1 || !symtablehamt_isLeaf(psNode->apsChildren[0])) break;
+        *appsPath[depth - 1] = psNode->apsChildren[0];
+        free(psNode);
+    }
+
+    oSymTable->nodeQuantity--;
+    return oldValue;
+}
+
+/*
+ * SymTable_map:
+ * Applies the given function *pfApply to each key-value pair in the SymTable,
+ * in the order of their hashes.
+ * Parameters:
+ *   oSymTable - A pointer to the SymTable.
+ *   pfApply - A pointer to a function that takes three parameters:
+ *     - The key (const char *)
+ *     - The value (void *)
+ *     - An extra parameter provided by the caller (void *)
+ *   pvExtra - A pointer to the extra parameter that will be passed to *pfApply.
+ */
+void SymTable_map(SymTable_T oSymTable,
+                  void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+                  const void *pvExtra) {
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    symtablehamt_mapNode(oSymTable->psRoot, pfApply, pvExtra);
+}
@@ -0,0 +1,42 @@
+/*--------------------------------------------------------------------*/
+/* symtablehamt.h                                                     */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#ifndef SymTableHAMT_INCLUDED
+#define SymTableHAMT_INCLUDED
+#include "symtable.h"
+#include "symtablehashfn.h"
+
+/* Extensions to the SymTable ADT that only the hash array mapped trie
+implementation (symtablehamt.c) provides. That implementation is
+persistent: a table can be cloned in constant time, and the clone and
+the original then share every node until one of them changes. A change
+copies only the nodes on the path to the binding it touches, a handful
+even for millions of bindings, and leaves the other table as it was.
+This suits work that forks a table, tries some changes and then keeps
+or drops them.
+
+Tables that share nodes may be read from several threads at once, but
+a change to any of them must not run at the same time as any other
+call on any of them. A SymTable_put, SymTable_replace or
+SymTable_remove that needs to copy shared nodes and finds memory
+insufficient leaves the table unchanged and returns 0, NULL or NULL. */
+
+/* Returns a SymTable containing no bindings whose keys are hashed with
+*pfHash, for example one of the functions declared in symtablehashfn.h,
+instead of SymTableHash_wyhash. Keys whose hashes are all equal are
+still told apart, only more slowly. Returns NULL if memory is
+insufficient. */
+
+SymTable_T SymTable_newWithHash(SymTableHashFn_T pfHash);
+
+/* Returns a new SymTable with the same bindings as oSymTable, in time
+that does not depend on how many there are. Either table may then be
+changed or freed without affecting the other. The keys are shared, not
+copied; the values are the same pointers. Returns NULL if memory is
+insufficient. */
+
+SymTable_T SymTable_clone(SymTable_T oSymTable);
+
+#endif
@@ -4,10 +4,20 @@
 /* Author: Ephraim Meles                                              */
 /*--------------------------------------------------------------------*/
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <assert.h>
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "symtable.h"
+#include "symtablehash.h"
+#include "symtablemph.h"
+#include "symtablesnapshot.h"
 
 /*
  * INITIAL_BUCKET_COUNT: Sets the initial number of buckets in the hash table.
@@ -23,9 +33,13 @@
 /*
  * primes: Array of prime numbers used for resizing the table to reduce collisions.
  * Each prime value is selected to increase bucket count when resizing the table.
+ * They run to about 2^31 buckets, so chains stay short well past a billion
+ * bindings; every value still fits in a 32-bit size_t.
  */
 static const size_t primes[] = {
-    509, 1021, 2039, 4093, 8191, 16381, 32771, 65537, 131071, 262147
+    509, 1021, 2039, 4093, 8191, 16381, 32771, 65537, 131071, 262147,
+    524309, 1048583, 2097169, 4194319, 8388617, 16777259, 33554467,
+    67108879, 134217757, 268435459, 536870923, 1073741827, 2147483659u
 };
 
 /*
@@ -35,24 +49,72 @@ static const size_t primes[] = {
 static const size_t PRIME_COUNT = sizeof(primes) / sizeof(primes[0]);
 
 /*
- * HASH_SHIFT_AMOUNT: Defines the left shift amount used in the hash function.
- * This helps spread the bits of each character in the key, improving the hash.
+ * MAX_RESIZE_THREADS: The most threads that may split one resize.
+ */
+#define MAX_RESIZE_THREADS 64
+
+/*
+ * PARALLEL_RESIZE_MIN_NODES: Resizes of tables smaller than this run on
+ * the calling thread, since starting workers would cost more than the
+ * rehash itself.
+ */
+#define PARALLEL_RESIZE_MIN_NODES 4096
+
+/*
+ * READER_RECHECK_STEPS: How many chain steps an optimistic reader of a
+ * read-mostly table takes between checks of the sequence counter.
+ */
+#define READER_RECHECK_STEPS 64
+
+/*
+ * LONG_CHAIN_LENGTH: A put that leaves a chain longer than this, plus
+ * four times the average chain length, treats the keys as an attack
+ * and reseeds the table. With a well-seeded hash an honest key set
+ * practically never produces such a chain.
+ */
+#define LONG_CHAIN_LENGTH 16
+
+/*
+ * MAX_RESEEDS: How many times one table may reseed. Keys that collide
+ * under every seed (a hash that ignores its seed, or a flood of equal
+ * hashes) would otherwise rehash the table on every put.
+ */
+#define MAX_RESEEDS 3
+
+/*
+ * BATCH_CHUNK: Batch operations hash and prefetch this many keys at a
+ * time, which bounds the scratch arrays they keep on the stack.
  */
-#define HASH_SHIFT_AMOUNT 5
+#define BATCH_CHUNK 64
+
+/*
+ * PARALLEL_LOAD_MIN_BYTES: Text files smaller than this are loaded on
+ * the calling thread alone.
+ */
+#define PARALLEL_LOAD_MIN_BYTES 65536
 
 /*
  * SymTableNode: Represents a single entry in the hash table. Each node stores
- * a key-value pair and a pointer to the next node in its bucket.
+ * a key-value pair and a pointer to the next node in its bucket. The key
+ * is stored at the end of the node's own allocation, so a chain walk
+ * that compares keys touches no memory beyond the nodes it visits.
  */
 struct SymTableNode {
-    /* The key */
-    char *pcKey;
-
     /* The value */
     const void *pvValue;
 
+    /* The key's full hash, kept so that a resize never rehashes a key
+       and so that most mismatches are rejected without reading the key */
+    size_t hash;
+
     /* Pointer to the next node in the linked list */
     struct SymTableNode *psNextNode;
+
+    /* The key's length, compared before any of its bytes */
+    size_t keyLength;
+
+    /* The key and its terminating '\0' */
+    char acKey[];
 };
 
 /*
@@ -72,27 +134,131 @@ struct SymTable {
 
     /* Current index in the primes array for resizing */
     size_t currentPrimeIndex;
+
+    /* Node count above which the next put resizes, that is
+       LOAD_FACTOR_THRESHOLD * bucketCount rounded down */
+    size_t resizeThreshold;
+
+    /* The function that hashes keys, and the seed passed to it */
+    SymTableHashFn_T pfHash;
+    uint64_t hashSeed;
+
+    /* 1 if a reseed also moves the table to SipHash, which is the case
+       for tables that did not choose their hash function */
+    int reseedToSipHash;
+
+    /* 1 while a table from SymTable_newWithSeed still hashes with the
+       function and seed it was made with, so that a hash passed in by
+       the caller can be used as is */
+    int callerHashValid;
+
+    /* How many more times a long chain may reseed the table */
+    size_t reseedsLeft;
+
+    /* Number of threads that rehash the nodes during a resize */
+    size_t resizeThreads;
+
+    /* 1 if readers run optimistically under `sequence`, 0 otherwise */
+    int isReadMostly;
+
+    /* Read-mostly only: odd while a writer is changing the table */
+    unsigned long sequence;
+
+    /* Read-mostly only: serializes writers */
+    pthread_mutex_t writerLock;
+
+    /* Read-mostly only: nodes unlinked by remove, chained through
+       psNextNode. An optimistic reader may still be walking them, so
+       they are freed only by SymTable_free. */
+    struct SymTableNode *psRetiredNodes;
+
+    /* Read-mostly only: bucket arrays replaced by a resize */
+    struct RetiredBuckets *psRetiredBuckets;
+
+    /* NULL until SymTable_freeze; then every binding lives here, and
+       `buckets` is empty */
+    SymTableMPH_T oFrozen;
+
+    /* NULL unless the table came from SymTable_openMapped; then every
+       binding lives in the mapped file, and `buckets` is empty */
+    SymTableSnapshot_T oMapped;
+};
+
+/*
+ * RetiredBuckets: A bucket array that a resize replaced while
+ * optimistic readers may still be indexing into it.
+ */
+struct RetiredBuckets {
+    /* The old bucket array */
+    struct SymTableNode **buckets;
+
+    /* The next retired array */
+    struct RetiredBuckets *psNext;
 };
 
 /*
- * Hashes a key to find its bucket index in the table.
+ * Hashes a key with the table's hash function.
  * Arguments:
+ *   - `oSymTable`: the symbol table whose function and seed are used
  *   - `pcKey`: the string key to hash
- *   - `bucketCount`: total number of buckets in the hash table
- * The function calculates a hash by shifting and adding each character in `pcKey`.
- * Returns an index (unsigned int) for storing the key-value pair.
+ *   - `keyLength`: strlen(pcKey)
+ * The function and seed are loaded atomically because an optimistic
+ * reader of a read-mostly table may race with a reseed; the sequence
+ * counter then makes it retry.
+ * Returns the full hash; the bucket index is the hash modulo the
+ * bucket count.
  */
-static unsigned int symtablehash_hashFunction(const char *pcKey, size_t bucketCount) {
-    unsigned int hash = 0U;
+static size_t symtablehash_hashFunction(SymTable_T oSymTable, const char *pcKey, size_t keyLength) {
+    SymTableHashFn_T pfHash;
+    uint64_t hashSeed;
 
     /* Validate that the key is not NULL */
     assert(pcKey != NULL);
 
-    
-    while (*pcKey != '\0') {
-        hash = (hash << HASH_SHIFT_AMOUNT) + (unsigned int)(*pcKey++);
+    pfHash = __atomic_load_n(&oSymTable->pfHash, __ATOMIC_RELAXED);
+    hashSeed = __atomic_load_n(&oSymTable->hashSeed, __ATOMIC_RELAXED);
+    return (size_t)(*pfHash)(pcKey, keyLength, hashSeed);
+}
+
+/*
+ * Gives the hash of a key under the table's current function and seed.
+ * `puCallerHash` is NULL, or points to the key's hash under the
+ * function and seed given to SymTable_newWithSeed, which is used as is
+ * unless the table has reseeded since.
+ */
+static size_t symtablehash_keyHash(SymTable_T oSymTable, const char *pcKey, size_t keyLength,
+                                   const uint64_t *puCallerHash) {
+    if (puCallerHash != NULL && __atomic_load_n(&oSymTable->callerHashValid, __ATOMIC_RELAXED)) {
+        return (size_t)*puCallerHash;
     }
-    return hash % bucketCount;
+    return symtablehash_hashFunction(oSymTable, pcKey, keyLength);
+}
+
+/*
+ * Tells whether a node holds a key. The hash and the length, both in
+ * the node, reject nearly every other key before a byte is compared.
+ */
+static int symtablehash_nodeMatches(const struct SymTableNode *psNode, size_t hash,
+                                    const char *pcKey, size_t keyLength) {
+    return psNode->hash == hash && psNode->keyLength == keyLength &&
+           memcmp(psNode->acKey, pcKey, keyLength) == 0;
+}
+
+/*
+ * Tells whether a table is frozen or mapped, in which case no binding
+ * may be added, changed or removed.
+ */
+static int symtablehash_isImmutable(SymTable_T oSymTable) {
+    return oSymTable->oFrozen != NULL || oSymTable->oMapped != NULL;
+}
+
+/*
+ * Gives the number of nodes a table with `bucketCount` buckets may hold
+ * before a put resizes it. Comparing against this precomputed count
+ * keeps the floating-point load factor out of every put.
+ */
+static size_t symtablehash_getResizeThreshold(size_t bucketCount) {
+    return (size_t)((double)bucketCount * LOAD_FACTOR_THRESHOLD);
 }
 
 /* Sets up a new, empty symbol table.
@@ -106,7 +272,20 @@ SymTable_T SymTable_new(void) {
 
     oSymTable->currentPrimeIndex = 0;
     oSymTable->bucketCount = primes[oSymTable->currentPrimeIndex];
+    oSymTable->resizeThreshold = symtablehash_getResizeThreshold(oSymTable->bucketCount);
     oSymTable->nodeQuantity = 0;
+    oSymTable->pfHash = SymTableHash_wyhash;
+    oSymTable->hashSeed = SymTableHash_randomSeed();
+    oSymTable->reseedToSipHash = 1;
+    oSymTable->callerHashValid = 0;
+    oSymTable->reseedsLeft = MAX_RESEEDS;
+    oSymTable->resizeThreads = 1;
+    oSymTable->isReadMostly = 0;
+    oSymTable->sequence = 0;
+    oSymTable->psRetiredNodes = NULL;
+    oSymTable->psRetiredBuckets = NULL;
+    oSymTable->oFrozen = NULL;
+    oSymTable->oMapped = NULL;
     oSymTable->buckets = (struct SymTableNode**)calloc(oSymTable->bucketCount, sizeof(struct SymTableNode*));
     
     if (oSymTable->buckets == NULL) {
@@ -117,6 +296,92 @@ SymTable_T SymTable_new(void) {
     return oSymTable;
 }
 
+/* Sets up a new, empty symbol table whose readers never lock.
+   SymTable_get and SymTable_contains read the sequence counter, walk
+   the chain, and retry only if a writer ran meanwhile. Writers are
+   serialized by a mutex and bump the counter around every change.
+   Returns a pointer to the table or NULL if there's an allocation issue. */
+SymTable_T SymTable_newReadMostly(void) {
+    SymTable_T oSymTable;
+
+    oSymTable = SymTable_new();
+    if (oSymTable == NULL) return NULL;
+
+    if (pthread_mutex_init(&oSymTable->writerLock, NULL) != 0) {
+        SymTable_free(oSymTable);
+        return NULL;
+    }
+    oSymTable->isReadMostly = 1;
+    return oSymTable;
+}
+
+/* Sets up a new, empty symbol table that hashes keys with `pfHash`.
+   Returns a pointer to the table or NULL if there's an allocation issue. */
+SymTable_T SymTable_newWithHash(SymTableHashFn_T pfHash) {
+    SymTable_T oSymTable;
+
+    assert(pfHash != NULL);
+
+    oSymTable = SymTable_new();
+    if (oSymTable == NULL) return NULL;
+
+    oSymTable->pfHash = pfHash;
+    oSymTable->reseedToSipHash = 0;
+    return oSymTable;
+}
+
+/* Sets up a new, empty symbol table that hashes keys with `pfHash` and
+   `uSeed`, so that a caller who hashes a key the same way can pass the
+   hash to the SymTable_*Hashed functions.
+   Returns a pointer to the table or NULL if there's an allocation issue. */
+SymTable_T SymTable_newWithSeed(SymTableHashFn_T pfHash, uint64_t uSeed) {
+    SymTable_T oSymTable;
+
+    oSymTable = SymTable_newWithHash(pfHash);
+    if (oSymTable == NULL) return NULL;
+
+    oSymTable->hashSeed = uSeed;
+    oSymTable->callerHashValid = 1;
+    return oSymTable;
+}
+
+/* Sets how many threads rehash the nodes when the table grows.
+   Arguments -> `oSymTable`: the symbol table
+                `uThreadCount`: 1 to rehash on the calling thread only
+   Counts above MAX_RESIZE_THREADS are clamped. */
+void SymTable_setResizeThreads(SymTable_T oSymTable, size_t uThreadCount) {
+    assert(oSymTable != NULL);
+    assert(uThreadCount > 0);
+
+    if (uThreadCount > MAX_RESIZE_THREADS) uThreadCount = MAX_RESIZE_THREADS;
+    oSymTable->resizeThreads = uThreadCount;
+}
+
+/*
+ * Starts a change to a read-mostly table: takes the writer lock and
+ * makes the sequence counter odd so that optimistic readers retry.
+ * Does nothing for an ordinary table.
+ */
+static void symtablehash_beginWrite(SymTable_T oSymTable) {
+    if (!oSymTable->isReadMostly) return;
+
+    pthread_mutex_lock(&oSymTable->writerLock);
+    __atomic_store_n(&oSymTable->sequence, oSymTable->sequence + 1, __ATOMIC_RELAXED);
+    /* Order the odd counter before every store the change makes */
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+/*
+ * Finishes a change started by symtablehash_beginWrite: makes the
+ * sequence counter even again and releases the writer lock.
+ */
+static void symtablehash_endWrite(SymTable_T oSymTable) {
+    if (!oSymTable->isReadMostly) return;
+
+    __atomic_store_n(&oSymTable->sequence, oSymTable->sequence + 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&oSymTable->writerLock);
+}
+
 /* Releases all memory used by the symbol table.
    Frees up each key-value node and the main structure itself.
    Arguments -> `oSymTable`: the symbol table to be freed
@@ -132,13 +397,35 @@ void SymTable_free(SymTable_T oSymTable) {
         psCurrentNode = oSymTable->buckets[i];
         while (psCurrentNode != NULL) {
             psNextNode = psCurrentNode->psNextNode;
-            free((char*)psCurrentNode->pcKey);
             free(psCurrentNode);
             psCurrentNode = psNextNode;
         }
         i++;
     }
     free(oSymTable->buckets);
+
+    /* Retired memory of a read-mostly table */
+    psCurrentNode = oSymTable->psRetiredNodes;
+    while (psCurrentNode != NULL) {
+        psNextNode = psCurrentNode->psNextNode;
+        free(psCurrentNode);
+        psCurrentNode = psNextNode;
+    }
+    while (oSymTable->psRetiredBuckets != NULL) {
+        struct RetiredBuckets *psRetired = oSymTable->psRetiredBuckets;
+        oSymTable->psRetiredBuckets = psRetired->psNext;
+        free(psRetired->buckets);
+        free(psRetired);
+    }
+    if (oSymTable->isReadMostly) {
+        pthread_mutex_destroy(&oSymTable->writerLock);
+    }
+    if (oSymTable->oFrozen != NULL) {
+        SymTableMPH_free(oSymTable->oFrozen);
+    }
+    if (oSymTable->oMapped != NULL) {
+        SymTableSnapshot_close(oSymTable->oMapped);
+    }
     free(oSymTable);
 }
 
@@ -150,107 +437,331 @@ void SymTable_free(SymTable_T oSymTable) {
  */
 size_t SymTable_getLength(SymTable_T oSymTable) {
     assert(oSymTable != NULL);
-    return oSymTable->nodeQuantity;
+    return __atomic_load_n(&oSymTable->nodeQuantity, __ATOMIC_RELAXED);
+}
+
+/*
+ * ResizeWork: One slice of a resize. The nodes of old buckets
+ * [firstBucket, endBucket) are moved into `newBuckets`, rehashed with
+ * `pfNewHash` and `newSeed` if `pfNewHash` is not NULL.
+ */
+struct ResizeWork {
+    /* The table being resized */
+    SymTable_T oSymTable;
+
+    /* The bucket array being filled */
+    struct SymTableNode **newBuckets;
+
+    /* Number of buckets in `newBuckets` */
+    size_t newBucketCount;
+
+    /* For a reseed, the function and seed that every key is rehashed
+       with; NULL to keep the stored hashes */
+    SymTableHashFn_T pfNewHash;
+    uint64_t newSeed;
+
+    /* First old bucket of the slice */
+    size_t firstBucket;
+
+    /* One past the last old bucket of the slice */
+    size_t endBucket;
+
+    /* 1 if other threads fill `newBuckets` at the same time */
+    int isShared;
+};
+
+/*
+ * Moves every node of one slice of the old bucket array into the new
+ * bucket array. When other slices are being moved by other threads,
+ * each node is pushed onto its new chain with a compare-and-swap of
+ * the chain head; otherwise plain stores are enough.
+ */
+static void symtablehash_rehashRange(struct ResizeWork *psWork) {
+    struct SymTableNode **newBuckets = psWork->newBuckets;
+    size_t i;
+
+    for (i = psWork->firstBucket; i < psWork->endBucket; i++) {
+        struct SymTableNode *psCurrentNode = psWork->oSymTable->buckets[i];
+        while (psCurrentNode != NULL) {
+            struct SymTableNode *psNextNode = psCurrentNode->psNextNode;
+            struct SymTableNode *psHead;
+
+            size_t newIndex;
+
+            /* The stored hash picks the new bucket unless this is a reseed */
+            if (psWork->pfNewHash != NULL) {
+                __atomic_store_n(&psCurrentNode->hash,
+                                 (size_t)(*psWork->pfNewHash)(psCurrentNode->acKey, psCurrentNode->keyLength,
+                                                              psWork->newSeed),
+                                 __ATOMIC_RELAXED);
+            }
+            newIndex = psCurrentNode->hash % psWork->newBucketCount;
+
+            /* Insert node into the new bucket array */
+            if (psWork->isShared) {
+                psHead = __atomic_load_n(&newBuckets[newIndex], __ATOMIC_RELAXED);
+                do {
+                    __atomic_store_n(&psCurrentNode->psNextNode, psHead, __ATOMIC_RELAXED);
+                } while (!__atomic_compare_exchange_n(&newBuckets[newIndex], &psHead, psCurrentNode,
+                                                      1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+            } else {
+                __atomic_store_n(&psCurrentNode->psNextNode, newBuckets[newIndex], __ATOMIC_RELAXED);
+                newBuckets[newIndex] = psCurrentNode;
+            }
+
+            psCurrentNode = psNextNode;
+        }
+    }
+}
+
+/*
+ * Thread entry point that moves the slice described by `pvArg`.
+ */
+static void *symtablehash_rehashWorker(void *pvArg) {
+    symtablehash_rehashRange((struct ResizeWork*)pvArg);
+    return NULL;
+}
+
+/*
+ * Moves every node into the new bucket array using the table's
+ * `resizeThreads` threads, the calling thread included. Each thread
+ * takes an equal slice of the old bucket array. A slice whose worker
+ * could not be started is moved by the calling thread instead.
+ */
+static void symtablehash_rehashParallel(struct ResizeWork *psWhole) {
+    struct ResizeWork asWork[MAX_RESIZE_THREADS];
+    pthread_t aThreads[MAX_RESIZE_THREADS];
+    int aiStarted[MAX_RESIZE_THREADS];
+    size_t threadCount = psWhole->oSymTable->resizeThreads;
+    size_t oldBucketCount = psWhole->endBucket;
+    size_t t;
+
+    for (t = 0; t < threadCount; t++) {
+        asWork[t] = *psWhole;
+        asWork[t].firstBucket = oldBucketCount * t / threadCount;
+        asWork[t].endBucket = oldBucketCount * (t + 1) / threadCount;
+        asWork[t].isShared = 1;
+    }
+
+    /* Slice 0 belongs to the calling thread */
+    aiStarted[0] = 0;
+    for (t = 1; t < threadCount; t++) {
+        aiStarted[t] = pthread_create(&aThreads[t], NULL, symtablehash_rehashWorker, &asWork[t]) == 0;
+    }
+
+    symtablehash_rehashRange(&asWork[0]);
+    for (t = 1; t < threadCount; t++) {
+        if (aiStarted[t]) {
+            pthread_join(aThreads[t], NULL);
+        } else {
+            symtablehash_rehashRange(&asWork[t]);
+        }
+    }
 }
 
 /*
  * Expands the hash table if it becomes too full (load factor is exceeded).
  * Arguments:
  *   - `oSymTable`: the symbol table to resize
+ *   - `newPrimeIndex`: index in `primes` of the new bucket count
+ *   - `pfNewHash`: NULL to keep the table's hash function; otherwise
+ *     the function that every key is rehashed with, and that the table
+ *     uses from then on
+ *   - `newSeed`: the seed that goes with `pfNewHash`
  * Sets up a larger bucket array and redistributes all nodes into new buckets.
  * If memory allocation fails, it leaves the table unchanged.
  */
-static void symtablehash_resizeHashTable(SymTable_T oSymTable) {
-    size_t newPrimeIndex;
+static void symtablehash_resizeHashTable(SymTable_T oSymTable, size_t newPrimeIndex,
+                                         SymTableHashFn_T pfNewHash, uint64_t newSeed) {
     size_t newBucketCount;
     struct SymTableNode **newBuckets;
-    size_t i;
+    struct RetiredBuckets *psRetired = NULL;
+    struct ResizeWork sWork;
 
-    newPrimeIndex = oSymTable->currentPrimeIndex + 1;
     if (newPrimeIndex >= PRIME_COUNT) return;  /* No more resizing */
 
     newBucketCount = primes[newPrimeIndex];
     newBuckets = (struct SymTableNode**)calloc(newBucketCount, sizeof(struct SymTableNode*));
     if (newBuckets == NULL) return;  /* Allocation failed, skip resizing */
 
-    /* Rehash all existing nodes into the new buckets */
-    i = 0;
-    while (i < oSymTable->bucketCount) {
-        struct SymTableNode *psCurrentNode = oSymTable->buckets[i];
-        while (psCurrentNode != NULL) {
-            struct SymTableNode *psNextNode = psCurrentNode->psNextNode;
+    /* Optimistic readers may still index the old array, so a
+       read-mostly table keeps it until SymTable_free */
+    if (oSymTable->isReadMostly) {
+        psRetired = (struct RetiredBuckets*)malloc(sizeof(struct RetiredBuckets));
+        if (psRetired == NULL) {
+            free(newBuckets);
+            return;
+        }
+    }
 
-            /* Use the new bucket count for rehashing */
-            unsigned int newIndex = symtablehash_hashFunction(psCurrentNode->pcKey, newBucketCount);
+    /* Rehash all existing nodes into the new buckets, splitting the
+       old bucket array among worker threads when the table is big */
+    sWork.oSymTable = oSymTable;
+    sWork.newBuckets = newBuckets;
+    sWork.newBucketCount = newBucketCount;
+    sWork.pfNewHash = pfNewHash;
+    sWork.newSeed = newSeed;
+    sWork.firstBucket = 0;
+    sWork.endBucket = oSymTable->bucketCount;
+    sWork.isShared = 0;
+    if (oSymTable->resizeThreads > 1 && oSymTable->nodeQuantity >= PARALLEL_RESIZE_MIN_NODES) {
+        symtablehash_rehashParallel(&sWork);
+    } else {
+        symtablehash_rehashRange(&sWork);
+    }
 
-            /* Insert node into the new bucket array */
-            psCurrentNode->psNextNode = newBuckets[newIndex];
-            newBuckets[newIndex] = psCurrentNode;
+    /* Replace the old buckets with the new ones. The array is
+       published before the larger count, so a reader that sees the
+       new count also sees the new array. */
+    if (psRetired != NULL) {
+        psRetired->buckets = oSymTable->buckets;
+        psRetired->psNext = oSymTable->psRetiredBuckets;
+        oSymTable->psRetiredBuckets = psRetired;
+    } else {
+        free(oSymTable->buckets);
+    }
+    __atomic_store_n(&oSymTable->buckets, newBuckets, __ATOMIC_RELEASE);
+    __atomic_store_n(&oSymTable->bucketCount, newBucketCount, __ATOMIC_RELEASE);
+    if (pfNewHash != NULL) {
+        __atomic_store_n(&oSymTable->pfHash, pfNewHash, __ATOMIC_RELAXED);
+        __atomic_store_n(&oSymTable->hashSeed, newSeed, __ATOMIC_RELAXED);
+    }
+    oSymTable->currentPrimeIndex = newPrimeIndex;
+    oSymTable->resizeThreshold = symtablehash_getResizeThreshold(newBucketCount);
+}
 
-            psCurrentNode = psNextNode;
-        }
-        i++;
+/* Grows the bucket array ahead of time so that the table can hold
+   `uCount` bindings without resizing again.
+   Arguments -> `oSymTable`: the symbol table
+                `uCount`: the number of bindings expected
+   Jumps straight to the first bucket count in `primes` that is large
+   enough, so a batch of puts pays for at most one rehash. */
+void SymTable_reserve(SymTable_T oSymTable, size_t uCount) {
+    size_t newPrimeIndex;
+
+    assert(oSymTable != NULL);
+
+    if (symtablehash_isImmutable(oSymTable)) return;
+
+    newPrimeIndex = oSymTable->currentPrimeIndex;
+    while (newPrimeIndex + 1 < PRIME_COUNT &&
+           uCount > symtablehash_getResizeThreshold(primes[newPrimeIndex])) {
+        newPrimeIndex++;
     }
+    if (newPrimeIndex == oSymTable->currentPrimeIndex) return;
 
-    /* Replace the old buckets with the new ones */
-    free(oSymTable->buckets);
-    oSymTable->buckets = newBuckets;
-    oSymTable->bucketCount = newBucketCount;
-    oSymTable->currentPrimeIndex = newPrimeIndex;
+    symtablehash_beginWrite(oSymTable);
+    symtablehash_resizeHashTable(oSymTable, newPrimeIndex, NULL, 0);
+    symtablehash_endWrite(oSymTable);
 }
 
 /*
- * Adds a new key-value pair to the symbol table if the key doesn’t already exist.
- * Arguments:
- *   - `oSymTable`: the symbol table
- *   - `pcKey`: string key to add
- *   - `pvValue`: the value associated with `pcKey`
- * Checks if the key exists, then allocates a new node and inserts it.
- * Resizes the table if it gets too full. Returns integer, either 1 on success, 0 on failure or if key exists.
+ * Reacts to a suspiciously long chain by rehashing every key with a
+ * fresh seed, so that keys chosen to collide under the old seed spread
+ * out. A table that did not choose its hash function also moves to
+ * SipHash, whose collisions cannot be found without the seed. Does
+ * nothing once the table has used up its MAX_RESEEDS reseeds.
  */
-int SymTable_put(SymTable_T oSymTable, const char *pcKey, const void *pvValue) {
-    unsigned int index;
+static void symtablehash_reseed(SymTable_T oSymTable) {
+    SymTableHashFn_T pfNewHash = oSymTable->pfHash;
+
+    if (oSymTable->reseedsLeft == 0) return;
+    oSymTable->reseedsLeft--;
+
+    if (oSymTable->reseedToSipHash) {
+        pfNewHash = SymTableHash_siphash;
+    }
+    /* Hashes passed in by the caller no longer match the table's */
+    __atomic_store_n(&oSymTable->callerHashValid, 0, __ATOMIC_RELAXED);
+    symtablehash_resizeHashTable(oSymTable, oSymTable->currentPrimeIndex, pfNewHash,
+                                 SymTableHash_randomSeed());
+}
+
+/*
+ * Does the work of SymTable_put once any writer lock is held. `hash`
+ * is the key's hash under the table's current function and seed, and
+ * `keyLength` is strlen(pcKey).
+ */
+static int symtablehash_insert(SymTable_T oSymTable, const char *pcKey, size_t keyLength,
+                               size_t hash, const void *pvValue) {
+    size_t index;
+    size_t chainLength = 0;
     struct SymTableNode *psNewNode, *psCurrentNode;
 
-    assert(oSymTable != NULL);
-    assert(pcKey != NULL);
-    
 
     /* Check if resizing is needed */
-    if ((double)oSymTable->nodeQuantity / oSymTable->bucketCount > LOAD_FACTOR_THRESHOLD) {
-        symtablehash_resizeHashTable(oSymTable);
+    if (oSymTable->nodeQuantity > oSymTable->resizeThreshold) {
+        symtablehash_resizeHashTable(oSymTable, oSymTable->currentPrimeIndex + 1, NULL, 0);
     }
 
-    index = symtablehash_hashFunction(pcKey, oSymTable->bucketCount);
+    index = hash % oSymTable->bucketCount;
 
     /* Check for duplicate keys */
     psCurrentNode = oSymTable->buckets[index];
     while (psCurrentNode != NULL) {
-        if (strcmp(pcKey, psCurrentNode->pcKey) == 0) {
+        if (symtablehash_nodeMatches(psCurrentNode, hash, pcKey, keyLength)) {
             return 0;
         }
         psCurrentNode = psCurrentNode->psNextNode;
+        chainLength++;
     }
 
     /* Create a new node for the key-value pair */
-    psNewNode = (struct SymTableNode*)malloc(sizeof(struct SymTableNode));
+    psNewNode = (struct SymTableNode*)malloc(sizeof(struct SymTableNode) + keyLength + 1);
     if (psNewNode == NULL) return 0;
 
-    psNewNode->pcKey = malloc(strlen(pcKey) + 1);
-    if (psNewNode->pcKey == NULL) {
-        free(psNewNode);
-        return 0;
-    }
-    strcpy(psNewNode->pcKey, pcKey);
+    memcpy(psNewNode->acKey, pcKey, keyLength + 1);
+    psNewNode->keyLength = keyLength;
     psNewNode->pvValue = pvValue;
+    psNewNode->hash = hash;
 
     /* Insert the new node into the hash table */
     psNewNode->psNextNode = oSymTable->buckets[index];
-    oSymTable->buckets[index] = psNewNode;
-    oSymTable->nodeQuantity++;
+    __atomic_store_n(&oSymTable->buckets[index], psNewNode, __ATOMIC_RELEASE);
+    __atomic_store_n(&oSymTable->nodeQuantity, oSymTable->nodeQuantity + 1, __ATOMIC_RELAXED);
+
+    /* A chain far longer than the average suggests crafted keys */
+    if (chainLength + 1 > LONG_CHAIN_LENGTH + 4 * (oSymTable->nodeQuantity / oSymTable->bucketCount)) {
+        symtablehash_reseed(oSymTable);
+    }
     return 1;
 }
 
+/*
+ * Adds a new key-value pair to the symbol table if the key doesn’t already exist.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `pcKey`: string key to add
+ *   - `pvValue`: the value associated with `pcKey`
+ * Checks if the key exists, then allocates a new node and inserts it.
+ * Resizes the table if it gets too full. Returns integer, either 1 on success, 0 on failure or if key exists.
+ * A frozen or mapped table always fails.
+ */
+int SymTable_put(SymTable_T oSymTable, const char *pcKey, const void *pvValue) {
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    return SymTable_putHashed(oSymTable, pcKey, strlen(pcKey), NULL, pvValue);
+}
+
+/* Does the work of SymTable_put for a key of length `uLength`, hashed
+   by the caller into *puHash unless `puHash` is NULL. */
+int SymTable_putHashed(SymTable_T oSymTable, const char *pcKey, size_t uLength,
+                       const uint64_t *puHash, const void *pvValue) {
+    int iSuccessful;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    if (symtablehash_isImmutable(oSymTable)) return 0;
+
+    symtablehash_beginWrite(oSymTable);
+    iSuccessful = symtablehash_insert(oSymTable, pcKey, uLength,
+                                      symtablehash_keyHash(oSymTable, pcKey, uLength, puHash), pvValue);
+    symtablehash_endWrite(oSymTable);
+    return iSuccessful;
+}
+
 /*
  * Replaces the value of an existing key in the table.
  * Arguments:
@@ -258,28 +769,108 @@ int SymTable_put(SymTable_T oSymTable, const char *pcKey, const void *pvValue) {
  *   - `pcKey`: the key whose value we want to update
  *   - `pvValue`: the new value to store
  * Finds the key, updates its value if found, and returns the old value. Returns NULL if the key doesn’t exist.
+ * A frozen or mapped table is left unchanged, and NULL is returned.
  */
 void *SymTable_replace(SymTable_T oSymTable, const char *pcKey, const void *pvValue) {
-    unsigned int index;
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    return SymTable_replaceHashed(oSymTable, pcKey, strlen(pcKey), NULL, pvValue);
+}
+
+/* Does the work of SymTable_replace for a key of length `uLength`,
+   hashed by the caller into *puHash unless `puHash` is NULL. */
+void *SymTable_replaceHashed(SymTable_T oSymTable, const char *pcKey, size_t uLength,
+                             const uint64_t *puHash, const void *pvValue) {
+    size_t hash;
+    size_t index;
     struct SymTableNode *psCurrentNode;
-    void *oldValue;
+    void *oldValue = NULL;
 
     assert(oSymTable != NULL);
     assert(pcKey != NULL);
-    
 
-    index = symtablehash_hashFunction(pcKey, oSymTable->bucketCount);
+    if (symtablehash_isImmutable(oSymTable)) return NULL;
+
+    symtablehash_beginWrite(oSymTable);
+    hash = symtablehash_keyHash(oSymTable, pcKey, uLength, puHash);
+    index = hash % oSymTable->bucketCount;
 
     psCurrentNode = oSymTable->buckets[index];
     while (psCurrentNode != NULL) {
-        if (strcmp(pcKey, psCurrentNode->pcKey) == 0) {
+        if (symtablehash_nodeMatches(psCurrentNode, hash, pcKey, uLength)) {
             oldValue = (void*)psCurrentNode->pvValue;
-            psCurrentNode->pvValue = pvValue;
-            return oldValue;
+            __atomic_store_n(&psCurrentNode->pvValue, pvValue, __ATOMIC_RELAXED);
+            break;
         }
         psCurrentNode = psCurrentNode->psNextNode;
     }
-    return NULL;
+    symtablehash_endWrite(oSymTable);
+    return oldValue;
+}
+
+/*
+ * Looks up a key in a read-mostly table without taking any lock.
+ * Arguments:
+ *   - `oSymTable`: the read-mostly symbol table
+ *   - `pcKey`: the key to look for
+ *   - `keyLength`: strlen(pcKey)
+ *   - `puCallerHash`: NULL, or the caller's hash as for symtablehash_keyHash
+ *   - `ppvValue`: receives the bound value when the key is found
+ * Reads the sequence counter, walks the chain, and then checks that the
+ * counter is unchanged. If a writer ran meanwhile the walk is retried.
+ * Returns 1 if the key is found, 0 otherwise.
+ */
+static int symtablehash_findOptimistic(SymTable_T oSymTable, const char *pcKey, size_t keyLength,
+                                       const uint64_t *puCallerHash, void **ppvValue) {
+    unsigned long startSequence;
+    size_t hash;
+    struct SymTableNode **buckets;
+    struct SymTableNode *psCurrentNode;
+    size_t bucketCount;
+    size_t steps;
+    void *pvValue;
+    int iFound;
+
+    for (;;) {
+        startSequence = __atomic_load_n(&oSymTable->sequence, __ATOMIC_ACQUIRE);
+        if ((startSequence & 1UL) != 0) continue;  /* A writer is active */
+
+        /* A reseed changes every hash, so hash inside the loop */
+        hash = symtablehash_keyHash(oSymTable, pcKey, keyLength, puCallerHash);
+
+        /* The count is read first: a resize publishes it last */
+        bucketCount = __atomic_load_n(&oSymTable->bucketCount, __ATOMIC_ACQUIRE);
+        buckets = __atomic_load_n(&oSymTable->buckets, __ATOMIC_ACQUIRE);
+        psCurrentNode = __atomic_load_n(&buckets[hash % bucketCount], __ATOMIC_ACQUIRE);
+
+        iFound = 0;
+        pvValue = NULL;
+        steps = 0;
+        while (psCurrentNode != NULL) {
+            if (__atomic_load_n(&psCurrentNode->hash, __ATOMIC_RELAXED) == hash &&
+                psCurrentNode->keyLength == keyLength &&
+                memcmp(psCurrentNode->acKey, pcKey, keyLength) == 0) {
+                iFound = 1;
+                pvValue = (void*)__atomic_load_n(&psCurrentNode->pvValue, __ATOMIC_RELAXED);
+                break;
+            }
+            psCurrentNode = __atomic_load_n(&psCurrentNode->psNextNode, __ATOMIC_ACQUIRE);
+
+            /* A long walk may be following nodes that a writer is
+               relinking, so give up early once the counter moved */
+            if (++steps % READER_RECHECK_STEPS == 0 &&
+                __atomic_load_n(&oSymTable->sequence, __ATOMIC_RELAXED) != startSequence) {
+                break;
+            }
+        }
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&oSymTable->sequence, __ATOMIC_RELAXED) == startSequence) {
+            *ppvValue = pvValue;
+            return iFound;
+        }
+    }
 }
 
 /* 
@@ -291,17 +882,40 @@ void *SymTable_replace(SymTable_T oSymTable, const char *pcKey, const void *pvVa
  *   pcKey - A string representing the key to search for.
  */
 int SymTable_contains(SymTable_T oSymTable, const char *pcKey) {
-    unsigned int index;
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    return SymTable_containsHashed(oSymTable, pcKey, strlen(pcKey), NULL);
+}
+
+/* Does the work of SymTable_contains for a key of length `uLength`,
+   hashed by the caller into *puHash unless `puHash` is NULL. */
+int SymTable_containsHashed(SymTable_T oSymTable, const char *pcKey, size_t uLength,
+                            const uint64_t *puHash) {
+    size_t hash;
+    size_t index;
     struct SymTableNode *psCurrentNode;
+    void *pvValue;
 
     assert(oSymTable != NULL);
     assert(pcKey != NULL);
 
-    index = symtablehash_hashFunction(pcKey, oSymTable->bucketCount);
+    if (oSymTable->oFrozen != NULL) {
+        return SymTableMPH_find(oSymTable->oFrozen, pcKey, uLength, &pvValue);
+    }
+    if (oSymTable->oMapped != NULL) {
+        return SymTableSnapshot_find(oSymTable->oMapped, pcKey, uLength, &pvValue);
+    }
+    if (oSymTable->isReadMostly) {
+        return symtablehash_findOptimistic(oSymTable, pcKey, uLength, puHash, &pvValue);
+    }
+
+    hash = symtablehash_keyHash(oSymTable, pcKey, uLength, puHash);
+    index = hash % oSymTable->bucketCount;
 
     psCurrentNode = oSymTable->buckets[index];
     while (psCurrentNode != NULL) {
-        if (strcmp(pcKey, psCurrentNode->pcKey) == 0) {
+        if (symtablehash_nodeMatches(psCurrentNode, hash, pcKey, uLength)) {
             return 1;
         }
         psCurrentNode = psCurrentNode->psNextNode;
@@ -317,17 +931,45 @@ int SymTable_contains(SymTable_T oSymTable, const char *pcKey) {
  * Finds and returns the value if `pcKey` exists in the table; returns NULL if the key isn’t found.
  */
 void *SymTable_get(SymTable_T oSymTable, const char *pcKey) {
-    unsigned int index;
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    return SymTable_getHashed(oSymTable, pcKey, strlen(pcKey), NULL);
+}
+
+/* Does the work of SymTable_get for a key of length `uLength`, hashed
+   by the caller into *puHash unless `puHash` is NULL. */
+void *SymTable_getHashed(SymTable_T oSymTable, const char *pcKey, size_t uLength,
+                         const uint64_t *puHash) {
+    size_t hash;
+    size_t index;
     struct SymTableNode *psCurrentNode;
+    void *pvValue;
 
     assert(oSymTable != NULL);
     assert(pcKey != NULL);
 
-    index = symtablehash_hashFunction(pcKey, oSymTable->bucketCount);
+    if (oSymTable->oFrozen != NULL) {
+        pvValue = NULL;
+        (void)SymTableMPH_find(oSymTable->oFrozen, pcKey, uLength, &pvValue);
+        return pvValue;
+    }
+    if (oSymTable->oMapped != NULL) {
+        pvValue = NULL;
+        (void)SymTableSnapshot_find(oSymTable->oMapped, pcKey, uLength, &pvValue);
+        return pvValue;
+    }
+    if (oSymTable->isReadMostly) {
+        (void)symtablehash_findOptimistic(oSymTable, pcKey, uLength, puHash, &pvValue);
+        return pvValue;
+    }
+
+    hash = symtablehash_keyHash(oSymTable, pcKey, uLength, puHash);
+    index = hash % oSymTable->bucketCount;
 
     psCurrentNode = oSymTable->buckets[index];
     while (psCurrentNode != NULL) {
-        if (strcmp(pcKey, psCurrentNode->pcKey) == 0) {
+        if (symtablehash_nodeMatches(psCurrentNode, hash, pcKey, uLength)) {
             return (void*)psCurrentNode->pvValue;
         }
         psCurrentNode = psCurrentNode->psNextNode;
@@ -339,41 +981,64 @@ void *SymTable_get(SymTable_T oSymTable, const char *pcKey) {
  * SymTable_remove:
  * Removes the key-value pair with the specified key from the SymTable.
  * Returns the associated value or NULL if the key is not found.
+ * A frozen or mapped table is left unchanged, and NULL is returned.
  * Parameters:
  *   oSymTable - A pointer to the SymTable.
  *   pcKey - A string representing the key to be removed.
  */
 void *SymTable_remove(SymTable_T oSymTable, const char *pcKey) {
-    unsigned int index;
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    return SymTable_removeHashed(oSymTable, pcKey, strlen(pcKey), NULL);
+}
+
+/* Does the work of SymTable_remove for a key of length `uLength`,
+   hashed by the caller into *puHash unless `puHash` is NULL. */
+void *SymTable_removeHashed(SymTable_T oSymTable, const char *pcKey, size_t uLength,
+                            const uint64_t *puHash) {
+    size_t hash;
+    size_t index;
     struct SymTableNode *psCurrentNode, *psPrevNode = NULL;
-    void *oldValue;
+    void *oldValue = NULL;
 
     assert(oSymTable != NULL);
     assert(pcKey != NULL);
 
-    index = symtablehash_hashFunction(pcKey, oSymTable->bucketCount);
+    if (symtablehash_isImmutable(oSymTable)) return NULL;
+
+    symtablehash_beginWrite(oSymTable);
+    hash = symtablehash_keyHash(oSymTable, pcKey, uLength, puHash);
+    index = hash % oSymTable->bucketCount;
 
     psCurrentNode = oSymTable->buckets[index];
     while (psCurrentNode != NULL) {
-        if (strcmp(pcKey, psCurrentNode->pcKey) == 0) {
+        if (symtablehash_nodeMatches(psCurrentNode, hash, pcKey, uLength)) {
             oldValue = (void*)psCurrentNode->pvValue;
 
             /* Adjust pointers to remove the node */
             if (psPrevNode == NULL) {
-                oSymTable->buckets[index] = psCurrentNode->psNextNode;
+                __atomic_store_n(&oSymTable->buckets[index], psCurrentNode->psNextNode, __ATOMIC_RELAXED);
             } else {
-                psPrevNode->psNextNode = psCurrentNode->psNextNode;
+                __atomic_store_n(&psPrevNode->psNextNode, psCurrentNode->psNextNode, __ATOMIC_RELAXED);
             }
 
-            free((char*)psCurrentNode->pcKey);
-            free(psCurrentNode);
-            oSymTable->nodeQuantity--;
-            return oldValue;
+            if (oSymTable->isReadMostly) {
+                /* A reader standing on this node follows the retired
+                   chain to its end and then fails validation */
+                __atomic_store_n(&psCurrentNode->psNextNode, oSymTable->psRetiredNodes, __ATOMIC_RELAXED);
+                oSymTable->psRetiredNodes = psCurrentNode;
+            } else {
+                free(psCurrentNode);
+            }
+            __atomic_store_n(&oSymTable->nodeQuantity, oSymTable->nodeQuantity - 1, __ATOMIC_RELAXED);
+            break;
         }
         psPrevNode = psCurrentNode;
         psCurrentNode = psCurrentNode->psNextNode;
     }
-    return NULL;
+    symtablehash_endWrite(oSymTable);
+    return oldValue;
 }
 
 /* 
@@ -397,13 +1062,778 @@ void SymTable_map(SymTable_T oSymTable,
     assert(oSymTable != NULL);
     assert(pfApply != NULL);
 
+    if (oSymTable->oFrozen != NULL) {
+        SymTableMPH_map(oSymTable->oFrozen, pfApply, pvExtra);
+        return;
+    }
+    if (oSymTable->oMapped != NULL) {
+        SymTableSnapshot_map(oSymTable->oMapped, pfApply, pvExtra);
+        return;
+    }
+
+    /* Keep writers of a read-mostly table out for the whole walk */
+    if (oSymTable->isReadMostly) {
+        pthread_mutex_lock(&oSymTable->writerLock);
+    }
+
     i = 0;
     while (i < oSymTable->bucketCount) {
         psCurrentNode = oSymTable->buckets[i];
         while (psCurrentNode != NULL) {
-            (*pfApply)(psCurrentNode->pcKey, (void*)psCurrentNode->pvValue, (void*)pvExtra);
+            (*pfApply)(psCurrentNode->acKey, (void*)psCurrentNode->pvValue, (void*)pvExtra);
             psCurrentNode = psCurrentNode->psNextNode;
         }
         i++;
     }
+
+    if (oSymTable->isReadMostly) {
+        pthread_mutex_unlock(&oSymTable->writerLock);
+    }
+}
+
+/*
+ * Counts the buckets of each chain length.
+ * Arguments:
+ *   - `oSymTable`: the symbol table to inspect
+ *   - `auCounts`: receives, at index i, the number of buckets holding
+ *     exactly i nodes; index `uMaxLength` counts every longer chain too
+ *   - `uMaxLength`: the last index of `auCounts`
+ */
+void SymTable_getChainHistogram(SymTable_T oSymTable, size_t auCounts[], size_t uMaxLength) {
+    struct SymTableNode *psCurrentNode;
+    size_t length;
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(auCounts != NULL);
+
+    for (i = 0; i <= uMaxLength; i++) {
+        auCounts[i] = 0;
+    }
+
+    if (oSymTable->isReadMostly) {
+        pthread_mutex_lock(&oSymTable->writerLock);
+    }
+    for (i = 0; i < oSymTable->bucketCount; i++) {
+        length = 0;
+        for (psCurrentNode = oSymTable->buckets[i]; psCurrentNode != NULL;
+             psCurrentNode = psCurrentNode->psNextNode) {
+            length++;
+        }
+        auCounts[length < uMaxLength ? length : uMaxLength]++;
+    }
+    if (oSymTable->isReadMostly) {
+        pthread_mutex_unlock(&oSymTable->writerLock);
+    }
+}
+
+/*
+ * Hashes one chunk of a batch with the table's function and seed, then
+ * prefetches the bucket of every key so that the chain walks that
+ * follow overlap their cache misses. The keys' lengths are left in
+ * `auLengths` for the walks to compare.
+ */
+static void symtablehash_hashChunk(SymTable_T oSymTable, const char *const apcKeys[], size_t uCount,
+                                   size_t auLengths[], uint64_t auHashes[]) {
+    size_t i;
+
+    for (i = 0; i < uCount; i++) {
+        assert(apcKeys[i] != NULL);
+        auLengths[i] = strlen(apcKeys[i]);
+    }
+    SymTableHash_hashBatch(oSymTable->pfHash, apcKeys, auLengths, uCount, oSymTable->hashSeed, auHashes);
+    for (i = 0; i < uCount; i++) {
+        __builtin_prefetch(&oSymTable->buckets[(size_t)auHashes[i] % oSymTable->bucketCount]);
+    }
+}
+
+/*
+ * Looks up a batch of keys in an ordinary table.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `apcKeys`: the keys to look up
+ *   - `uCount`: how many keys
+ *   - `apvValues`: if not NULL, receives each key's value or NULL
+ *   - `aiFound`: if not NULL, receives 1 for each key found, else 0
+ */
+static void symtablehash_findBatch(SymTable_T oSymTable, const char *const apcKeys[], size_t uCount,
+                                   void *apvValues[], int aiFound[]) {
+    size_t auLengths[BATCH_CHUNK];
+    uint64_t auHashes[BATCH_CHUNK];
+    struct SymTableNode *psCurrentNode;
+    size_t first, chunk, i;
+
+    for (first = 0; first < uCount; first += chunk) {
+        chunk = uCount - first < BATCH_CHUNK ? uCount - first : BATCH_CHUNK;
+        symtablehash_hashChunk(oSymTable, apcKeys + first, chunk, auLengths, auHashes);
+
+        for (i = 0; i < chunk; i++) {
+            size_t hash = (size_t)auHashes[i];
+
+            psCurrentNode = oSymTable->buckets[hash % oSymTable->bucketCount];
+            while (psCurrentNode != NULL &&
+                   !symtablehash_nodeMatches(psCurrentNode, hash, apcKeys[first + i], auLengths[i])) {
+                psCurrentNode = psCurrentNode->psNextNode;
+            }
+            if (apvValues != NULL) {
+                apvValues[first + i] = psCurrentNode != NULL ? (void*)psCurrentNode->pvValue : NULL;
+            }
+            if (aiFound != NULL) {
+                aiFound[first + i] = psCurrentNode != NULL;
+            }
+        }
+    }
+}
+
+/* Gets the values of a batch of keys.
+   Arguments -> `apcKeys`: the keys, `uCount` of them
+                `apvValues`: receives each key's value, NULL if absent
+   Read-mostly, frozen and mapped tables look the keys up one at a time. */
+void SymTable_getBatch(SymTable_T oSymTable, const char *const apcKeys[], size_t uCount,
+                       void *apvValues[]) {
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(uCount == 0 || (apcKeys != NULL && apvValues != NULL));
+
+    if (oSymTable->isReadMostly || symtablehash_isImmutable(oSymTable)) {
+        for (i = 0; i < uCount; i++) {
+            apvValues[i] = SymTable_get(oSymTable, apcKeys[i]);
+        }
+        return;
+    }
+    symtablehash_findBatch(oSymTable, apcKeys, uCount, apvValues, NULL);
+}
+
+/* Checks a batch of keys.
+   Arguments -> `apcKeys`: the keys, `uCount` of them
+                `aiFound`: receives 1 for each key present, 0 otherwise
+   Read-mostly, frozen and mapped tables look the keys up one at a time. */
+void SymTable_containsBatch(SymTable_T oSymTable, const char *const apcKeys[], size_t uCount,
+                            int aiFound[]) {
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(uCount == 0 || (apcKeys != NULL && aiFound != NULL));
+
+    if (oSymTable->isReadMostly || symtablehash_isImmutable(oSymTable)) {
+        for (i = 0; i < uCount; i++) {
+            aiFound[i] = SymTable_contains(oSymTable, apcKeys[i]);
+        }
+        return;
+    }
+    symtablehash_findBatch(oSymTable, apcKeys, uCount, NULL, aiFound);
+}
+
+/*
+ * Adds a batch of bindings.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `apcKeys`, `apvValues`: the bindings, `uCount` of them
+ *   - `aiResults`: if not NULL, receives what SymTable_put would have
+ *     returned for each binding
+ * Grows the table once for the whole batch, then inserts with hashes
+ * computed a chunk at a time. A reseed in the middle of a chunk makes
+ * the chunk's remaining hashes stale, so those keys are rehashed one
+ * by one. Read-mostly, frozen and mapped tables put the bindings one at
+ * a time.
+ * Returns the number of bindings added.
+ */
+size_t SymTable_putBatch(SymTable_T oSymTable, const char *const apcKeys[],
+                         const void *const apvValues[], size_t uCount, int aiResults[]) {
+    size_t auLengths[BATCH_CHUNK];
+    uint64_t auHashes[BATCH_CHUNK];
+    SymTableHashFn_T pfHash;
+    uint64_t hashSeed;
+    size_t added = 0;
+    size_t first, chunk, i;
+    int iSuccessful;
+
+    assert(oSymTable != NULL);
+    assert(uCount == 0 || (apcKeys != NULL && apvValues != NULL));
+
+    if (oSymTable->isReadMostly || symtablehash_isImmutable(oSymTable)) {
+        for (i = 0; i < uCount; i++) {
+            iSuccessful = SymTable_put(oSymTable, apcKeys[i], apvValues[i]);
+            if (aiResults != NULL) aiResults[i] = iSuccessful;
+            added += (size_t)iSuccessful;
+        }
+        return added;
+    }
+
+    SymTable_reserve(oSymTable, oSymTable->nodeQuantity + uCount);
+    for (first = 0; first < uCount; first += chunk) {
+        chunk = uCount - first < BATCH_CHUNK ? uCount - first : BATCH_CHUNK;
+        pfHash = oSymTable->pfHash;
+        hashSeed = oSymTable->hashSeed;
+        symtablehash_hashChunk(oSymTable, apcKeys + first, chunk, auLengths, auHashes);
+
+        for (i = 0; i < chunk; i++) {
+            const char *pcKey = apcKeys[first + i];
+            size_t hash = (size_t)auHashes[i];
+
+            if (oSymTable->pfHash != pfHash || oSymTable->hashSeed != hashSeed) {
+                hash = symtablehash_hashFunction(oSymTable, pcKey, auLengths[i]);
+            }
+            iSuccessful = symtablehash_insert(oSymTable, pcKey, auLengths[i], hash, apvValues[first + i]);
+            if (aiResults != NULL) aiResults[first + i] = iSuccessful;
+            added += (size_t)iSuccessful;
+        }
+    }
+    return added;
+}
+
+/*
+ * Turns the table into its immutable form.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ * Builds a minimal perfect hash over every binding, on the table's
+ * `resizeThreads` threads, then frees the nodes and the bucket array.
+ * Returns 1 on success, or 0 if memory is insufficient or the index
+ * cannot be built under any seed, in which case the table is unchanged
+ * and still mutable.
+ */
+int SymTable_freeze(SymTable_T oSymTable) {
+    const char **apcKeys;
+    const void **apvValues;
+    struct SymTableNode *psCurrentNode, *psNextNode;
+    size_t count = 0;
+    size_t i;
+
+    assert(oSymTable != NULL);
+
+    if (symtablehash_isImmutable(oSymTable)) return 1;
+
+    apcKeys = (const char**)malloc((oSymTable->nodeQuantity + 1) * sizeof(const char*));
+    apvValues = (const void**)malloc((oSymTable->nodeQuantity + 1) * sizeof(const void*));
+    if (apcKeys == NULL || apvValues == NULL) {
+        free(apcKeys);
+        free(apvValues);
+        return 0;
+    }
+    for (i = 0; i < oSymTable->bucketCount; i++) {
+        for (psCurrentNode = oSymTable->buckets[i]; psCurrentNode != NULL;
+             psCurrentNode = psCurrentNode->psNextNode) {
+            apcKeys[count] = psCurrentNode->acKey;
+            apvValues[count] = psCurrentNode->pvValue;
+            count++;
+        }
+    }
+
+    /* The index copies the keys, so the nodes can go once it exists */
+    oSymTable->oFrozen = SymTableMPH_new(apcKeys, apvValues, count, oSymTable->resizeThreads);
+    free(apcKeys);
+    free(apvValues);
+    if (oSymTable->oFrozen == NULL) return 0;
+
+    for (i = 0; i < oSymTable->bucketCount; i++) {
+        for (psCurrentNode = oSymTable->buckets[i]; psCurrentNode != NULL; psCurrentNode = psNextNode) {
+            psNextNode = psCurrentNode->psNextNode;
+            free(psCurrentNode);
+        }
+    }
+    free(oSymTable->buckets);
+    oSymTable->buckets = NULL;
+    oSymTable->bucketCount = 0;
+    return 1;
+}
+
+/*
+ * Tells whether the table is frozen or mapped.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ * Returns 1 if no change to the table can succeed, 0 otherwise.
+ */
+int SymTable_isImmutable(SymTable_T oSymTable) {
+    assert(oSymTable != NULL);
+    return symtablehash_isImmutable(oSymTable);
+}
+
+/*
+ * SaveWork: The bindings that SymTable_save collects before writing
+ * them out, and room for at most `capacity` of them.
+ */
+struct SaveWork {
+    const char **apcKeys;
+    const void **apvValues;
+    size_t count;
+    size_t capacity;
+};
+
+/*
+ * Adds one binding to the SaveWork that `pvExtra` points to, for
+ * SymTable_map.
+ */
+static void symtablehash_collectBinding(const char *pcKey, void *pvValue, void *pvExtra) {
+    struct SaveWork *psWork = (struct SaveWork*)pvExtra;
+
+    if (psWork->count == psWork->capacity) return;
+    psWork->apcKeys[psWork->count] = pcKey;
+    psWork->apvValues[psWork->count] = pvValue;
+    psWork->count++;
+}
+
+/*
+ * Saves the table as a snapshot that SymTable_openMapped can map.
+ * Arguments:
+ *   - `oSymTable`: the symbol table, in any form
+ *   - `pcPath`: the file to write
+ * Collects the bindings with SymTable_map, so the table may be mutable,
+ * frozen or itself mapped, then hands them to SymTableSnapshot_write.
+ * Returns 1 on success, or 0 if memory is insufficient or the file
+ * cannot be written.
+ */
+int SymTable_save(SymTable_T oSymTable, const char *pcPath) {
+    struct SaveWork sWork;
+    int iSuccessful;
+
+    assert(oSymTable != NULL);
+    assert(pcPath != NULL);
+
+    sWork.capacity = SymTable_getLength(oSymTable);
+    sWork.count = 0;
+    sWork.apcKeys = (const char**)malloc((sWork.capacity + 1) * sizeof(const char*));
+    sWork.apvValues = (const void**)malloc((sWork.capacity + 1) * sizeof(const void*));
+    if (sWork.apcKeys == NULL || sWork.apvValues == NULL) {
+        free(sWork.apcKeys);
+        free(sWork.apvValues);
+        return 0;
+    }
+
+    SymTable_map(oSymTable, symtablehash_collectBinding, &sWork);
+    iSuccessful = SymTableSnapshot_write(pcPath, sWork.apcKeys, sWork.apvValues, sWork.count);
+    free(sWork.apcKeys);
+    free(sWork.apvValues);
+    return iSuccessful;
+}
+
+/*
+ * Opens a snapshot that SymTable_save wrote as a read-only table.
+ * Arguments:
+ *   - `pcPath`: the file to map
+ * The table keeps no bucket array: lookups go straight to the mapping,
+ * and the file stays mapped until SymTable_free.
+ * Returns the table, or NULL if the file is not a usable snapshot or
+ * memory is insufficient.
+ */
+SymTable_T SymTable_openMapped(const char *pcPath) {
+    SymTableSnapshot_T oSnapshot;
+    SymTable_T oSymTable;
+
+    assert(pcPath != NULL);
+
+    oSnapshot = SymTableSnapshot_open(pcPath);
+    if (oSnapshot == NULL) return NULL;
+
+    oSymTable = SymTable_new();
+    if (oSymTable == NULL) {
+        SymTableSnapshot_close(oSnapshot);
+        return NULL;
+    }
+    free(oSymTable->buckets);
+    oSymTable->buckets = NULL;
+    oSymTable->bucketCount = 0;
+    oSymTable->nodeQuantity = SymTableSnapshot_getLength(oSnapshot);
+    oSymTable->oMapped = oSnapshot;
+    return oSymTable;
+}
+
+/*
+ * LoadRecord: One line of a text file that SymTable_loadText found and
+ * hashed, waiting to be inserted. The value's text, if any, follows the
+ * key and its tab.
+ */
+struct LoadRecord {
+    size_t hash;
+    const char *pcKey;
+    size_t keyLength;
+    size_t valueLength;
+};
+
+/*
+ * LoadPartition: The records of one chunk of the file whose buckets
+ * belong to one partition, in the order of their lines.
+ */
+struct LoadPartition {
+    struct LoadRecord *psRecords;
+    size_t count;
+    size_t capacity;
+};
+
+/*
+ * LoadWork: What one thread of SymTable_loadText does. It first counts
+ * and then hashes the lines of its chunk [pcStart, pcEnd), sorting them
+ * into one LoadPartition per thread; then it inserts the records that
+ * every chunk sorted into its own partition, whose buckets no other
+ * thread touches.
+ */
+struct LoadWork {
+    /* The table being loaded */
+    SymTable_T oSymTable;
+
+    /* The chunk of the file, starting and ending on line boundaries */
+    const char *pcStart;
+    const char *pcEnd;
+
+    /* Number of lines in the chunk, empty ones included */
+    size_t lineCount;
+
+    /* The work of every thread, and how many threads there are; this
+       thread's partition is `partition` */
+    struct LoadWork *psAll;
+    size_t threadCount;
+    size_t partition;
+
+    /* The chunk's records, one LoadPartition per thread */
+    struct LoadPartition *psPartitions;
+
+    /* The table's hash function, seed and bucket count when the lines
+       were hashed and partitioned */
+    SymTableHashFn_T pfHash;
+    uint64_t hashSeed;
+    size_t bucketCount;
+
+    /* Converts each value's text, or NULL to bind NULL */
+    SymTableParseFn_T pfParse;
+    void *pvExtra;
+
+    /* Number of bindings that this thread's partition added */
+    size_t added;
+
+    /* 1 if this thread ran out of memory, met a key holding a '\0' or
+       had a value rejected by `pfParse` */
+    int failed;
+
+    /* 1 if an insert left a suspiciously long chain */
+    int sawLongChain;
+};
+
+/*
+ * Counts the lines of one chunk, a last one without '\n' included.
+ */
+static void *symtablehash_countLines(void *pvArg) {
+    struct LoadWork *psWork = (struct LoadWork*)pvArg;
+    const char *pcLine = psWork->pcStart;
+    const char *pcNewline;
+
+    psWork->lineCount = 0;
+    while (pcLine < psWork->pcEnd) {
+        pcNewline = (const char*)memchr(pcLine, '\n', (size_t)(psWork->pcEnd - pcLine));
+        psWork->lineCount++;
+        pcLine = pcNewline != NULL ? pcNewline + 1 : psWork->pcEnd;
+    }
+    return NULL;
+}
+
+/*
+ * Makes room in a LoadPartition for at least `capacity` records.
+ * Returns 1 on success, or 0 if memory is insufficient.
+ */
+static int symtablehash_growPartition(struct LoadPartition *psPartition, size_t capacity) {
+    struct LoadRecord *psRecords;
+
+    if (capacity <= psPartition->capacity) return 1;
+    psRecords = (struct LoadRecord*)realloc(psPartition->psRecords, capacity * sizeof(struct LoadRecord));
+    if (psRecords == NULL) return 0;
+    psPartition->psRecords = psRecords;
+    psPartition->capacity = capacity;
+    return 1;
+}
+
+/*
+ * Splits each line of one chunk into its key and its value, hashes the
+ * key, and adds the record to the partition that owns its bucket. Empty
+ * lines are skipped, and a '\r' before the '\n' is dropped.
+ */
+static void *symtablehash_hashLines(void *pvArg) {
+    struct LoadWork *psWork = (struct LoadWork*)pvArg;
+    const char *pcLine = psWork->pcStart;
+    const char *pcLineEnd, *pcTab;
+    struct LoadPartition *psPartition;
+    struct LoadRecord sRecord;
+    size_t partition;
+
+    /* The hash spreads the lines evenly over the partitions, so each
+       starts with room for its share and a little more */
+    for (partition = 0; partition < psWork->threadCount; partition++) {
+        if (!symtablehash_growPartition(&psWork->psPartitions[partition],
+                                        psWork->lineCount / psWork->threadCount * 9 / 8 + 16)) {
+            psWork->failed = 1;
+            return NULL;
+        }
+    }
+
+    while (pcLine < psWork->pcEnd) {
+        pcLineEnd = (const char*)memchr(pcLine, '\n', (size_t)(psWork->pcEnd - pcLine));
+        if (pcLineEnd == NULL) pcLineEnd = psWork->pcEnd;
+        sRecord.pcKey = pcLine;
+        pcLine = pcLineEnd < psWork->pcEnd ? pcLineEnd + 1 : pcLineEnd;
+
+        if (pcLineEnd > sRecord.pcKey && pcLineEnd[-1] == '\r') pcLineEnd--;
+        if (pcLineEnd == sRecord.pcKey) continue;
+
+        pcTab = (const char*)memchr(sRecord.pcKey, '\t', (size_t)(pcLineEnd - sRecord.pcKey));
+        if (pcTab == NULL) pcTab = pcLineEnd;
+        sRecord.keyLength = (size_t)(pcTab - sRecord.pcKey);
+        sRecord.valueLength = pcTab < pcLineEnd ? (size_t)(pcLineEnd - pcTab - 1) : 0;
+        if (memchr(sRecord.pcKey, '\0', sRecord.keyLength) != NULL) {
+            psWork->failed = 1;
+            return NULL;
+        }
+
+        sRecord.hash = (size_t)(*psWork->pfHash)(sRecord.pcKey, sRecord.keyLength, psWork->hashSeed);
+        partition = sRecord.hash % psWork->bucketCount * psWork->threadCount / psWork->bucketCount;
+        psPartition = &psWork->psPartitions[partition];
+        if (psPartition->count == psPartition->capacity &&
+            !symtablehash_growPartition(psPartition, 2 * psPartition->capacity)) {
+            psWork->failed = 1;
+            return NULL;
+        }
+        psPartition->psRecords[psPartition->count++] = sRecord;
+    }
+    return NULL;
+}
+
+/*
+ * Inserts the records of this thread's partition from every chunk, in
+ * file order, so that the first line with a key wins as with
+ * SymTable_put. Only this thread touches the partition's buckets, so
+ * no insert takes a lock. Each value is parsed only once its key is
+ * known to be new, so no parsed value is left unbound.
+ */
+static void *symtablehash_insertPartition(void *pvArg) {
+    struct LoadWork *psWork = (struct LoadWork*)pvArg;
+    SymTable_T oSymTable = psWork->oSymTable;
+    const struct LoadPartition *psPartition;
+    const struct LoadRecord *psRecord;
+    struct SymTableNode *psNewNode, *psCurrentNode;
+    const char *pcValue;
+    void *pvValue;
+    size_t averageLength, chainLength, chunk, index, i;
+
+    averageLength = (oSymTable->nodeQuantity + oSymTable->bucketCount - 1) / oSymTable->bucketCount;
+    for (chunk = 0; chunk < psWork->threadCount; chunk++) {
+        psPartition = &psWork->psAll[chunk].psPartitions[psWork->partition];
+        for (i = 0; i < psPartition->count; i++) {
+            psRecord = &psPartition->psRecords[i];
+            index = psRecord->hash % oSymTable->bucketCount;
+
+            chainLength = 0;
+            psCurrentNode = oSymTable->buckets[index];
+            while (psCurrentNode != NULL &&
+                   !symtablehash_nodeMatches(psCurrentNode, psRecord->hash, psRecord->pcKey,
+                                             psRecord->keyLength)) {
+                psCurrentNode = psCurrentNode->psNextNode;
+                chainLength++;
+            }
+            if (psCurrentNode != NULL) continue;
+
+            /* A line without a tab may end the file, so only a value
+               that has text is looked for past the key */
+            pcValue = psRecord->pcKey + psRecord->keyLength + (psRecord->valueLength > 0);
+            pvValue = NULL;
+            if (psWork->pfParse != NULL &&
+                !(*psWork->pfParse)(pcValue, psRecord->valueLength, &pvValue, psWork->pvExtra)) {
+                psWork->failed = 1;
+                return NULL;
+            }
+            psNewNode = (struct SymTableNode*)malloc(sizeof(struct SymTableNode) + psRecord->keyLength + 1);
+            if (psNewNode == NULL) {
+                psWork->failed = 1;
+                return NULL;
+            }
+            memcpy(psNewNode->acKey, psRecord->pcKey, psRecord->keyLength);
+            psNewNode->acKey[psRecord->keyLength] = '\0';
+            psNewNode->keyLength = psRecord->keyLength;
+            psNewNode->pvValue = pvValue;
+            psNewNode->hash = psRecord->hash;
+            psNewNode->psNextNode = oSymTable->buckets[index];
+            __atomic_store_n(&oSymTable->buckets[index], psNewNode, __ATOMIC_RELEASE);
+            psWork->added++;
+
+            if (chainLength + 1 > LONG_CHAIN_LENGTH + 4 * averageLength) {
+                psWork->sawLongChain = 1;
+            }
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Runs `pfWorker` on every LoadWork, on threads of their own but for
+ * the first, which runs on the calling thread. Work whose thread could
+ * not be started runs on the calling thread instead.
+ */
+static void symtablehash_runLoad(struct LoadWork asWork[], size_t threadCount, void *(*pfWorker)(void*)) {
+    pthread_t aThreads[MAX_RESIZE_THREADS];
+    int aiStarted[MAX_RESIZE_THREADS];
+    size_t t;
+
+    aiStarted[0] = 0;
+    for (t = 1; t < threadCount; t++) {
+        aiStarted[t] = pthread_create(&aThreads[t], NULL, pfWorker, &asWork[t]) == 0;
+    }
+    (*pfWorker)(&asWork[0]);
+    for (t = 1; t < threadCount; t++) {
+        if (aiStarted[t]) {
+            pthread_join(aThreads[t], NULL);
+        } else {
+            (*pfWorker)(&asWork[t]);
+        }
+    }
+}
+
+/*
+ * Hashes and partitions the lines of every chunk under the table's
+ * current hash function, seed and bucket count, which each LoadWork
+ * keeps so that the caller can tell whether they have changed since.
+ * Records from an earlier run are dropped. Returns 1 on success, or 0
+ * if a key holds a '\0' byte or memory is insufficient.
+ */
+static int symtablehash_partitionLines(SymTable_T oSymTable, struct LoadWork asWork[], size_t threadCount) {
+    SymTableHashFn_T pfHash;
+    uint64_t hashSeed;
+    size_t bucketCount, t, p;
+
+    pfHash = __atomic_load_n(&oSymTable->pfHash, __ATOMIC_RELAXED);
+    hashSeed = __atomic_load_n(&oSymTable->hashSeed, __ATOMIC_RELAXED);
+    bucketCount = __atomic_load_n(&oSymTable->bucketCount, __ATOMIC_ACQUIRE);
+    for (t = 0; t < threadCount; t++) {
+        asWork[t].pfHash = pfHash;
+        asWork[t].hashSeed = hashSeed;
+        asWork[t].bucketCount = bucketCount;
+        for (p = 0; p < threadCount; p++) {
+            asWork[t].psPartitions[p].count = 0;
+        }
+    }
+
+    symtablehash_runLoad(asWork, threadCount, symtablehash_hashLines);
+    for (t = 0; t < threadCount; t++) {
+        if (asWork[t].failed) return 0;
+    }
+    return 1;
+}
+
+/*
+ * Loads the bindings of a text file of "key<TAB>value" lines.
+ * Arguments:
+ *   - `oSymTable`: the symbol table to add them to
+ *   - `pcPath`: the file to read
+ *   - `pfParse`: converts each value's text, or NULL to bind NULL
+ *   - `pvExtra`: passed to `pfParse`
+ * The file is mapped and cut into one chunk per thread at line
+ * boundaries. The threads count their lines, the table is grown once
+ * to hold them all, and the threads then hash their lines and sort
+ * them by the range of buckets they fall in, one range per thread.
+ * Finally each thread inserts the lines of its own range. A long chain
+ * seen along the way reseeds the table once at the end.
+ * Returns 1 on success, or 0 on any failure.
+ */
+int SymTable_loadText(SymTable_T oSymTable, const char *pcPath,
+                      SymTableParseFn_T pfParse, void *pvExtra) {
+    struct LoadWork *psWork;
+    struct stat sStat;
+    const char *pcText, *pcCut;
+    size_t threadCount, lineCount, added, length, t, p;
+    int iSuccessful = 1, sawLongChain = 0, hasWriteLock = 0;
+    int fd;
+
+    assert(oSymTable != NULL);
+    assert(pcPath != NULL);
+
+    if (symtablehash_isImmutable(oSymTable)) return 0;
+
+    fd = open(pcPath, O_RDONLY);
+    if (fd < 0) return 0;
+    if (fstat(fd, &sStat) != 0) {
+        close(fd);
+        return 0;
+    }
+    length = (size_t)sStat.st_size;
+    if (length == 0) {
+        close(fd);
+        return 1;
+    }
+    pcText = (const char*)mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (pcText == (const char*)MAP_FAILED) return 0;
+
+    threadCount = length >= PARALLEL_LOAD_MIN_BYTES ? oSymTable->resizeThreads : 1;
+    psWork = (struct LoadWork*)calloc(threadCount, sizeof(struct LoadWork));
+    if (psWork == NULL) {
+        munmap((void*)pcText, length);
+        return 0;
+    }
+
+    /* Chunk t starts after the first '\n' at or past t/threadCount of
+       the file, so no line is split between two chunks */
+    for (t = 0; t < threadCount; t++) {
+        psWork[t].oSymTable = oSymTable;
+        psWork[t].psAll = psWork;
+        psWork[t].threadCount = threadCount;
+        psWork[t].partition = t;
+        psWork[t].pfParse = pfParse;
+        psWork[t].pvExtra = pvExtra;
+        pcCut = pcText + length;
+        if (t + 1 < threadCount) {
+            pcCut = (const char*)memchr(pcText + length / threadCount * (t + 1), '\n',
+                                        length - length / threadCount * (t + 1));
+            pcCut = pcCut != NULL ? pcCut + 1 : pcText + length;
+        }
+        psWork[t].pcStart = t > 0 ? psWork[t - 1].pcEnd : pcText;
+        psWork[t].pcEnd = pcCut > psWork[t].pcStart ? pcCut : psWork[t].pcStart;
+        psWork[t].psPartitions = (struct LoadPartition*)calloc(threadCount, sizeof(struct LoadPartition));
+        if (psWork[t].psPartitions == NULL) iSuccessful = 0;
+    }
+
+    if (iSuccessful) {
+        symtablehash_runLoad(psWork, threadCount, symtablehash_countLines);
+        lineCount = oSymTable->nodeQuantity;
+        for (t = 0; t < threadCount; t++) {
+            lineCount += psWork[t].lineCount;
+        }
+        SymTable_reserve(oSymTable, lineCount);
+        iSuccessful = symtablehash_partitionLines(oSymTable, psWork, threadCount);
+    }
+
+    if (iSuccessful) {
+        symtablehash_beginWrite(oSymTable);
+        hasWriteLock = 1;
+        /* The lines were hashed without the lock, so another writer may
+           have grown or reseeded the table since; if so, partition them
+           anew while no writer can change it again */
+        if (psWork[0].pfHash != oSymTable->pfHash || psWork[0].hashSeed != oSymTable->hashSeed ||
+            psWork[0].bucketCount != oSymTable->bucketCount) {
+            iSuccessful = symtablehash_partitionLines(oSymTable, psWork, threadCount);
+        }
+    }
+
+    if (iSuccessful) {
+        symtablehash_runLoad(psWork, threadCount, symtablehash_insertPartition);
+        added = 0;
+        for (t = 0; t < threadCount; t++) {
+            added += psWork[t].added;
+            if (psWork[t].failed) iSuccessful = 0;
+            if (psWork[t].sawLongChain) sawLongChain = 1;
+        }
+        __atomic_store_n(&oSymTable->nodeQuantity, oSymTable->nodeQuantity + added, __ATOMIC_RELAXED);
+        if (sawLongChain) {
+            symtablehash_reseed(oSymTable);
+        }
+    }
+
+    if (hasWriteLock) {
+        symtablehash_endWrite(oSymTable);
+    }
+
+    for (t = 0; t < threadCount; t++) {
+        if (psWork[t].psPartitions == NULL) continue;
+        for (p = 0; p < threadCount; p++) {
+            free(psWork[t].psPartitions[p].psRecords);
+        }
+        free(psWork[t].psPartitions);
+    }
+    free(psWork);
+    munmap((void*)pcText, length);
+    return iSuccessful;
 }
@@ -0,0 +1,203 @@
+/*--------------------------------------------------------------------*/
+/* symtablehash.h                                                     */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#ifndef SymTableHash_INCLUDED
+#define SymTableHash_INCLUDED
+#include "symtable.h"
+#include "symtablehashfn.h"
+
+/* Extensions to the SymTable ADT that only the hash table
+implementation (symtablehash.c) provides. Tables made by these
+functions are still SymTable_T objects and work with every function
+declared in symtable.h. */
+
+/* Returns a SymTable containing no bindings, meant for tables that
+many threads read and few threads change. SymTable_get and
+SymTable_contains take no lock and make no atomic read-modify-write;
+they retry only if a writer ran at the same time. SymTable_put,
+SymTable_replace and SymTable_remove are serialized among themselves
+and may run concurrently with readers. Removed bindings are kept until
+SymTable_free, because a reader may still be walking them. Returns
+NULL if memory is insufficient. */
+
+SymTable_T SymTable_newReadMostly(void);
+
+/* Every table hashes keys with a seed of its own from
+SymTableHash_randomSeed. If a SymTable_put leaves a chain far longer
+than the average, the table rehashes every key with a new seed, at
+most a few times over its life. A table from SymTable_new starts with
+SymTableHash_wyhash and moves to SymTableHash_siphash at its first
+reseed. */
+
+/* Returns a SymTable containing no bindings whose keys are hashed with
+*pfHash, for example one of the functions declared in
+symtablehashfn.h. Reseeding keeps *pfHash. Returns NULL if memory is
+insufficient. */
+
+SymTable_T SymTable_newWithHash(SymTableHashFn_T pfHash);
+
+/* Returns a SymTable containing no bindings whose keys are hashed with
+*pfHash and uSeed, for a front end that hashes each key itself, such as
+symtableshard.c. Reseeding keeps *pfHash. Returns NULL if memory is
+insufficient. */
+
+SymTable_T SymTable_newWithSeed(SymTableHashFn_T pfHash, uint64_t uSeed);
+
+/* Versions of SymTable_put, SymTable_replace, SymTable_contains,
+SymTable_get and SymTable_remove for a key pcKey whose length uLength
+the caller already knows. If puHash is not NULL, *puHash must be
+(*pfHash)(pcKey, uLength, uSeed) for the pfHash and uSeed oSymTable was
+made with by SymTable_newWithSeed; the key is then not hashed again,
+unless oSymTable has reseeded since. If puHash is NULL, the key is
+hashed as the plain functions would. */
+
+int SymTable_putHashed(SymTable_T oSymTable, const char *pcKey,
+   size_t uLength, const uint64_t *puHash, const void *pvValue);
+
+void *SymTable_replaceHashed(SymTable_T oSymTable, const char *pcKey,
+   size_t uLength, const uint64_t *puHash, const void *pvValue);
+
+int SymTable_containsHashed(SymTable_T oSymTable, const char *pcKey,
+   size_t uLength, const uint64_t *puHash);
+
+void *SymTable_getHashed(SymTable_T oSymTable, const char *pcKey,
+   size_t uLength, const uint64_t *puHash);
+
+void *SymTable_removeHashed(SymTable_T oSymTable, const char *pcKey,
+   size_t uLength, const uint64_t *puHash);
+
+/* Sets how many threads, the calling thread included, rehash the
+bindings of oSymTable each time it grows. Each thread moves the
+bindings of an equal slice of the old buckets. Small tables are always
+rehashed on the calling thread. SymTable_freeze builds its index on as
+many threads. uThreadCount must be at least 1; the default is 1. */
+
+void SymTable_setResizeThreads(SymTable_T oSymTable, size_t uThreadCount);
+
+/* Grows oSymTable ahead of time so that it can hold uCount bindings
+without resizing again. Use it before a batch of SymTable_put calls
+whose size is known. If memory is insufficient, oSymTable is left
+unchanged and simply resizes later as usual. */
+
+void SymTable_reserve(SymTable_T oSymTable, size_t uCount);
+
+/* Stores in auCounts[i] the number of buckets of oSymTable whose chain
+holds exactly i bindings, for i from 0 to uMaxLength - 1, and in
+auCounts[uMaxLength] the number of buckets holding uMaxLength or more.
+auCounts must have room for uMaxLength + 1 elements. */
+
+void SymTable_getChainHistogram(SymTable_T oSymTable, size_t auCounts[],
+   size_t uMaxLength);
+
+/* Batch versions of SymTable_get, SymTable_contains and SymTable_put
+for many keys at once, such as a batch of tokens. Every key's bucket is
+fetched from memory before any chain is walked, so the cache misses of
+the batch overlap. Only a table built with SymTableHash_murmur3, on a
+CPU with AVX2, also hashes the keys together, eight at a time in vector
+lanes; a table with the default SymTableHash_wyhash, or any other
+function, hashes them one at a time as SymTable_get would.
+
+SymTable_getBatch stores in apvValues[i] the value of apcKeys[i], or
+NULL if oSymTable has no such binding. */
+
+void SymTable_getBatch(SymTable_T oSymTable, const char *const apcKeys[],
+   size_t uCount, void *apvValues[]);
+
+/* Stores in aiFound[i] 1 (TRUE) if oSymTable contains apcKeys[i], 0
+(FALSE) otherwise. */
+
+void SymTable_containsBatch(SymTable_T oSymTable,
+   const char *const apcKeys[], size_t uCount, int aiFound[]);
+
+/* Puts each binding (apcKeys[i], apvValues[i]) into oSymTable in
+order, as SymTable_put would. If aiResults is not NULL, stores what
+SymTable_put would have returned in aiResults[i]. Returns the number of
+bindings added. */
+
+size_t SymTable_putBatch(SymTable_T oSymTable, const char *const apcKeys[],
+   const void *const apvValues[], size_t uCount, int aiResults[]);
+
+/* Makes oSymTable immutable, for tables that are filled once and then
+only read. Its bindings move into a minimal perfect hash (see
+symtablemph.h): a lookup hashes the key once and compares it with the
+one binding it could be, and the index takes a few bits per key
+instead of a chain node per binding. From then on SymTable_put,
+SymTable_replace, SymTable_remove and SymTable_putBatch change nothing
+and report failure as for an absent or present key: 0, NULL, NULL and
+0. Lookups, SymTable_map and SymTable_getLength work as before, and
+need no lock even on a read-mostly table. SymTable_freeze must not run
+at the same time as any other call on oSymTable. Returns 1 (TRUE) on
+success, or if oSymTable was already frozen. Keys whose hashes collide
+do not make it fail by themselves, as the index then hashes with
+SipHash instead. Returns 0 (FALSE), leaving oSymTable unchanged and
+mutable, if memory is insufficient, or if a few SipHash seeds cannot
+build the index either, which is vanishingly unlikely. */
+
+int SymTable_freeze(SymTable_T oSymTable);
+
+/* Returns 1 (TRUE) if oSymTable is frozen by SymTable_freeze or mapped
+by SymTable_openMapped, so that no change to it can succeed, or 0
+(FALSE) otherwise. */
+
+int SymTable_isImmutable(SymTable_T oSymTable);
+
+/* Saves the bindings of oSymTable, mutable, frozen or mapped, to the
+file named pcPath as a snapshot (see symtablesnapshot.h). Each value is
+saved as the integer its pointer converts to, so save values that mean
+the same in the process that maps the file: offsets or indices cast to
+void*, say, rather than pointers to memory of this process. The file is
+replaced only once the snapshot is complete. Returns 1 (TRUE) on
+success, or 0 (FALSE) if memory is insufficient or the file cannot be
+written. */
+
+int SymTable_save(SymTable_T oSymTable, const char *pcPath);
+
+/* Returns a table that serves the snapshot in the file named pcPath
+straight from a read-only memory mapping of the file. Opening reads no
+bindings, so it takes about as long for millions of bindings as for
+one; lookups fault in the pages they touch. The table is immutable, as
+if frozen by SymTable_freeze, until SymTable_free unmaps the file. The
+file must not change while it is mapped; SymTable_save replaces a file
+rather than rewriting it, so saving anew to the same path is safe.
+Returns NULL if the file cannot be mapped, is not a snapshot written on
+this kind of machine, or if memory is insufficient. */
+
+SymTable_T SymTable_openMapped(const char *pcPath);
+
+/* A function that converts the uLength bytes of text at pcText, which
+are not followed by a '\0', into a value stored in *ppvValue. It must
+copy any of the text it keeps. Returns 1 (TRUE) on success, or 0
+(FALSE) to stop the load. pvExtra is the caller's extra parameter. */
+
+typedef int (*SymTableParseFn_T)(const char *pcText, size_t uLength,
+   void **ppvValue, void *pvExtra);
+
+/* Adds to oSymTable the bindings of the text file named pcPath, one
+per line: the key, a tab, and the value's text, converted by *pfParse;
+if pfParse is NULL, every value is NULL. A line without a tab is a key
+whose value's text is empty. Empty lines are skipped, and a '\r' ending
+a line is dropped. As with SymTable_put, a key already bound keeps its
+value, so the first line with a key wins.
+
+The file is mapped and split at line boundaries among as many threads
+as SymTable_setResizeThreads allows. Each thread parses and hashes its
+share of the lines, and sorts them by the range of buckets they fall
+into. Each thread then inserts the lines of one range, so no two
+threads touch the same chain and no insert takes a lock. The table is
+grown once, before any insert, to hold every line. *pfParse may run on
+several threads at once, and is called only for a key that is new. On a
+read-mostly table the lines are hashed before the writer lock is taken
+and inserted under it; if another writer grew or reseeded the table in
+between, they are hashed again under the lock.
+
+Returns 1 (TRUE) on success. Returns 0 (FALSE) if the file cannot be
+mapped, if a key holds a '\0' byte, if *pfParse fails, if oSymTable is
+frozen or mapped, or if memory is insufficient; bindings added by then
+stay in oSymTable, so that their values can be released. */
+
+int SymTable_loadText(SymTable_T oSymTable, const char *pcPath,
+   SymTableParseFn_T pfParse, void *pvExtra);
+
+#endif
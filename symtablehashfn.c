@@ -0,0 +1,668 @@
+/*--------------------------------------------------------------------*/
+/* symtablehashfn.c                                                   */
+/* String hash functions for the hash table SymTable                  */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "symtablehashfn.h"
+
+/*
+ * X86_64_INTRINSICS: 1 where SSE4.2 and AVX2 code can be compiled in;
+ * whether the CPU running the program has them is checked at run time.
+ */
+#if defined(__GNUC__) && defined(__x86_64__)
+#define X86_64_INTRINSICS 1
+#include <immintrin.h>
+#else
+#define X86_64_INTRINSICS 0
+#endif
+
+/*
+ * BATCH_LANES: How many keys the vector MurmurHash3 kernel hashes at
+ * once, one per 32-bit lane of an AVX2 register.
+ */
+#define BATCH_LANES 8
+
+/*
+ * HASH_SHIFT_AMOUNT: Defines the left shift amount used in the legacy
+ * hash function.
+ */
+#define HASH_SHIFT_AMOUNT 5
+
+/*
+ * wySecret: The constants that the wyhash-style hash mixes into every
+ * step. Each is an odd 64-bit value with half of its bits set.
+ */
+static const uint64_t wySecret[4] = {
+    0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL,
+    0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL
+};
+
+/*
+ * processSecret: Random bits read once per process, from which every
+ * table seed is derived. seedCounter makes each derived seed distinct.
+ */
+static uint64_t processSecret;
+static uint64_t seedCounter;
+static pthread_once_t processSecretOnce = PTHREAD_ONCE_INIT;
+
+/*
+ * Multiplies *puA by *puB as 128-bit numbers, leaving the low half in
+ * *puA and the high half in *puB. Uses the compiler's 128-bit type
+ * where there is one, and four 32-bit products otherwise.
+ */
+static void symtablehashfn_multiply(uint64_t *puA, uint64_t *puB) {
+#ifdef __SIZEOF_INT128__
+    __extension__ typedef unsigned __int128 Product;
+    Product product = (Product)*puA * *puB;
+
+    *puA = (uint64_t)product;
+    *puB = (uint64_t)(product >> 64);
+#else
+    uint64_t aHigh = *puA >> 32, aLow = (uint32_t)*puA;
+    uint64_t bHigh = *puB >> 32, bLow = (uint32_t)*puB;
+    uint64_t highHigh = aHigh * bHigh, highLow = aHigh * bLow;
+    uint64_t lowHigh = aLow * bHigh, lowLow = aLow * bLow;
+    uint64_t middle = (lowLow >> 32) + (uint32_t)highLow + (uint32_t)lowHigh;
+
+    *puA = (middle << 32) | (uint32_t)lowLow;
+    *puB = highHigh + (highLow >> 32) + (lowHigh >> 32) + (middle >> 32);
+#endif
+}
+
+/*
+ * Folds a 128-bit product of `a` and `b` back to 64 bits.
+ */
+static uint64_t symtablehashfn_mix(uint64_t a, uint64_t b) {
+    symtablehashfn_multiply(&a, &b);
+    return a ^ b;
+}
+
+/*
+ * Reads 8 or 4 bytes in native byte order. memcpy keeps unaligned
+ * reads legal; compilers turn it into a single load.
+ */
+static uint64_t symtablehashfn_read8(const unsigned char *pucBytes) {
+    uint64_t value;
+    memcpy(&value, pucBytes, sizeof(value));
+    return value;
+}
+
+static uint64_t symtablehashfn_read4(const unsigned char *pucBytes) {
+    uint32_t value;
+    memcpy(&value, pucBytes, sizeof(value));
+    return value;
+}
+
+/*
+ * Hashes a key eight bytes at a time.
+ * Arguments:
+ *   - `pcKey`: the bytes to hash
+ *   - `uLength`: how many bytes
+ *   - `uSeed`: mixed into the starting state
+ * Keys of up to 16 bytes are covered by two overlapping reads and one
+ * multiply. Longer keys are consumed 16 bytes per step, or 48 bytes
+ * per step over three independent lanes once they pass 48 bytes. The
+ * running state goes into both sides of every multiply: were it in
+ * only one, key bytes equal to the secret on the other side would zero
+ * the product and erase the seed, and those keys would collide under
+ * every seed.
+ */
+uint64_t SymTableHash_wyhash(const char *pcKey, size_t uLength, uint64_t uSeed) {
+    const unsigned char *p = (const unsigned char*)pcKey;
+    size_t i = uLength;
+    uint64_t a, b;
+
+    assert(pcKey != NULL);
+
+    uSeed ^= symtablehashfn_mix(uSeed ^ wySecret[0], wySecret[1]);
+    if (uLength <= 16) {
+        if (uLength >= 4) {
+            size_t shift = (uLength >> 3) << 2;
+            a = (symtablehashfn_read4(p) << 32) | symtablehashfn_read4(p + shift);
+            b = (symtablehashfn_read4(p + uLength - 4) << 32) |
+                symtablehashfn_read4(p + uLength - 4 - shift);
+        } else if (uLength > 0) {
+            a = ((uint64_t)p[0] << 16) | ((uint64_t)p[uLength >> 1] << 8) | p[uLength - 1];
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        if (i > 48) {
+            uint64_t lane1 = uSeed, lane2 = uSeed;
+            do {
+                uSeed = symtablehashfn_mix(symtablehashfn_read8(p) ^ wySecret[1] ^ uSeed,
+                                           symtablehashfn_read8(p + 8) ^ uSeed);
+                lane1 = symtablehashfn_mix(symtablehashfn_read8(p + 16) ^ wySecret[2] ^ lane1,
+                                           symtablehashfn_read8(p + 24) ^ lane1);
+                lane2 = symtablehashfn_mix(symtablehashfn_read8(p + 32) ^ wySecret[3] ^ lane2,
+                                           symtablehashfn_read8(p + 40) ^ lane2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            uSeed ^= lane1 ^ lane2;
+        }
+        while (i > 16) {
+            uSeed = symtablehashfn_mix(symtablehashfn_read8(p) ^ wySecret[1] ^ uSeed,
+                                       symtablehashfn_read8(p + 8) ^ uSeed);
+            p += 16;
+            i -= 16;
+        }
+        a = symtablehashfn_read8(p + i - 16);
+        b = symtablehashfn_read8(p + i - 8);
+    }
+
+    a ^= wySecret[1] ^ uSeed;
+    b ^= wySecret[0] ^ uSeed;
+    symtablehashfn_multiply(&a, &b);
+    return symtablehashfn_mix(a ^ wySecret[0] ^ uLength, b ^ wySecret[1]);
+}
+
+/*
+ * Hashes a key with 64-bit FNV-1a, starting from the offset basis
+ * xor the seed.
+ */
+uint64_t SymTableHash_fnv1a(const char *pcKey, size_t uLength, uint64_t uSeed) {
+    uint64_t hash = 14695981039346656037ULL ^ uSeed;
+    size_t i;
+
+    assert(pcKey != NULL);
+
+    for (i = 0; i < uLength; i++) {
+        hash ^= (unsigned char)pcKey[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/*
+ * Hashes a key by shifting and adding each character, in unsigned int
+ * arithmetic exactly as the original table did. The seed is ignored.
+ */
+uint64_t SymTableHash_legacy(const char *pcKey, size_t uLength, uint64_t uSeed) {
+    unsigned int hash = 0U;
+    size_t i;
+
+    assert(pcKey != NULL);
+    (void)uSeed;
+
+    for (i = 0; i < uLength; i++) {
+        hash = (hash << HASH_SHIFT_AMOUNT) + (unsigned int)pcKey[i];
+    }
+    return hash;
+}
+
+/*
+ * Rotates `value` left by `bits`, which must be between 1 and 63.
+ */
+static uint64_t symtablehashfn_rotate(uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+/*
+ * Scrambles a 64-bit value with the splitmix64 finalizer. Every input
+ * bit affects every output bit.
+ */
+static uint64_t symtablehashfn_scramble(uint64_t value) {
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9ULL;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111ebULL;
+    value ^= value >> 31;
+    return value;
+}
+
+/*
+ * One SipHash round over the four state words.
+ */
+static void symtablehashfn_sipRound(uint64_t *v) {
+    v[0] += v[1]; v[1] = symtablehashfn_rotate(v[1], 13); v[1] ^= v[0];
+    v[0] = symtablehashfn_rotate(v[0], 32);
+    v[2] += v[3]; v[3] = symtablehashfn_rotate(v[3], 16); v[3] ^= v[2];
+    v[0] += v[3]; v[3] = symtablehashfn_rotate(v[3], 21); v[3] ^= v[0];
+    v[2] += v[1]; v[1] = symtablehashfn_rotate(v[1], 17); v[1] ^= v[2];
+    v[2] = symtablehashfn_rotate(v[2], 32);
+}
+
+/*
+ * Hashes a key with SipHash-1-3, a keyed hash whose output cannot be
+ * predicted without the key, so collisions cannot be precomputed.
+ * Arguments:
+ *   - `pcKey`: the bytes to hash
+ *   - `uLength`: how many bytes
+ *   - `uSeed`: the first half of the 128-bit key; the second half is
+ *     derived from it
+ * Message words are read little-endian as the SipHash specification
+ * requires, so a given seed gives the same hash on every machine.
+ */
+uint64_t SymTableHash_siphash(const char *pcKey, size_t uLength, uint64_t uSeed) {
+    const unsigned char *p = (const unsigned char*)pcKey;
+    uint64_t k0 = uSeed, k1 = symtablehashfn_scramble(uSeed);
+    uint64_t v[4];
+    uint64_t word;
+    size_t i, j;
+
+    assert(pcKey != NULL);
+
+    v[0] = k0 ^ 0x736f6d6570736575ULL;
+    v[1] = k1 ^ 0x646f72616e646f6dULL;
+    v[2] = k0 ^ 0x6c7967656e657261ULL;
+    v[3] = k1 ^ 0x7465646279746573ULL;
+
+    for (i = 0; i + 8 <= uLength; i += 8) {
+        word = 0;
+        for (j = 0; j < 8; j++) {
+            word |= (uint64_t)p[i + j] << (8 * j);
+        }
+        v[3] ^= word;
+        symtablehashfn_sipRound(v);
+        v[0] ^= word;
+    }
+
+    /* The last 0 to 7 bytes, with the length in the top byte */
+    word = (uint64_t)uLength << 56;
+    for (j = 0; i + j < uLength; j++) {
+        word |= (uint64_t)p[i + j] << (8 * j);
+    }
+    v[3] ^= word;
+    symtablehashfn_sipRound(v);
+    v[0] ^= word;
+
+    v[2] ^= 0xff;
+    symtablehashfn_sipRound(v);
+    symtablehashfn_sipRound(v);
+    symtablehashfn_sipRound(v);
+    return v[0] ^ v[1] ^ v[2] ^ v[3];
+}
+
+/*
+ * crc32cTable: For the software CRC32C, the CRC of each byte value
+ * under the reflected Castagnoli polynomial 0x82f63b78.
+ */
+static uint32_t crc32cTable[256];
+
+/*
+ * Builds crc32cTable.
+ */
+static void symtablehashfn_initCrc32cTable(void) {
+    uint32_t crc;
+    int i, bit;
+
+    for (i = 0; i < 256; i++) {
+        crc = (uint32_t)i;
+        for (bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0x82f63b78U & (0U - (crc & 1U)));
+        }
+        crc32cTable[i] = crc;
+    }
+}
+
+/*
+ * Folds two CRC lanes and the length into a 64-bit hash. The seed is
+ * already in the lanes, which start from its two halves. A CRC alone
+ * changes only linearly with its input, so the lanes go through a
+ * multiplicative scramble.
+ */
+static uint64_t symtablehashfn_finishCrc32c(uint32_t lane0, uint32_t lane1, size_t uLength) {
+    return symtablehashfn_scramble((((uint64_t)lane1 << 32) | lane0) ^
+                                   ((uint64_t)uLength * 0x9e3779b97f4a7c15ULL));
+}
+
+/*
+ * Software CRC32C hash, one byte per table lookup. Consumes the key in
+ * the same 8-byte words and lanes as the hardware version and gives
+ * the same result.
+ */
+static uint64_t symtablehashfn_crc32cSoftware(const char *pcKey, size_t uLength, uint64_t uSeed) {
+    const unsigned char *p = (const unsigned char*)pcKey;
+    uint32_t lanes[2];
+    size_t word, i;
+
+    lanes[0] = (uint32_t)uSeed;
+    lanes[1] = (uint32_t)(uSeed >> 32);
+    for (word = 0; word * 8 < uLength; word++) {
+        uint32_t crc = lanes[word & 1];
+        for (i = word * 8; i < word * 8 + 8; i++) {
+            unsigned char byte = i < uLength ? p[i] : 0;
+            crc = crc32cTable[(crc ^ byte) & 0xff] ^ (crc >> 8);
+        }
+        lanes[word & 1] = crc;
+    }
+    return symtablehashfn_finishCrc32c(lanes[0], lanes[1], uLength);
+}
+
+#if X86_64_INTRINSICS
+/*
+ * CRC32C hash using the SSE4.2 crc32 instruction, 8 bytes per
+ * instruction. Alternate words go to two independent lanes so that the
+ * instruction's latency overlaps. The last partial word is zero-padded.
+ */
+__attribute__((target("sse4.2")))
+static uint64_t symtablehashfn_crc32cHardware(const char *pcKey, size_t uLength, uint64_t uSeed) {
+    const unsigned char *p = (const unsigned char*)pcKey;
+    uint64_t lane0 = (uint32_t)uSeed, lane1 = (uint32_t)(uSeed >> 32);
+    uint64_t tail = 0;
+    size_t i = 0;
+
+    for (; i + 16 <= uLength; i += 16) {
+        lane0 = _mm_crc32_u64(lane0, symtablehashfn_read8(p + i));
+        lane1 = _mm_crc32_u64(lane1, symtablehashfn_read8(p + i + 8));
+    }
+    if (i + 8 <= uLength) {
+        lane0 = _mm_crc32_u64(lane0, symtablehashfn_read8(p + i));
+        i += 8;
+        if (i < uLength) {
+            memcpy(&tail, p + i, uLength - i);
+            lane1 = _mm_crc32_u64(lane1, tail);
+        }
+    } else if (i < uLength) {
+        memcpy(&tail, p + i, uLength - i);
+        lane0 = _mm_crc32_u64(lane0, tail);
+    }
+    return symtablehashfn_finishCrc32c((uint32_t)lane0, (uint32_t)lane1, uLength);
+}
+#endif
+
+static uint64_t symtablehashfn_crc32cResolve(const char *pcKey, size_t uLength, uint64_t uSeed);
+
+/*
+ * pfCrc32c: The CRC32C implementation for this CPU. It starts out as
+ * the resolver, which replaces itself on the first call.
+ */
+static SymTableHashFn_T pfCrc32c = symtablehashfn_crc32cResolve;
+
+/*
+ * Picks the hardware CRC32C if the CPU has SSE4.2 and the software one
+ * otherwise, stores the choice in pfCrc32c, and hashes with it. Racing
+ * first calls all make the same choice.
+ */
+static uint64_t symtablehashfn_crc32cResolve(const char *pcKey, size_t uLength, uint64_t uSeed) {
+    static pthread_once_t tableOnce = PTHREAD_ONCE_INIT;
+    SymTableHashFn_T pfChosen = symtablehashfn_crc32cSoftware;
+
+#if X86_64_INTRINSICS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.2")) {
+        pfChosen = symtablehashfn_crc32cHardware;
+    }
+#endif
+    if (pfChosen == symtablehashfn_crc32cSoftware) {
+        pthread_once(&tableOnce, symtablehashfn_initCrc32cTable);
+    }
+    __atomic_store_n(&pfCrc32c, pfChosen, __ATOMIC_RELEASE);
+    return (*pfChosen)(pcKey, uLength, uSeed);
+}
+
+/*
+ * Hashes a key with CRC32C, through the implementation chosen for this
+ * CPU on the first call.
+ */
+uint64_t SymTableHash_crc32c(const char *pcKey, size_t uLength, uint64_t uSeed) {
+    assert(pcKey != NULL);
+
+    return (*__atomic_load_n(&pfCrc32c, __ATOMIC_ACQUIRE))(pcKey, uLength, uSeed);
+}
+
+/*
+ * Scrambles one 32-bit block of a MurmurHash3 key.
+ */
+static uint32_t symtablehashfn_murmurBlock(uint32_t block) {
+    block *= 0xcc9e2d51U;
+    block = (block << 15) | (block >> 17);
+    return block * 0x1b873593U;
+}
+
+/*
+ * Hashes a key with MurmurHash3 (x86_32), four bytes per step, and
+ * returns the 32-bit result. The low half of the seed is used. Blocks
+ * are read little-endian, so the hash is the same on every machine.
+ */
+uint64_t SymTableHash_murmur3(const char *pcKey, size_t uLength, uint64_t uSeed) {
+    const unsigned char *p = (const unsigned char*)pcKey;
+    uint32_t hash = (uint32_t)uSeed;
+    uint32_t block;
+    size_t i, j;
+
+    assert(pcKey != NULL);
+
+    for (i = 0; i + 4 <= uLength; i += 4) {
+        block = (uint32_t)p[i] | ((uint32_t)p[i + 1] << 8) |
+                ((uint32_t)p[i + 2] << 16) | ((uint32_t)p[i + 3] << 24);
+        hash ^= symtablehashfn_murmurBlock(block);
+        hash = (hash << 13) | (hash >> 19);
+        hash = hash * 5 + 0xe6546b64U;
+    }
+    if (i < uLength) {
+        block = 0;
+        for (j = 0; i + j < uLength; j++) {
+            block |= (uint32_t)p[i + j] << (8 * j);
+        }
+        hash ^= symtablehashfn_murmurBlock(block);
+    }
+
+    hash ^= (uint32_t)uLength;
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bU;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35U;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+#if X86_64_INTRINSICS
+/*
+ * Rotates each 32-bit lane left by `bits`.
+ */
+#define ROTATE_LANES(value, bits) \
+    _mm256_or_si256(_mm256_slli_epi32(value, bits), _mm256_srli_epi32(value, 32 - (bits)))
+
+/*
+ * Hashes BATCH_LANES keys with MurmurHash3 at once, one key per 32-bit
+ * lane of an AVX2 register, and gives the same hashes as
+ * SymTableHash_murmur3.
+ * Each step gathers the next 4-byte block of every key that still has
+ * a whole block left; the gather's mask keeps it from reading past any
+ * key. A key's last, partial block is gathered once beforehand as the
+ * four bytes that end the key, shifted down, and takes the gathered
+ * block's place; only keys shorter than four bytes are read a byte at
+ * a time. Every lane computes both the whole-block and the tail update,
+ * and a mask per lane keeps the one that applies, so keys of any
+ * lengths share a batch.
+ * Intrinsics compiled without optimization keep every vector in memory
+ * and lose to the scalar loop, so the Makefile builds this file with
+ * -O2 whatever the flags of the rest of the build.
+ */
+__attribute__((target("avx2")))
+static void symtablehashfn_murmurLanes(const char *const apcKeys[], const size_t auLengths[],
+                                       uint64_t uSeed, uint64_t auHashes[]) {
+    const __m256i evenHalves = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+    const __m256i four = _mm256_set1_epi64x(4);
+    __m256i hash, lengths, blocks, tails, hasTail, longTail, addressLow, addressHigh;
+    __m256i lengthLow, lengthHigh, tailBytes;
+    __m128i tailLow, tailHigh;
+    size_t maxLength = 0;
+    size_t block, i;
+    unsigned shortKeys;
+    int lane;
+
+    addressLow = _mm256_loadu_si256((const __m256i*)(const void*)apcKeys);
+    addressHigh = _mm256_loadu_si256((const __m256i*)(const void*)(apcKeys + 4));
+    lengthLow = _mm256_loadu_si256((const __m256i*)(const void*)auLengths);
+    lengthHigh = _mm256_loadu_si256((const __m256i*)(const void*)(auLengths + 4));
+    lengths = _mm256_inserti128_si256(
+        _mm256_castsi128_si256(_mm256_castsi256_si128(_mm256_permutevar8x32_epi32(lengthLow, evenHalves))),
+        _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(lengthHigh, evenHalves)), 1);
+    blocks = _mm256_srli_epi32(lengths, 2);
+    tailBytes = _mm256_and_si256(lengths, _mm256_set1_epi32(3));
+    hasTail = _mm256_cmpgt_epi32(tailBytes, _mm256_setzero_si256());
+    longTail = _mm256_and_si256(hasTail, _mm256_cmpgt_epi32(lengths, _mm256_set1_epi32(3)));
+
+    /* Keys shorter than four bytes cannot be read as a word ending at
+       their last byte. */
+    tails = _mm256_setzero_si256();
+    shortKeys = (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(
+        _mm256_andnot_si256(longTail, hasTail)));
+    if (shortKeys != 0) {
+        uint32_t auTails[BATCH_LANES] = {0};
+        for (lane = 0; lane < BATCH_LANES; lane++) {
+            if ((shortKeys >> lane & 1) == 0) continue;
+            for (i = 0; i < auLengths[lane]; i++) {
+                auTails[lane] |= (uint32_t)(unsigned char)apcKeys[lane][i] << (8 * i);
+            }
+        }
+        tails = _mm256_loadu_si256((const __m256i*)(const void*)auTails);
+    }
+    tailLow = _mm256_mask_i64gather_epi32(_mm256_castsi256_si128(tails), (const int*)0,
+                                          _mm256_add_epi64(addressLow, _mm256_sub_epi64(lengthLow, four)),
+                                          _mm256_castsi256_si128(longTail), 1);
+    tailHigh = _mm256_mask_i64gather_epi32(_mm256_extracti128_si256(tails, 1), (const int*)0,
+                                           _mm256_add_epi64(addressHigh, _mm256_sub_epi64(lengthHigh, four)),
+                                           _mm256_extracti128_si256(longTail, 1), 1);
+    tails = _mm256_inserti128_si256(_mm256_castsi128_si256(tailLow), tailHigh, 1);
+    tails = _mm256_srlv_epi32(tails, _mm256_and_si256(longTail,
+        _mm256_sub_epi32(_mm256_set1_epi32(32), _mm256_slli_epi32(tailBytes, 3))));
+    hash = _mm256_set1_epi32((int)(uint32_t)uSeed);
+
+    for (lane = 0; lane < BATCH_LANES; lane++) {
+        if (auLengths[lane] > maxLength) maxLength = auLengths[lane];
+    }
+
+    for (block = 0; block * 4 < maxLength; block++) {
+        const __m256i blockIndex = _mm256_set1_epi32((int)block);
+        const __m256i offset = _mm256_set1_epi64x((long long)(block * 4));
+        __m256i isWhole = _mm256_cmpgt_epi32(blocks, blockIndex);
+        __m256i isTail = _mm256_and_si256(_mm256_cmpeq_epi32(blocks, blockIndex), hasTail);
+        __m128i dataLow = _mm256_mask_i64gather_epi32(_mm256_castsi256_si128(tails), (const int*)0,
+                                                      _mm256_add_epi64(addressLow, offset),
+                                                      _mm256_castsi256_si128(isWhole), 1);
+        __m128i dataHigh = _mm256_mask_i64gather_epi32(_mm256_extracti128_si256(tails, 1), (const int*)0,
+                                                       _mm256_add_epi64(addressHigh, offset),
+                                                       _mm256_extracti128_si256(isWhole, 1), 1);
+        __m256i data = _mm256_inserti128_si256(_mm256_castsi128_si256(dataLow), dataHigh, 1);
+        __m256i mixed, whole;
+
+        data = _mm256_mullo_epi32(data, _mm256_set1_epi32((int)0xcc9e2d51U));
+        data = ROTATE_LANES(data, 15);
+        data = _mm256_mullo_epi32(data, _mm256_set1_epi32(0x1b873593));
+        mixed = _mm256_xor_si256(hash, data);
+
+        whole = ROTATE_LANES(mixed, 13);
+        whole = _mm256_add_epi32(_mm256_add_epi32(_mm256_slli_epi32(whole, 2), whole),
+                                 _mm256_set1_epi32((int)0xe6546b64U));
+
+        hash = _mm256_blendv_epi8(hash, whole, isWhole);
+        hash = _mm256_blendv_epi8(hash, mixed, isTail);
+    }
+
+    hash = _mm256_xor_si256(hash, lengths);
+    hash = _mm256_xor_si256(hash, _mm256_srli_epi32(hash, 16));
+    hash = _mm256_mullo_epi32(hash, _mm256_set1_epi32((int)0x85ebca6bU));
+    hash = _mm256_xor_si256(hash, _mm256_srli_epi32(hash, 13));
+    hash = _mm256_mullo_epi32(hash, _mm256_set1_epi32((int)0xc2b2ae35U));
+    hash = _mm256_xor_si256(hash, _mm256_srli_epi32(hash, 16));
+    _mm256_storeu_si256((__m256i*)(void*)auHashes,
+                        _mm256_cvtepu32_epi64(_mm256_castsi256_si128(hash)));
+    _mm256_storeu_si256((__m256i*)(void*)(auHashes + 4),
+                        _mm256_cvtepu32_epi64(_mm256_extracti128_si256(hash, 1)));
+}
+#endif
+
+/*
+ * batchLevel: 1 once the CPU is known to have AVX2, 0 once it is known
+ * not to, -1 until the first batch call checks.
+ */
+static int batchLevel = -1;
+
+/*
+ * Hashes many keys with one function.
+ * Arguments:
+ *   - `pfHash`: the hash function
+ *   - `apcKeys`, `auLengths`: the keys and their lengths
+ *   - `uCount`: how many keys
+ *   - `uSeed`: the seed for every key
+ *   - `auHashes`: receives the hash of each key
+ * MurmurHash3 on a CPU with AVX2 runs BATCH_LANES keys at a time
+ * through the vector kernel; everything else is hashed one key at a
+ * time. Keys too long for 32-bit lane arithmetic also go one at a time.
+ */
+void SymTableHash_hashBatch(SymTableHashFn_T pfHash, const char *const apcKeys[],
+                            const size_t auLengths[], size_t uCount, uint64_t uSeed,
+                            uint64_t auHashes[]) {
+    size_t i = 0;
+
+    assert(pfHash != NULL);
+    assert(uCount == 0 || (apcKeys != NULL && auLengths != NULL && auHashes != NULL));
+
+#if X86_64_INTRINSICS
+    if (pfHash == SymTableHash_murmur3) {
+        int level = __atomic_load_n(&batchLevel, __ATOMIC_RELAXED);
+        if (level < 0) {
+            __builtin_cpu_init();
+            level = __builtin_cpu_supports("avx2") ? 1 : 0;
+            __atomic_store_n(&batchLevel, level, __ATOMIC_RELAXED);
+        }
+        while (level > 0 && i + BATCH_LANES <= uCount) {
+            size_t lane;
+            for (lane = 0; lane < BATCH_LANES; lane++) {
+                if (auLengths[i + lane] > 0x7fffffffU) break;
+            }
+            if (lane == BATCH_LANES) {
+                symtablehashfn_murmurLanes(apcKeys + i, auLengths + i, uSeed, auHashes + i);
+            } else {
+                for (lane = 0; lane < BATCH_LANES; lane++) {
+                    auHashes[i + lane] = SymTableHash_murmur3(apcKeys[i + lane], auLengths[i + lane], uSeed);
+                }
+            }
+            i += BATCH_LANES;
+        }
+    }
+#else
+    (void)batchLevel;
+#endif
+    for (; i < uCount; i++) {
+        auHashes[i] = (*pfHash)(apcKeys[i], auLengths[i], uSeed);
+    }
+}
+
+/*
+ * Fills processSecret from /dev/urandom. If that cannot be read, the
+ * time, the clock and the address of a local are mixed instead, which
+ * still differs from run to run.
+ */
+static void symtablehashfn_initSecret(void) {
+    FILE *psFile;
+    uint64_t secret = 0;
+    int iStackMarker;
+
+    psFile = fopen("/dev/urandom", "rb");
+    if (psFile != NULL) {
+        if (fread(&secret, sizeof(secret), 1, psFile) != 1) secret = 0;
+        fclose(psFile);
+    }
+    if (secret == 0) {
+        secret = symtablehashfn_scramble((uint64_t)time(NULL)) ^
+                 symtablehashfn_scramble((uint64_t)clock() + 1) ^
+                 symtablehashfn_scramble((uint64_t)(size_t)&iStackMarker);
+    }
+    processSecret = secret;
+}
+
+/*
+ * Returns a fresh seed. The process secret is read once; each call
+ * then hashes a counter with SipHash keyed by the secret. A keyed hash
+ * cannot be run backwards the way a scramble can, so a seed that leaks
+ * reveals neither the secret nor any other seed.
+ */
+uint64_t SymTableHash_randomSeed(void) {
+    uint64_t count;
+
+    pthread_once(&processSecretOnce, symtablehashfn_initSecret);
+    count = __atomic_add_fetch(&seedCounter, 1, __ATOMIC_RELAXED);
+    return SymTableHash_siphash((const char*)&count, sizeof(count), processSecret);
+}
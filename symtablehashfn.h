@@ -0,0 +1,78 @@
+/*--------------------------------------------------------------------*/
+/* symtablehashfn.h                                                   */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#ifndef SymTableHashFn_INCLUDED
+#define SymTableHashFn_INCLUDED
+#include <stddef.h>
+#include <stdint.h>
+
+/* String hash functions that a hash table SymTable can be built with.
+Each one hashes the uLength bytes at pcKey, mixed with uSeed, to a
+64-bit value. A function may ignore uSeed. */
+
+typedef uint64_t (*SymTableHashFn_T)(const char *pcKey, size_t uLength,
+   uint64_t uSeed);
+
+/* A wyhash-style hash that reads the key eight bytes at a time and
+mixes with 64x64->128-bit multiplies. It is the default for new
+tables: fast on keys of every length and well mixed in every bit. */
+
+uint64_t SymTableHash_wyhash(const char *pcKey, size_t uLength,
+   uint64_t uSeed);
+
+/* 64-bit FNV-1a, one byte per step. Simple and well known, but slow
+on long keys. */
+
+uint64_t SymTableHash_fnv1a(const char *pcKey, size_t uLength,
+   uint64_t uSeed);
+
+/* SipHash-1-3, a keyed hash: without the seed, an attacker cannot
+choose keys that collide. Slower than SymTableHash_wyhash; a table that
+finds a suspiciously long chain switches to it. */
+
+uint64_t SymTableHash_siphash(const char *pcKey, size_t uLength,
+   uint64_t uSeed);
+
+/* A hash built on CRC32C. On CPUs with SSE4.2 it uses the crc32
+instruction, 8 bytes per instruction; elsewhere a table-driven version
+gives the same results. The choice is made on the first call. Fast on
+long keys, but CRC collisions do not depend on the seed, so reseeding
+cannot break up crafted keys; use it only for keys that are trusted. */
+
+uint64_t SymTableHash_crc32c(const char *pcKey, size_t uLength,
+   uint64_t uSeed);
+
+/* MurmurHash3 (x86_32): four bytes per step in 32-bit arithmetic, with
+a 32-bit result. Only the low half of uSeed is used. Its 32-bit
+operations map onto vector lanes, so SymTableHash_hashBatch hashes
+eight keys at a time with it on CPUs with AVX2. */
+
+uint64_t SymTableHash_murmur3(const char *pcKey, size_t uLength,
+   uint64_t uSeed);
+
+/* The original shift-by-5-and-add hash over unsigned int, kept so that
+tables can reproduce the bucket layout of earlier versions. It mixes
+poorly and ignores uSeed; avoid it for new tables. */
+
+uint64_t SymTableHash_legacy(const char *pcKey, size_t uLength,
+   uint64_t uSeed);
+
+/* Stores in auHashes[i] the hash (*pfHash)(apcKeys[i], auLengths[i],
+uSeed) for each i below uCount. When *pfHash is SymTableHash_murmur3
+and the CPU has AVX2, eight keys of any lengths are hashed at once in
+vector lanes. Every other function, SymTableHash_wyhash included,
+hashes one key at a time: its 64x64->128-bit multiplies have no AVX2
+counterpart, so a batch of them is no faster than a loop. */
+
+void SymTableHash_hashBatch(SymTableHashFn_T pfHash,
+   const char *const apcKeys[], const size_t auLengths[], size_t uCount,
+   uint64_t uSeed, uint64_t auHashes[]);
+
+/* Returns an unpredictable seed, different on every call. Every
+SymTable hash table gets its own seed this way. */
+
+uint64_t SymTableHash_randomSeed(void);
+
+#endif
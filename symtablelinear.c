@@ -0,0 +1,410 @@
+/*--------------------------------------------------------------------*/
+/* symtablelinear.c                                                   */
+/* Linear hashing: the table grows by splitting one bucket at a time  */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include "symtable.h"
+#include "symtablehashfn.h"
+
+/*
+ * SEGMENT_SIZE: Buckets are allocated in segments of this many, so
+ * that growing the table never moves a bucket. A power of two; a new
+ * table starts with one segment.
+ */
+#define SEGMENT_SIZE 256
+
+/*
+ * INITIAL_DIRECTORY_SIZE: Segment pointers in a new table's directory.
+ * The directory doubles when it fills, which copies only these
+ * pointers, never a bucket or a node.
+ */
+#define INITIAL_DIRECTORY_SIZE 8
+
+/*
+ * LOAD_FACTOR_THRESHOLD: A put that leaves more nodes than this many
+ * per bucket splits one bucket. A put splits at most one bucket, and
+ * each put adds at most one node, so the load factor settles at this
+ * value as the table grows.
+ */
+#define LOAD_FACTOR_THRESHOLD 1.0
+
+/*
+ * SymTableNode: One binding in a bucket's chain. The key is stored at
+ * the end of the node's own allocation.
+ */
+struct SymTableNode {
+    /* The value */
+    const void *pvValue;
+
+    /* The key's full hash; a split reads the next bit of it */
+    size_t hash;
+
+    /* Pointer to the next node in the chain */
+    struct SymTableNode *psNextNode;
+
+    /* The key's length, compared before any of its bytes */
+    size_t keyLength;
+
+    /* The key and its terminating '\0' */
+    char acKey[];
+};
+
+/*
+ * Segment: A fixed block of bucket heads.
+ */
+struct Segment {
+    struct SymTableNode *buckets[SEGMENT_SIZE];
+};
+
+/*
+ * SymTable: A linear hash table. During a round the table grows from
+ * `roundSize` to 2 * `roundSize` buckets: bucket `splitIndex` is the
+ * next to be split, buckets below it have already been split into
+ * themselves and `roundSize` + themselves, and buckets from it on are
+ * still addressed with one fewer hash bit.
+ */
+struct SymTable {
+    /* The directory of segments, `segmentCapacity` pointers long */
+    struct Segment **segments;
+    size_t segmentCapacity;
+
+    /* Buckets at the start of the current round, a power of two */
+    size_t roundSize;
+
+    /* The next bucket to split */
+    size_t splitIndex;
+
+    /* Total number of nodes in the table */
+    size_t nodeQuantity;
+
+    /* The seed passed to the hash function */
+    uint64_t hashSeed;
+};
+
+/*
+ * Gives the number of buckets in use.
+ */
+static size_t symtablelinear_getBucketCount(SymTable_T oSymTable) {
+    return oSymTable->roundSize + oSymTable->splitIndex;
+}
+
+/*
+ * Gives the address of the head of bucket `index`.
+ */
+static struct SymTableNode **symtablelinear_bucket(SymTable_T oSymTable, size_t index) {
+    return &oSymTable->segments[index / SEGMENT_SIZE]->buckets[index % SEGMENT_SIZE];
+}
+
+/*
+ * Gives the bucket a hash selects: its low bits modulo the round size,
+ * or modulo twice the round size for buckets already split this round.
+ */
+static size_t symtablelinear_bucketIndex(SymTable_T oSymTable, size_t hash) {
+    size_t index = hash & (oSymTable->roundSize - 1);
+
+    if (index < oSymTable->splitIndex) {
+        index = hash & (2 * oSymTable->roundSize - 1);
+    }
+    return index;
+}
+
+/*
+ * Hashes a key with the table's seed.
+ */
+static size_t symtablelinear_hash(SymTable_T oSymTable, const char *pcKey, size_t keyLength) {
+    return (size_t)SymTableHash_wyhash(pcKey, keyLength, oSymTable->hashSeed);
+}
+
+/*
+ * Finds the node that holds a key.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `pcKey`, `keyLength`, `hash`: the key, strlen(pcKey) and its hash
+ *   - `pppsLink`: if not NULL, receives the address of the pointer to
+ *     the node, or of the chain's last pointer if the key is absent
+ * Returns the node, or NULL if the table has no such key.
+ */
+static struct SymTableNode *symtablelinear_find(SymTable_T oSymTable, const char *pcKey, size_t keyLength,
+                                                size_t hash, struct SymTableNode ***pppsLink) {
+    struct SymTableNode **ppsLink = symtablelinear_bucket(oSymTable, symtablelinear_bucketIndex(oSymTable, hash));
+    struct SymTableNode *psCurrentNode;
+
+    for (psCurrentNode = *ppsLink; psCurrentNode != NULL; psCurrentNode = psCurrentNode->psNextNode) {
+        if (psCurrentNode->hash == hash && psCurrentNode->keyLength == keyLength &&
+            memcmp(psCurrentNode->acKey, pcKey, keyLength) == 0) {
+            break;
+        }
+        ppsLink = &psCurrentNode->psNextNode;
+    }
+    if (pppsLink != NULL) *pppsLink = ppsLink;
+    return psCurrentNode;
+}
+
+/*
+ * Splits bucket `splitIndex` into itself and bucket `roundSize` +
+ * `splitIndex`, by the next bit of each node's stored hash, then
+ * advances the split pointer. Only the nodes of that one bucket move.
+ * Allocates the new bucket's segment, and grows the directory, when
+ * the new bucket is the first of its segment.
+ * Returns 1 on success, or 0 if memory is insufficient, in which case
+ * the table is unchanged.
+ */
+static int symtablelinear_splitBucket(SymTable_T oSymTable) {
+    size_t newIndex = symtablelinear_getBucketCount(oSymTable);
+    struct SymTableNode *psCurrentNode, *psNextNode;
+    struct SymTableNode **ppsOld, **ppsNew;
+
+    if (newIndex % SEGMENT_SIZE == 0) {
+        size_t segment = newIndex / SEGMENT_SIZE;
+
+        if (segment == oSymTable->segmentCapacity) {
+            struct Segment **segments = (struct Segment**)realloc(
+                oSymTable->segments, 2 * oSymTable->segmentCapacity * sizeof(struct Segment*));
+            if (segments == NULL) return 0;
+            oSymTable->segments = segments;
+            oSymTable->segmentCapacity *= 2;
+        }
+        oSymTable->segments[segment] = (struct Segment*)calloc(1, sizeof(struct Segment));
+        if (oSymTable->segments[segment] == NULL) return 0;
+    }
+
+    ppsOld = symtablelinear_bucket(oSymTable, oSymTable->splitIndex);
+    ppsNew = symtablelinear_bucket(oSymTable, newIndex);
+    psCurrentNode = *ppsOld;
+    *ppsOld = NULL;
+    while (psCurrentNode != NULL) {
+        psNextNode = psCurrentNode->psNextNode;
+        if ((psCurrentNode->hash & oSymTable->roundSize) != 0) {
+            psCurrentNode->psNextNode = *ppsNew;
+            *ppsNew = psCurrentNode;
+        } else {
+            psCurrentNode->psNextNode = *ppsOld;
+            *ppsOld = psCurrentNode;
+        }
+        psCurrentNode = psNextNode;
+    }
+
+    /* The round ends once every bucket it started with is split */
+    if (++oSymTable->splitIndex == oSymTable->roundSize) {
+        oSymTable->roundSize *= 2;
+        oSymTable->splitIndex = 0;
+    }
+    return 1;
+}
+
+/* Sets up a new, empty symbol table with one segment of buckets.
+   Returns a pointer to the table or NULL if there's an allocation issue. */
+SymTable_T SymTable_new(void) {
+    SymTable_T oSymTable;
+
+    oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+    if (oSymTable == NULL) return NULL;
+
+    oSymTable->segments = (struct Segment**)calloc(INITIAL_DIRECTORY_SIZE, sizeof(struct Segment*));
+    if (oSymTable->segments == NULL) {
+        free(oSymTable);
+        return NULL;
+    }
+    oSymTable->segments[0] = (struct Segment*)calloc(1, sizeof(struct Segment));
+    if (oSymTable->segments[0] == NULL) {
+        free(oSymTable->segments);
+        free(oSymTable);
+        return NULL;
+    }
+    oSymTable->segmentCapacity = INITIAL_DIRECTORY_SIZE;
+    oSymTable->roundSize = SEGMENT_SIZE;
+    oSymTable->splitIndex = 0;
+    oSymTable->nodeQuantity = 0;
+    oSymTable->hashSeed = SymTableHash_randomSeed();
+    return oSymTable;
+}
+
+/* Returns the number of bindings in the table.
+   Arguments -> `oSymTable`: the symbol table */
+size_t SymTable_getLength(SymTable_T oSymTable) {
+    assert(oSymTable != NULL);
+    return oSymTable->nodeQuantity;
+}
+
+/* Releases every node, every segment, the directory and the table.
+   Arguments -> `oSymTable`: the symbol table to be freed */
+void SymTable_free(SymTable_T oSymTable) {
+    struct SymTableNode *psCurrentNode, *psNextNode;
+    size_t bucketCount;
+    size_t i;
+
+    assert(oSymTable != NULL);
+
+    bucketCount = symtablelinear_getBucketCount(oSymTable);
+    for (i = 0; i < bucketCount; i++) {
+        psCurrentNode = *symtablelinear_bucket(oSymTable, i);
+        while (psCurrentNode != NULL) {
+            psNextNode = psCurrentNode->psNextNode;
+            free(psCurrentNode);
+            psCurrentNode = psNextNode;
+        }
+    }
+    for (i = 0; i * SEGMENT_SIZE < bucketCount; i++) {
+        free(oSymTable->segments[i]);
+    }
+    free(oSymTable->segments);
+    free(oSymTable);
+}
+
+/*
+ * Adds a new key-value pair to the symbol table if the key doesn't already exist.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `pcKey`: string key to add
+ *   - `pvValue`: the value associated with `pcKey`
+ * A put that leaves the table above LOAD_FACTOR_THRESHOLD splits one
+ * bucket, so no put rehashes more than one chain.
+ * Returns 1 on success, 0 on failure or if the key exists.
+ */
+int SymTable_put(SymTable_T oSymTable, const char *pcKey, const void *pvValue) {
+    size_t keyLength;
+    size_t hash;
+    struct SymTableNode *psNewNode;
+    struct SymTableNode **ppsLink;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    keyLength = strlen(pcKey);
+    hash = symtablelinear_hash(oSymTable, pcKey, keyLength);
+    if (symtablelinear_find(oSymTable, pcKey, keyLength, hash, &ppsLink) != NULL) return 0;
+
+    psNewNode = (struct SymTableNode*)malloc(sizeof(struct SymTableNode) + keyLength + 1);
+    if (psNewNode == NULL) return 0;
+    memcpy(psNewNode->acKey, pcKey, keyLength + 1);
+    psNewNode->keyLength = keyLength;
+    psNewNode->pvValue = pvValue;
+    psNewNode->hash = hash;
+    psNewNode->psNextNode = NULL;
+    *ppsLink = psNewNode;
+    oSymTable->nodeQuantity++;
+
+    /* A failed split leaves a fuller but still correct table */
+    if ((double)oSymTable->nodeQuantity >
+        LOAD_FACTOR_THRESHOLD * (double)symtablelinear_getBucketCount(oSymTable)) {
+        (void)symtablelinear_splitBucket(oSymTable);
+    }
+    return 1;
+}
+
+/*
+ * Replaces the value of an existing key in the table.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `pcKey`: the key whose value we want to update
+ *   - `pvValue`: the new value to store
+ * Returns the old value, or NULL if the key doesn't exist.
+ */
+void *SymTable_replace(SymTable_T oSymTable, const char *pcKey, const void *pvValue) {
+    struct SymTableNode *psNode;
+    size_t keyLength;
+    void *oldValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    keyLength = strlen(pcKey);
+    psNode = symtablelinear_find(oSymTable, pcKey, keyLength,
+                                 symtablelinear_hash(oSymTable, pcKey, keyLength), NULL);
+    if (psNode == NULL) return NULL;
+
+    oldValue = (void*)psNode->pvValue;
+    psNode->pvValue = pvValue;
+    return oldValue;
+}
+
+/* Checks whether the table has a key.
+   Arguments -> `oSymTable`: the symbol table
+                `pcKey`: the key to look for
+   Returns 1 if the key is found, 0 otherwise. */
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey) {
+    size_t keyLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    keyLength = strlen(pcKey);
+    return symtablelinear_find(oSymTable, pcKey, keyLength,
+                                 symtablelinear_hash(oSymTable, pcKey, keyLength), NULL) != NULL;
+}
+
+/* Gets the value associated with a key.
+   Arguments -> `oSymTable`: the symbol table
+                `pcKey`: the key whose value we want to retrieve
+   Returns the value, or NULL if the key isn't found. */
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey) {
+    struct SymTableNode *psNode;
+    size_t keyLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    keyLength = strlen(pcKey);
+    psNode = symtablelinear_find(oSymTable, pcKey, keyLength,
+                                 symtablelinear_hash(oSymTable, pcKey, keyLength), NULL);
+    return psNode != NULL ? (void*)psNode->pvValue : NULL;
+}
+
+/*
+ * Removes a key and its value from the table.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `pcKey`: the key to be removed
+ * Buckets are never merged back; a table keeps the size it grew to.
+ * Returns the removed value, or NULL if the key isn't found.
+ */
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey) {
+    struct SymTableNode *psNode;
+    struct SymTableNode **ppsLink;
+    size_t keyLength;
+    void *oldValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    keyLength = strlen(pcKey);
+    psNode = symtablelinear_find(oSymTable, pcKey, keyLength,
+                                 symtablelinear_hash(oSymTable, pcKey, keyLength), &ppsLink);
+    if (psNode == NULL) return NULL;
+
+    oldValue = (void*)psNode->pvValue;
+    *ppsLink = psNode->psNextNode;
+    free(psNode);
+    oSymTable->nodeQuantity--;
+    return oldValue;
+}
+
+/*
+ * Applies the given function *pfApply to each key-value pair in the table.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `pfApply`: called as (*pfApply)(pcKey, pvValue, pvExtra)
+ *   - `pvExtra`: passed through to every call
+ */
+void SymTable_map(SymTable_T oSymTable,
+                  void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+                  const void *pvExtra) {
+    struct SymTableNode *psCurrentNode;
+    size_t bucketCount;
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    bucketCount = symtablelinear_getBucketCount(oSymTable);
+    for (i = 0; i < bucketCount; i++) {
+        for (psCurrentNode = *symtablelinear_bucket(oSymTable, i); psCurrentNode != NULL;
+             psCurrentNode = psCurrentNode->psNextNode) {
+            (*pfApply)(psCurrentNode->acKey, (void*)psCurrentNode->pvValue, (void*)pvExtra);
+        }
+    }
+}
@@ -4,46 +4,307 @@
 /*--------------------------------------------------------------------*/
 
 #include <assert.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include "symtable.h"
+#include "symtablelist.h"
 #include <string.h>
+
 /*
- * SymTableNode: Represents a single entry in the symbol table.
- * Each node has a key-value pair and a pointer to the next node.
- * These nodes are linked together to form a singly linked list.
+ * CHUNK_ENTRIES: How many bindings one chunk of the list holds. The
+ * hashes of a full chunk fill half a cache line, so a scan reads one
+ * line of hashes per eight bindings and follows a pointer only from
+ * chunk to chunk.
  */
-struct SymTableNode
+enum {CHUNK_ENTRIES = 8};
+
+/*
+ * SymTableChunk: Holds up to CHUNK_ENTRIES bindings, in list order.
+ * Each binding is a hash of its key, the key and the value, kept in
+ * three parallel arrays so that the hashes sit next to one another.
+ * The chunks are linked together to form an unrolled singly linked
+ * list; no chunk in the list is empty.
+ */
+struct SymTableChunk
 {
-   /* The key */
-   char *pcKey;
+   /* The address of the next SymTableChunk. */
+   struct SymTableChunk *psNextChunk;
 
-   /* The value. */
-   const void *pvValue;
+   /* Number of bindings in this chunk */
+   unsigned int entryCount;
+
+   /* The hash of each key, compared before the key itself */
+   uint32_t auHashes[CHUNK_ENTRIES];
+
+   /* The keys, each a defensive copy */
+   char *apcKeys[CHUNK_ENTRIES];
 
-   /* The address of the next SymTableNode. */
-   struct SymTableNode *psNextNode;
+   /* The values. */
+   const void *apvValues[CHUNK_ENTRIES];
 };
 
 /*
  * SymTable: Main structure for managing the symbol table.
- * Contains the head pointer to the list of SymTableNodes and a count of nodes.
+ * Contains the head pointer to the list of SymTableChunks and a count
+ * of bindings.
  * Acts as the entry point to access the linked list of key-value pairs.
  */
 struct SymTable
 {
-   /* The address of the first SymTableNode. */
-   struct SymTableNode *psFirstNode;
+   /* The address of the first SymTableChunk. */
+   struct SymTableChunk *psFirstChunk;
 
-   /* Number of nodes in linked list */
+   /* Number of bindings in the list */
    size_t nodeQuantity;
+
+   /* How lookups reorder the list */
+   enum SymTableListPolicy ePolicy;
+
+   /* Keys compared by lookups so far */
+   size_t comparisonCount;
 };
 
+/*
+ * Position: Where a binding sits in the list, as found by
+ * symtablelist_find.
+ */
+struct Position
+{
+   /* The chunk holding the binding, and the one before it, or NULL */
+   struct SymTableChunk *psChunk;
+   struct SymTableChunk *psPrevChunk;
+
+   /* The binding's index in its chunk */
+   unsigned int index;
+
+   /* How many bindings the search passed, the one found included */
+   size_t uPassed;
+};
+
+/*
+ * symtablelist_hash:
+ * Hashes a key with 32-bit FNV-1a.
+ * Arguments:
+ *   - `pcKey`: the key
+ * Returns: The hash.
+ */
+static uint32_t symtablelist_hash(const char *pcKey)
+{
+   uint32_t uHash = 2166136261u;
+
+   while (*pcKey != '\0')
+   {
+      uHash ^= (unsigned char)*pcKey++;
+      uHash *= 16777619u;
+   }
+   return uHash;
+}
+
+/*
+ * symtablelist_find:
+ * Finds the binding with a given key.
+ * Arguments:
+ *   - `oSymTable`: pointer to the symbol table
+ *   - `pcKey`: string key to look for
+ *   - `uHash`: the key's hash
+ *   - `psPosition`: where to store the binding's position
+ * Behavior: Walks the chunks in order, comparing the key only with
+ *           bindings whose hash matches, and counts the bindings passed
+ *           in `psPosition->uPassed` whether or not it finds the key.
+ * Returns: 1 if `pcKey` is found, with its position in `psPosition`,
+ *          or 0 if not.
+ */
+static int symtablelist_find(SymTable_T oSymTable, const char *pcKey,
+   uint32_t uHash, struct Position *psPosition)
+{
+   struct SymTableChunk *psChunk;
+   struct SymTableChunk *psPrevChunk = NULL;
+   unsigned int i;
+
+   psPosition->uPassed = 0;
+   for (psChunk = oSymTable->psFirstChunk;
+        psChunk != NULL;
+        psChunk = psChunk->psNextChunk)
+   {
+      for (i = 0; i < psChunk->entryCount; i++)
+      {
+         if (psChunk->auHashes[i] == uHash &&
+             strcmp(pcKey, psChunk->apcKeys[i]) == 0)
+         {
+            psPosition->uPassed += i + 1;
+            psPosition->psChunk = psChunk;
+            psPosition->psPrevChunk = psPrevChunk;
+            psPosition->index = i;
+            return 1;
+         }
+      }
+      psPosition->uPassed += psChunk->entryCount;
+      psPrevChunk = psChunk;
+   }
+   return 0;
+}
+
+/*
+ * symtablelist_insertFirst:
+ * Puts a binding at index 0 of a chunk that has room for it.
+ * Arguments:
+ *   - `psChunk`: the chunk
+ *   - `uHash`, `pcKey`, `pvValue`: the binding
+ * Returns: Nothing (void).
+ */
+static void symtablelist_insertFirst(struct SymTableChunk *psChunk,
+   uint32_t uHash, char *pcKey, const void *pvValue)
+{
+   unsigned int uCount = psChunk->entryCount;
+
+   assert(uCount < CHUNK_ENTRIES);
+
+   memmove(psChunk->auHashes + 1, psChunk->auHashes,
+      uCount * sizeof(uint32_t));
+   memmove(psChunk->apcKeys + 1, psChunk->apcKeys,
+      uCount * sizeof(char*));
+   memmove(psChunk->apvValues + 1, psChunk->apvValues,
+      uCount * sizeof(const void*));
+   psChunk->auHashes[0] = uHash;
+   psChunk->apcKeys[0] = pcKey;
+   psChunk->apvValues[0] = pvValue;
+   psChunk->entryCount++;
+}
+
+/*
+ * symtablelist_erase:
+ * Takes the binding at index `index` out of a chunk, closing the gap.
+ * Arguments:
+ *   - `psChunk`: the chunk
+ *   - `index`: the binding's index
+ * Returns: Nothing (void). The key is not freed.
+ */
+static void symtablelist_erase(struct SymTableChunk *psChunk,
+   unsigned int index)
+{
+   unsigned int uAfter = psChunk->entryCount - 1 - index;
+
+   memmove(psChunk->auHashes + index, psChunk->auHashes + index + 1,
+      uAfter * sizeof(uint32_t));
+   memmove(psChunk->apcKeys + index, psChunk->apcKeys + index + 1,
+      uAfter * sizeof(char*));
+   memmove(psChunk->apvValues + index, psChunk->apvValues + index + 1,
+      uAfter * sizeof(const void*));
+   psChunk->entryCount--;
+}
+
+/*
+ * symtablelist_unlinkIfEmpty:
+ * Frees a chunk that has no bindings left.
+ * Arguments:
+ *   - `oSymTable`: pointer to the symbol table
+ *   - `psChunk`: the chunk
+ *   - `psPrevChunk`: the chunk before it, or NULL if it is first
+ * Returns: Nothing (void).
+ */
+static void symtablelist_unlinkIfEmpty(SymTable_T oSymTable,
+   struct SymTableChunk *psChunk, struct SymTableChunk *psPrevChunk)
+{
+   if (psChunk->entryCount != 0)
+      return;
+   if (psPrevChunk == NULL)
+      oSymTable->psFirstChunk = psChunk->psNextChunk;
+   else
+      psPrevChunk->psNextChunk = psChunk->psNextChunk;
+   free(psChunk);
+}
+
+/*
+ * symtablelist_reorder:
+ * Reorders the list after a lookup found a binding, as the table's
+ * policy says.
+ * Arguments:
+ *   - `oSymTable`: pointer to the symbol table
+ *   - `psPosition`: where the binding is
+ * Behavior: Under SYMTABLE_TRANSPOSE the binding trades places with
+ *           the one before it, which may be the last of the previous
+ *           chunk. Under SYMTABLE_MOVE_TO_FRONT it is taken out and put
+ *           first; each full chunk in between passes its last binding
+ *           on to the next, down to the chunk that just lost one, so
+ *           that the order of the others is kept without allocating.
+ * Returns: Nothing (void).
+ */
+static void symtablelist_reorder(SymTable_T oSymTable,
+   const struct Position *psPosition)
+{
+   struct SymTableChunk *psChunk = psPosition->psChunk;
+   struct SymTableChunk *psSwap;
+   unsigned int index = psPosition->index;
+   unsigned int uSwap;
+   uint32_t uHash;
+   char *pcKey;
+   const void *pvValue;
+
+   if (psChunk == oSymTable->psFirstChunk && index == 0)
+      return;
+
+   if (oSymTable->ePolicy == SYMTABLE_TRANSPOSE)
+   {
+      if (index > 0)
+      {
+         psSwap = psChunk;
+         uSwap = index - 1;
+      }
+      else
+      {
+         psSwap = psPosition->psPrevChunk;
+         uSwap = psSwap->entryCount - 1;
+      }
+      uHash = psSwap->auHashes[uSwap];
+      pcKey = psSwap->apcKeys[uSwap];
+      pvValue = psSwap->apvValues[uSwap];
+      psSwap->auHashes[uSwap] = psChunk->auHashes[index];
+      psSwap->apcKeys[uSwap] = psChunk->apcKeys[index];
+      psSwap->apvValues[uSwap] = psChunk->apvValues[index];
+      psChunk->auHashes[index] = uHash;
+      psChunk->apcKeys[index] = pcKey;
+      psChunk->apvValues[index] = pvValue;
+   }
+   else if (oSymTable->ePolicy == SYMTABLE_MOVE_TO_FRONT)
+   {
+      uHash = psChunk->auHashes[index];
+      pcKey = psChunk->apcKeys[index];
+      pvValue = psChunk->apvValues[index];
+      symtablelist_erase(psChunk, index);
+
+      /* psChunk now has room, so the carried binding lands by then */
+      for (psSwap = oSymTable->psFirstChunk; ;
+           psSwap = psSwap->psNextChunk)
+      {
+         uint32_t uLastHash;
+         char *pcLastKey;
+         const void *pvLastValue;
+
+         if (psSwap->entryCount < CHUNK_ENTRIES)
+         {
+            symtablelist_insertFirst(psSwap, uHash, pcKey, pvValue);
+            break;
+         }
+         uLastHash = psSwap->auHashes[CHUNK_ENTRIES - 1];
+         pcLastKey = psSwap->apcKeys[CHUNK_ENTRIES - 1];
+         pvLastValue = psSwap->apvValues[CHUNK_ENTRIES - 1];
+         psSwap->entryCount--;
+         symtablelist_insertFirst(psSwap, uHash, pcKey, pvValue);
+         uHash = uLastHash;
+         pcKey = pcLastKey;
+         pvValue = pvLastValue;
+      }
+      symtablelist_unlinkIfEmpty(oSymTable, psChunk,
+         psPosition->psPrevChunk);
+   }
+}
+
 /*
  * SymTable_new:
  * Creates an empty symbol table.
  * Arguments: None
  * Behavior: Allocates memory for a new `SymTable` structure, initializes
- *           `psFirstNode` to NULL, and sets `nodeQuantity` to 0.
+ *           `psFirstChunk` to NULL, and sets `nodeQuantity` to 0.
  * Returns: A pointer to the new SymTable, or NULL if memory allocation fails.
  */
 SymTable_T SymTable_new(void)
@@ -54,11 +315,48 @@ SymTable_T SymTable_new(void)
    if (oSymTable == NULL)
       return NULL;
 
-   oSymTable->psFirstNode = NULL;
-   oSymTable-> nodeQuantity = 0;
+   oSymTable->psFirstChunk = NULL;
+   oSymTable->nodeQuantity = 0;
+   oSymTable->ePolicy = SYMTABLE_KEEP_ORDER;
+   oSymTable->comparisonCount = 0;
    return oSymTable;
 }
 
+/*
+ * SymTable_setAccessPolicy:
+ * Sets how lookups reorder the symbol table's list.
+ * Arguments:
+ *   - `oSymTable`: pointer to the symbol table
+ *   - `ePolicy`: the policy, as described in symtablelist.h
+ * Behavior: Records `ePolicy`; the order of the list is left as it is.
+ * Returns: Nothing (void).
+ */
+void SymTable_setAccessPolicy(SymTable_T oSymTable,
+   enum SymTableListPolicy ePolicy)
+{
+   assert(oSymTable != NULL);
+   assert(ePolicy == SYMTABLE_KEEP_ORDER ||
+      ePolicy == SYMTABLE_MOVE_TO_FRONT || ePolicy == SYMTABLE_TRANSPOSE);
+
+   oSymTable->ePolicy = ePolicy;
+}
+
+/*
+ * SymTable_getComparisonCount:
+ * Returns the number of key comparisons made by lookups so far.
+ * Arguments:
+ *   - `oSymTable`: pointer to the symbol table
+ * Behavior: Each binding a lookup passes counts once, whether its key
+ *           was told apart by its hash or by strcmp.
+ * Returns: The count, as a `size_t`.
+ */
+size_t SymTable_getComparisonCount(SymTable_T oSymTable)
+{
+   assert(oSymTable != NULL);
+
+   return oSymTable->comparisonCount;
+}
+
 /*
  * SymTable_getLength:
  * Returns the number of key-value pairs in the symbol table.
@@ -69,10 +367,9 @@ SymTable_T SymTable_new(void)
  */
 size_t SymTable_getLength(SymTable_T oSymTable)
 {
-   
    assert(oSymTable != NULL);
 
-return oSymTable-> nodeQuantity;
+   return oSymTable->nodeQuantity;
 }
 
 /*
@@ -80,27 +377,26 @@ return oSymTable-> nodeQuantity;
  * Frees all memory associated with the symbol table.
  * Arguments:
  *   - `oSymTable`: pointer to the symbol table to free
- * Behavior: Iterates through each node in the linked list, frees each key 
- *           and node, and finally frees the table itself.
+ * Behavior: Iterates through each chunk in the linked list, frees each key
+ *           and chunk, and finally frees the table itself.
  * Returns: Nothing (void).
  */
 void SymTable_free(SymTable_T oSymTable)
 {
-   struct SymTableNode *psCurrentNode;
-   struct SymTableNode *psNextNode;
+   struct SymTableChunk *psCurrentChunk;
+   struct SymTableChunk *psNextChunk;
+   unsigned int i;
 
    assert(oSymTable != NULL);
 
-   for (psCurrentNode = oSymTable->psFirstNode;
-        psCurrentNode != NULL;
-        psCurrentNode = psNextNode)
+   for (psCurrentChunk = oSymTable->psFirstChunk;
+        psCurrentChunk != NULL;
+        psCurrentChunk = psNextChunk)
    {
-      psNextNode = psCurrentNode->psNextNode;
-      
-   /* free the current node's key, const char stars are protected,
-   must cast as plain char star to free. */
-      free((char*)psCurrentNode->pcKey);
-      free(psCurrentNode);
+      psNextChunk = psCurrentChunk->psNextChunk;
+      for (i = 0; i < psCurrentChunk->entryCount; i++)
+         free(psCurrentChunk->apcKeys[i]);
+      free(psCurrentChunk);
    }
    free(oSymTable);
 }
@@ -112,54 +408,48 @@ void SymTable_free(SymTable_T oSymTable)
  *   - `oSymTable`: pointer to the symbol table
  *   - `pcKey`: string key for the new binding
  *   - `pvValue`: pointer to the value associated with the key
- * Behavior: Checks if `pcKey` already exists. If not, allocates a new node
- *           with `pcKey` and `pvValue` and adds it to the front of the list.
+ * Behavior: Checks if `pcKey` already exists. If not, copies `pcKey` and
+ *           adds the binding to the front of the list, in the first
+ *           chunk if it has room or else in a new chunk before it.
  * Returns: 1 if added successfully, 0 if the key already exists or if memory fails.
  */
-int SymTable_put(SymTable_T oSymTable, 
-const char *pcKey, const void *pvValue)
+int SymTable_put(SymTable_T oSymTable,
+   const char *pcKey, const void *pvValue)
 {
-   struct SymTableNode *psNewNode;
-   /* Travelling, placeholder node */
-   struct SymTableNode *psCurrentNode;
-   
+   struct SymTableChunk *psFirstChunk;
+   struct Position sPosition;
+   uint32_t uHash;
+   char *pcKeyCopy;
+
    assert(oSymTable != NULL);
    assert(pcKey != NULL);
 
-/* WALK for loop */
-   for (psCurrentNode = oSymTable->psFirstNode;
-        psCurrentNode != NULL;
-      /* pcCurrentNode walks to it's OWN next node */
-        psCurrentNode = psCurrentNode->psNextNode)
-   {
-      if (strcmp(pcKey, psCurrentNode->pcKey) == 0)
-      {
-         return 0;
-      }
-   }
-   
-   /* in the case that there are no duplicates, make space 
-   and put in a new node */
-   
-   psNewNode = (struct SymTableNode*)
-      malloc(sizeof(struct SymTableNode));
-   if (psNewNode == NULL)
+   uHash = symtablelist_hash(pcKey);
+   if (symtablelist_find(oSymTable, pcKey, uHash, &sPosition))
       return 0;
-   
+
    /* need to make space for defensive copy of the key */
-   psNewNode->pcKey = malloc(strlen(pcKey) + 1);
+   pcKeyCopy = (char*)malloc(strlen(pcKey) + 1);
+   if (pcKeyCopy == NULL)
+      return 0;
+   strcpy(pcKeyCopy, pcKey);
 
-   /* check for sufficient memory */
-   if (psNewNode->pcKey == NULL)
+   psFirstChunk = oSymTable->psFirstChunk;
+   if (psFirstChunk == NULL || psFirstChunk->entryCount == CHUNK_ENTRIES)
    {
-      free(psNewNode);
-      return 0;
+      psFirstChunk = (struct SymTableChunk*)
+         malloc(sizeof(struct SymTableChunk));
+      if (psFirstChunk == NULL)
+      {
+         free(pcKeyCopy);
+         return 0;
+      }
+      psFirstChunk->entryCount = 0;
+      psFirstChunk->psNextChunk = oSymTable->psFirstChunk;
+      oSymTable->psFirstChunk = psFirstChunk;
    }
-   strcpy(psNewNode->pcKey, pcKey);
+   symtablelist_insertFirst(psFirstChunk, uHash, pcKeyCopy, pvValue);
    oSymTable->nodeQuantity++;
-   psNewNode->pvValue = pvValue;
-   psNewNode->psNextNode = oSymTable->psFirstNode;
-   oSymTable->psFirstNode = psNewNode;
    return 1;
 }
 
@@ -175,29 +465,21 @@ const char *pcKey, const void *pvValue)
  * Returns: The old value if replaced, or NULL if `pcKey` is not found.
  */
 void *SymTable_replace(SymTable_T oSymTable,
-     const char *pcKey, const void *pvValue)
+   const char *pcKey, const void *pvValue)
 {
-   struct SymTableNode* psCurrentNode;
+   struct Position sPosition;
    void *oldValue;
 
-   
    assert(oSymTable != NULL);
    assert(pcKey != NULL);
 
-/* WALK for loop */
-   for (psCurrentNode = oSymTable->psFirstNode;
-        psCurrentNode != NULL;
-      /* pcCurrentNode walks to it's OWN next node */
-        psCurrentNode = psCurrentNode->psNextNode)
-   {
-      if (strcmp(pcKey, psCurrentNode->pcKey) == 0)
-      {
-         oldValue = (void*)psCurrentNode->pvValue;
-         psCurrentNode->pvValue = pvValue;
-         return oldValue;
-      }
-   }
-return NULL;
+   if (! symtablelist_find(oSymTable, pcKey, symtablelist_hash(pcKey),
+      &sPosition))
+      return NULL;
+
+   oldValue = (void*)sPosition.psChunk->apvValues[sPosition.index];
+   sPosition.psChunk->apvValues[sPosition.index] = pvValue;
+   return oldValue;
 }
 
 /*
@@ -206,28 +488,25 @@ return NULL;
  * Arguments:
  *   - `oSymTable`: pointer to the symbol table
  *   - `pcKey`: string key to look for
- * Behavior: Searches the list for `pcKey`.
+ * Behavior: Searches the list for `pcKey`, reordering it as the table's
+ *           access policy says.
  * Returns: 1 if `pcKey` exists in the table, 0 otherwise.
  */
 int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
 {
-   struct SymTableNode* psCurrentNode;
-   
+   struct Position sPosition;
+   int iFound;
+
    assert(oSymTable != NULL);
    assert(pcKey != NULL);
 
-/* WALK for loop */
-   for (psCurrentNode = oSymTable->psFirstNode;
-        psCurrentNode != NULL;
-      /* pcCurrentNode walks to it's OWN next node */
-        psCurrentNode = psCurrentNode->psNextNode)
-   {
-      if (strcmp(pcKey, psCurrentNode->pcKey) == 0)
-      {
-         return 1;
-      }
-   }
-return 0;
+   iFound = symtablelist_find(oSymTable, pcKey, symtablelist_hash(pcKey),
+      &sPosition);
+   oSymTable->comparisonCount += sPosition.uPassed;
+   if (! iFound)
+      return 0;
+   symtablelist_reorder(oSymTable, &sPosition);
+   return 1;
 }
 
 /*
@@ -236,28 +515,27 @@ return 0;
  * Arguments:
  *   - `oSymTable`: pointer to the symbol table
  *   - `pcKey`: string key to retrieve
- * Behavior: Searches the list for `pcKey`. If found, returns the value associated with it.
+ * Behavior: Searches the list for `pcKey`, reordering it as the table's
+ *           access policy says. If found, returns the value associated with it.
  * Returns: The value if `pcKey` is found, or NULL if `pcKey` does not exist.
  */
-  void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
 {
-   struct SymTableNode* psCurrentNode;
-   
+   struct Position sPosition;
+   void *pvValue;
+   int iFound;
+
    assert(oSymTable != NULL);
    assert(pcKey != NULL);
 
-/* WALK for loop */
-   for (psCurrentNode = oSymTable->psFirstNode;
-        psCurrentNode != NULL;
-      /* pcCurrentNode walks to it's OWN next node */
-        psCurrentNode = psCurrentNode->psNextNode)
-   {
-      if (strcmp(pcKey, psCurrentNode->pcKey) == 0)
-      {
-        return (void*)psCurrentNode->pvValue;
-      }
-   }
-return NULL;
+   iFound = symtablelist_find(oSymTable, pcKey, symtablelist_hash(pcKey),
+      &sPosition);
+   oSymTable->comparisonCount += sPosition.uPassed;
+   if (! iFound)
+      return NULL;
+   pvValue = (void*)sPosition.psChunk->apvValues[sPosition.index];
+   symtablelist_reorder(oSymTable, &sPosition);
+   return pvValue;
 }
 
 /*
@@ -266,52 +544,51 @@ return NULL;
  * Arguments:
  *   - `oSymTable`: pointer to the symbol table
  *   - `pcKey`: string key to remove
- * Behavior: Searches for `pcKey`, removes the node if found, adjusts the links,
- *           and decrements `nodeQuantity`.
+ * Behavior: Searches for `pcKey` and takes its binding out of its chunk.
+ *           A chunk left empty is freed; one left with few enough
+ *           bindings to take in the next chunk's does so, so that the
+ *           chunks stay well filled.
  * Returns: The removed value if `pcKey` is found, or NULL if `pcKey` does not exist.
  */
 void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
 {
-   struct SymTableNode* psCurrentNode;
+   struct SymTableChunk *psChunk;
+   struct SymTableChunk *psNextChunk;
+   struct Position sPosition;
    void *oldValue;
-   struct SymTableNode* psPrevNode = NULL;
-   
+   unsigned int uCount;
+
    assert(oSymTable != NULL);
    assert(pcKey != NULL);
 
-/* WALK for loop */
-   for (psCurrentNode = oSymTable->psFirstNode;
-        psCurrentNode != NULL;
-      /* pcCurrentNode walks to it's OWN next node */
-        psCurrentNode = psCurrentNode->psNextNode)
+   if (! symtablelist_find(oSymTable, pcKey, symtablelist_hash(pcKey),
+      &sPosition))
+      return NULL;
+
+   psChunk = sPosition.psChunk;
+   oldValue = (void*)psChunk->apvValues[sPosition.index];
+   free(psChunk->apcKeys[sPosition.index]);
+   symtablelist_erase(psChunk, sPosition.index);
+   oSymTable->nodeQuantity--;
+
+   psNextChunk = psChunk->psNextChunk;
+   uCount = psChunk->entryCount;
+   if (psNextChunk != NULL &&
+       uCount + psNextChunk->entryCount <= CHUNK_ENTRIES)
    {
-      if (strcmp(pcKey, psCurrentNode->pcKey) == 0)
-      {
-      /* save the value */
-         oldValue = (void*)psCurrentNode->pvValue;
-      /* if else statement to change the links to remove the node */
-         if (psPrevNode == NULL)
-         {
-      /* sym tables first node skip current and go to current's next */
-            oSymTable->psFirstNode = psCurrentNode->psNextNode;
-         }
-         else 
-         {
-      /* previous node's next has to point to current node's next */
-            psPrevNode->psNextNode = psCurrentNode->psNextNode;
-         }
-         /* free the key and free the node */
-         free ((void*)psCurrentNode->pcKey);
-         free (psCurrentNode);
-         /* decrement count */
-         oSymTable->nodeQuantity--;
-         /* return value */
-         return oldValue;
-      }
-     /* move previous to become the current one */
-      psPrevNode = psCurrentNode;
+      /* the next chunk's bindings follow this chunk's */
+      memcpy(psChunk->auHashes + uCount, psNextChunk->auHashes,
+         psNextChunk->entryCount * sizeof(uint32_t));
+      memcpy(psChunk->apcKeys + uCount, psNextChunk->apcKeys,
+         psNextChunk->entryCount * sizeof(char*));
+      memcpy(psChunk->apvValues + uCount, psNextChunk->apvValues,
+         psNextChunk->entryCount * sizeof(const void*));
+      psChunk->entryCount += psNextChunk->entryCount;
+      psChunk->psNextChunk = psNextChunk->psNextChunk;
+      free(psNextChunk);
    }
-return NULL;
+   symtablelist_unlinkIfEmpty(oSymTable, psChunk, sPosition.psPrevChunk);
+   return oldValue;
 }
 
 /*
@@ -321,24 +598,26 @@ return NULL;
  *   - `oSymTable`: pointer to the symbol table
  *   - `pfApply`: function to call on each key-value pair
  *   - `pvExtra`: additional data to pass to `pfApply`
- * Behavior: Iterates through each node in the table and calls `pfApply` 
- *           with the key, value, and `pvExtra`.
+ * Behavior: Iterates through each binding of each chunk in order and
+ *           calls `pfApply` with the key, value, and `pvExtra`.
  * Returns: Nothing (void).
  */
- void SymTable_map(SymTable_T oSymTable,
-     void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
-     const void *pvExtra)
+void SymTable_map(SymTable_T oSymTable,
+   void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+   const void *pvExtra)
 {
-   struct SymTableNode *psCurrentNode;
-   
+   struct SymTableChunk *psCurrentChunk;
+   unsigned int i;
+
    assert(oSymTable != NULL);
    assert(pfApply != NULL);
 
-   for (psCurrentNode = oSymTable->psFirstNode;
-        psCurrentNode != NULL;
-        psCurrentNode = psCurrentNode->psNextNode)
-      /* pfApply has three arguments, key, value, extra */ 
-      (*pfApply)(psCurrentNode->pcKey, 
-         (void*)psCurrentNode->pvValue, 
-         (void*)pvExtra);
+   for (psCurrentChunk = oSymTable->psFirstChunk;
+        psCurrentChunk != NULL;
+        psCurrentChunk = psCurrentChunk->psNextChunk)
+      for (i = 0; i < psCurrentChunk->entryCount; i++)
+         /* pfApply has three arguments, key, value, extra */
+         (*pfApply)(psCurrentChunk->apcKeys[i],
+            (void*)psCurrentChunk->apvValues[i],
+            (void*)pvExtra);
 }
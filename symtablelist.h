@@ -0,0 +1,47 @@
+/*--------------------------------------------------------------------*/
+/* symtablelist.h                                                     */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#ifndef SymTableList_INCLUDED
+#define SymTableList_INCLUDED
+#include <stddef.h>
+#include "symtable.h"
+
+/* Extensions to the SymTable ADT that only the linked list
+implementation (symtablelist.c) provides. A lookup in that
+implementation compares the key with each binding from the front of
+the list until it finds it, so it costs the most for the keys furthest
+back. When a few keys account for most lookups, the list can reorder
+itself so that those keys drift to the front. */
+
+/* How a table reorders its list when SymTable_get or
+SymTable_contains finds a key. SYMTABLE_KEEP_ORDER leaves the list as
+it is, the newest binding first. SYMTABLE_MOVE_TO_FRONT moves the
+binding found to the front, which adapts at once to a change in which
+keys are hot. SYMTABLE_TRANSPOSE swaps it with the binding before it,
+which adapts slowly but is not thrown off by a single lookup of a cold
+key. */
+
+enum SymTableListPolicy
+{
+   SYMTABLE_KEEP_ORDER,
+   SYMTABLE_MOVE_TO_FRONT,
+   SYMTABLE_TRANSPOSE
+};
+
+/* Sets the policy by which oSymTable reorders its list on lookups,
+which is SYMTABLE_KEEP_ORDER for a new table. Under any other policy a
+lookup changes the order in which SymTable_map visits the bindings, so
+*pfApply must not look keys up in the table it is applied to. */
+
+void SymTable_setAccessPolicy(SymTable_T oSymTable,
+   enum SymTableListPolicy ePolicy);
+
+/* Returns the number of keys that SymTable_get and SymTable_contains
+have compared with the keys of oSymTable's bindings since the table
+was created, a measure of how well its order suits its lookups. */
+
+size_t SymTable_getComparisonCount(SymTable_T oSymTable);
+
+#endif
@@ -0,0 +1,725 @@
+/*--------------------------------------------------------------------*/
+/* symtablemph.c                                                      */
+/* Minimal perfect hashing for frozen symbol tables                   */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "symtablemph.h"
+#include "symtablehashfn.h"
+
+/*
+ * The index follows PTHash: keys are split into partitions by hash,
+ * and each partition is built on its own, which is what lets several
+ * threads share the construction. Within a partition the keys fall
+ * into small buckets, and each bucket gets the first "pilot" value
+ * that sends all of its keys to free slots of a table slightly larger
+ * than the partition. The few keys that land past the partition's last
+ * slot are remapped to the slots left free below it.
+ */
+
+/*
+ * PARTITION_KEYS: The average number of keys in one partition. Large
+ * enough that the per-partition bookkeeping is negligible, small
+ * enough that a partition's build fits in cache.
+ */
+#define PARTITION_KEYS 4096
+
+/*
+ * BUCKET_KEYS: The average number of keys in one bucket. Each bucket
+ * costs one 16-bit pilot, so this sets most of the index's bits per
+ * key; larger buckets are cheaper to store but slower to place.
+ */
+#define BUCKET_KEYS 4.0
+
+/*
+ * LOAD_FACTOR: Keys per table slot within a partition. Just below 1,
+ * the last buckets still find free slots quickly, and the slack costs
+ * few remap entries.
+ */
+#define LOAD_FACTOR 0.99
+
+/*
+ * DENSE_KEY_THRESHOLD, DENSE_BUCKET_SHARE: 60% of the keys (those whose
+ * low hash bits fall below 0.6 * 2^32) go to 30% of the buckets. The
+ * resulting large buckets are placed first, while the table is empty.
+ */
+#define DENSE_KEY_THRESHOLD 2576980377u
+#define DENSE_BUCKET_SHARE 0.3
+
+/*
+ * MAX_PILOT: The largest pilot tried for one bucket. A bucket that no
+ * pilot places means the build starts over with a new seed.
+ */
+#define MAX_PILOT 65535
+
+/*
+ * MAX_SEEDS: How many seeds a build tries with each hash function.
+ * Only keys whose 64-bit hashes collide make a build fail, and a second
+ * seed separates them unless the hash function ignores the seed for
+ * them; after MAX_SEEDS failures the build switches to SipHash, whose
+ * collisions no one can find without the seed.
+ */
+#define MAX_SEEDS 4
+
+/*
+ * HASH_CHUNK: Keys that a construction thread hashes per task.
+ */
+#define HASH_CHUNK 4096
+
+/*
+ * MAX_BUILD_THREADS: The most threads that may share one build.
+ */
+#define MAX_BUILD_THREADS 64
+
+/*
+ * GOLDEN: An odd 64-bit constant for multiplicative mixing.
+ */
+#define GOLDEN 0x9e3779b97f4a7c15ULL
+
+/*
+ * MPHEntry: One binding, at the slot its key hashes to.
+ */
+struct MPHEntry {
+    /* The value */
+    const void *pvValue;
+
+    /* The key, in the table's key buffer, and its length */
+    const char *pcKey;
+    size_t keyLength;
+};
+
+/*
+ * Partition: The keys whose hashes scale to one partition index, with
+ * their own buckets, table slots and remap entries.
+ */
+struct Partition {
+    /* Index in `entries` of the partition's slot 0 */
+    size_t firstEntry;
+
+    /* Index in `pilots` of the partition's bucket 0 */
+    size_t firstBucket;
+
+    /* Index in `remap` of the partition's slot `keyCount` */
+    size_t firstRemap;
+
+    /* Offset in `keyBytes` of the partition's keys */
+    size_t firstKeyByte;
+
+    /* Keys, table slots, buckets, and buckets for the dense 60% */
+    uint32_t keyCount;
+    uint32_t tableSize;
+    uint32_t bucketCount;
+    uint32_t denseBucketCount;
+};
+
+/*
+ * SymTableMPH: The index and the packed bindings.
+ */
+struct SymTableMPH {
+    /* Number of bindings */
+    size_t keyCount;
+
+    /* The hash function and the seed the keys are hashed with */
+    SymTableHashFn_T pfHash;
+    uint64_t hashSeed;
+
+    /* The partitions */
+    struct Partition *partitions;
+    size_t partitionCount;
+
+    /* One pilot per bucket, `bucketTotal` of them */
+    uint16_t *pilots;
+    size_t bucketTotal;
+
+    /* For each slot past a partition's last key, the free slot below
+       it that stands in for it; `remapTotal` of them */
+    uint32_t *remap;
+    size_t remapTotal;
+
+    /* The bindings in slot order, and the keys they point into */
+    struct MPHEntry *entries;
+    char *keyBytes;
+};
+
+/*
+ * BuildWork: What the construction threads share. Tasks are claimed
+ * one at a time from `nextTask`, so a thread that could not be started
+ * leaves its share to the others.
+ */
+struct BuildWork {
+    /* The index under construction */
+    SymTableMPH_T oSymTableMPH;
+
+    /* The caller's bindings */
+    const char *const *apcKeys;
+    const void *const *apvValues;
+
+    /* Per binding: key length and hash */
+    size_t *auLengths;
+    uint64_t *auHashes;
+
+    /* Binding indices grouped by partition, in partition order */
+    size_t *auOrder;
+
+    /* 1 while hashing, 0 while building partitions */
+    int isHashPhase;
+
+    /* Tasks of the current phase, and the next one to claim */
+    size_t taskCount;
+    size_t nextTask;
+
+    /* BUILD_OK, or why the build failed */
+    int result;
+};
+
+/*
+ * Build results, worst last: a later one overrides an earlier one.
+ */
+enum {BUILD_OK, BUILD_RETRY, BUILD_NO_MEMORY};
+
+/*
+ * Scrambles all 64 bits of `x` (the MurmurHash3 finalizer).
+ */
+static uint64_t symtablemph_mix(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+/*
+ * Maps `x`, spread over 32 bits, onto [0, `n`) without a division.
+ */
+static size_t symtablemph_scale(uint32_t x, uint32_t n) {
+    return (size_t)(((uint64_t)x * n) >> 32);
+}
+
+/*
+ * Gives the partition of a hash, from its high 32 bits.
+ */
+static struct Partition *symtablemph_partition(SymTableMPH_T oSymTableMPH, uint64_t hash) {
+    return &oSymTableMPH->partitions[(size_t)(((hash >> 32) * oSymTableMPH->partitionCount) >> 32)];
+}
+
+/*
+ * Gives the bucket of a hash within its partition. The low 32 bits
+ * decide between the dense and the sparse buckets; a multiply of the
+ * whole hash picks one of them.
+ */
+static size_t symtablemph_bucket(const struct Partition *psPartition, uint64_t hash) {
+    uint32_t spread = (uint32_t)((hash * GOLDEN) >> 32);
+
+    if ((uint32_t)hash < DENSE_KEY_THRESHOLD) {
+        return symtablemph_scale(spread, psPartition->denseBucketCount);
+    }
+    return psPartition->denseBucketCount +
+           symtablemph_scale(spread, psPartition->bucketCount - psPartition->denseBucketCount);
+}
+
+/*
+ * Gives the table slot that a pilot sends a hash to.
+ */
+static size_t symtablemph_position(uint64_t hash, unsigned int pilot, uint32_t tableSize) {
+    return symtablemph_scale((uint32_t)(symtablemph_mix(hash ^ ((uint64_t)pilot * GOLDEN)) >> 32),
+                             tableSize);
+}
+
+/*
+ * Records a failed build, keeping the worst result seen.
+ */
+static void symtablemph_fail(struct BuildWork *psWork, int result) {
+    int current = __atomic_load_n(&psWork->result, __ATOMIC_RELAXED);
+
+    while (current < result &&
+           !__atomic_compare_exchange_n(&psWork->result, &current, result, 1,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+/*
+ * Hashing task `task`: stores the length and hash of each binding in
+ * one chunk.
+ */
+static void symtablemph_hashChunk(struct BuildWork *psWork, size_t task) {
+    size_t first = task * HASH_CHUNK;
+    size_t end = first + HASH_CHUNK;
+    size_t i;
+
+    if (end > psWork->oSymTableMPH->keyCount) end = psWork->oSymTableMPH->keyCount;
+    for (i = first; i < end; i++) {
+        psWork->auLengths[i] = strlen(psWork->apcKeys[i]);
+        psWork->auHashes[i] = (*psWork->oSymTableMPH->pfHash)(psWork->apcKeys[i], psWork->auLengths[i],
+                                                              psWork->oSymTableMPH->hashSeed);
+    }
+}
+
+/*
+ * PartitionScratch: The working arrays of one partition's build.
+ */
+struct PartitionScratch {
+    /* For each bucket, where its keys start in `sorted`; one more
+       entry marks the end of the last bucket */
+    size_t *bucketStarts;
+
+    /* The partition's binding indices, grouped by bucket */
+    size_t *sorted;
+
+    /* The buckets, largest first */
+    uint32_t *bucketOrder;
+
+    /* The slot of each key in `sorted` */
+    uint32_t *positions;
+
+    /* 1 for each table slot already taken */
+    unsigned char *taken;
+};
+
+/*
+ * Groups a partition's keys by bucket into `sorted`, and orders the
+ * buckets largest first into `bucketOrder`.
+ * Returns 1 on success, 0 if memory is insufficient.
+ */
+static int symtablemph_sortBuckets(const struct BuildWork *psWork, const struct Partition *psPartition,
+                                   struct PartitionScratch *psScratch) {
+    const size_t *auKeys = psWork->auOrder + psPartition->firstEntry;
+    size_t *bucketStarts = psScratch->bucketStarts;
+    uint32_t *bucketOrder = psScratch->bucketOrder;
+    size_t *sizeStarts;
+    size_t maxSize = 0;
+    size_t b, i;
+
+    /* Bucket sizes, then a counting sort with `bucketOrder` as the
+       cursors */
+    for (i = 0; i < psPartition->keyCount; i++) {
+        bucketStarts[symtablemph_bucket(psPartition, psWork->auHashes[auKeys[i]]) + 1]++;
+    }
+    for (b = 0; b < psPartition->bucketCount; b++) {
+        if (bucketStarts[b + 1] > maxSize) maxSize = bucketStarts[b + 1];
+        bucketStarts[b + 1] += bucketStarts[b];
+        bucketOrder[b] = (uint32_t)bucketStarts[b];
+    }
+    for (i = 0; i < psPartition->keyCount; i++) {
+        psScratch->sorted[bucketOrder[symtablemph_bucket(psPartition, psWork->auHashes[auKeys[i]])]++] =
+            auKeys[i];
+    }
+
+    /* A counting sort of the buckets by size, largest first */
+    sizeStarts = (size_t*)calloc(maxSize + 2, sizeof(size_t));
+    if (sizeStarts == NULL) return 0;
+    for (b = 0; b < psPartition->bucketCount; b++) {
+        sizeStarts[maxSize - (bucketStarts[b + 1] - bucketStarts[b]) + 1]++;
+    }
+    for (i = 0; i <= maxSize; i++) {
+        sizeStarts[i + 1] += sizeStarts[i];
+    }
+    for (b = 0; b < psPartition->bucketCount; b++) {
+        bucketOrder[sizeStarts[maxSize - (bucketStarts[b + 1] - bucketStarts[b])]++] = (uint32_t)b;
+    }
+    free(sizeStarts);
+    return 1;
+}
+
+/*
+ * Gives each bucket of a partition, largest first, the first pilot
+ * that sends all of its keys to distinct free slots, and records each
+ * key's slot in `positions`.
+ * Returns 1 on success, or 0 if some bucket fits under no pilot.
+ */
+static int symtablemph_placeBuckets(const struct BuildWork *psWork, const struct Partition *psPartition,
+                                    struct PartitionScratch *psScratch) {
+    unsigned char *taken = psScratch->taken;
+    uint32_t *positions = psScratch->positions;
+    size_t i, j, slot;
+
+    for (i = 0; i < psPartition->bucketCount; i++) {
+        size_t b = psScratch->bucketOrder[i];
+        size_t start = psScratch->bucketStarts[b];
+        size_t size = psScratch->bucketStarts[b + 1] - start;
+        unsigned int pilot;
+
+        for (pilot = 0; pilot <= MAX_PILOT; pilot++) {
+            for (j = 0; j < size; j++) {
+                slot = symtablemph_position(psWork->auHashes[psScratch->sorted[start + j]], pilot,
+                                            psPartition->tableSize);
+                if (taken[slot]) break;
+                taken[slot] = 1;
+                positions[start + j] = (uint32_t)slot;
+            }
+            if (j == size) break;
+
+            /* Undo the keys already placed under this pilot */
+            while (j > 0) {
+                taken[positions[start + --j]] = 0;
+            }
+        }
+        if (pilot > MAX_PILOT) return 0;
+        psWork->oSymTableMPH->pilots[psPartition->firstBucket + b] = (uint16_t)pilot;
+    }
+    return 1;
+}
+
+/*
+ * Sends each taken slot past a partition's last key to a free slot
+ * below it, then stores the bindings at their slots and copies their
+ * keys, in slot order, into the partition's part of the key buffer.
+ */
+static void symtablemph_storeBindings(const struct BuildWork *psWork, const struct Partition *psPartition,
+                                      const struct PartitionScratch *psScratch) {
+    SymTableMPH_T oSymTableMPH = psWork->oSymTableMPH;
+    struct MPHEntry *entries = oSymTableMPH->entries + psPartition->firstEntry;
+    uint32_t *remap = oSymTableMPH->remap + psPartition->firstRemap;
+    size_t keyCount = psPartition->keyCount;
+    size_t freeSlot = 0;
+    size_t keyByte;
+    size_t i, slot;
+
+    /* A slot no key took can still be reached by an absent key, so it
+       leads to slot 0, where the key comparison rejects it */
+    for (slot = keyCount; slot < psPartition->tableSize; slot++) {
+        if (!psScratch->taken[slot]) {
+            remap[slot - keyCount] = 0;
+            continue;
+        }
+        while (psScratch->taken[freeSlot]) freeSlot++;
+        remap[slot - keyCount] = (uint32_t)freeSlot++;
+    }
+
+    for (i = 0; i < keyCount; i++) {
+        size_t key = psScratch->sorted[i];
+
+        slot = psScratch->positions[i];
+        if (slot >= keyCount) slot = remap[slot - keyCount];
+        entries[slot].pvValue = psWork->apvValues[key];
+        entries[slot].pcKey = psWork->apcKeys[key];
+        entries[slot].keyLength = psWork->auLengths[key];
+    }
+
+    keyByte = psPartition->firstKeyByte;
+    for (slot = 0; slot < keyCount; slot++) {
+        char *pcCopy = oSymTableMPH->keyBytes + keyByte;
+
+        memcpy(pcCopy, entries[slot].pcKey, entries[slot].keyLength + 1);
+        entries[slot].pcKey = pcCopy;
+        keyByte += entries[slot].keyLength + 1;
+    }
+}
+
+/*
+ * Building task `task`: builds the index of one partition and stores
+ * its bindings.
+ * Returns BUILD_OK, BUILD_RETRY if some bucket could not be placed,
+ * or BUILD_NO_MEMORY.
+ */
+static int symtablemph_buildPartition(struct BuildWork *psWork, size_t task) {
+    const struct Partition *psPartition = &psWork->oSymTableMPH->partitions[task];
+    struct PartitionScratch sScratch;
+    int result;
+
+    if (psPartition->keyCount == 0) return BUILD_OK;
+
+    sScratch.bucketStarts = (size_t*)calloc(psPartition->bucketCount + 1, sizeof(size_t));
+    sScratch.sorted = (size_t*)malloc(psPartition->keyCount * sizeof(size_t));
+    sScratch.bucketOrder = (uint32_t*)malloc(psPartition->bucketCount * sizeof(uint32_t));
+    sScratch.positions = (uint32_t*)malloc(psPartition->keyCount * sizeof(uint32_t));
+    sScratch.taken = (unsigned char*)calloc(psPartition->tableSize, 1);
+
+    if (sScratch.bucketStarts == NULL || sScratch.sorted == NULL || sScratch.bucketOrder == NULL ||
+        sScratch.positions == NULL || sScratch.taken == NULL ||
+        !symtablemph_sortBuckets(psWork, psPartition, &sScratch)) {
+        result = BUILD_NO_MEMORY;
+    } else if (!symtablemph_placeBuckets(psWork, psPartition, &sScratch)) {
+        result = BUILD_RETRY;
+    } else {
+        symtablemph_storeBindings(psWork, psPartition, &sScratch);
+        result = BUILD_OK;
+    }
+
+    free(sScratch.bucketStarts);
+    free(sScratch.sorted);
+    free(sScratch.bucketOrder);
+    free(sScratch.positions);
+    free(sScratch.taken);
+    return result;
+}
+
+/*
+ * Thread entry point: claims and runs tasks of the current phase until
+ * none are left, or until a partition has failed.
+ */
+static void *symtablemph_worker(void *pvArg) {
+    struct BuildWork *psWork = (struct BuildWork*)pvArg;
+    size_t task;
+    int result;
+
+    for (;;) {
+        task = __atomic_fetch_add(&psWork->nextTask, 1, __ATOMIC_RELAXED);
+        if (task >= psWork->taskCount) break;
+
+        if (psWork->isHashPhase) {
+            symtablemph_hashChunk(psWork, task);
+        } else {
+            if (__atomic_load_n(&psWork->result, __ATOMIC_RELAXED) != BUILD_OK) break;
+            result = symtablemph_buildPartition(psWork, task);
+            if (result != BUILD_OK) symtablemph_fail(psWork, result);
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Runs `taskCount` tasks of one phase on up to `threadCount` threads,
+ * the calling thread included, and waits for all of them.
+ */
+static void symtablemph_runPhase(struct BuildWork *psWork, int isHashPhase, size_t taskCount,
+                                 size_t threadCount) {
+    pthread_t aThreads[MAX_BUILD_THREADS];
+    int aiStarted[MAX_BUILD_THREADS];
+    size_t t;
+
+    psWork->isHashPhase = isHashPhase;
+    psWork->taskCount = taskCount;
+    psWork->nextTask = 0;
+    if (threadCount > taskCount) threadCount = taskCount;
+    if (threadCount > MAX_BUILD_THREADS) threadCount = MAX_BUILD_THREADS;
+
+    for (t = 1; t < threadCount; t++) {
+        aiStarted[t] = pthread_create(&aThreads[t], NULL, symtablemph_worker, psWork) == 0;
+    }
+    symtablemph_worker(psWork);
+    for (t = 1; t < threadCount; t++) {
+        if (aiStarted[t]) pthread_join(aThreads[t], NULL);
+    }
+}
+
+/*
+ * Lays out the partitions for the current hashes: counts each
+ * partition's keys, sizes its table and buckets, assigns its ranges of
+ * the shared arrays, and groups the binding indices by partition.
+ * (Re)allocates the pilots, remap entries and key buffer to fit.
+ * Returns 1 on success, 0 if memory is insufficient.
+ */
+static int symtablemph_layOut(struct BuildWork *psWork) {
+    SymTableMPH_T oSymTableMPH = psWork->oSymTableMPH;
+    size_t keyCount = oSymTableMPH->keyCount;
+    size_t bucketTotal = 0, remapTotal = 0, entryTotal = 0, byteTotal = 0;
+    struct Partition *psPartition;
+    size_t p, i;
+
+    /* Count keys and key bytes, keeping the bytes in firstKeyByte
+       until the offsets are known */
+    for (p = 0; p < oSymTableMPH->partitionCount; p++) {
+        oSymTableMPH->partitions[p].keyCount = 0;
+        oSymTableMPH->partitions[p].firstKeyByte = 0;
+    }
+    for (i = 0; i < keyCount; i++) {
+        psPartition = symtablemph_partition(oSymTableMPH, psWork->auHashes[i]);
+        psPartition->keyCount++;
+        psPartition->firstKeyByte += psWork->auLengths[i] + 1;
+    }
+
+    for (p = 0; p < oSymTableMPH->partitionCount; p++) {
+        size_t byteCount;
+
+        psPartition = &oSymTableMPH->partitions[p];
+        psPartition->tableSize = (uint32_t)((double)psPartition->keyCount / LOAD_FACTOR) + 1;
+        psPartition->bucketCount = (uint32_t)((double)psPartition->keyCount / BUCKET_KEYS) + 1;
+        psPartition->denseBucketCount = (uint32_t)((double)psPartition->bucketCount * DENSE_BUCKET_SHARE);
+        psPartition->firstEntry = entryTotal;
+        psPartition->firstBucket = bucketTotal;
+        psPartition->firstRemap = remapTotal;
+        byteCount = psPartition->firstKeyByte;
+        psPartition->firstKeyByte = byteTotal;
+
+        entryTotal += psPartition->keyCount;
+        bucketTotal += psPartition->bucketCount;
+        remapTotal += psPartition->tableSize - psPartition->keyCount;
+        byteTotal += byteCount;
+    }
+
+    free(oSymTableMPH->pilots);
+    free(oSymTableMPH->remap);
+    free(oSymTableMPH->keyBytes);
+    oSymTableMPH->pilots = (uint16_t*)malloc(bucketTotal * sizeof(uint16_t));
+    oSymTableMPH->remap = (uint32_t*)malloc(remapTotal * sizeof(uint32_t));
+    oSymTableMPH->keyBytes = (char*)malloc(byteTotal + 1);
+    oSymTableMPH->bucketTotal = bucketTotal;
+    oSymTableMPH->remapTotal = remapTotal;
+    if (oSymTableMPH->pilots == NULL || oSymTableMPH->remap == NULL || oSymTableMPH->keyBytes == NULL) {
+        return 0;
+    }
+
+    /* Counting sort of the binding indices by partition, using each
+       partition's firstEntry as its cursor and restoring it after */
+    for (i = 0; i < keyCount; i++) {
+        psPartition = symtablemph_partition(oSymTableMPH, psWork->auHashes[i]);
+        psWork->auOrder[psPartition->firstEntry++] = i;
+    }
+    for (p = 0; p < oSymTableMPH->partitionCount; p++) {
+        oSymTableMPH->partitions[p].firstEntry -= oSymTableMPH->partitions[p].keyCount;
+    }
+    return 1;
+}
+
+/* Builds the index over `uCount` distinct keys with SymTableHash_wyhash.
+   Returns the index, or NULL if memory is insufficient or every seed
+   fails. */
+SymTableMPH_T SymTableMPH_new(const char *const apcKeys[], const void *const apvValues[], size_t uCount,
+                              size_t uThreadCount) {
+    return SymTableMPH_newWithHash(apcKeys, apvValues, uCount, uThreadCount, SymTableHash_wyhash);
+}
+
+/* Builds the index over `uCount` distinct keys, on up to `uThreadCount`
+   threads. Keys are hashed by `pfHash` with a fresh seed; if some
+   bucket cannot be placed, the build starts over with another, and
+   after MAX_SEEDS of them with SymTableHash_siphash, which lookups then
+   use too.
+   Returns the index, or NULL if memory is insufficient or MAX_SEEDS
+   SipHash seeds fail as well. */
+SymTableMPH_T SymTableMPH_newWithHash(const char *const apcKeys[], const void *const apvValues[],
+                                      size_t uCount, size_t uThreadCount, SymTableHashFn_T pfHash) {
+    SymTableMPH_T oSymTableMPH;
+    struct BuildWork sWork;
+    size_t seed;
+
+    assert(uCount == 0 || (apcKeys != NULL && apvValues != NULL));
+    assert(uThreadCount > 0);
+    assert(pfHash != NULL);
+
+    oSymTableMPH = (SymTableMPH_T)calloc(1, sizeof(struct SymTableMPH));
+    if (oSymTableMPH == NULL) return NULL;
+    oSymTableMPH->keyCount = uCount;
+    oSymTableMPH->partitionCount = uCount / PARTITION_KEYS + 1;
+    oSymTableMPH->partitions = (struct Partition*)calloc(oSymTableMPH->partitionCount,
+                                                          sizeof(struct Partition));
+    oSymTableMPH->entries = (struct MPHEntry*)malloc((uCount + 1) * sizeof(struct MPHEntry));
+
+    sWork.oSymTableMPH = oSymTableMPH;
+    sWork.apcKeys = apcKeys;
+    sWork.apvValues = apvValues;
+    sWork.auLengths = (size_t*)malloc((uCount + 1) * sizeof(size_t));
+    sWork.auHashes = (uint64_t*)malloc((uCount + 1) * sizeof(uint64_t));
+    sWork.auOrder = (size_t*)malloc((uCount + 1) * sizeof(size_t));
+    sWork.result = BUILD_NO_MEMORY;
+
+    if (oSymTableMPH->partitions != NULL && oSymTableMPH->entries != NULL &&
+        sWork.auLengths != NULL && sWork.auHashes != NULL && sWork.auOrder != NULL) {
+        for (seed = 0; seed < 2 * MAX_SEEDS; seed++) {
+            oSymTableMPH->pfHash = seed < MAX_SEEDS ? pfHash : SymTableHash_siphash;
+            oSymTableMPH->hashSeed = SymTableHash_randomSeed();
+            symtablemph_runPhase(&sWork, 1, (uCount + HASH_CHUNK - 1) / HASH_CHUNK, uThreadCount);
+            if (!symtablemph_layOut(&sWork)) {
+                sWork.result = BUILD_NO_MEMORY;
+                break;
+            }
+            sWork.result = BUILD_OK;
+            symtablemph_runPhase(&sWork, 0, oSymTableMPH->partitionCount, uThreadCount);
+            if (sWork.result != BUILD_RETRY) break;
+        }
+    }
+
+    free(sWork.auLengths);
+    free(sWork.auHashes);
+    free(sWork.auOrder);
+    if (sWork.result != BUILD_OK) {
+        SymTableMPH_free(oSymTableMPH);
+        return NULL;
+    }
+    return oSymTableMPH;
+}
+
+/* Releases the index, the bindings and the key buffer.
+   Arguments -> `oSymTableMPH`: the index to be freed */
+void SymTableMPH_free(SymTableMPH_T oSymTableMPH) {
+    assert(oSymTableMPH != NULL);
+
+    free(oSymTableMPH->partitions);
+    free(oSymTableMPH->pilots);
+    free(oSymTableMPH->remap);
+    free(oSymTableMPH->entries);
+    free(oSymTableMPH->keyBytes);
+    free(oSymTableMPH);
+}
+
+/* Returns the number of bindings.
+   Arguments -> `oSymTableMPH`: the index */
+size_t SymTableMPH_getLength(SymTableMPH_T oSymTableMPH) {
+    assert(oSymTableMPH != NULL);
+    return oSymTableMPH->keyCount;
+}
+
+/*
+ * Looks up a key: one hash, one pilot, one slot and one comparison.
+ * Arguments:
+ *   - `oSymTableMPH`: the index
+ *   - `pcKey`, `uLength`: the key and its length
+ *   - `ppvValue`: receives the value when the key is found
+ * Returns 1 if the key is found, 0 otherwise.
+ */
+int SymTableMPH_find(SymTableMPH_T oSymTableMPH, const char *pcKey, size_t uLength, void **ppvValue) {
+    const struct Partition *psPartition;
+    const struct MPHEntry *psEntry;
+    uint64_t hash;
+    size_t slot;
+
+    assert(oSymTableMPH != NULL);
+    assert(pcKey != NULL);
+    assert(ppvValue != NULL);
+
+    if (oSymTableMPH->keyCount == 0) return 0;
+
+    hash = (*oSymTableMPH->pfHash)(pcKey, uLength, oSymTableMPH->hashSeed);
+    psPartition = symtablemph_partition(oSymTableMPH, hash);
+    if (psPartition->keyCount == 0) return 0;
+
+    slot = symtablemph_position(hash,
+                                oSymTableMPH->pilots[psPartition->firstBucket +
+                                                     symtablemph_bucket(psPartition, hash)],
+                                psPartition->tableSize);
+    if (slot >= psPartition->keyCount) {
+        slot = oSymTableMPH->remap[psPartition->firstRemap + slot - psPartition->keyCount];
+    }
+
+    psEntry = &oSymTableMPH->entries[psPartition->firstEntry + slot];
+    if (psEntry->keyLength != uLength || memcmp(psEntry->pcKey, pcKey, uLength) != 0) return 0;
+    *ppvValue = (void*)psEntry->pvValue;
+    return 1;
+}
+
+/*
+ * Applies *pfApply to every binding, in slot order.
+ * Arguments:
+ *   - `oSymTableMPH`: the index
+ *   - `pfApply`: called as (*pfApply)(pcKey, pvValue, pvExtra)
+ *   - `pvExtra`: passed through to every call
+ */
+void SymTableMPH_map(SymTableMPH_T oSymTableMPH,
+                     void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+                     const void *pvExtra) {
+    size_t i;
+
+    assert(oSymTableMPH != NULL);
+    assert(pfApply != NULL);
+
+    for (i = 0; i < oSymTableMPH->keyCount; i++) {
+        (*pfApply)(oSymTableMPH->entries[i].pcKey, (void*)oSymTableMPH->entries[i].pvValue,
+                   (void*)pvExtra);
+    }
+}
+
+/* Returns the bytes of the index proper: the table header, the
+   partitions, the pilots and the remap entries.
+   Arguments -> `oSymTableMPH`: the index */
+size_t SymTableMPH_getIndexBytes(SymTableMPH_T oSymTableMPH) {
+    assert(oSymTableMPH != NULL);
+    return sizeof(struct SymTableMPH) +
+           oSymTableMPH->partitionCount * sizeof(struct Partition) +
+           oSymTableMPH->bucketTotal * sizeof(uint16_t) +
+           oSymTableMPH->remapTotal * sizeof(uint32_t);
+}
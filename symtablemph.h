@@ -0,0 +1,72 @@
+/*--------------------------------------------------------------------*/
+/* symtablemph.h                                                      */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#ifndef SymTableMPH_INCLUDED
+#define SymTableMPH_INCLUDED
+#include <stddef.h>
+#include "symtablehashfn.h"
+
+/* A SymTableMPH is an immutable set of bindings indexed by a minimal
+perfect hash: every key of the set hashes to its own slot among
+exactly as many slots as there are keys. A lookup hashes the key once,
+reads one small pilot value and the slot it leads to, and compares the
+key there. The index costs a few bits per key on top of the bindings,
+which are kept packed in one array and the keys in one buffer. Keys
+not in the set land on some slot too, and are rejected by the key
+comparison. */
+
+typedef struct SymTableMPH *SymTableMPH_T;
+
+/* Returns a SymTableMPH that binds each of the uCount keys apcKeys[i]
+to apvValues[i], hashed with SymTableHash_wyhash. The keys must be
+distinct; they are copied. Up to uThreadCount threads, the calling
+thread included, share the construction; uThreadCount must be at least
+1. Keys whose hashes collide whatever the seed do not make the build
+fail by themselves: after a few seeds it starts over with
+SymTableHash_siphash, and lookups use that from then on. Returns NULL
+if memory is insufficient, or if a few SipHash seeds fail too, which
+for distinct keys is vanishingly unlikely. */
+
+SymTableMPH_T SymTableMPH_new(const char *const apcKeys[],
+   const void *const apvValues[], size_t uCount, size_t uThreadCount);
+
+/* Returns a SymTableMPH like SymTableMPH_new, but whose keys are
+hashed with *pfHash, for example one of the functions declared in
+symtablehashfn.h, until its collisions make the build fall back to
+SymTableHash_siphash. Returns NULL in the same cases as
+SymTableMPH_new. */
+
+SymTableMPH_T SymTableMPH_newWithHash(const char *const apcKeys[],
+   const void *const apvValues[], size_t uCount, size_t uThreadCount,
+   SymTableHashFn_T pfHash);
+
+/* Frees all the memory that oSymTableMPH occupies. */
+
+void SymTableMPH_free(SymTableMPH_T oSymTableMPH);
+
+/* Returns the number of bindings in oSymTableMPH. */
+
+size_t SymTableMPH_getLength(SymTableMPH_T oSymTableMPH);
+
+/* If oSymTableMPH binds the uLength bytes at pcKey, stores the value
+in *ppvValue and returns 1 (TRUE). Otherwise returns 0 (FALSE) and
+leaves *ppvValue unchanged. */
+
+int SymTableMPH_find(SymTableMPH_T oSymTableMPH, const char *pcKey,
+   size_t uLength, void **ppvValue);
+
+/* Applies function *pfApply to each binding in oSymTableMPH, passing
+pvExtra as an extra parameter. */
+
+void SymTableMPH_map(SymTableMPH_T oSymTableMPH,
+   void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+   const void *pvExtra);
+
+/* Returns the number of bytes that the index of oSymTableMPH occupies:
+everything but the bindings and the keys themselves. */
+
+size_t SymTableMPH_getIndexBytes(SymTableMPH_T oSymTableMPH);
+
+#endif
@@ -0,0 +1,36 @@
+/*--------------------------------------------------------------------*/
+/* symtableordered.h                                                  */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#ifndef SymTableOrdered_INCLUDED
+#define SymTableOrdered_INCLUDED
+#include "symtable.h"
+
+/* Extensions to the SymTable ADT that the ordered implementations
+provide. Such a table keeps its keys sorted in the order of strcmp,
+and its SymTable_map visits the bindings in that order. The functions
+below visit only the bindings that they select, still in order, at a
+cost that grows with the number of those bindings and only
+logarithmically with the size of the table. *pfApply must not change
+oSymTable. */
+
+/* Applies function *pfApply to each binding in oSymTable whose key is
+at least pcLow and less than pcHigh, in increasing order of keys,
+passing pvExtra as an extra parameter. A NULL pcLow or pcHigh leaves
+that end of the range open. */
+
+void SymTable_mapRange(SymTable_T oSymTable, const char *pcLow,
+   const char *pcHigh,
+   void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+   const void *pvExtra);
+
+/* Applies function *pfApply to each binding in oSymTable whose key
+begins with pcPrefix, in increasing order of keys, passing pvExtra as
+an extra parameter. The empty prefix selects every binding. */
+
+void SymTable_mapPrefix(SymTable_T oSymTable, const char *pcPrefix,
+   void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+   const void *pvExtra);
+
+#endif
@@ -0,0 +1,164 @@
+/*--------------------------------------------------------------------*/
+/* symtablercu.c                                                      */
+/* Published read-only versions of a SymTable, read without locks    */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include "symtable.h"
+#include "symtablercu.h"
+
+/*
+ * COUNTER_PAD_SIZE: Each reader counter is padded to this many bytes
+ * so that readers of one epoch do not share a cache line with readers
+ * of the other or with the version pointer.
+ */
+#define COUNTER_PAD_SIZE 128
+
+/*
+ * PaddedCounter: A reader count rounded up to COUNTER_PAD_SIZE bytes.
+ */
+union PaddedCounter {
+    size_t uCount;
+    char acPad[COUNTER_PAD_SIZE];
+};
+
+/*
+ * SymTableRCU: The current version and the bookkeeping that tells a
+ * publisher when an old version is no longer read. Readers count
+ * themselves in the counter selected by the parity of the epoch they
+ * entered in; a publisher flips the epoch and waits for the old
+ * parity's counter to drain.
+ */
+struct SymTableRCU {
+    /* Readers that entered during an even or an odd epoch */
+    union PaddedCounter readers[2];
+
+    /* The current version */
+    SymTable_T oSymTable;
+
+    /* Incremented by every publish */
+    size_t epoch;
+
+    /* Serializes publishers */
+    pthread_mutex_t publishLock;
+};
+
+/* Sets up a holder whose first version is an empty table.
+   Returns a pointer to it, or NULL if there's an allocation issue or
+   its mutex cannot be set up. */
+SymTableRCU_T SymTableRCU_new(void) {
+    SymTableRCU_T oSymTableRCU;
+
+    oSymTableRCU = (SymTableRCU_T)calloc(1, sizeof(struct SymTableRCU));
+    if (oSymTableRCU == NULL) return NULL;
+
+    oSymTableRCU->oSymTable = SymTable_new();
+    if (oSymTableRCU->oSymTable == NULL) {
+        free(oSymTableRCU);
+        return NULL;
+    }
+    if (pthread_mutex_init(&oSymTableRCU->publishLock, NULL) != 0) {
+        SymTable_free(oSymTableRCU->oSymTable);
+        free(oSymTableRCU);
+        return NULL;
+    }
+    return oSymTableRCU;
+}
+
+/* Releases the current version and the holder itself.
+   Arguments -> `oSymTableRCU`: the holder to be freed */
+void SymTableRCU_free(SymTableRCU_T oSymTableRCU) {
+    assert(oSymTableRCU != NULL);
+    assert(oSymTableRCU->readers[0].uCount == 0);
+    assert(oSymTableRCU->readers[1].uCount == 0);
+
+    pthread_mutex_destroy(&oSymTableRCU->publishLock);
+    SymTable_free(oSymTableRCU->oSymTable);
+    free(oSymTableRCU);
+}
+
+/*
+ * Installs a new version and frees the one it replaces.
+ * Arguments:
+ *   - `oSymTableRCU`: the holder
+ *   - `oSymTable`: the new version, now owned by the holder
+ * The pointer is swapped before the epoch is flipped, so every reader
+ * that enters in the new epoch sees the new version. Readers still
+ * counted under the old epoch's parity may hold the old version; once
+ * that counter drains, nobody can.
+ */
+void SymTable_publish(SymTableRCU_T oSymTableRCU, SymTable_T oSymTable) {
+    SymTable_T oOldSymTable;
+    size_t uParity;
+
+    assert(oSymTableRCU != NULL);
+    assert(oSymTable != NULL);
+
+    pthread_mutex_lock(&oSymTableRCU->publishLock);
+
+    oOldSymTable = __atomic_exchange_n(&oSymTableRCU->oSymTable, oSymTable,
+                                       __ATOMIC_SEQ_CST);
+    uParity = oSymTableRCU->epoch & 1;
+    __atomic_store_n(&oSymTableRCU->epoch, oSymTableRCU->epoch + 1,
+                     __ATOMIC_SEQ_CST);
+
+    while (__atomic_load_n(&oSymTableRCU->readers[uParity].uCount,
+                           __ATOMIC_SEQ_CST) != 0) {
+        sched_yield();
+    }
+
+    pthread_mutex_unlock(&oSymTableRCU->publishLock);
+    SymTable_free(oOldSymTable);
+}
+
+/*
+ * Enters the current epoch and returns the current version.
+ * Arguments:
+ *   - `oSymTableRCU`: the holder
+ *   - `puTicket`: receives the counter to decrement on release
+ * A reader that counted itself just as a publisher flipped the epoch
+ * cannot tell which version the publisher is waiting on, so it backs
+ * out and tries again in the new epoch.
+ */
+SymTable_T SymTable_acquireSnapshot(SymTableRCU_T oSymTableRCU,
+                                    size_t *puTicket) {
+    size_t uEpoch;
+    size_t uParity;
+
+    assert(oSymTableRCU != NULL);
+    assert(puTicket != NULL);
+
+    for (;;) {
+        uEpoch = __atomic_load_n(&oSymTableRCU->epoch, __ATOMIC_SEQ_CST);
+        uParity = uEpoch & 1;
+        __atomic_fetch_add(&oSymTableRCU->readers[uParity].uCount, 1,
+                           __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&oSymTableRCU->epoch, __ATOMIC_SEQ_CST) == uEpoch)
+            break;
+        __atomic_fetch_sub(&oSymTableRCU->readers[uParity].uCount, 1,
+                           __ATOMIC_RELEASE);
+    }
+
+    *puTicket = uParity;
+    return __atomic_load_n(&oSymTableRCU->oSymTable, __ATOMIC_ACQUIRE);
+}
+
+/*
+ * Leaves the epoch recorded in a ticket.
+ * Arguments:
+ *   - `oSymTableRCU`: the holder
+ *   - `uTicket`: the ticket filled in by SymTable_acquireSnapshot
+ * The release ordering keeps the reader's last lookups ahead of the
+ * publisher's free.
+ */
+void SymTable_releaseSnapshot(SymTableRCU_T oSymTableRCU, size_t uTicket) {
+    assert(oSymTableRCU != NULL);
+    assert(uTicket < 2);
+
+    __atomic_fetch_sub(&oSymTableRCU->readers[uTicket].uCount, 1,
+                       __ATOMIC_RELEASE);
+}
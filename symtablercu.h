@@ -0,0 +1,57 @@
+/*--------------------------------------------------------------------*/
+/* symtablercu.h                                                      */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#ifndef SymTableRCU_INCLUDED
+#define SymTableRCU_INCLUDED
+#include <stddef.h>
+#include "symtable.h"
+
+/* A SymTableRCU holds the current version of a SymTable that many
+threads read and that is replaced as a whole. A writer builds a
+private SymTable and publishes it; from then on the table is
+read-only and belongs to the SymTableRCU. Readers acquire the current
+version without taking a lock, read it with the ordinary SymTable_get,
+SymTable_contains, SymTable_getLength and SymTable_map functions, and
+release it when done. An old version is freed once every reader that
+may have acquired it has released it. All functions are safe to call
+from several threads. */
+
+typedef struct SymTableRCU *SymTableRCU_T;
+
+/* Returns a SymTableRCU whose current version is an empty SymTable.
+Returns NULL if memory is insufficient or a mutex cannot be
+initialized. */
+
+SymTableRCU_T SymTableRCU_new(void);
+
+/* Takes in oSymTableRCU and frees all the memory that it occupies,
+including its current version. No snapshot of oSymTableRCU may still
+be held. */
+
+void SymTableRCU_free(SymTableRCU_T oSymTableRCU);
+
+/* Makes oSymTable the current version of oSymTableRCU and takes
+ownership of it; the caller must not change oSymTable afterwards.
+Waits until no reader holds the previous version, then frees it.
+Publishers are serialized among themselves. A thread must not publish
+while it holds a snapshot of the same SymTableRCU. */
+
+void SymTable_publish(SymTableRCU_T oSymTableRCU, SymTable_T oSymTable);
+
+/* Returns the current version of oSymTableRCU, which stays valid and
+unchanged until the caller passes the ticket stored in *puTicket to
+SymTable_releaseSnapshot. The caller must not change the returned
+table. Takes no lock. */
+
+SymTable_T SymTable_acquireSnapshot(SymTableRCU_T oSymTableRCU,
+   size_t *puTicket);
+
+/* Releases the snapshot of oSymTableRCU that was acquired with ticket
+uTicket. The snapshot must not be used afterwards. */
+
+void SymTable_releaseSnapshot(SymTableRCU_T oSymTableRCU,
+   size_t uTicket);
+
+#endif
@@ -0,0 +1,302 @@
+/*--------------------------------------------------------------------*/
+/* symtableshard.c                                                    */
+/* Sharded front end: 2^k independent SymTables, one lock per shard   */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "symtable.h"
+#include "symtablehash.h"
+#include "symtablehashfn.h"
+#include "symtableshard.h"
+
+/*
+ * SHARD_PAD_SIZE: Each shard is padded to this many bytes so that two
+ * shards never share a cache line and threads locking neighbouring
+ * shards do not slow each other down.
+ */
+#define SHARD_PAD_SIZE 128
+
+/*
+ * Shard: One independent sub-table together with the mutex that
+ * guards it.
+ */
+struct Shard {
+    /* Serializes every access to oSymTable */
+    pthread_mutex_t lock;
+
+    /* The sub-table holding this shard's bindings */
+    SymTable_T oSymTable;
+};
+
+/*
+ * PaddedShard: A Shard rounded up to SHARD_PAD_SIZE bytes.
+ */
+union PaddedShard {
+    struct Shard sShard;
+    char acPad[SHARD_PAD_SIZE];
+};
+
+/*
+ * SymTableShard: Main structure for the sharded table. Holds the
+ * shard array, the number of hash bits used to pick a shard, and the
+ * seed that every key is hashed with.
+ */
+struct SymTableShard {
+    /* Array of 2^shardBits shards */
+    union PaddedShard *shards;
+
+    /* Number of top hash bits that select a shard */
+    unsigned int shardBits;
+
+    /* Number of shards, 2^shardBits */
+    size_t shardCount;
+
+    /* The seed passed to SymTableHash_wyhash, shared by every shard so
+       that the hash that picks a shard is the one the shard uses */
+    uint64_t hashSeed;
+};
+
+/*
+ * ShardKey: A key together with its length and its hash, computed once
+ * by symtableshard_getShard and passed down to the shard.
+ */
+struct ShardKey {
+    /* strlen of the key */
+    size_t keyLength;
+
+    /* SymTableHash_wyhash of the key under the table's seed */
+    uint64_t hash;
+};
+
+/*
+ * Finds the shard that owns a key.
+ * Arguments:
+ *   - `oSymTableShard`: the sharded table
+ *   - `pcKey`: the key to look up
+ *   - `psKey`: receives the key's length and hash
+ * Returns the shard selected by the top `shardBits` bits of the hash.
+ */
+static struct Shard *symtableshard_getShard(SymTableShard_T oSymTableShard,
+                                            const char *pcKey, struct ShardKey *psKey) {
+    size_t index = 0;
+
+    assert(pcKey != NULL);
+
+    psKey->keyLength = strlen(pcKey);
+    psKey->hash = SymTableHash_wyhash(pcKey, psKey->keyLength, oSymTableShard->hashSeed);
+    if (oSymTableShard->shardBits > 0) {
+        index = (size_t)(psKey->hash >> (64 - oSymTableShard->shardBits));
+    }
+    return &oSymTableShard->shards[index].sShard;
+}
+
+/* Sets up a sharded table with 2^uShardBits empty shards.
+   Returns a pointer to the table, or NULL if uShardBits is too large
+   or there's an allocation issue or a shard's mutex cannot be set up. */
+SymTableShard_T SymTableShard_new(unsigned int uShardBits) {
+    SymTableShard_T oSymTableShard;
+    size_t i;
+
+    if (uShardBits > SYMTABLESHARD_MAX_BITS) return NULL;
+
+    oSymTableShard = (SymTableShard_T)malloc(sizeof(struct SymTableShard));
+    if (oSymTableShard == NULL) return NULL;
+
+    oSymTableShard->shardBits = uShardBits;
+    oSymTableShard->shardCount = (size_t)1 << uShardBits;
+    oSymTableShard->hashSeed = SymTableHash_randomSeed();
+    oSymTableShard->shards = (union PaddedShard*)calloc(oSymTableShard->shardCount, sizeof(union PaddedShard));
+    if (oSymTableShard->shards == NULL) {
+        free(oSymTableShard);
+        return NULL;
+    }
+
+    for (i = 0; i < oSymTableShard->shardCount; i++) {
+        struct Shard *psShard = &oSymTableShard->shards[i].sShard;
+
+        psShard->oSymTable = SymTable_newWithSeed(SymTableHash_wyhash, oSymTableShard->hashSeed);
+        if (psShard->oSymTable != NULL && pthread_mutex_init(&psShard->lock, NULL) != 0) {
+            SymTable_free(psShard->oSymTable);
+            psShard->oSymTable = NULL;
+        }
+        if (psShard->oSymTable == NULL) {
+            /* Undo the shards that were already set up */
+            while (i > 0) {
+                i--;
+                psShard = &oSymTableShard->shards[i].sShard;
+                SymTable_free(psShard->oSymTable);
+                pthread_mutex_destroy(&psShard->lock);
+            }
+            free(oSymTableShard->shards);
+            free(oSymTableShard);
+            return NULL;
+        }
+    }
+    return oSymTableShard;
+}
+
+/* Releases every shard and the sharded table itself.
+   Arguments -> `oSymTableShard`: the sharded table to be freed */
+void SymTableShard_free(SymTableShard_T oSymTableShard) {
+    size_t i;
+
+    assert(oSymTableShard != NULL);
+
+    for (i = 0; i < oSymTableShard->shardCount; i++) {
+        struct Shard *psShard = &oSymTableShard->shards[i].sShard;
+        SymTable_free(psShard->oSymTable);
+        pthread_mutex_destroy(&psShard->lock);
+    }
+    free(oSymTableShard->shards);
+    free(oSymTableShard);
+}
+
+/*
+ * Gives the total number of bindings across all shards.
+ * Arguments:
+ *   - `oSymTableShard`: the sharded table to check
+ * Each shard is locked only while its own length is read, so the sum
+ * is exact only when no writer runs at the same time.
+ */
+size_t SymTableShard_getLength(SymTableShard_T oSymTableShard) {
+    size_t uLength = 0;
+    size_t i;
+
+    assert(oSymTableShard != NULL);
+
+    for (i = 0; i < oSymTableShard->shardCount; i++) {
+        struct Shard *psShard = &oSymTableShard->shards[i].sShard;
+        pthread_mutex_lock(&psShard->lock);
+        uLength += SymTable_getLength(psShard->oSymTable);
+        pthread_mutex_unlock(&psShard->lock);
+    }
+    return uLength;
+}
+
+/*
+ * Adds a binding to the shard that owns `pcKey`.
+ * Returns 1 on success, 0 on failure or if the key already exists.
+ */
+int SymTableShard_put(SymTableShard_T oSymTableShard,
+                      const char *pcKey, const void *pvValue) {
+    struct Shard *psShard;
+    struct ShardKey sKey;
+    int iSuccessful;
+
+    assert(oSymTableShard != NULL);
+    assert(pcKey != NULL);
+
+    psShard = symtableshard_getShard(oSymTableShard, pcKey, &sKey);
+    pthread_mutex_lock(&psShard->lock);
+    iSuccessful = SymTable_putHashed(psShard->oSymTable, pcKey, sKey.keyLength, &sKey.hash, pvValue);
+    pthread_mutex_unlock(&psShard->lock);
+    return iSuccessful;
+}
+
+/*
+ * Replaces the value of `pcKey` in the shard that owns it.
+ * Returns the old value, or NULL if the key doesn't exist.
+ */
+void *SymTableShard_replace(SymTableShard_T oSymTableShard,
+                            const char *pcKey, const void *pvValue) {
+    struct Shard *psShard;
+    struct ShardKey sKey;
+    void *oldValue;
+
+    assert(oSymTableShard != NULL);
+    assert(pcKey != NULL);
+
+    psShard = symtableshard_getShard(oSymTableShard, pcKey, &sKey);
+    pthread_mutex_lock(&psShard->lock);
+    oldValue = SymTable_replaceHashed(psShard->oSymTable, pcKey, sKey.keyLength, &sKey.hash, pvValue);
+    pthread_mutex_unlock(&psShard->lock);
+    return oldValue;
+}
+
+/*
+ * Checks whether the shard that owns `pcKey` contains it.
+ * Returns 1 if the key is found, 0 otherwise.
+ */
+int SymTableShard_contains(SymTableShard_T oSymTableShard,
+                           const char *pcKey) {
+    struct Shard *psShard;
+    struct ShardKey sKey;
+    int iFound;
+
+    assert(oSymTableShard != NULL);
+    assert(pcKey != NULL);
+
+    psShard = symtableshard_getShard(oSymTableShard, pcKey, &sKey);
+    pthread_mutex_lock(&psShard->lock);
+    iFound = SymTable_containsHashed(psShard->oSymTable, pcKey, sKey.keyLength, &sKey.hash);
+    pthread_mutex_unlock(&psShard->lock);
+    return iFound;
+}
+
+/*
+ * Gets the value bound to `pcKey` from the shard that owns it.
+ * Returns the value, or NULL if the key isn't found.
+ */
+void *SymTableShard_get(SymTableShard_T oSymTableShard,
+                        const char *pcKey) {
+    struct Shard *psShard;
+    struct ShardKey sKey;
+    void *pvValue;
+
+    assert(oSymTableShard != NULL);
+    assert(pcKey != NULL);
+
+    psShard = symtableshard_getShard(oSymTableShard, pcKey, &sKey);
+    pthread_mutex_lock(&psShard->lock);
+    pvValue = SymTable_getHashed(psShard->oSymTable, pcKey, sKey.keyLength, &sKey.hash);
+    pthread_mutex_unlock(&psShard->lock);
+    return pvValue;
+}
+
+/*
+ * Removes `pcKey` from the shard that owns it.
+ * Returns the removed value, or NULL if the key isn't found.
+ */
+void *SymTableShard_remove(SymTableShard_T oSymTableShard,
+                           const char *pcKey) {
+    struct Shard *psShard;
+    struct ShardKey sKey;
+    void *oldValue;
+
+    assert(oSymTableShard != NULL);
+    assert(pcKey != NULL);
+
+    psShard = symtableshard_getShard(oSymTableShard, pcKey, &sKey);
+    pthread_mutex_lock(&psShard->lock);
+    oldValue = SymTable_removeHashed(psShard->oSymTable, pcKey, sKey.keyLength, &sKey.hash);
+    pthread_mutex_unlock(&psShard->lock);
+    return oldValue;
+}
+
+/*
+ * Applies *pfApply to every binding, one shard at a time.
+ * Parameters:
+ *   oSymTableShard - A pointer to the sharded table.
+ *   pfApply - The function to call for each key-value pair.
+ *   pvExtra - The extra parameter passed through to *pfApply.
+ */
+void SymTableShard_map(SymTableShard_T oSymTableShard,
+                       void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+                       const void *pvExtra) {
+    size_t i;
+
+    assert(oSymTableShard != NULL);
+    assert(pfApply != NULL);
+
+    for (i = 0; i < oSymTableShard->shardCount; i++) {
+        struct Shard *psShard = &oSymTableShard->shards[i].sShard;
+        pthread_mutex_lock(&psShard->lock);
+        SymTable_map(psShard->oSymTable, pfApply, pvExtra);
+        pthread_mutex_unlock(&psShard->lock);
+    }
+}
@@ -0,0 +1,87 @@
+/*--------------------------------------------------------------------*/
+/* symtableshard.h                                                    */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#ifndef SymTableShard_INCLUDED
+#define SymTableShard_INCLUDED
+#include <stddef.h>
+
+/* A SymTableShard splits its key space into 2^uShardBits independent
+SymTable objects, chosen by the top bits of each key's hash. A key is
+hashed once, with SymTableHash_wyhash and a seed of the table's own
+from SymTableHash_randomSeed, and its shard reuses that hash. Every
+shard has its own lock and grows on its own, so a resize only touches
+the bindings of one shard and writers that hit different shards never
+contend. All functions are safe to call from several threads.
+
+The shards are symtablehash.c tables, so this module cannot define the
+SymTable_* functions itself; it offers the same operations under the
+SymTableShard_ prefix instead, with SymTableShard_getLength and
+SymTableShard_map covering every shard. */
+
+typedef struct SymTableShard *SymTableShard_T;
+
+/* The largest number of shard bits that SymTableShard_new accepts. */
+
+enum {SYMTABLESHARD_MAX_BITS = 12};
+
+/* Returns a SymTableShard with 2^uShardBits empty shards. Returns
+NULL if memory is insufficient, if a shard's mutex cannot be
+initialized, or if uShardBits exceeds SYMTABLESHARD_MAX_BITS. */
+
+SymTableShard_T SymTableShard_new(unsigned int uShardBits);
+
+/* Takes in oSymTableShard and frees all the memory that it occupies,
+including its shards. */
+
+void SymTableShard_free(SymTableShard_T oSymTableShard);
+
+/* Takes in oSymTableShard, returns its number of bindings summed
+across all shards. */
+
+size_t SymTableShard_getLength(SymTableShard_T oSymTableShard);
+
+/* Returns 1 (TRUE) if oSymTableShard did not contain a binding with
+key pcKey and one was added with value pvValue. Returns 0 (FALSE) if
+either memory is insufficient or the key is already present. */
+
+int SymTableShard_put(SymTableShard_T oSymTableShard,
+   const char *pcKey, const void *pvValue);
+
+/* If oSymTableShard contains a binding with key pcKey, replace its
+value with pvValue and RETURN the previous value. Otherwise, return
+NULL and leave oSymTableShard unchanged. */
+
+void *SymTableShard_replace(SymTableShard_T oSymTableShard,
+   const char *pcKey, const void *pvValue);
+
+/* Returns 1(TRUE) if oSymTableShard contains a binding with a key
+equal to pcKey. Otherwise return 0(FALSE). */
+
+int SymTableShard_contains(SymTableShard_T oSymTableShard,
+   const char *pcKey);
+
+/* Returns the value of the binding within oSymTableShard with a key
+equal to pcKey. Otherwise return NULL. */
+
+void *SymTableShard_get(SymTableShard_T oSymTableShard,
+   const char *pcKey);
+
+/* Removes the binding in oSymTableShard with key == pcKey and RETURNS
+its value. Otherwise, return NULL and leave oSymTableShard
+untouched. */
+
+void *SymTableShard_remove(SymTableShard_T oSymTableShard,
+   const char *pcKey);
+
+/* Applies function *pfApply to each binding in every shard, calling
+(*pfApply)(pcKey, pvValue, pvExtra) for each binding. Each shard is
+locked while it is visited, so *pfApply must not call back into
+oSymTableShard. */
+
+void SymTableShard_map(SymTableShard_T oSymTableShard,
+   void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+   const void *pvExtra);
+
+#endif
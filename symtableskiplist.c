@@ -0,0 +1,394 @@
+/*--------------------------------------------------------------------*/
+/* symtableskiplist.c                                                 */
+/* Skip list: keys kept in strcmp order                               */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "symtable.h"
+#include "symtablehashfn.h"
+#include "symtableordered.h"
+
+/*
+ * MAX_LEVEL: The most levels a node can be linked into. Each level
+ * holds about a quarter of the nodes of the one below, so 16 levels
+ * keep searches logarithmic up to about four billion bindings.
+ */
+#define MAX_LEVEL 16
+
+/*
+ * SkipNode: One binding, linked into levels 0 to `level` - 1. The key
+ * follows the node's next pointers in the same allocation.
+ *
+ * A node's key and level never change once it is allocated, and a
+ * node is only ever linked in from level 0 upwards and unlinked from
+ * its top level downwards, one pointer store at a time, so that level
+ * 0 alone decides whether a binding is in the table and the upper
+ * levels are only shortcuts to it. That is the order a lock-free
+ * variant needs, with each store a compare-and-swap and the lowest bit
+ * of a next pointer, which malloc's alignment leaves clear, marking
+ * the node as being removed.
+ */
+struct SkipNode {
+    /* The value */
+    const void *pvValue;
+
+    /* The key, stored after apsNext */
+    const char *pcKey;
+
+    /* How many levels the node is linked into */
+    unsigned int level;
+
+    /* The next node at each level, or NULL at the end */
+    struct SkipNode *apsNext[];
+};
+
+/*
+ * SymTable: A skip list with a head node that is linked into every
+ * level and holds no binding.
+ */
+struct SymTable {
+    /* The head, with MAX_LEVEL next pointers */
+    struct SkipNode *psHead;
+
+    /* The number of levels that hold any node, at least 1 */
+    unsigned int level;
+
+    /* The state of the generator of random levels */
+    uint64_t randomState;
+
+    /* Total number of bindings in the table */
+    size_t nodeQuantity;
+};
+
+/*
+ * Draws a level for a new node: 1, then one more with probability 1/4
+ * each time, up to MAX_LEVEL. The generator is xorshift64.
+ */
+static unsigned int symtableskiplist_randomLevel(SymTable_T oSymTable) {
+    uint64_t random = oSymTable->randomState;
+    unsigned int level = 1;
+
+    random ^= random << 13;
+    random ^= random >> 7;
+    random ^= random << 17;
+    oSymTable->randomState = random;
+
+    while ((random & 3) == 0 && level < MAX_LEVEL) {
+        level++;
+        random >>= 2;
+    }
+    return level;
+}
+
+/*
+ * Finds, at each level, the last node whose key is less than `pcKey`,
+ * and stores it in apsPreds, the head standing in where there is none.
+ * Levels above the list's highest get the head.
+ * Returns the first node at level 0 whose key is at least `pcKey`, or
+ * NULL if there is none.
+ */
+static struct SkipNode *symtableskiplist_findPath(SymTable_T oSymTable, const char *pcKey,
+                                                  struct SkipNode *apsPreds[]) {
+    struct SkipNode *psNode = oSymTable->psHead;
+    struct SkipNode *psNext;
+    unsigned int i;
+
+    for (i = MAX_LEVEL; i > oSymTable->level; i--) {
+        apsPreds[i - 1] = psNode;
+    }
+    for (i = oSymTable->level; i > 0; i--) {
+        while ((psNext = psNode->apsNext[i - 1]) != NULL && strcmp(psNext->pcKey, pcKey) < 0) {
+            psNode = psNext;
+        }
+        apsPreds[i - 1] = psNode;
+    }
+    return psNode->apsNext[0];
+}
+
+/*
+ * Gives the first node whose key is at least `pcKey`, or NULL if there
+ * is none, without recording the path to it.
+ */
+static struct SkipNode *symtableskiplist_lowerBound(SymTable_T oSymTable, const char *pcKey) {
+    struct SkipNode *psNode = oSymTable->psHead;
+    struct SkipNode *psNext;
+    unsigned int i;
+
+    for (i = oSymTable->level; i > 0; i--) {
+        while ((psNext = psNode->apsNext[i - 1]) != NULL && strcmp(psNext->pcKey, pcKey) < 0) {
+            psNode = psNext;
+        }
+    }
+    return psNode->apsNext[0];
+}
+
+/*
+ * Finds the node that holds a key.
+ * Returns the node, or NULL if the table has no such key.
+ */
+static struct SkipNode *symtableskiplist_find(SymTable_T oSymTable, const char *pcKey) {
+    struct SkipNode *psNode = symtableskiplist_lowerBound(oSymTable, pcKey);
+
+    return psNode != NULL && strcmp(psNode->pcKey, pcKey) == 0 ? psNode : NULL;
+}
+
+/* Sets up a new, empty symbol table: a head linked into every level
+   with nothing after it.
+   Returns a pointer to the table or NULL if there's an allocation
+   issue. */
+SymTable_T SymTable_new(void) {
+    SymTable_T oSymTable;
+    unsigned int i;
+
+    oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+    if (oSymTable == NULL) return NULL;
+
+    oSymTable->psHead = (struct SkipNode*)malloc(sizeof(struct SkipNode) + MAX_LEVEL * sizeof(struct SkipNode*));
+    if (oSymTable->psHead == NULL) {
+        free(oSymTable);
+        return NULL;
+    }
+    oSymTable->psHead->pvValue = NULL;
+    oSymTable->psHead->pcKey = NULL;
+    oSymTable->psHead->level = MAX_LEVEL;
+    for (i = 0; i < MAX_LEVEL; i++) {
+        oSymTable->psHead->apsNext[i] = NULL;
+    }
+    oSymTable->level = 1;
+    /* Each table draws its levels from its own unpredictable stream,
+       so no caller can tell which nodes are tall and remove just those.
+       Xorshift64 needs a state other than 0. */
+    oSymTable->randomState = SymTableHash_randomSeed() | 1;
+    oSymTable->nodeQuantity = 0;
+    return oSymTable;
+}
+
+/* Returns the number of bindings in the table.
+   Arguments -> `oSymTable`: the symbol table */
+size_t SymTable_getLength(SymTable_T oSymTable) {
+    assert(oSymTable != NULL);
+    return oSymTable->nodeQuantity;
+}
+
+/* Releases every node along level 0, the head and the table.
+   Arguments -> `oSymTable`: the symbol table to be freed */
+void SymTable_free(SymTable_T oSymTable) {
+    struct SkipNode *psNode;
+    struct SkipNode *psNext;
+
+    assert(oSymTable != NULL);
+
+    for (psNode = oSymTable->psHead; psNode != NULL; psNode = psNext) {
+        psNext = psNode->apsNext[0];
+        free(psNode);
+    }
+    free(oSymTable);
+}
+
+/*
+ * Adds a new key-value pair to the symbol table if the key doesn't already exist.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `pcKey`: string key to add
+ *   - `pvValue`: the value associated with `pcKey`
+ * Links the new node in after its predecessor at each of its levels,
+ * level 0 first.
+ * Returns 1 on success, 0 on failure or if the key exists.
+ */
+int SymTable_put(SymTable_T oSymTable, const char *pcKey, const void *pvValue) {
+    struct SkipNode *apsPreds[MAX_LEVEL];
+    struct SkipNode *psNewNode;
+    struct SkipNode *psNext;
+    unsigned int level, i;
+    size_t keyLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    psNext = symtableskiplist_findPath(oSymTable, pcKey, apsPreds);
+    if (psNext != NULL && strcmp(psNext->pcKey, pcKey) == 0) return 0;
+
+    level = symtableskiplist_randomLevel(oSymTable);
+    keyLength = strlen(pcKey);
+    psNewNode = (struct SkipNode*)malloc(sizeof(struct SkipNode) + level * sizeof(struct SkipNode*) + keyLength + 1);
+    if (psNewNode == NULL) return 0;
+    psNewNode->pcKey = (const char*)&psNewNode->apsNext[level];
+    memcpy((char*)&psNewNode->apsNext[level], pcKey, keyLength + 1);
+    psNewNode->pvValue = pvValue;
+    psNewNode->level = level;
+
+    for (i = 0; i < level; i++) {
+        psNewNode->apsNext[i] = apsPreds[i]->apsNext[i];
+        apsPreds[i]->apsNext[i] = psNewNode;
+    }
+    if (level > oSymTable->level) oSymTable->level = level;
+    oSymTable->nodeQuantity++;
+    return 1;
+}
+
+/*
+ * Replaces the value of an existing key in the table.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `pcKey`: the key whose value we want to update
+ *   - `pvValue`: the new value to store
+ * Returns the old value, or NULL if the key doesn't exist.
+ */
+void *SymTable_replace(SymTable_T oSymTable, const char *pcKey, const void *pvValue) {
+    struct SkipNode *psNode;
+    void *oldValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    psNode = symtableskiplist_find(oSymTable, pcKey);
+    if (psNode == NULL) return NULL;
+    oldValue = (void*)psNode->pvValue;
+    psNode->pvValue = pvValue;
+    return oldValue;
+}
+
+/*
+ * Checks if a key exists in the table.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `pcKey`: the key to look for
+ * Returns 1 if the key is found, 0 if not.
+ */
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey) {
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    return symtableskiplist_find(oSymTable, pcKey) != NULL;
+}
+
+/*
+ * Gets the value associated with a given key.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `pcKey`: the key to look for
+ * Returns the value if the key is found, NULL if not.
+ */
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey) {
+    struct SkipNode *psNode;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    psNode = symtableskiplist_find(oSymTable, pcKey);
+    return psNode != NULL ? (void*)psNode->pvValue : NULL;
+}
+
+/*
+ * Removes a key-value pair from the table.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `pcKey`: the key to remove
+ * Unlinks the node from its top level down to level 0, then drops
+ * levels that are left empty.
+ * Returns the value of the removed binding, or NULL if the key doesn't
+ * exist.
+ */
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey) {
+    struct SkipNode *apsPreds[MAX_LEVEL];
+    struct SkipNode *psNode;
+    void *oldValue;
+    unsigned int i;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    psNode = symtableskiplist_findPath(oSymTable, pcKey, apsPreds);
+    if (psNode == NULL || strcmp(psNode->pcKey, pcKey) != 0) return NULL;
+
+    for (i = psNode->level; i > 0; i--) {
+        apsPreds[i - 1]->apsNext[i - 1] = psNode->apsNext[i - 1];
+    }
+    while (oSymTable->level > 1 && oSymTable->psHead->apsNext[oSymTable->level - 1] == NULL) {
+        oSymTable->level--;
+    }
+
+    oldValue = (void*)psNode->pvValue;
+    free(psNode);
+    oSymTable->nodeQuantity--;
+    return oldValue;
+}
+
+/*
+ * SymTable_map:
+ * Applies the given function *pfApply to each key-value pair in the SymTable,
+ * in increasing order of keys.
+ * Parameters:
+ *   oSymTable - A pointer to the SymTable.
+ *   pfApply - A pointer to a function that takes three parameters:
+ *     - The key (const char *)
+ *     - The value (void *)
+ *     - An extra parameter provided by the caller (void *)
+ *   pvExtra - A pointer to the extra parameter that will be passed to *pfApply.
+ */
+void SymTable_map(SymTable_T oSymTable,
+                  void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+                  const void *pvExtra) {
+    const struct SkipNode *psNode;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    for (psNode = oSymTable->psHead->apsNext[0]; psNode != NULL; psNode = psNode->apsNext[0]) {
+        (*pfApply)(psNode->pcKey, (void*)psNode->pvValue, (void*)pvExtra);
+    }
+}
+
+/*
+ * Applies *pfApply to the bindings whose keys lie in [pcLow, pcHigh).
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `pcLow`, `pcHigh`: the ends of the range, NULL for an open end
+ *   - `pfApply`, `pvExtra`: as for SymTable_map
+ * Searches once for the first key at least `pcLow`, then walks level 0
+ * until a key reaches `pcHigh`.
+ */
+void SymTable_mapRange(SymTable_T oSymTable, const char *pcLow, const char *pcHigh,
+                       void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+                       const void *pvExtra) {
+    const struct SkipNode *psNode;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    psNode = pcLow != NULL ? symtableskiplist_lowerBound(oSymTable, pcLow) : oSymTable->psHead->apsNext[0];
+    for (; psNode != NULL; psNode = psNode->apsNext[0]) {
+        if (pcHigh != NULL && strcmp(psNode->pcKey, pcHigh) >= 0) return;
+        (*pfApply)(psNode->pcKey, (void*)psNode->pvValue, (void*)pvExtra);
+    }
+}
+
+/*
+ * Applies *pfApply to the bindings whose keys begin with `pcPrefix`.
+ * Arguments:
+ *   - `oSymTable`: the symbol table
+ *   - `pcPrefix`: the prefix
+ *   - `pfApply`, `pvExtra`: as for SymTable_map
+ * The keys with a prefix are contiguous in key order and start at the
+ * prefix itself, so this walks from there until a key lacks it.
+ */
+void SymTable_mapPrefix(SymTable_T oSymTable, const char *pcPrefix,
+                        void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+                        const void *pvExtra) {
+    const struct SkipNode *psNode;
+    size_t prefixLength;
+
+    assert(oSymTable != NULL);
+    assert(pcPrefix != NULL);
+    assert(pfApply != NULL);
+
+    prefixLength = strlen(pcPrefix);
+    for (psNode = symtableskiplist_lowerBound(oSymTable, pcPrefix); psNode != NULL; psNode = psNode->apsNext[0]) {
+        if (strncmp(psNode->pcKey, pcPrefix, prefixLength) != 0) return;
+        (*pfApply)(psNode->pcKey, (void*)psNode->pvValue, (void*)pvExtra);
+    }
+}
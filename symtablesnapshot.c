@@ -0,0 +1,452 @@
+/*--------------------------------------------------------------------*/
+/* symtablesnapshot.c                                                 */
+/* Memory-mapped, position-independent symbol table snapshots         */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "symtablesnapshot.h"
+#include "symtablehashfn.h"
+
+/*
+ * A snapshot file is a header, then the bucket index, the entries and
+ * the keys, each section found through an offset in the header. The
+ * bindings are sorted by bucket, so the index is just where each
+ * bucket's entries start (a bucket ends where the next one starts),
+ * and a lookup reads one index word and then a run of adjacent
+ * entries. Every key is stored with its '\0', so that the keys handed
+ * to a map callback are C strings inside the mapping.
+ */
+
+/*
+ * SNAPSHOT_MAGIC: The first bytes of every snapshot file.
+ */
+static const char SNAPSHOT_MAGIC[8] = {'S', 'y', 'm', 'T', 'a', 'b', 'S', 'n'};
+
+/*
+ * SNAPSHOT_VERSION: Bumped whenever the layout or the hash changes, so
+ * that an old file is refused instead of misread.
+ */
+#define SNAPSHOT_VERSION 2
+
+/*
+ * BYTE_ORDER_MARK: Written as a native integer; it reads back the same
+ * only on a machine with the writer's byte order.
+ */
+#define BYTE_ORDER_MARK 0x0102030405060708ULL
+
+/*
+ * ENTRIES_PER_BUCKET: The bucket count is the smallest power of two
+ * that is at least the binding count divided by this, so a lookup
+ * scans one or two entries on average, and the index costs between two
+ * and four bytes per binding.
+ */
+#define ENTRIES_PER_BUCKET 2
+
+/*
+ * SnapshotHeader: The start of the file. Offsets and sizes are in
+ * bytes from the start of the file.
+ */
+struct SnapshotHeader {
+    char acMagic[8];
+    uint32_t version;
+
+    /* sizeof(struct SnapshotEntry) and sizeof(void*) of the writer */
+    uint16_t entryBytes;
+    uint16_t pointerBytes;
+
+    uint64_t byteOrderMark;
+
+    /* The size of the whole file, checked against the file itself */
+    uint64_t fileBytes;
+
+    /* The seed the keys were hashed with */
+    uint64_t hashSeed;
+
+    /* Bindings, and buckets (a power of two) */
+    uint64_t count;
+    uint64_t bucketCount;
+
+    /* bucketCount + 1 uint32_t entry indices */
+    uint64_t bucketsOffset;
+
+    /* `count` entries */
+    uint64_t entriesOffset;
+
+    /* The keys, each followed by '\0' */
+    uint64_t keysOffset;
+    uint64_t keyBytes;
+};
+
+/*
+ * SnapshotEntry: One binding.
+ */
+struct SnapshotEntry {
+    /* Where the key starts, from the start of the keys */
+    uint64_t keyOffset;
+
+    /* The value, as the integer its pointer converts to */
+    uint64_t value;
+
+    /* The high half of the key's hash; the low bits chose the bucket */
+    uint32_t hashCheck;
+
+    /* The key's length, without its '\0' */
+    uint32_t keyLength;
+};
+
+/*
+ * SymTableSnapshot: A mapped file and pointers to its sections.
+ */
+struct SymTableSnapshot {
+    /* The mapping and its length */
+    void *pvMapping;
+    size_t mappingBytes;
+
+    /* Copied from the header */
+    uint64_t hashSeed;
+    size_t count;
+    size_t bucketMask;
+    size_t keyBytes;
+
+    /* The sections, inside the mapping */
+    const uint32_t *buckets;
+    const struct SnapshotEntry *entries;
+    const char *keys;
+};
+
+/*
+ * Gives `offset` rounded up to a multiple of eight, the alignment of
+ * every section.
+ */
+static uint64_t symtablesnapshot_align(uint64_t offset) {
+    return (offset + 7) & ~(uint64_t)7;
+}
+
+/*
+ * Writes `uBytes` zero bytes, the padding before a section.
+ * Returns 1 on success, 0 on a write error.
+ */
+static int symtablesnapshot_pad(FILE *psFile, size_t uBytes) {
+    static const char acZeros[8] = {0};
+    return uBytes == 0 || fwrite(acZeros, 1, uBytes, psFile) == uBytes;
+}
+
+/*
+ * Writes the file once the bindings are laid out.
+ * Arguments:
+ *   - `psFile`: the file, open for writing at its start
+ *   - `psHeader`: the complete header
+ *   - `auBuckets`, `asEntries`: the index and the entries
+ *   - `apcKeys`, `auOrder`: the keys, written in the order `auOrder`
+ *     gives, which is the order of the entries
+ * Returns 1 on success, 0 on a write error.
+ */
+static int symtablesnapshot_writeSections(FILE *psFile, const struct SnapshotHeader *psHeader,
+                                          const uint32_t auBuckets[],
+                                          const struct SnapshotEntry asEntries[],
+                                          const char *const apcKeys[], const uint32_t auOrder[]) {
+    size_t count = (size_t)psHeader->count;
+    size_t i;
+
+    if (fwrite(psHeader, sizeof(*psHeader), 1, psFile) != 1) return 0;
+    if (!symtablesnapshot_pad(psFile, (size_t)(psHeader->bucketsOffset - sizeof(*psHeader))))
+        return 0;
+    if (fwrite(auBuckets, sizeof(uint32_t), (size_t)psHeader->bucketCount + 1, psFile) !=
+        (size_t)psHeader->bucketCount + 1) return 0;
+    if (!symtablesnapshot_pad(psFile, (size_t)(psHeader->entriesOffset - psHeader->bucketsOffset -
+                                               (psHeader->bucketCount + 1) * sizeof(uint32_t))))
+        return 0;
+    if (fwrite(asEntries, sizeof(struct SnapshotEntry), count, psFile) != count) return 0;
+    for (i = 0; i < count; i++) {
+        size_t keyLength = (size_t)asEntries[i].keyLength + 1;
+        if (fwrite(apcKeys[auOrder[i]], 1, keyLength, psFile) != keyLength) return 0;
+    }
+    return 1;
+}
+
+/*
+ * Hashes every key, sorts the bindings by bucket, and writes the file.
+ * Arguments:
+ *   - `pcPath`: where the snapshot goes
+ *   - `apcKeys`, `apvValues`: the bindings, `uCount` of them
+ * The file is written as `pcPath` followed by ".tmp" and renamed over
+ * `pcPath` once it is complete.
+ * Returns 1 on success, 0 if memory is insufficient, a write fails, or
+ * the bindings exceed the format's 32-bit counts and lengths.
+ */
+int SymTableSnapshot_write(const char *pcPath, const char *const apcKeys[],
+                           const void *const apvValues[], size_t uCount) {
+    struct SnapshotHeader sHeader;
+    struct SnapshotEntry *asEntries = NULL;
+    uint32_t *auBuckets = NULL;
+    uint32_t *auOrder = NULL;
+    uint64_t *auHashes = NULL;
+    char *pcTempPath = NULL;
+    FILE *psFile = NULL;
+    uint64_t bucketCount = 1;
+    uint64_t keyOffset = 0;
+    size_t i;
+    int iSuccessful = 0;
+
+    assert(pcPath != NULL);
+    assert(uCount == 0 || (apcKeys != NULL && apvValues != NULL));
+
+    if ((uint64_t)uCount >= UINT32_MAX) return 0;
+    while (bucketCount * ENTRIES_PER_BUCKET < uCount) bucketCount *= 2;
+
+    memset(&sHeader, 0, sizeof(sHeader));
+    memcpy(sHeader.acMagic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    sHeader.version = SNAPSHOT_VERSION;
+    sHeader.entryBytes = (uint16_t)sizeof(struct SnapshotEntry);
+    sHeader.pointerBytes = (uint16_t)sizeof(void*);
+    sHeader.byteOrderMark = BYTE_ORDER_MARK;
+    sHeader.hashSeed = SymTableHash_randomSeed();
+    sHeader.count = uCount;
+    sHeader.bucketCount = bucketCount;
+
+    asEntries = (struct SnapshotEntry*)malloc((uCount + 1) * sizeof(struct SnapshotEntry));
+    auBuckets = (uint32_t*)calloc((size_t)bucketCount + 1, sizeof(uint32_t));
+    auOrder = (uint32_t*)malloc((uCount + 1) * sizeof(uint32_t));
+    auHashes = (uint64_t*)malloc((uCount + 1) * sizeof(uint64_t));
+    pcTempPath = (char*)malloc(strlen(pcPath) + sizeof(".tmp"));
+
+    if (asEntries != NULL && auBuckets != NULL && auOrder != NULL && auHashes != NULL &&
+        pcTempPath != NULL) {
+        iSuccessful = 1;
+
+        /* Count each bucket's bindings in the slot after it, so that
+           the running sums leave each bucket's start in its own slot */
+        for (i = 0; i < uCount && iSuccessful; i++) {
+            size_t keyLength = strlen(apcKeys[i]);
+            if ((uint64_t)keyLength >= UINT32_MAX) iSuccessful = 0;
+            auHashes[i] = SymTableHash_wyhash(apcKeys[i], keyLength, sHeader.hashSeed);
+            auBuckets[(auHashes[i] & (bucketCount - 1)) + 1]++;
+        }
+        for (i = 1; i <= bucketCount; i++) auBuckets[i] += auBuckets[i - 1];
+
+        /* Place each binding at its bucket's next free entry, with
+           each bucket's start as its cursor. A full bucket's cursor
+           ends at the next bucket's start, so shifting the cursors up
+           one slot turns them back into starts */
+        for (i = 0; i < uCount && iSuccessful; i++) {
+            size_t position = auBuckets[auHashes[i] & (bucketCount - 1)]++;
+            auOrder[position] = (uint32_t)i;
+        }
+        for (i = (size_t)bucketCount; i > 0; i--) auBuckets[i] = auBuckets[i - 1];
+        auBuckets[0] = 0;
+
+        for (i = 0; i < uCount && iSuccessful; i++) {
+            size_t key = auOrder[i];
+            asEntries[i].keyOffset = keyOffset;
+            asEntries[i].value = (uint64_t)(uintptr_t)apvValues[key];
+            asEntries[i].hashCheck = (uint32_t)(auHashes[key] >> 32);
+            asEntries[i].keyLength = (uint32_t)strlen(apcKeys[key]);
+            keyOffset += (uint64_t)asEntries[i].keyLength + 1;
+        }
+
+        sHeader.bucketsOffset = symtablesnapshot_align(sizeof(sHeader));
+        sHeader.entriesOffset = symtablesnapshot_align(sHeader.bucketsOffset +
+                                                       (bucketCount + 1) * sizeof(uint32_t));
+        sHeader.keysOffset = sHeader.entriesOffset + uCount * sizeof(struct SnapshotEntry);
+        sHeader.keyBytes = keyOffset;
+        sHeader.fileBytes = sHeader.keysOffset + keyOffset;
+    }
+
+    if (iSuccessful) {
+        strcpy(pcTempPath, pcPath);
+        strcat(pcTempPath, ".tmp");
+        psFile = fopen(pcTempPath, "wb");
+        iSuccessful = psFile != NULL &&
+                      symtablesnapshot_writeSections(psFile, &sHeader, auBuckets, asEntries,
+                                                     apcKeys, auOrder);
+        if (psFile != NULL && fclose(psFile) != 0) iSuccessful = 0;
+        if (iSuccessful && rename(pcTempPath, pcPath) != 0) iSuccessful = 0;
+        if (!iSuccessful && psFile != NULL) remove(pcTempPath);
+    }
+
+    free(asEntries);
+    free(auBuckets);
+    free(auOrder);
+    free(auHashes);
+    free(pcTempPath);
+    return iSuccessful;
+}
+
+/*
+ * Tells whether a header describes a snapshot that this build can
+ * read from a file of `fileBytes` bytes: the right magic, version and
+ * machine, and sections that lie inside the file. Entries and keys are
+ * checked as they are used, so that opening reads only the header.
+ */
+static int symtablesnapshot_isValid(const struct SnapshotHeader *psHeader, uint64_t fileBytes) {
+    uint64_t bucketBytes;
+
+    if (memcmp(psHeader->acMagic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 ||
+        psHeader->version != SNAPSHOT_VERSION ||
+        psHeader->entryBytes != sizeof(struct SnapshotEntry) ||
+        psHeader->pointerBytes != sizeof(void*) ||
+        psHeader->byteOrderMark != BYTE_ORDER_MARK ||
+        psHeader->fileBytes != fileBytes) return 0;
+
+    if (psHeader->count >= UINT32_MAX || psHeader->bucketCount == 0 ||
+        psHeader->bucketCount > UINT32_MAX ||
+        (psHeader->bucketCount & (psHeader->bucketCount - 1)) != 0) return 0;
+
+    bucketBytes = (psHeader->bucketCount + 1) * sizeof(uint32_t);
+    return psHeader->bucketsOffset % 8 == 0 && psHeader->entriesOffset % 8 == 0 &&
+           psHeader->bucketsOffset >= sizeof(*psHeader) &&
+           psHeader->bucketsOffset <= fileBytes &&
+           bucketBytes <= fileBytes - psHeader->bucketsOffset &&
+           psHeader->entriesOffset <= fileBytes &&
+           psHeader->count * sizeof(struct SnapshotEntry) <= fileBytes - psHeader->entriesOffset &&
+           psHeader->keysOffset <= fileBytes &&
+           psHeader->keyBytes <= fileBytes - psHeader->keysOffset;
+}
+
+/* Maps a snapshot file read-only and checks its header.
+   Arguments -> `pcPath`: the file
+   Returns the snapshot, or NULL if the file cannot be opened or mapped
+   or is not a snapshot this build can read. */
+SymTableSnapshot_T SymTableSnapshot_open(const char *pcPath) {
+    SymTableSnapshot_T oSymTableSnapshot;
+    const struct SnapshotHeader *psHeader;
+    struct stat sStat;
+    void *pvMapping;
+    int fd;
+
+    assert(pcPath != NULL);
+
+    fd = open(pcPath, O_RDONLY);
+    if (fd < 0) return NULL;
+    if (fstat(fd, &sStat) != 0 || (size_t)sStat.st_size < sizeof(struct SnapshotHeader)) {
+        close(fd);
+        return NULL;
+    }
+    pvMapping = mmap(NULL, (size_t)sStat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (pvMapping == MAP_FAILED) return NULL;
+
+    psHeader = (const struct SnapshotHeader*)pvMapping;
+    oSymTableSnapshot = (SymTableSnapshot_T)malloc(sizeof(struct SymTableSnapshot));
+    if (oSymTableSnapshot == NULL || !symtablesnapshot_isValid(psHeader, (uint64_t)sStat.st_size)) {
+        free(oSymTableSnapshot);
+        munmap(pvMapping, (size_t)sStat.st_size);
+        return NULL;
+    }
+
+    oSymTableSnapshot->pvMapping = pvMapping;
+    oSymTableSnapshot->mappingBytes = (size_t)sStat.st_size;
+    oSymTableSnapshot->hashSeed = psHeader->hashSeed;
+    oSymTableSnapshot->count = (size_t)psHeader->count;
+    oSymTableSnapshot->bucketMask = (size_t)psHeader->bucketCount - 1;
+    oSymTableSnapshot->keyBytes = (size_t)psHeader->keyBytes;
+    oSymTableSnapshot->buckets = (const uint32_t*)((const char*)pvMapping + psHeader->bucketsOffset);
+    oSymTableSnapshot->entries =
+        (const struct SnapshotEntry*)((const char*)pvMapping + psHeader->entriesOffset);
+    oSymTableSnapshot->keys = (const char*)pvMapping + psHeader->keysOffset;
+    return oSymTableSnapshot;
+}
+
+/* Unmaps the file and frees the handle.
+   Arguments -> `oSymTableSnapshot`: the snapshot to be closed */
+void SymTableSnapshot_close(SymTableSnapshot_T oSymTableSnapshot) {
+    assert(oSymTableSnapshot != NULL);
+
+    munmap(oSymTableSnapshot->pvMapping, oSymTableSnapshot->mappingBytes);
+    free(oSymTableSnapshot);
+}
+
+/* Returns the number of bindings.
+   Arguments -> `oSymTableSnapshot`: the snapshot */
+size_t SymTableSnapshot_getLength(SymTableSnapshot_T oSymTableSnapshot) {
+    assert(oSymTableSnapshot != NULL);
+    return oSymTableSnapshot->count;
+}
+
+/*
+ * Tells whether an entry's key lies inside the keys section and ends
+ * with its '\0'. A damaged file then fails lookups instead of sending
+ * them outside the mapping.
+ */
+static int symtablesnapshot_keyFits(SymTableSnapshot_T oSymTableSnapshot,
+                                    const struct SnapshotEntry *psEntry) {
+    return psEntry->keyOffset < oSymTableSnapshot->keyBytes &&
+           psEntry->keyLength < oSymTableSnapshot->keyBytes - psEntry->keyOffset &&
+           oSymTableSnapshot->keys[psEntry->keyOffset + psEntry->keyLength] == '\0';
+}
+
+/*
+ * Looks up a key: one hash, one index word, and the bucket's entries,
+ * each rejected by its hash check and length before its key is read.
+ * Arguments:
+ *   - `oSymTableSnapshot`: the snapshot
+ *   - `pcKey`, `uLength`: the key and its length
+ *   - `ppvValue`: receives the value when the key is found
+ * Returns 1 if the key is found, 0 otherwise.
+ */
+int SymTableSnapshot_find(SymTableSnapshot_T oSymTableSnapshot, const char *pcKey, size_t uLength,
+                          void **ppvValue) {
+    const struct SnapshotEntry *psEntry;
+    uint64_t hash;
+    uint32_t hashCheck;
+    size_t bucket, first, end;
+
+    assert(oSymTableSnapshot != NULL);
+    assert(pcKey != NULL);
+    assert(ppvValue != NULL);
+
+    hash = SymTableHash_wyhash(pcKey, uLength, oSymTableSnapshot->hashSeed);
+    hashCheck = (uint32_t)(hash >> 32);
+    bucket = (size_t)hash & oSymTableSnapshot->bucketMask;
+    first = oSymTableSnapshot->buckets[bucket];
+    end = oSymTableSnapshot->buckets[bucket + 1];
+    if (end > oSymTableSnapshot->count) end = oSymTableSnapshot->count;
+
+    for (; first < end; first++) {
+        psEntry = &oSymTableSnapshot->entries[first];
+        if (psEntry->hashCheck == hashCheck && psEntry->keyLength == uLength &&
+            symtablesnapshot_keyFits(oSymTableSnapshot, psEntry) &&
+            memcmp(oSymTableSnapshot->keys + psEntry->keyOffset, pcKey, uLength) == 0) {
+            *ppvValue = (void*)(uintptr_t)psEntry->value;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Applies *pfApply to every binding, in bucket order. Entries whose
+ * key does not fit in the file are skipped.
+ * Arguments:
+ *   - `oSymTableSnapshot`: the snapshot
+ *   - `pfApply`: called as (*pfApply)(pcKey, pvValue, pvExtra)
+ *   - `pvExtra`: passed through to every call
+ */
+void SymTableSnapshot_map(SymTableSnapshot_T oSymTableSnapshot,
+                          void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+                          const void *pvExtra) {
+    const struct SnapshotEntry *psEntry;
+    size_t i;
+
+    assert(oSymTableSnapshot != NULL);
+    assert(pfApply != NULL);
+
+    for (i = 0; i < oSymTableSnapshot->count; i++) {
+        psEntry = &oSymTableSnapshot->entries[i];
+        if (symtablesnapshot_keyFits(oSymTableSnapshot, psEntry)) {
+            (*pfApply)(oSymTableSnapshot->keys + psEntry->keyOffset,
+                       (void*)(uintptr_t)psEntry->value, (void*)pvExtra);
+        }
+    }
+}
@@ -0,0 +1,67 @@
+/*--------------------------------------------------------------------*/
+/* symtablesnapshot.h                                                 */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#ifndef SymTableSnapshot_INCLUDED
+#define SymTableSnapshot_INCLUDED
+#include <stddef.h>
+
+/* A SymTableSnapshot is a set of bindings saved in a file laid out so
+that it can be searched where it lies: a bucket index, the bindings
+grouped by bucket, and the keys, all located by offsets from the start
+of the file. Opening a snapshot maps the file into memory and reads
+nothing else; lookups then touch only the pages they need, and pages
+come from the operating system's cache, shared by every process that
+maps the same file.
+
+A value is saved as the integer that its pointer converts to. That
+keeps values that are themselves offsets or indices, cast to void*, as
+they were; a pointer into the memory of the process that saved the
+snapshot means nothing to another. A snapshot is read on the kind of
+machine that wrote it: opening one written with another byte order or
+word size fails. */
+
+typedef struct SymTableSnapshot *SymTableSnapshot_T;
+
+/* Writes a snapshot to the file named pcPath that binds each of the
+uCount keys apcKeys[i] to apvValues[i]. The keys must be distinct.
+The file is written under a temporary name and renamed to pcPath only
+when complete, so that a reader never maps a partial snapshot. Returns
+1 (TRUE) on success, or 0 (FALSE) if memory is insufficient, if the
+file cannot be written, or if the snapshot would hold 2^32 or more
+bindings or a key of 2^32 or more bytes. */
+
+int SymTableSnapshot_write(const char *pcPath, const char *const apcKeys[],
+   const void *const apvValues[], size_t uCount);
+
+/* Maps the snapshot in the file named pcPath and returns it. Returns
+NULL if the file cannot be opened or mapped, or is not a snapshot
+written on this kind of machine. */
+
+SymTableSnapshot_T SymTableSnapshot_open(const char *pcPath);
+
+/* Unmaps oSymTableSnapshot and frees the memory it occupies. */
+
+void SymTableSnapshot_close(SymTableSnapshot_T oSymTableSnapshot);
+
+/* Returns the number of bindings in oSymTableSnapshot. */
+
+size_t SymTableSnapshot_getLength(SymTableSnapshot_T oSymTableSnapshot);
+
+/* If oSymTableSnapshot binds the uLength bytes at pcKey, stores the
+value in *ppvValue and returns 1 (TRUE). Otherwise returns 0 (FALSE)
+and leaves *ppvValue unchanged. */
+
+int SymTableSnapshot_find(SymTableSnapshot_T oSymTableSnapshot,
+   const char *pcKey, size_t uLength, void **ppvValue);
+
+/* Applies function *pfApply to each binding in oSymTableSnapshot,
+passing pvExtra as an extra parameter. The keys passed to *pfApply
+point into the mapping. */
+
+void SymTableSnapshot_map(SymTableSnapshot_T oSymTableSnapshot,
+   void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+   const void *pvExtra);
+
+#endif
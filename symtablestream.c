@@ -0,0 +1,378 @@
+/*--------------------------------------------------------------------*/
+/* symtablestream.c                                                   */
+/* Streaming a symbol table to and from a FILE                        */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include "symtablestream.h"
+
+/*
+ * STREAM_MAGIC: The first bytes of every stream, so that a read of
+ * something else fails at once rather than somewhere in the middle.
+ */
+static const char STREAM_MAGIC[8] = {'S', 'y', 'm', 'T', 'a', 'b', 'S', 't'};
+
+/*
+ * STREAM_VERSION: The format written after the magic. A reader refuses
+ * any other.
+ */
+#define STREAM_VERSION 1
+
+/*
+ * MAX_VARINT_BYTES: The most bytes a 64-bit integer takes at 7 bits
+ * per byte.
+ */
+#define MAX_VARINT_BYTES 10
+
+/*
+ * MIN_BINDING_BYTES: The fewest bytes a binding takes in a stream: the
+ * two lengths, of an empty key and an empty value.
+ */
+#define MIN_BINDING_BYTES 2
+
+/*
+ * MAX_UNSIZED_RESERVE: The most bindings a read reserves room for
+ * before it has read them, when the stream's length is unknown, as for
+ * a pipe. Past it, the table grows with the bindings that do arrive.
+ */
+#define MAX_UNSIZED_RESERVE 65536
+
+/*
+ * FIRST_BUFFER_BYTES: The size of the scratch buffer for one key or
+ * value before any binding has needed a larger one.
+ */
+#define FIRST_BUFFER_BYTES 64
+
+/*
+ * READ_CHUNK_BYTES: How far past the bytes that have arrived a read
+ * grows its buffer for a key or value, when the stream's length is
+ * unknown and the length it declares cannot be checked.
+ */
+#define READ_CHUNK_BYTES 65536
+
+/*
+ * StreamBuffer: A scratch buffer that grows to the longest key or value
+ * it has had to hold, and no further.
+ */
+struct StreamBuffer {
+    unsigned char *pucBytes;
+    size_t capacity;
+};
+
+/*
+ * StreamWriter: The state of one SymTable_writeStream, passed through
+ * SymTable_map to each binding.
+ */
+struct StreamWriter {
+    FILE *psFile;
+    SymTableEncodeFn_T pfEncode;
+    void *pvExtra;
+    struct StreamBuffer sValue;
+    size_t written;
+    size_t expected;
+    int failed;
+};
+
+/*
+ * Makes sure that `psBuffer` holds at least `size` bytes, keeping its
+ * contents.
+ * Returns 1 on success, or 0 if memory is insufficient.
+ */
+static int symtablestream_reserve(struct StreamBuffer *psBuffer, size_t size) {
+    unsigned char *pucBytes;
+    size_t capacity;
+
+    if (psBuffer->pucBytes != NULL && size <= psBuffer->capacity) return 1;
+
+    capacity = psBuffer->capacity > 0 ? psBuffer->capacity : FIRST_BUFFER_BYTES;
+    while (capacity < size) {
+        if (capacity > SIZE_MAX / 2) {
+            capacity = size;
+            break;
+        }
+        capacity *= 2;
+    }
+    pucBytes = (unsigned char*)realloc(psBuffer->pucBytes, capacity);
+    if (pucBytes == NULL) return 0;
+    psBuffer->pucBytes = pucBytes;
+    psBuffer->capacity = capacity;
+    return 1;
+}
+
+/*
+ * Writes `value` to `psFile` as a variable-length integer: 7 bits per
+ * byte, lowest first, with the top bit set on every byte but the last.
+ * Returns 1 on success, or 0 if the bytes cannot be written.
+ */
+static int symtablestream_putVarint(FILE *psFile, uint64_t value) {
+    unsigned char aucBytes[MAX_VARINT_BYTES];
+    size_t length = 0;
+
+    while (value >= 0x80) {
+        aucBytes[length++] = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    aucBytes[length++] = (unsigned char)value;
+    return fwrite(aucBytes, 1, length, psFile) == length;
+}
+
+/*
+ * Reads a variable-length integer that symtablestream_putVarint wrote
+ * from `psFile` into `*pValue`.
+ * Returns 1 on success, or 0 if the stream ends first or the integer
+ * does not fit in 64 bits.
+ */
+static int symtablestream_getVarint(FILE *psFile, uint64_t *pValue) {
+    uint64_t value = 0;
+    unsigned shift = 0;
+    int iChar;
+
+    for (;;) {
+        iChar = getc_unlocked(psFile);
+        if (iChar == EOF) return 0;
+        if (shift == 63 && (iChar & 0x7e) != 0) return 0;
+        value |= (uint64_t)(iChar & 0x7f) << shift;
+        if ((iChar & 0x80) == 0) break;
+        shift += 7;
+        if (shift > 63) return 0;
+    }
+    *pValue = value;
+    return 1;
+}
+
+/*
+ * Writes one binding to the stream of the StreamWriter that `pvExtra`
+ * points to, for SymTable_map. After a failure, the remaining bindings
+ * are skipped.
+ */
+static void symtablestream_writeBinding(const char *pcKey, void *pvValue, void *pvExtra) {
+    struct StreamWriter *psWriter = (struct StreamWriter*)pvExtra;
+    size_t keyLength, valueLength = 0;
+
+    if (psWriter->failed) return;
+
+    /* A binding beyond the announced count would make the stream
+       unreadable */
+    if (psWriter->written == psWriter->expected) {
+        psWriter->failed = 1;
+        return;
+    }
+
+    if (psWriter->pfEncode != NULL) {
+        valueLength = (*psWriter->pfEncode)(pvValue, psWriter->sValue.pucBytes,
+                                            psWriter->sValue.capacity, psWriter->pvExtra);
+        if (valueLength == (size_t)-1) {
+            psWriter->failed = 1;
+            return;
+        }
+        if (valueLength > psWriter->sValue.capacity) {
+            if (!symtablestream_reserve(&psWriter->sValue, valueLength) ||
+                (*psWriter->pfEncode)(pvValue, psWriter->sValue.pucBytes,
+                                      psWriter->sValue.capacity, psWriter->pvExtra) != valueLength) {
+                psWriter->failed = 1;
+                return;
+            }
+        }
+    }
+
+    keyLength = strlen(pcKey);
+    if (!symtablestream_putVarint(psWriter->psFile, keyLength) ||
+        fwrite(pcKey, 1, keyLength, psWriter->psFile) != keyLength ||
+        !symtablestream_putVarint(psWriter->psFile, valueLength) ||
+        fwrite(psWriter->sValue.pucBytes, 1, valueLength, psWriter->psFile) != valueLength) {
+        psWriter->failed = 1;
+        return;
+    }
+    psWriter->written++;
+}
+
+/*
+ * Writes every binding of a table to a stream.
+ * Arguments:
+ *   - `oSymTable`: the symbol table, in any form
+ *   - `psFile`: the stream to write to
+ *   - `pfEncode`: encodes each value, or NULL to write empty values
+ *   - `pvExtra`: passed to `pfEncode`
+ * The header announces SymTable_getLength bindings, and the write
+ * fails if SymTable_map visits any other number.
+ * Returns 1 on success, or 0 on any failure.
+ */
+int SymTable_writeStream(SymTable_T oSymTable, FILE *psFile,
+                         SymTableEncodeFn_T pfEncode, void *pvExtra) {
+    struct StreamWriter sWriter;
+
+    assert(oSymTable != NULL);
+    assert(psFile != NULL);
+
+    sWriter.psFile = psFile;
+    sWriter.pfEncode = pfEncode;
+    sWriter.pvExtra = pvExtra;
+    sWriter.sValue.pucBytes = NULL;
+    sWriter.sValue.capacity = 0;
+    sWriter.written = 0;
+    sWriter.expected = SymTable_getLength(oSymTable);
+    sWriter.failed = !symtablestream_reserve(&sWriter.sValue, FIRST_BUFFER_BYTES);
+
+    /* Hold the stream's lock once instead of once per call */
+    flockfile(psFile);
+    if (!sWriter.failed) {
+        sWriter.failed = fwrite(STREAM_MAGIC, 1, sizeof(STREAM_MAGIC), psFile) != sizeof(STREAM_MAGIC) ||
+                         !symtablestream_putVarint(psFile, STREAM_VERSION) ||
+                         !symtablestream_putVarint(psFile, sWriter.expected);
+    }
+    if (!sWriter.failed) {
+        SymTable_map(oSymTable, symtablestream_writeBinding, &sWriter);
+    }
+    funlockfile(psFile);
+
+    free(sWriter.sValue.pucBytes);
+    if (sWriter.failed || sWriter.written != sWriter.expected) return 0;
+    return fflush(psFile) == 0;
+}
+
+/*
+ * Finds how many bytes of `psFile` are left to read.
+ * Returns 1 and stores them in `*pLeft` if `psFile` is a regular file,
+ * or returns 0 if its length is unknown, as for a pipe.
+ */
+static int symtablestream_bytesLeft(FILE *psFile, uint64_t *pLeft) {
+    struct stat sStat;
+    off_t position;
+
+    position = ftello(psFile);
+    if (position < 0 || fstat(fileno(psFile), &sStat) != 0 || !S_ISREG(sStat.st_mode)) return 0;
+    *pLeft = sStat.st_size > position ? (uint64_t)(sStat.st_size - position) : 0;
+    return 1;
+}
+
+/*
+ * Bounds the number of bindings that a stream's header announces by
+ * what the rest of `psFile` could hold, so that a damaged or hostile
+ * header cannot make a read reserve room for bindings that are not
+ * there. A stream that is not a regular file is trusted for no more
+ * than MAX_UNSIZED_RESERVE bindings.
+ * Returns the bound count.
+ */
+static uint64_t symtablestream_boundCount(FILE *psFile, uint64_t count) {
+    uint64_t bound = MAX_UNSIZED_RESERVE;
+
+    if (symtablestream_bytesLeft(psFile, &bound)) {
+        bound /= MIN_BINDING_BYTES;
+    }
+    return count < bound ? count : bound;
+}
+
+/*
+ * Reads the `length` bytes of a key or value from `psFile` into
+ * `psBuffer`, leaving room after them for a '\0'. The length comes
+ * from the stream, so it is trusted no further than the bytes behind
+ * it: one longer than the rest of a regular file fails before anything
+ * is allocated, and on a stream of unknown length the buffer grows
+ * READ_CHUNK_BYTES at a time as the bytes arrive.
+ * Returns 1 on success, or 0 if the stream ends first or memory is
+ * insufficient.
+ */
+static int symtablestream_readBytes(FILE *psFile, struct StreamBuffer *psBuffer, uint64_t length) {
+    uint64_t left;
+    size_t done = 0, step;
+
+    if (length >= SIZE_MAX) return 0;
+    if (symtablestream_bytesLeft(psFile, &left)) {
+        return length <= left && symtablestream_reserve(psBuffer, (size_t)length + 1) &&
+               fread(psBuffer->pucBytes, 1, (size_t)length, psFile) == length;
+    }
+
+    do {
+        step = length - done < READ_CHUNK_BYTES ? (size_t)(length - done) : READ_CHUNK_BYTES;
+        if (!symtablestream_reserve(psBuffer, done + step + 1) ||
+            fread(psBuffer->pucBytes + done, 1, step, psFile) != step) {
+            return 0;
+        }
+        done += step;
+    } while (done < length);
+    return 1;
+}
+
+/*
+ * Reads the bindings that SymTable_writeStream wrote into a table.
+ * Arguments:
+ *   - `oSymTable`: the symbol table to add them to
+ *   - `psFile`: the stream to read from
+ *   - `pfDecode`: decodes each value, or NULL to bind NULL
+ *   - `pfRelease`: releases a decoded value that could not be bound,
+ *     or NULL if values need no releasing
+ *   - `pvExtra`: passed to `pfDecode` and `pfRelease`
+ * A frozen or mapped table is refused before anything is read, and a
+ * key already bound is caught before its value is decoded; only a put
+ * that runs out of memory leaves a decoded value to `pfRelease`.
+ * Returns 1 on success, or 0 on any failure.
+ */
+int SymTable_readStream(SymTable_T oSymTable, FILE *psFile, SymTableDecodeFn_T pfDecode,
+                        SymTableReleaseFn_T pfRelease, void *pvExtra) {
+    struct StreamBuffer sKey = {NULL, 0};
+    struct StreamBuffer sValue = {NULL, 0};
+    char acMagic[sizeof(STREAM_MAGIC)];
+    uint64_t version, count, reserve, keyLength, valueLength, i;
+    size_t length;
+    void *pvValue;
+    int iSuccessful = 0;
+
+    assert(oSymTable != NULL);
+    assert(psFile != NULL);
+
+    if (SymTable_isImmutable(oSymTable)) return 0;
+
+    flockfile(psFile);
+    if (fread(acMagic, 1, sizeof(acMagic), psFile) != sizeof(acMagic) ||
+        memcmp(acMagic, STREAM_MAGIC, sizeof(STREAM_MAGIC)) != 0 ||
+        !symtablestream_getVarint(psFile, &version) || version != STREAM_VERSION ||
+        !symtablestream_getVarint(psFile, &count)) {
+        funlockfile(psFile);
+        return 0;
+    }
+
+    /* The count is only a hint for the reserve; the loop below stops
+       where the bindings do */
+    reserve = symtablestream_boundCount(psFile, count);
+    length = SymTable_getLength(oSymTable);
+    SymTable_reserve(oSymTable, reserve < SIZE_MAX - length ? length + (size_t)reserve : SIZE_MAX);
+
+    for (i = 0; i < count; i++) {
+        if (!symtablestream_getVarint(psFile, &keyLength) ||
+            !symtablestream_readBytes(psFile, &sKey, keyLength) ||
+            memchr(sKey.pucBytes, '\0', (size_t)keyLength) != NULL) {
+            break;
+        }
+        sKey.pucBytes[keyLength] = '\0';
+        if (SymTable_contains(oSymTable, (const char*)sKey.pucBytes)) break;
+
+        if (!symtablestream_getVarint(psFile, &valueLength) ||
+            !symtablestream_readBytes(psFile, &sValue, valueLength)) {
+            break;
+        }
+        pvValue = NULL;
+        if (pfDecode != NULL &&
+            !(*pfDecode)(sValue.pucBytes, (size_t)valueLength, &pvValue, pvExtra)) {
+            break;
+        }
+        if (!SymTable_put(oSymTable, (const char*)sKey.pucBytes, pvValue)) {
+            if (pfRelease != NULL) (*pfRelease)(pvValue, pvExtra);
+            break;
+        }
+    }
+    iSuccessful = i == count;
+    funlockfile(psFile);
+
+    free(sKey.pucBytes);
+    free(sValue.pucBytes);
+    return iSuccessful;
+}
@@ -0,0 +1,77 @@
+/*--------------------------------------------------------------------*/
+/* symtablestream.h                                                   */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#ifndef SymTableStream_INCLUDED
+#define SymTableStream_INCLUDED
+#include <stdio.h>
+#include "symtablehash.h"
+
+/* Writing a SymTable to a stream and reading it back, one binding at a
+time, so that neither side needs a second copy of the table. The
+stream holds a short header with the number of bindings, then each
+binding as the length of its key, the key, the length of its encoded
+value and the encoded value, every length a variable-length integer.
+The bytes go through the FILE's own buffer; set its size with setvbuf
+before the first call to move the stream in larger or smaller chunks.
+Beyond that buffer, memory grows only with the longest key or encoded
+value. A file descriptor can be streamed through fdopen. */
+
+/* A function that encodes pvValue as bytes: it stores the encoding in
+the uSize bytes at pvBuffer if it fits, and returns its length in
+either case. If the length exceeds uSize, the function is called again
+with a buffer of that size. To give up, it returns (size_t)-1.
+pvExtra is the caller's extra parameter. */
+
+typedef size_t (*SymTableEncodeFn_T)(const void *pvValue, void *pvBuffer,
+   size_t uSize, void *pvExtra);
+
+/* A function that decodes the uLength bytes at pvBuffer, which a
+SymTableEncodeFn_T produced, into a value stored in *ppvValue. Returns
+1 (TRUE) on success, or 0 (FALSE) to stop the read. pvExtra is the
+caller's extra parameter. */
+
+typedef int (*SymTableDecodeFn_T)(const void *pvBuffer, size_t uLength,
+   void **ppvValue, void *pvExtra);
+
+/* A function that releases pvValue, which a SymTableDecodeFn_T
+produced but which could not be bound. pvExtra is the caller's extra
+parameter. */
+
+typedef void (*SymTableReleaseFn_T)(void *pvValue, void *pvExtra);
+
+/* Writes every binding of oSymTable to psFile, encoding each value
+with *pfEncode, or as no bytes at all if pfEncode is NULL. pvExtra is
+passed to *pfEncode. The table may be mutable, frozen or mapped, and
+must not change during the write. psFile is flushed at the end.
+Returns 1 (TRUE) on success, or 0 (FALSE) if memory is insufficient,
+if *pfEncode gives up, or if psFile cannot be written. */
+
+int SymTable_writeStream(SymTable_T oSymTable, FILE *psFile,
+   SymTableEncodeFn_T pfEncode, void *pvExtra);
+
+/* Reads bindings that SymTable_writeStream wrote from psFile and puts
+them into oSymTable, decoding each value with *pfDecode, or leaving it
+NULL if pfDecode is NULL. A value that was decoded but could not be
+bound, because memory ran out, is passed to *pfRelease unless pfRelease
+is NULL. pvExtra is passed to both. The table is first grown, with
+SymTable_reserve, to hold the bindings that the header announces, but
+no more than the rest of psFile could hold, or than a modest number if
+psFile is not a regular file; past that it grows as usual. Likewise a
+key or value longer than the rest of a regular file is refused before
+any memory is set aside for it, and one read from any other stream
+takes memory only as its bytes arrive. Reading stops right after the
+last binding, leaving psFile positioned there.
+Returns 1 (TRUE) on success. Returns 0 (FALSE) without reading anything
+if oSymTable is frozen or mapped. Returns 0 (FALSE) if psFile ends
+early or does not hold a written table, if a key is already bound in
+oSymTable, if *pfDecode fails, or if memory is insufficient; the
+bindings read until then stay in oSymTable, so that their values can
+be released. */
+
+int SymTable_readStream(SymTable_T oSymTable, FILE *psFile,
+   SymTableDecodeFn_T pfDecode, SymTableReleaseFn_T pfRelease,
+   void *pvExtra);
+
+#endif
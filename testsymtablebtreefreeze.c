@@ -0,0 +1,361 @@
+/*--------------------------------------------------------------------*/
+/* testsymtablebtreefreeze.c                                          */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#include "symtable.h"
+#include "symtablebtree.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* The longest key that the tests build. */
+
+enum {MAX_KEY_LENGTH = 48};
+
+/* How many namespaces the keys are spread over. */
+
+enum {NAMESPACE_COUNT = 12};
+
+/*--------------------------------------------------------------------*/
+
+/* What a visit of the bindings expects and has seen so far. A NULL
+   bound or prefix selects everything. */
+
+struct Visit
+{
+   /* The range that every visited key must lie in */
+   const char *pcLow;
+   const char *pcHigh;
+
+   /* The prefix that every visited key must begin with */
+   const char *pcPrefix;
+
+   /* The last key visited, or NULL before the first */
+   const char *pcLast;
+
+   /* How many bindings were visited */
+   int iCount;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) if pcKey lies in the range and has the prefix that
+   psVisit selects, 0 (FALSE) otherwise. */
+
+static int isSelected(const struct Visit *psVisit, const char *pcKey)
+{
+   if (psVisit->pcLow != NULL && strcmp(pcKey, psVisit->pcLow) < 0)
+      return 0;
+   if (psVisit->pcHigh != NULL && strcmp(pcKey, psVisit->pcHigh) >= 0)
+      return 0;
+   if (psVisit->pcPrefix != NULL &&
+      strncmp(pcKey, psVisit->pcPrefix, strlen(psVisit->pcPrefix)) != 0)
+      return 0;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Check that pcKey is selected by the struct Visit that pvExtra points
+   to, that it follows the last key visited and that pvValue is the
+   key's own string, and count it. */
+
+static void checkVisit(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   struct Visit *psVisit = (struct Visit*)pvExtra;
+
+   ASSURE(isSelected(psVisit, pcKey));
+   ASSURE(psVisit->pcLast == NULL || strcmp(psVisit->pcLast, pcKey) < 0);
+   ASSURE(strcmp((const char*)pvValue, pcKey) == 0);
+   psVisit->pcLast = pcKey;
+   psVisit->iCount++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Start a visit that selects the keys in [pcLow, pcHigh) that begin
+   with pcPrefix. */
+
+static void startVisit(struct Visit *psVisit, const char *pcLow,
+   const char *pcHigh, const char *pcPrefix)
+{
+   psVisit->pcLow = pcLow;
+   psVisit->pcHigh = pcHigh;
+   psVisit->pcPrefix = pcPrefix;
+   psVisit->pcLast = NULL;
+   psVisit->iCount = 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return how many of the first iBindingCount keys of pcKeys that are
+   not removed the visit psVisit selects. abRemoved tells which are
+   removed. */
+
+static int countSelected(const struct Visit *psVisit,
+   const char *pcKeys, const char *abRemoved, int iBindingCount)
+{
+   int iCount = 0;
+   int i;
+
+   for (i = 0; i < iBindingCount; i++)
+      if (! abRemoved[i] &&
+         isSelected(psVisit, pcKeys + (size_t)i * MAX_KEY_LENGTH))
+         iCount++;
+   return iCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test freezing empty tables and tables of one to a few bindings:
+   every shape of a small implicit tree, and awkward keys that differ
+   only past their first eight bytes or are prefixes of one another. */
+
+static void testSmallTables(void)
+{
+   static const char *apcKeys[] =
+   {
+      "", "a", "ab", "abcdefg", "abcdefgh", "abcdefgh0", "abcdefghi",
+      "abcdefghij", "abcdefgi", "b", "\x7f", "\x80", "\xff", "\xff\xff"
+   };
+   enum {KEY_COUNT = sizeof(apcKeys) / sizeof(apcKeys[0])};
+   SymTable_T oSymTable;
+   struct Visit sVisit;
+   int iCount;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing small frozen tables.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   for (iCount = 0; iCount <= KEY_COUNT; iCount++)
+   {
+      oSymTable = SymTable_new();
+      ASSURE(oSymTable != NULL);
+      if (oSymTable == NULL)
+         continue;
+      for (i = iCount - 1; i >= 0; i--)
+         ASSURE(SymTable_put(oSymTable, apcKeys[i], apcKeys[i]));
+      ASSURE(SymTable_freeze(oSymTable));
+      ASSURE(SymTable_getLength(oSymTable) == (size_t)iCount);
+
+      for (i = 0; i < KEY_COUNT; i++)
+      {
+         ASSURE(SymTable_contains(oSymTable, apcKeys[i]) == (i < iCount));
+         ASSURE(SymTable_get(oSymTable, apcKeys[i]) ==
+            (i < iCount ? apcKeys[i] : NULL));
+      }
+      ASSURE(! SymTable_contains(oSymTable, "abcdef"));
+      ASSURE(! SymTable_contains(oSymTable, "abcdefgh1"));
+      ASSURE(! SymTable_contains(oSymTable, "\xff\xff\xff"));
+
+      startVisit(&sVisit, NULL, NULL, NULL);
+      SymTable_map(oSymTable, checkVisit, &sVisit);
+      ASSURE(sVisit.iCount == iCount);
+
+      startVisit(&sVisit, NULL, NULL, "abcdefgh");
+      SymTable_mapPrefix(oSymTable, "abcdefgh", checkVisit, &sVisit);
+      ASSURE(sVisit.iCount == (iCount > 7 ? 4 : iCount > 4 ?
+         iCount - 4 : 0));
+
+      startVisit(&sVisit, "\x80", NULL, NULL);
+      SymTable_mapRange(oSymTable, "\x80", NULL, checkVisit, &sVisit);
+      ASSURE(sVisit.iCount == (iCount > 11 ? iCount - 11 : 0));
+
+      SymTable_free(oSymTable);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test freezing a table of iBindingCount namespaced keys, every third
+   one removed before the freeze: every binding stays findable, absent
+   keys stay absent, SymTable_map, SymTable_mapRange and
+   SymTable_mapPrefix select what they did before, and every change
+   fails and changes nothing. */
+
+static void testFrozenTable(int iBindingCount)
+{
+   static const char *apcRanges[][2] =
+   {
+      {NULL, NULL}, {"ns3::", NULL}, {NULL, "ns3::"}, {"ns3::", "ns5::"},
+      {"ns1", "ns1~"}, {"ns4::", "ns4::"}, {"ns5::", "ns3::"},
+      {"ns2::detail::symbol_1", "ns2::detail::symbol_2"}, {"zz", NULL},
+      {NULL, ""}
+   };
+   static const char *apcPrefixes[] =
+   {
+      "", "ns", "ns1", "ns1::", "ns7::detail::symbol_1",
+      "ns7::detail::symbol_1x", "ns12::", "zz"
+   };
+   enum {RANGE_COUNT = sizeof(apcRanges) / sizeof(apcRanges[0]),
+      PREFIX_COUNT = sizeof(apcPrefixes) / sizeof(apcPrefixes[0])};
+   SymTable_T oSymTable;
+   struct Visit sVisit;
+   char *pcKeys;
+   char *abRemoved;
+   char *pcKey;
+   char acMiss[MAX_KEY_LENGTH + 1];
+   int iRemoved = 0;
+   int iTruncated;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a large frozen table.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   pcKeys = (char*)malloc((size_t)iBindingCount * MAX_KEY_LENGTH + 1);
+   abRemoved = (char*)calloc((size_t)iBindingCount + 1, 1);
+   ASSURE(oSymTable != NULL && pcKeys != NULL && abRemoved != NULL);
+   if (oSymTable == NULL || pcKeys == NULL || abRemoved == NULL)
+      return;
+
+   /* Keys go in from the last, so that the tree splits every way */
+   for (i = 0; i < iBindingCount; i++)
+      sprintf(pcKeys + (size_t)i * MAX_KEY_LENGTH,
+         "ns%d::detail::symbol_%d", i % NAMESPACE_COUNT,
+         i / NAMESPACE_COUNT);
+   for (i = iBindingCount - 1; i >= 0; i--)
+   {
+      pcKey = pcKeys + (size_t)i * MAX_KEY_LENGTH;
+      ASSURE(SymTable_put(oSymTable, pcKey, pcKey));
+   }
+   for (i = 0; i < iBindingCount; i += 3)
+   {
+      ASSURE(SymTable_remove(oSymTable,
+         pcKeys + (size_t)i * MAX_KEY_LENGTH) != NULL);
+      abRemoved[i] = 1;
+      iRemoved++;
+   }
+
+   ASSURE(SymTable_freeze(oSymTable));
+   ASSURE(SymTable_freeze(oSymTable));
+   ASSURE(SymTable_getLength(oSymTable) ==
+      (size_t)(iBindingCount - iRemoved));
+
+   for (i = 0; i < iBindingCount; i++)
+   {
+      pcKey = pcKeys + (size_t)i * MAX_KEY_LENGTH;
+      ASSURE(SymTable_contains(oSymTable, pcKey) == ! abRemoved[i]);
+      ASSURE(SymTable_get(oSymTable, pcKey) ==
+         (abRemoved[i] ? NULL : pcKey));
+      sprintf(acMiss, "%s#", pcKey);
+      ASSURE(! SymTable_contains(oSymTable, acMiss));
+
+      /* Without its last digit, the key of symbol j is that of symbol
+         j / 10, which shares all but one byte with it and its
+         neighbours, or no key at all */
+      strcpy(acMiss, pcKey);
+      acMiss[strlen(acMiss) - 1] = '\0';
+      iTruncated = i % NAMESPACE_COUNT +
+         i / NAMESPACE_COUNT / 10 * NAMESPACE_COUNT;
+      ASSURE(SymTable_contains(oSymTable, acMiss) ==
+         (i >= 10 * NAMESPACE_COUNT && ! abRemoved[iTruncated]));
+   }
+   ASSURE(! SymTable_contains(oSymTable, ""));
+   ASSURE(! SymTable_contains(oSymTable, "ns"));
+   ASSURE(! SymTable_contains(oSymTable, "ns1::det"));
+   ASSURE(SymTable_get(oSymTable, "zz") == NULL);
+
+   for (i = 0; i < RANGE_COUNT; i++)
+   {
+      startVisit(&sVisit, apcRanges[i][0], apcRanges[i][1], NULL);
+      SymTable_mapRange(oSymTable, apcRanges[i][0], apcRanges[i][1],
+         checkVisit, &sVisit);
+      ASSURE(sVisit.iCount ==
+         countSelected(&sVisit, pcKeys, abRemoved, iBindingCount));
+   }
+   for (i = 0; i < PREFIX_COUNT; i++)
+   {
+      startVisit(&sVisit, NULL, NULL, apcPrefixes[i]);
+      SymTable_mapPrefix(oSymTable, apcPrefixes[i], checkVisit,
+         &sVisit);
+      ASSURE(sVisit.iCount ==
+         countSelected(&sVisit, pcKeys, abRemoved, iBindingCount));
+   }
+
+   /* Every change fails and changes nothing */
+   if (iBindingCount > 0)
+   {
+      pcKey = pcKeys;
+      ASSURE(! SymTable_put(oSymTable, pcKey, pcKey));
+      ASSURE(! SymTable_contains(oSymTable, pcKey));
+   }
+   if (iBindingCount > 1)
+   {
+      pcKey = pcKeys + MAX_KEY_LENGTH;
+      ASSURE(SymTable_replace(oSymTable, pcKey, "") == NULL);
+      ASSURE(SymTable_remove(oSymTable, pcKey) == NULL);
+      ASSURE(SymTable_get(oSymTable, pcKey) == pcKey);
+   }
+   ASSURE(SymTable_getLength(oSymTable) ==
+      (size_t)(iBindingCount - iRemoved));
+   startVisit(&sVisit, NULL, NULL, NULL);
+   SymTable_map(oSymTable, checkVisit, &sVisit);
+   ASSURE(sVisit.iCount == iBindingCount - iRemoved);
+
+   SymTable_free(oSymTable);
+   free(abRemoved);
+   free(pcKeys);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_freeze of the B+tree SymTable with argv[1] bindings.
+   Write to stdout a message for each test that fails. Exit with
+   EXIT_FAILURE if argv[1] is missing or not a non-negative number.
+   Otherwise return 0. */
+
+int main(int argc, char *argv[])
+{
+   int iBindingCount;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s bindingcount\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+
+   if (sscanf(argv[1], "%d", &iBindingCount) != 1)
+   {
+      fprintf(stderr, "bindingcount must be numeric\n");
+      exit(EXIT_FAILURE);
+   }
+   if (iBindingCount < 0)
+   {
+      fprintf(stderr, "bindingcount cannot be negative\n");
+      exit(EXIT_FAILURE);
+   }
+
+   testSmallTables();
+   testFrozenTable(iBindingCount);
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
@@ -0,0 +1,117 @@
+/*--------------------------------------------------------------------*/
+/* testsymtablecollide.c                                              */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#include "symtable.h"
+#include "symtablehashfn.h"
+#include "testsymtablecollidekeys.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*--------------------------------------------------------------------*/
+
+/* Each hashing SymTable that this client is linked with (extendible,
+   hash and HAMT) declares this in its own header, as returning a
+   SymTable whose keys are hashed with *pfHash. The cuckoo table holds
+   only a few keys with one hash, and has testsymtablecuckoocollide. */
+
+SymTable_T SymTable_newWithHash(SymTableHashFn_T pfHash);
+
+/*--------------------------------------------------------------------*/
+
+/* Count the bindings that SymTable_map visits, checking that each is
+   bound to its own key, in the int that pvExtra points to. */
+
+static void countBinding(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   ASSURE(strcmp((const char*)pvValue, pcKey) == 0);
+   (*(int*)pvExtra)++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test a table holding COLLIDING_COUNT keys that share one hash under
+   every seed, mixed with iBindingCount keys that do not: every put
+   must succeed, every key must stay reachable, and removes must find
+   keys wherever the table had to put them. */
+
+static void testCollisions(int iBindingCount)
+{
+   SymTable_T oSymTable;
+   char *pcKeys;
+   int iKeyCount = COLLIDING_COUNT + iBindingCount;
+   int iVisited = 0;
+   int i;
+
+   pcKeys = makeCollidingKeys(iBindingCount);
+   oSymTable = SymTable_newWithHash(collidingHash);
+   ASSURE(oSymTable != NULL);
+   if (oSymTable == NULL)
+      exit(EXIT_FAILURE);
+
+   /* Colliding keys first, then the rest, which must grow the table
+      around the colliding keys already in it */
+   for (i = 0; i < iKeyCount; i++)
+      ASSURE(SymTable_put(oSymTable, keyAt(pcKeys, i), keyAt(pcKeys, i)));
+   ASSURE(SymTable_getLength(oSymTable) == (size_t)iKeyCount);
+   for (i = 0; i < iKeyCount; i++)
+   {
+      ASSURE(SymTable_get(oSymTable, keyAt(pcKeys, i)) ==
+         keyAt(pcKeys, i));
+      ASSURE(! SymTable_put(oSymTable, keyAt(pcKeys, i), ""));
+   }
+   ASSURE(! SymTable_contains(oSymTable, "x-1"));
+   SymTable_map(oSymTable, countBinding, &iVisited);
+   ASSURE(iVisited == iKeyCount);
+
+   /* Remove every other key, then put them back */
+   for (i = 0; i < iKeyCount; i += 2)
+      ASSURE(SymTable_remove(oSymTable, keyAt(pcKeys, i)) ==
+         keyAt(pcKeys, i));
+   for (i = 0; i < iKeyCount; i++)
+      ASSURE(SymTable_contains(oSymTable, keyAt(pcKeys, i)) ==
+         (i % 2 == 1));
+   ASSURE(SymTable_getLength(oSymTable) == (size_t)(iKeyCount / 2));
+   for (i = 0; i < iKeyCount; i += 2)
+      ASSURE(SymTable_put(oSymTable, keyAt(pcKeys, i), keyAt(pcKeys, i)));
+   for (i = 0; i < iKeyCount; i++)
+      ASSURE(SymTable_get(oSymTable, keyAt(pcKeys, i)) ==
+         keyAt(pcKeys, i));
+   ASSURE(SymTable_getLength(oSymTable) == (size_t)iKeyCount);
+
+   /* Remove the colliding keys; the others must be left as they were */
+   for (i = 0; i < COLLIDING_COUNT; i++)
+      ASSURE(SymTable_remove(oSymTable, keyAt(pcKeys, i)) ==
+         keyAt(pcKeys, i));
+   ASSURE(SymTable_getLength(oSymTable) == (size_t)iBindingCount);
+   for (i = 0; i < iKeyCount; i++)
+      ASSURE(SymTable_get(oSymTable, keyAt(pcKeys, i)) ==
+         (i < COLLIDING_COUNT ? NULL : keyAt(pcKeys, i)));
+
+   SymTable_free(oSymTable);
+   free(pcKeys);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test a hashing SymTable with keys that collide under every seed,
+   alongside argv[1] keys that do not. Write to stdout a message for
+   each test that fails. Exit with EXIT_FAILURE if argv[1] is missing
+   or not a non-negative number. Otherwise return 0. */
+
+int main(int argc, char *argv[])
+{
+   int iBindingCount = getBindingCount(argc, argv);
+
+   printf("------------------------------------------------------\n");
+   printf("Testing keys that collide under every seed.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+   testCollisions(iBindingCount);
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
@@ -0,0 +1,84 @@
+/*--------------------------------------------------------------------*/
+/* testsymtablecollidekeys.c                                          */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#include "testsymtablecollidekeys.h"
+#include "symtablehashfn.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/*--------------------------------------------------------------------*/
+
+void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+uint64_t collidingHash(const char *pcKey, size_t uLength, uint64_t uSeed)
+{
+   if (uLength > 0 && pcKey[0] == 'x')
+      return 0x0123456789abcdefu;
+   return SymTableHash_siphash(pcKey, uLength, uSeed);
+}
+
+/*--------------------------------------------------------------------*/
+
+char *makeCollidingKeys(int iBindingCount)
+{
+   char *pcKeys;
+   int iKeyCount = COLLIDING_COUNT + iBindingCount;
+   int i;
+
+   pcKeys = (char*)malloc((size_t)iKeyCount * MAX_KEY_LENGTH);
+   ASSURE(pcKeys != NULL);
+   if (pcKeys == NULL)
+      exit(EXIT_FAILURE);
+
+   for (i = 0; i < iKeyCount; i++)
+   {
+      if (i < COLLIDING_COUNT)
+         sprintf(pcKeys + (size_t)i * MAX_KEY_LENGTH, "x%d", i);
+      else
+         sprintf(pcKeys + (size_t)i * MAX_KEY_LENGTH, "k%d", i);
+   }
+   return pcKeys;
+}
+
+/*--------------------------------------------------------------------*/
+
+const char *keyAt(const char *pcKeys, int iIndex)
+{
+   return pcKeys + (size_t)iIndex * MAX_KEY_LENGTH;
+}
+
+/*--------------------------------------------------------------------*/
+
+int getBindingCount(int argc, char *argv[])
+{
+   int iBindingCount;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s bindingcount\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+
+   if (sscanf(argv[1], "%d", &iBindingCount) != 1)
+   {
+      fprintf(stderr, "bindingcount must be numeric\n");
+      exit(EXIT_FAILURE);
+   }
+   if (iBindingCount < 0)
+   {
+      fprintf(stderr, "bindingcount cannot be negative\n");
+      exit(EXIT_FAILURE);
+   }
+   return iBindingCount;
+}
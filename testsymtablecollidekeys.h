@@ -0,0 +1,54 @@
+/*--------------------------------------------------------------------*/
+/* testsymtablecollidekeys.h                                          */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#ifndef TestSymTableCollideKeys_INCLUDED
+#define TestSymTableCollideKeys_INCLUDED
+#include <stddef.h>
+#include <stdint.h>
+
+/* The fixture shared by the clients that test hashing SymTables with
+keys whose hashes are equal under every seed. */
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/* The longest key that the tests build. */
+
+enum {MAX_KEY_LENGTH = 16};
+
+/* How many keys share one hash under every seed: far more than one
+bucket, page or chain of any of the tables is meant to hold. */
+
+enum {COLLIDING_COUNT = 1000};
+
+/* If !iSuccessful, print a message to stdout indicating that the test
+at line iLineNum failed. */
+
+void assure(int iSuccessful, int iLineNum);
+
+/* Returns the same hash for every key that begins with 'x', whatever
+the seed, and the SipHash of any other key. It stands in for keys
+whose collisions no seed can break. */
+
+uint64_t collidingHash(const char *pcKey, size_t uLength, uint64_t uSeed);
+
+/* Returns an array of COLLIDING_COUNT + iBindingCount keys, each
+MAX_KEY_LENGTH bytes apart: first the keys "x0", "x1", ..., which
+collidingHash sends to one hash, then iBindingCount keys that it does
+not. The caller frees the array. Exits with EXIT_FAILURE if memory is
+insufficient. */
+
+char *makeCollidingKeys(int iBindingCount);
+
+/* Returns the iIndex-th key of an array from makeCollidingKeys. */
+
+const char *keyAt(const char *pcKeys, int iIndex);
+
+/* Returns the binding count given as argv[1] of a client. Writes a
+message to stderr and exits with EXIT_FAILURE if argv[1] is missing
+or not a non-negative number. */
+
+int getBindingCount(int argc, char *argv[]);
+
+#endif
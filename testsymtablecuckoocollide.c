@@ -0,0 +1,114 @@
+/*--------------------------------------------------------------------*/
+/* testsymtablecuckoocollide.c                                        */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#include "symtable.h"
+#include "symtablecuckoo.h"
+#include "testsymtablecollidekeys.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The most keys with one hash under every seed that the table holds:
+   two four-slot buckets and an eight-slot stash. */
+
+enum {MAX_EQUAL_HASHES = 16};
+
+/*--------------------------------------------------------------------*/
+
+/* Test a table offered COLLIDING_COUNT keys that share one hash under
+   every seed, mixed with iBindingCount keys that do not: the table
+   must take a few of the colliding keys and refuse the rest without
+   changing, while every other put succeeds and every key taken stays
+   reachable. */
+
+static void testCollisions(int iBindingCount)
+{
+   SymTable_T oSymTable;
+   char *pcKeys;
+   int iKeyCount = COLLIDING_COUNT + iBindingCount;
+   int iTaken = 0;
+   int i;
+
+   pcKeys = makeCollidingKeys(iBindingCount);
+   oSymTable = SymTable_newWithHash(collidingHash);
+   ASSURE(oSymTable != NULL);
+   if (oSymTable == NULL)
+      exit(EXIT_FAILURE);
+
+   /* Colliding keys first: once two buckets and the stash are full,
+      no seed makes room for another */
+   for (i = 0; i < COLLIDING_COUNT; i++)
+   {
+      if (SymTable_put(oSymTable, keyAt(pcKeys, i), keyAt(pcKeys, i)))
+      {
+         ASSURE(i == iTaken);
+         iTaken++;
+      }
+   }
+   ASSURE(iTaken > 2 * 4 && iTaken <= MAX_EQUAL_HASHES);
+   ASSURE(SymTable_getLength(oSymTable) == (size_t)iTaken);
+
+   /* Then the rest, which must grow the table around the colliding
+      keys already in it */
+   for (i = COLLIDING_COUNT; i < iKeyCount; i++)
+      ASSURE(SymTable_put(oSymTable, keyAt(pcKeys, i), keyAt(pcKeys, i)));
+   ASSURE(SymTable_getLength(oSymTable) ==
+      (size_t)(iTaken + iBindingCount));
+   for (i = 0; i < iKeyCount; i++)
+      ASSURE(SymTable_get(oSymTable, keyAt(pcKeys, i)) ==
+         (i >= iTaken && i < COLLIDING_COUNT ? NULL : keyAt(pcKeys, i)));
+
+   /* A refused put leaves the table as it was */
+   ASSURE(! SymTable_put(oSymTable, keyAt(pcKeys, iTaken), ""));
+   ASSURE(SymTable_getLength(oSymTable) ==
+      (size_t)(iTaken + iBindingCount));
+   for (i = 0; i < iKeyCount; i++)
+      ASSURE(SymTable_contains(oSymTable, keyAt(pcKeys, i)) ==
+         (i < iTaken || i >= COLLIDING_COUNT));
+
+   /* Removing a colliding key makes room for another */
+   ASSURE(SymTable_remove(oSymTable, keyAt(pcKeys, 0)) ==
+      keyAt(pcKeys, 0));
+   ASSURE(SymTable_put(oSymTable, keyAt(pcKeys, iTaken),
+      keyAt(pcKeys, iTaken)));
+   ASSURE(SymTable_get(oSymTable, keyAt(pcKeys, iTaken)) ==
+      keyAt(pcKeys, iTaken));
+   ASSURE(! SymTable_contains(oSymTable, keyAt(pcKeys, 0)));
+
+   /* Remove the colliding keys; the others must be left as they were */
+   for (i = 1; i <= iTaken; i++)
+      ASSURE(SymTable_remove(oSymTable, keyAt(pcKeys, i)) ==
+         keyAt(pcKeys, i));
+   ASSURE(SymTable_getLength(oSymTable) == (size_t)iBindingCount);
+   for (i = COLLIDING_COUNT; i < iKeyCount; i++)
+      ASSURE(SymTable_get(oSymTable, keyAt(pcKeys, i)) ==
+         keyAt(pcKeys, i));
+
+   SymTable_free(oSymTable);
+   free(pcKeys);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the cuckoo SymTable with keys that collide under every seed,
+   alongside argv[1] keys that do not. Write to stdout a message for
+   each test that fails. Exit with EXIT_FAILURE if argv[1] is missing
+   or not a non-negative number. Otherwise return 0. */
+
+int main(int argc, char *argv[])
+{
+   int iBindingCount = getBindingCount(argc, argv);
+
+   printf("------------------------------------------------------\n");
+   printf("Testing keys that collide under every seed.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+   testCollisions(iBindingCount);
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
@@ -0,0 +1,103 @@
+/*--------------------------------------------------------------------*/
+/* testsymtableextendiblecollide.c                                    */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#include "symtable.h"
+#include "symtableextendible.h"
+#include "testsymtablecollidekeys.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/*--------------------------------------------------------------------*/
+
+/* Test the space that COLLIDING_COUNT keys sharing one hash take in a
+   table alongside iBindingCount keys that do not: the colliding keys
+   must not grow the directory past what a table of the other keys
+   alone needs, and removing them must give their pages back. That
+   every key stays reachable is tested by testsymtablecollide. */
+
+static void testSpace(int iBindingCount)
+{
+   SymTable_T oSymTable;
+   SymTable_T oControl;
+   char *pcKeys;
+   size_t uBucketCount;
+   size_t uSlotCount;
+   size_t uDirectorySize;
+   size_t uBucketsBefore;
+   size_t uControlDirectory;
+   int iKeyCount = COLLIDING_COUNT + iBindingCount;
+   int i;
+
+   pcKeys = makeCollidingKeys(iBindingCount);
+   oSymTable = SymTable_newWithHash(collidingHash);
+   oControl = SymTable_newWithHash(collidingHash);
+   ASSURE(oSymTable != NULL && oControl != NULL);
+   if (oSymTable == NULL || oControl == NULL)
+      exit(EXIT_FAILURE);
+
+   /* Colliding keys first: a split cannot part them, so they fill
+      overflow pages and leave the directory as it was */
+   for (i = 0; i < COLLIDING_COUNT; i++)
+      ASSURE(SymTable_put(oSymTable, keyAt(pcKeys, i), keyAt(pcKeys, i)));
+   SymTable_getSpaceUsage(oSymTable, &uBucketCount, &uSlotCount,
+      &uDirectorySize);
+   ASSURE(uDirectorySize == 1);
+   ASSURE(uSlotCount >= COLLIDING_COUNT);
+   ASSURE(uSlotCount / uBucketCount * (uBucketCount - 1) <
+      COLLIDING_COUNT);
+
+   /* Then the rest, which must split the colliding keys' bucket around
+      them. The luck of the seeds may leave the two directories one bit
+      apart, but the colliding keys must add no bit of their own */
+   for (i = COLLIDING_COUNT; i < iKeyCount; i++)
+   {
+      ASSURE(SymTable_put(oSymTable, keyAt(pcKeys, i), keyAt(pcKeys, i)));
+      ASSURE(SymTable_put(oControl, keyAt(pcKeys, i), keyAt(pcKeys, i)));
+   }
+   SymTable_getSpaceUsage(oControl, &uBucketCount, &uSlotCount,
+      &uControlDirectory);
+   SymTable_getSpaceUsage(oSymTable, &uBucketCount, &uSlotCount,
+      &uDirectorySize);
+   ASSURE(uDirectorySize <= 2 * uControlDirectory);
+
+   /* The colliding keys still sit in overflow pages: removing them
+      frees every page they fill, which a split would never do */
+   uBucketsBefore = uBucketCount;
+   for (i = 0; i < COLLIDING_COUNT; i++)
+      ASSURE(SymTable_remove(oSymTable, keyAt(pcKeys, i)) ==
+         keyAt(pcKeys, i));
+   SymTable_getSpaceUsage(oSymTable, &uBucketCount, &uSlotCount,
+      &uDirectorySize);
+   ASSURE(uBucketCount + (COLLIDING_COUNT - 1) / (uSlotCount /
+      uBucketCount) <= uBucketsBefore);
+   ASSURE(SymTable_getLength(oSymTable) == (size_t)iBindingCount);
+
+   SymTable_free(oControl);
+   SymTable_free(oSymTable);
+   free(pcKeys);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the space that the extendible hashing SymTable takes for keys
+   that no split can part, alongside argv[1] keys that do not collide.
+   Write to stdout a message for each test that fails. Exit with
+   EXIT_FAILURE if argv[1] is missing or not a non-negative number.
+   Otherwise return 0. */
+
+int main(int argc, char *argv[])
+{
+   int iBindingCount = getBindingCount(argc, argv);
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the space taken by keys whose hashes are equal.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+   testSpace(iBindingCount);
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
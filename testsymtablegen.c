@@ -0,0 +1,258 @@
+/*--------------------------------------------------------------------*/
+/* testsymtablegen.c                                                  */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#include "symtablekeywords.h"
+#include "testsymtablegenkeys.h"
+#include "symtable.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* The keywords of C99, as listed in symtablekeywords.txt. */
+
+static const char *const apcKeywords[] =
+{
+   "auto", "break", "case", "char", "const", "continue", "default",
+   "do", "double", "else", "enum", "extern", "float", "for", "goto",
+   "if", "inline", "int", "long", "register", "restrict", "return",
+   "short", "signed", "sizeof", "static", "struct", "switch", "typedef",
+   "union", "unsigned", "void", "volatile", "while", "_Bool",
+   "_Complex", "_Imaginary"
+};
+
+enum {KEYWORD_COUNT = sizeof(apcKeywords) / sizeof(apcKeywords[0])};
+
+/* The longest key that the tests build. */
+
+enum {MAX_KEY_LENGTH = 64};
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Check that pcKey is a keyword bound to its own text, and count it in
+   the visit counts that pvExtra points to. */
+
+static void countKeyword(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   int *piVisits = (int*)pvExtra;
+   int i;
+
+   ASSURE(pvValue != NULL && strcmp((const char*)pvValue, pcKey) == 0);
+   for (i = 0; i < KEYWORD_COUNT; i++)
+      if (strcmp(apcKeywords[i], pcKey) == 0)
+         piVisits[i]++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the generated table of C keywords: every keyword is found and
+   bound to its own text, map visits each once, and keys that differ
+   from a keyword by a byte, a case or a length are not found. */
+
+static void testKeywords(void)
+{
+   int aiVisits[KEYWORD_COUNT];
+   char acKey[MAX_KEY_LENGTH];
+   size_t uLength;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the generated keyword table.\n");
+   printf("No output except for this line should appear here.\n");
+   fflush(stdout);
+
+   ASSURE(SymTableKeywords_getLength() == KEYWORD_COUNT);
+   for (i = 0; i < KEYWORD_COUNT; i++)
+   {
+      const char *pcValue;
+      ASSURE(SymTableKeywords_contains(apcKeywords[i]));
+      pcValue = (const char*)SymTableKeywords_get(apcKeywords[i]);
+      ASSURE(pcValue != NULL && strcmp(pcValue, apcKeywords[i]) == 0);
+
+      /* Near misses: every proper prefix, one byte more, and the
+         keyword with its first letter's case changed */
+      strcpy(acKey, apcKeywords[i]);
+      uLength = strlen(acKey);
+      while (uLength-- > 0)
+      {
+         acKey[uLength] = '\0';
+         ASSURE(! SymTableKeywords_contains(acKey) ||
+            strcmp(acKey, "do") == 0);
+      }
+      sprintf(acKey, "%sx", apcKeywords[i]);
+      ASSURE(! SymTableKeywords_contains(acKey));
+      ASSURE(SymTableKeywords_get(acKey) == NULL);
+      strcpy(acKey, apcKeywords[i]);
+      acKey[0] = (char)(acKey[0] == '_' ? 'x' : acKey[0] - 'a' + 'A');
+      ASSURE(! SymTableKeywords_contains(acKey));
+   }
+
+   ASSURE(! SymTableKeywords_contains(""));
+   ASSURE(! SymTableKeywords_contains("main"));
+   ASSURE(! SymTableKeywords_contains("_Imaginary_"));
+   ASSURE(! SymTableKeywords_contains("a_name_longer_than_any_keyword"));
+
+   for (i = 0; i < KEYWORD_COUNT; i++)
+      aiVisits[i] = 0;
+   SymTableKeywords_map(countKeyword, aiVisits);
+   for (i = 0; i < KEYWORD_COUNT; i++)
+      ASSURE(aiVisits[i] == 1);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Count one binding in the count that pvExtra points to. */
+
+static void countBinding(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   (void)pcKey;
+   (void)pvValue;
+   (*(int*)pvExtra)++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the table generated from testsymtablegenkeys.txt: keys that
+   need quoting in C, keys bound to their own text, and keys bound to
+   values given in the key list, one of them a null pointer. */
+
+static void testQuotingAndValues(void)
+{
+   const char *pcLongKey =
+      "a_key_that_is_quite_a_bit_longer_than_the_rest_of_them";
+   char acKey[MAX_KEY_LENGTH];
+   int iCount;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing quoting and values in a generated table.\n");
+   printf("No output except for this line should appear here.\n");
+   fflush(stdout);
+
+   ASSURE(TestSymTableGenKeys_getLength() == 12);
+
+   /* Values given in the key list */
+   ASSURE(strcmp((char*)TestSymTableGenKeys_get("alpha"), "first") == 0);
+   ASSURE(strcmp((char*)TestSymTableGenKeys_get("beta"), "second") == 0);
+   ASSURE(strcmp((char*)TestSymTableGenKeys_get("xx"), "xx") == 0);
+   ASSURE(TestSymTableGenKeys_contains("gamma"));
+   ASSURE(TestSymTableGenKeys_get("gamma") == NULL);
+
+   /* Keys that the generator must escape */
+   ASSURE(strcmp((char*)TestSymTableGenKeys_get("quote\"mark"),
+      "quote\"mark") == 0);
+   ASSURE(strcmp((char*)TestSymTableGenKeys_get("back\\slash"),
+      "back\\slash") == 0);
+   ASSURE(TestSymTableGenKeys_contains("what?\?=trigraph"));
+   ASSURE(! TestSymTableGenKeys_contains("what#trigraph"));
+   ASSURE(TestSymTableGenKeys_contains("caf\303\251"));
+   ASSURE(TestSymTableGenKeys_contains("\303\2511"));
+   ASSURE(! TestSymTableGenKeys_contains("\303\251"));
+   ASSURE(TestSymTableGenKeys_contains("bell\007"));
+   ASSURE(! TestSymTableGenKeys_contains("bell"));
+
+   /* Lengths at and beyond the bounds */
+   ASSURE(TestSymTableGenKeys_contains("x"));
+   ASSURE(TestSymTableGenKeys_contains(pcLongKey));
+   sprintf(acKey, "%s_", pcLongKey);
+   ASSURE(! TestSymTableGenKeys_contains(acKey));
+   strcpy(acKey, pcLongKey);
+   acKey[strlen(acKey) - 1] = '\0';
+   ASSURE(! TestSymTableGenKeys_contains(acKey));
+   ASSURE(! TestSymTableGenKeys_contains(""));
+
+   /* Lines that are not keys */
+   ASSURE(! TestSymTableGenKeys_contains("#"));
+   ASSURE(! TestSymTableGenKeys_contains("\"first\""));
+
+   iCount = 0;
+   TestSymTableGenKeys_map(countBinding, &iCount);
+   ASSURE(iCount == 12);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the read-only SymTable_T that symtablegen -s wrapped around the
+   table of testsymtablegenkeys.txt: lookups agree with the prefixed
+   functions, and changes fail and change nothing. */
+
+static void testSymTable(void)
+{
+   SymTable_T oSymTable;
+   int iCount;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a generated table as a read-only SymTable_T.\n");
+   printf("No output except for this line should appear here.\n");
+   fflush(stdout);
+
+   oSymTable = TestSymTableGenKeys_getTable();
+   ASSURE(oSymTable != NULL);
+   ASSURE(oSymTable == TestSymTableGenKeys_getTable());
+   ASSURE(SymTable_new() == NULL);
+   ASSURE(SymTable_getLength(oSymTable) == 12);
+
+   ASSURE(SymTable_contains(oSymTable, "alpha"));
+   ASSURE(SymTable_get(oSymTable, "alpha") ==
+      TestSymTableGenKeys_get("alpha"));
+   ASSURE(SymTable_contains(oSymTable, "gamma"));
+   ASSURE(SymTable_get(oSymTable, "gamma") == NULL);
+   ASSURE(! SymTable_contains(oSymTable, "delta"));
+   ASSURE(SymTable_get(oSymTable, "delta") == NULL);
+
+   /* Changes fail, whether or not the key is bound */
+   ASSURE(! SymTable_put(oSymTable, "delta", "fourth"));
+   ASSURE(! SymTable_put(oSymTable, "alpha", "fourth"));
+   ASSURE(SymTable_replace(oSymTable, "alpha", "fourth") == NULL);
+   ASSURE(SymTable_replace(oSymTable, "delta", "fourth") == NULL);
+   ASSURE(SymTable_remove(oSymTable, "alpha") == NULL);
+   ASSURE(SymTable_remove(oSymTable, "delta") == NULL);
+   ASSURE(! SymTable_contains(oSymTable, "delta"));
+   ASSURE(strcmp((char*)SymTable_get(oSymTable, "alpha"), "first") == 0);
+   ASSURE(SymTable_getLength(oSymTable) == 12);
+
+   /* Freeing the table leaves it as it was */
+   SymTable_free(oSymTable);
+   iCount = 0;
+   SymTable_map(TestSymTableGenKeys_getTable(), countBinding, &iCount);
+   ASSURE(iCount == 12);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the tables that symtablegen generated at build time. Write the
+   output of the tests to stdout. The tables are fixed, so an argument,
+   if given, is ignored. Return 0. */
+
+int main(int argc, char *argv[])
+{
+   (void)argc;
+
+   testKeywords();
+   testQuotingAndValues();
+   testSymTable();
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
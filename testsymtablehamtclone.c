@@ -0,0 +1,436 @@
+/*--------------------------------------------------------------------*/
+/* testsymtablehamtclone.c                                            */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#include "symtable.h"
+#include "symtablehamt.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* The longest key that the tests build. */
+
+enum {MAX_KEY_LENGTH = 32};
+
+/* What a table binds each key of the tests to. */
+
+enum {ABSENT, BOUND_TO_KEY, BOUND_TO_EMPTY};
+
+/* How many forks testForks tries, and how many changes each makes. */
+
+enum {FORK_COUNT = 64, CHANGES_PER_FORK = 16};
+
+/*--------------------------------------------------------------------*/
+
+/* What a visit of the bindings expects and has seen so far. */
+
+struct Visit
+{
+   /* The keys of the test and what the table binds each to */
+   const char *pcKeys;
+   const char *acState;
+
+   /* How many keys there are */
+   int iKeyCount;
+
+   /* How many bindings were visited */
+   int iCount;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the same hash for every key, so that every key collides. */
+
+static uint64_t constantHash(const char *pcKey, size_t uLength,
+   uint64_t uSeed)
+{
+   (void)pcKey;
+   (void)uLength;
+   (void)uSeed;
+   return 0x5555555555555555u;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a hash that depends only on the last byte of the key, and
+   only in its top four bits, so that keys share a path down to the
+   deepest level before they part, and many still collide there. */
+
+static uint64_t deepHash(const char *pcKey, size_t uLength,
+   uint64_t uSeed)
+{
+   (void)uSeed;
+   if (uLength == 0)
+      return 0;
+   return (uint64_t)((unsigned char)pcKey[uLength - 1] & 0x0f) << 60;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the iIndex-th key of the array pcKeys. */
+
+static const char *keyAt(const char *pcKeys, int iIndex)
+{
+   return pcKeys + (size_t)iIndex * MAX_KEY_LENGTH;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Check that pvValue is what the struct Visit that pvExtra points to
+   expects pcKey to be bound to, and count the binding. */
+
+static void checkVisit(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   struct Visit *psVisit = (struct Visit*)pvExtra;
+   int iIndex;
+
+   ASSURE(sscanf(pcKey, "key%d", &iIndex) == 1);
+   ASSURE(iIndex >= 0 && iIndex < psVisit->iKeyCount);
+   if (iIndex < 0 || iIndex >= psVisit->iKeyCount)
+      return;
+   ASSURE(strcmp(keyAt(psVisit->pcKeys, iIndex), pcKey) == 0);
+   if (psVisit->acState[iIndex] == BOUND_TO_KEY)
+      ASSURE(strcmp((const char*)pvValue, pcKey) == 0);
+   else
+      ASSURE(psVisit->acState[iIndex] == BOUND_TO_EMPTY &&
+         strcmp((const char*)pvValue, "") == 0);
+   psVisit->iCount++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Check that oSymTable binds each of the iKeyCount keys of pcKeys as
+   acState says, and nothing else. */
+
+static void checkTable(SymTable_T oSymTable, const char *pcKeys,
+   const char *acState, int iKeyCount)
+{
+   struct Visit sVisit;
+   const char *pcKey;
+   int iBound = 0;
+   int i;
+
+   for (i = 0; i < iKeyCount; i++)
+   {
+      pcKey = keyAt(pcKeys, i);
+      switch (acState[i])
+      {
+         case ABSENT:
+            ASSURE(! SymTable_contains(oSymTable, pcKey));
+            ASSURE(SymTable_get(oSymTable, pcKey) == NULL);
+            break;
+         case BOUND_TO_KEY:
+            ASSURE(SymTable_get(oSymTable, pcKey) == pcKey);
+            iBound++;
+            break;
+         default:
+            ASSURE(strcmp((const char*)SymTable_get(oSymTable, pcKey), "")
+               == 0);
+            iBound++;
+            break;
+      }
+   }
+   ASSURE(SymTable_getLength(oSymTable) == (size_t)iBound);
+
+   sVisit.pcKeys = pcKeys;
+   sVisit.acState = acState;
+   sVisit.iKeyCount = iKeyCount;
+   sVisit.iCount = 0;
+   SymTable_map(oSymTable, checkVisit, &sVisit);
+   ASSURE(sVisit.iCount == iBound);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Make the change to oSymTable that rand() picks for the iIndex-th key
+   of pcKeys, checking the result against acState, which it updates. */
+
+static void changeTable(SymTable_T oSymTable, const char *pcKeys,
+   char *acState, int iIndex)
+{
+   const char *pcKey = keyAt(pcKeys, iIndex);
+   void *pvValue;
+
+   switch (rand() % 3)
+   {
+      case 0:
+         ASSURE(SymTable_put(oSymTable, pcKey, pcKey) ==
+            (acState[iIndex] == ABSENT));
+         if (acState[iIndex] == ABSENT)
+            acState[iIndex] = BOUND_TO_KEY;
+         break;
+      case 1:
+         pvValue = SymTable_replace(oSymTable, pcKey, "");
+         ASSURE((pvValue == NULL) == (acState[iIndex] == ABSENT));
+         if (acState[iIndex] != ABSENT)
+            acState[iIndex] = BOUND_TO_EMPTY;
+         break;
+      default:
+         pvValue = SymTable_remove(oSymTable, pcKey);
+         ASSURE((pvValue == NULL) == (acState[iIndex] == ABSENT));
+         acState[iIndex] = ABSENT;
+         break;
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test a table of iKeyCount keys, hashed with *pfHash, and two
+   generations of clones of it: a change to any one of them must leave
+   the others as they were, and they may be freed in any order. */
+
+static void testClones(SymTableHashFn_T pfHash, int iKeyCount)
+{
+   SymTable_T oOriginal;
+   SymTable_T oChild;
+   SymTable_T oGrandchild;
+   char *pcKeys;
+   char *acOriginal;
+   char *acChild;
+   char *acGrandchild;
+   size_t uKeyCount = (size_t)iKeyCount + 1;
+   int i;
+
+   pcKeys = (char*)malloc(uKeyCount * MAX_KEY_LENGTH);
+   acOriginal = (char*)calloc(uKeyCount, 1);
+   acChild = (char*)malloc(uKeyCount);
+   acGrandchild = (char*)malloc(uKeyCount);
+   ASSURE(pcKeys != NULL && acOriginal != NULL && acChild != NULL &&
+      acGrandchild != NULL);
+   if (pcKeys == NULL || acOriginal == NULL || acChild == NULL ||
+      acGrandchild == NULL)
+      exit(EXIT_FAILURE);
+   for (i = 0; i <= iKeyCount; i++)
+      sprintf(pcKeys + (size_t)i * MAX_KEY_LENGTH, "key%d", i);
+
+   oOriginal = pfHash != NULL ? SymTable_newWithHash(pfHash) :
+      SymTable_new();
+   ASSURE(oOriginal != NULL);
+   if (oOriginal == NULL)
+      exit(EXIT_FAILURE);
+
+   /* A clone of an empty table is empty */
+   oChild = SymTable_clone(oOriginal);
+   ASSURE(oChild != NULL);
+   if (oChild == NULL)
+      exit(EXIT_FAILURE);
+   ASSURE(SymTable_getLength(oChild) == 0);
+   SymTable_free(oChild);
+
+   for (i = 0; i < iKeyCount; i++)
+   {
+      ASSURE(SymTable_put(oOriginal, keyAt(pcKeys, i), keyAt(pcKeys, i)));
+      acOriginal[i] = BOUND_TO_KEY;
+   }
+   checkTable(oOriginal, pcKeys, acOriginal, iKeyCount);
+
+   /* Change a clone in every way; the original stays as it was */
+   oChild = SymTable_clone(oOriginal);
+   ASSURE(oChild != NULL);
+   if (oChild == NULL)
+      exit(EXIT_FAILURE);
+   memcpy(acChild, acOriginal, uKeyCount);
+   checkTable(oChild, pcKeys, acChild, iKeyCount);
+   for (i = 0; i < iKeyCount; i++)
+      if (i % 4 == 0)
+      {
+         ASSURE(SymTable_remove(oChild, keyAt(pcKeys, i)) ==
+            keyAt(pcKeys, i));
+         acChild[i] = ABSENT;
+      }
+      else if (i % 4 == 1)
+      {
+         ASSURE(SymTable_replace(oChild, keyAt(pcKeys, i), "") ==
+            keyAt(pcKeys, i));
+         acChild[i] = BOUND_TO_EMPTY;
+      }
+   checkTable(oChild, pcKeys, acChild, iKeyCount);
+   checkTable(oOriginal, pcKeys, acOriginal, iKeyCount);
+
+   /* Change the original; the clone stays as it was */
+   for (i = 0; i < iKeyCount; i += 3)
+   {
+      ASSURE(SymTable_remove(oOriginal, keyAt(pcKeys, i)) ==
+         keyAt(pcKeys, i));
+      acOriginal[i] = ABSENT;
+   }
+   ASSURE(SymTable_put(oOriginal, keyAt(pcKeys, iKeyCount), ""));
+   ASSURE(SymTable_get(oChild, keyAt(pcKeys, iKeyCount)) == NULL);
+   ASSURE(SymTable_remove(oOriginal, keyAt(pcKeys, iKeyCount)) != NULL);
+   checkTable(oOriginal, pcKeys, acOriginal, iKeyCount);
+   checkTable(oChild, pcKeys, acChild, iKeyCount);
+
+   /* A clone of a clone, outliving both */
+   oGrandchild = SymTable_clone(oChild);
+   ASSURE(oGrandchild != NULL);
+   if (oGrandchild == NULL)
+      exit(EXIT_FAILURE);
+   memcpy(acGrandchild, acChild, uKeyCount);
+   for (i = 0; i < iKeyCount; i++)
+      if (i % 2 == 0)
+      {
+         ASSURE(SymTable_put(oGrandchild, keyAt(pcKeys, i),
+            keyAt(pcKeys, i)) == (acGrandchild[i] == ABSENT));
+         acGrandchild[i] = BOUND_TO_KEY;
+      }
+   SymTable_free(oOriginal);
+   checkTable(oChild, pcKeys, acChild, iKeyCount);
+   checkTable(oGrandchild, pcKeys, acGrandchild, iKeyCount);
+
+   /* Emptying a table leaves its clone whole */
+   for (i = 0; i < iKeyCount; i++)
+      if (acChild[i] != ABSENT)
+      {
+         ASSURE(SymTable_remove(oChild, keyAt(pcKeys, i)) != NULL);
+         acChild[i] = ABSENT;
+      }
+   checkTable(oChild, pcKeys, acChild, iKeyCount);
+   checkTable(oGrandchild, pcKeys, acGrandchild, iKeyCount);
+   SymTable_free(oChild);
+   checkTable(oGrandchild, pcKeys, acGrandchild, iKeyCount);
+   SymTable_free(oGrandchild);
+
+   free(acGrandchild);
+   free(acChild);
+   free(acOriginal);
+   free(pcKeys);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the speculative use that SymTable_clone is for: fork a table of
+   iKeyCount keys, make a few random changes to the fork, and keep it
+   in place of the table or discard it, many times over. */
+
+static void testForks(int iKeyCount)
+{
+   SymTable_T oSymTable;
+   SymTable_T oFork;
+   char *pcKeys;
+   char *acState;
+   char *acFork;
+   int iFork;
+   int i;
+
+   if (iKeyCount == 0)
+      return;
+
+   pcKeys = (char*)malloc((size_t)iKeyCount * MAX_KEY_LENGTH);
+   acState = (char*)malloc((size_t)iKeyCount);
+   acFork = (char*)malloc((size_t)iKeyCount);
+   oSymTable = SymTable_new();
+   ASSURE(pcKeys != NULL && acState != NULL && acFork != NULL &&
+      oSymTable != NULL);
+   if (pcKeys == NULL || acState == NULL || acFork == NULL ||
+      oSymTable == NULL)
+      exit(EXIT_FAILURE);
+   for (i = 0; i < iKeyCount; i++)
+   {
+      sprintf(pcKeys + (size_t)i * MAX_KEY_LENGTH, "key%d", i);
+      acState[i] = ABSENT;
+      if (i % 2 == 0)
+      {
+         ASSURE(SymTable_put(oSymTable, keyAt(pcKeys, i),
+            keyAt(pcKeys, i)));
+         acState[i] = BOUND_TO_KEY;
+      }
+   }
+
+   srand(7);
+   for (iFork = 0; iFork < FORK_COUNT; iFork++)
+   {
+      oFork = SymTable_clone(oSymTable);
+      ASSURE(oFork != NULL);
+      if (oFork == NULL)
+         exit(EXIT_FAILURE);
+      memcpy(acFork, acState, (size_t)iKeyCount);
+      for (i = 0; i < CHANGES_PER_FORK; i++)
+         changeTable(oFork, pcKeys, acFork, rand() % iKeyCount);
+
+      /* Keep every third fork, dropping the table it came from */
+      if (iFork % 3 == 0)
+      {
+         SymTable_free(oSymTable);
+         oSymTable = oFork;
+         memcpy(acState, acFork, (size_t)iKeyCount);
+      }
+      else
+      {
+         SymTable_free(oFork);
+      }
+      if (iKeyCount <= 1000 || iFork % 16 == 0)
+         checkTable(oSymTable, pcKeys, acState, iKeyCount);
+   }
+   checkTable(oSymTable, pcKeys, acState, iKeyCount);
+
+   SymTable_free(oSymTable);
+   free(acFork);
+   free(acState);
+   free(pcKeys);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_clone of the HAMT SymTable with argv[1] bindings, and
+   with a few hundred bindings under hash functions that make keys
+   collide. Write to stdout a message for each test that fails. Exit
+   with EXIT_FAILURE if argv[1] is missing or not a non-negative
+   number. Otherwise return 0. */
+
+int main(int argc, char *argv[])
+{
+   int iBindingCount;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s bindingcount\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+
+   if (sscanf(argv[1], "%d", &iBindingCount) != 1)
+   {
+      fprintf(stderr, "bindingcount must be numeric\n");
+      exit(EXIT_FAILURE);
+   }
+   if (iBindingCount < 0)
+   {
+      fprintf(stderr, "bindingcount cannot be negative\n");
+      exit(EXIT_FAILURE);
+   }
+
+   printf("------------------------------------------------------\n");
+   printf("Testing clones.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+   testClones(NULL, iBindingCount);
+   testClones(constantHash, iBindingCount < 200 ? iBindingCount : 200);
+   testClones(deepHash, iBindingCount < 500 ? iBindingCount : 500);
+   testForks(iBindingCount);
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
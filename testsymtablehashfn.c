@@ -0,0 +1,649 @@
+/*--------------------------------------------------------------------*/
+/* testsymtablehashfn.c                                               */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#include "symtable.h"
+#include "symtablehash.h"
+#include "symtablehashfn.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* The longest key that the tests build. */
+
+enum {MAX_KEY_LENGTH = 32};
+
+/* The longest chain that the histograms in these tests tell apart. */
+
+enum {MAX_CHAIN_LENGTH = 64};
+
+/* A chain this much longer than the average counts as a pile-up. */
+
+enum {PILE_UP_LENGTH = 16};
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) if some chain of oSymTable is PILE_UP_LENGTH or
+   more bindings longer than the average chain, 0 (FALSE) otherwise. */
+
+static int hasPileUp(SymTable_T oSymTable)
+{
+   size_t auCounts[MAX_CHAIN_LENGTH + 1];
+   size_t uBuckets = 0;
+   size_t uLongest = 0;
+   size_t uLength;
+
+   SymTable_getChainHistogram(oSymTable, auCounts, MAX_CHAIN_LENGTH);
+   for (uLength = 0; uLength <= MAX_CHAIN_LENGTH; uLength++)
+   {
+      uBuckets += auCounts[uLength];
+      if (auCounts[uLength] != 0)
+         uLongest = uLength;
+   }
+   return uLongest >=
+      PILE_UP_LENGTH + SymTable_getLength(oSymTable) / uBuckets;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write to acKey the iIndex-th of the 2^iBlocks keys that all have
+   the same legacy hash: each block is "Aa" or "BA", which hash alike
+   because 32 * 'A' + 'a' == 32 * 'B' + 'A'. */
+
+static void makeLegacyCollision(char *acKey, int iIndex, int iBlocks)
+{
+   int i;
+
+   for (i = 0; i < iBlocks; i++)
+      strcpy(acKey + 2 * i, ((iIndex >> i) & 1) ? "BA" : "Aa");
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write to acKey a key of uLength bytes, 16 or more, whose other bytes
+   are cFill and whose bytes cancel wyhash's secrets where they meet
+   them: bytes 0-3 and 8-11 of a 16-byte key, the first eight of a
+   longer one, and the first eight of each 16-byte lane of one longer
+   than 48. While the seed went into only one side of wyhash's
+   multiplies, such keys zeroed the products and so hashed alike under
+   every seed. */
+
+static void makeSecretKey(char *acKey, size_t uLength, char cFill)
+{
+   static const unsigned char aucSecrets[3][8] =
+   {
+      {0xc9, 0xac, 0x2e, 0x96, 0x93, 0x4b, 0xb8, 0x8b},
+      {0xa3, 0xd4, 0x33, 0xd4, 0x2e, 0xa6, 0x33, 0x4b},
+      {0x47, 0xaa, 0xe1, 0x1d, 0xa5, 0x2d, 0x5a, 0x4d}
+   };
+
+   memset(acKey, cFill, uLength);
+   if (uLength == 16)
+   {
+      memcpy(acKey, aucSecrets[0] + 4, 4);
+      memcpy(acKey + 8, aucSecrets[0], 4);
+   }
+   else
+      memcpy(acKey, aucSecrets[0], 8);
+   if (uLength > 48)
+   {
+      memcpy(acKey + 16, aucSecrets[1], 8);
+      memcpy(acKey + 32, aucSecrets[2], 8);
+   }
+   acKey[uLength] = '\0';
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The first seed that weakHash was called with. */
+
+static uint64_t uWeakSeed;
+static int iWeakSeedKnown = 0;
+
+/* A hash function that sends every key to the same bucket under the
+   first seed it sees, and behaves like FNV-1a under any other seed.
+   It stands in for a hash whose collisions an attacker has found. */
+
+static uint64_t weakHash(const char *pcKey, size_t uLength,
+   uint64_t uSeed)
+{
+   if (! iWeakSeedKnown)
+   {
+      uWeakSeed = uSeed;
+      iWeakSeedKnown = 1;
+   }
+   if (uSeed == uWeakSeed)
+      return 0;
+   return SymTableHash_fnv1a(pcKey, uLength, uSeed);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the hash functions themselves. */
+
+static void testHashFunctions(void)
+{
+   const char acLong[] =
+      "_ZN4core3ops8function6FnOnce9call_once17h0123456789abcdefE";
+   char acKey[MAX_KEY_LENGTH];
+   char acOther[MAX_KEY_LENGTH];
+   char acSecret[sizeof(acLong)];
+   size_t i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable hash functions.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   /* The legacy hash is the original shift-by-5-and-add function */
+   ASSURE(SymTableHash_legacy("250", 3, 0) ==
+      (((uint64_t)'2' * 32 + '5') * 32 + '0'));
+   ASSURE(SymTableHash_legacy("2016", 4, 0) ==
+      ((((uint64_t)'2' * 32 + '0') * 32 + '1') * 32 + '6'));
+   ASSURE(SymTableHash_legacy("abc", 3, 0) ==
+      SymTableHash_legacy("abc", 3, 12345));
+
+   /* Published FNV-1a 64 values */
+   ASSURE(SymTableHash_fnv1a("", 0, 0) == 0xcbf29ce484222325ULL);
+   ASSURE(SymTableHash_fnv1a("a", 1, 0) == 0xaf63dc4c8601ec8cULL);
+
+   /* Published MurmurHash3 x86_32 values */
+   ASSURE(SymTableHash_murmur3("", 0, 0) == 0);
+   ASSURE(SymTableHash_murmur3("", 0, 1) == 0x514e28b7);
+   ASSURE(SymTableHash_murmur3("hello", 5, 0) == 0x248bfa47);
+   ASSURE(SymTableHash_murmur3("Hello, world!", 13, 1234) == 0xfaf6cdb3);
+
+   /* Every length path of the seeded hashes is deterministic, depends
+      on the seed, and depends on every byte */
+   for (i = 0; i <= sizeof(acLong) - 1; i++)
+   {
+      ASSURE(SymTableHash_wyhash(acLong, i, 7) ==
+         SymTableHash_wyhash(acLong, i, 7));
+      ASSURE(SymTableHash_wyhash(acLong, i, 7) !=
+         SymTableHash_wyhash(acLong, i, 8));
+      ASSURE(SymTableHash_siphash(acLong, i, 7) ==
+         SymTableHash_siphash(acLong, i, 7));
+      ASSURE(SymTableHash_siphash(acLong, i, 7) !=
+         SymTableHash_siphash(acLong, i, 8));
+      ASSURE(SymTableHash_crc32c(acLong, i, 7) ==
+         SymTableHash_crc32c(acLong, i, 7));
+      ASSURE(SymTableHash_crc32c(acLong, i, 7) !=
+         SymTableHash_crc32c(acLong, i, 8));
+      if (i > 0)
+      {
+         ASSURE(SymTableHash_wyhash(acLong, i, 7) !=
+            SymTableHash_wyhash(acLong, i - 1, 7));
+         ASSURE(SymTableHash_siphash(acLong, i, 7) !=
+            SymTableHash_siphash(acLong, i - 1, 7));
+         ASSURE(SymTableHash_crc32c(acLong, i, 7) !=
+            SymTableHash_crc32c(acLong, i - 1, 7));
+      }
+   }
+
+   /* The keys that collide under the legacy hash do not under the
+      seeded hashes */
+   makeLegacyCollision(acKey, 0, 8);
+   makeLegacyCollision(acOther, 255, 8);
+   ASSURE(SymTableHash_legacy(acKey, 16, 0) ==
+      SymTableHash_legacy(acOther, 16, 0));
+   ASSURE(SymTableHash_wyhash(acKey, 16, 1) !=
+      SymTableHash_wyhash(acOther, 16, 1));
+   ASSURE(SymTableHash_siphash(acKey, 16, 1) !=
+      SymTableHash_siphash(acOther, 16, 1));
+
+   /* Keys that cancel wyhash's secrets still depend on the seed, so
+      reseeding separates them */
+   makeSecretKey(acKey, 16, 'a');
+   makeSecretKey(acOther, 16, 'b');
+   ASSURE(SymTableHash_wyhash(acKey, 16, 1) !=
+      SymTableHash_wyhash(acOther, 16, 1));
+   ASSURE(SymTableHash_wyhash(acKey, 16, 1) !=
+      SymTableHash_wyhash(acKey, 16, 2));
+   makeSecretKey(acSecret, 40, 'a');
+   ASSURE(SymTableHash_wyhash(acSecret, 40, 1) !=
+      SymTableHash_wyhash(acSecret, 40, 2));
+   makeSecretKey(acSecret, sizeof(acLong) - 1, 'a');
+   ASSURE(SymTableHash_wyhash(acSecret, sizeof(acLong) - 1, 1) !=
+      SymTableHash_wyhash(acSecret, sizeof(acLong) - 1, 2));
+
+   ASSURE(SymTableHash_randomSeed() != SymTableHash_randomSeed());
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that a table reseeds when its keys pile into one chain, and
+   that it gives up reseeding when that does not help. */
+
+static void testFloodResistance(void)
+{
+   enum {FLOOD_BLOCKS = 8, FLOOD_KEYS = 1 << FLOOD_BLOCKS};
+
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   uint64_t uHash;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the flooding resistance of a SymTable.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   /* Under its first seed weakHash puts every key in one bucket; the
+      reseed spreads them out again */
+   oSymTable = SymTable_newWithHash(weakHash);
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < FLOOD_KEYS; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_put(oSymTable, acKey, oSymTable));
+   }
+   ASSURE(! hasPileUp(oSymTable));
+   for (i = 0; i < FLOOD_KEYS; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_get(oSymTable, acKey) == oSymTable);
+   }
+   ASSURE(SymTable_getLength(oSymTable) == FLOOD_KEYS);
+   SymTable_free(oSymTable);
+
+   /* The legacy hash ignores its seed, so reseeding cannot split these
+      keys up; the table must stop trying and stay correct */
+   oSymTable = SymTable_newWithHash(SymTableHash_legacy);
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < FLOOD_KEYS; i++)
+   {
+      makeLegacyCollision(acKey, i, FLOOD_BLOCKS);
+      ASSURE(SymTable_put(oSymTable, acKey, oSymTable));
+   }
+   ASSURE(hasPileUp(oSymTable));
+   for (i = 0; i < FLOOD_KEYS; i++)
+   {
+      makeLegacyCollision(acKey, i, FLOOD_BLOCKS);
+      ASSURE(SymTable_get(oSymTable, acKey) == oSymTable);
+      ASSURE(SymTable_remove(oSymTable, acKey) == oSymTable);
+   }
+   ASSURE(SymTable_getLength(oSymTable) == 0);
+   SymTable_free(oSymTable);
+
+   /* A table that takes its keys' hashes from the caller uses them
+      until it reseeds, and hashes every key itself from then on, so
+      a stale hash still finds the key */
+   oSymTable = SymTable_newWithSeed(SymTableHash_legacy, 0);
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < FLOOD_KEYS; i++)
+   {
+      makeLegacyCollision(acKey, i, FLOOD_BLOCKS);
+      uHash = SymTableHash_legacy(acKey, strlen(acKey), 0);
+      ASSURE(SymTable_putHashed(oSymTable, acKey, strlen(acKey), &uHash,
+         oSymTable));
+   }
+   for (i = 0; i < FLOOD_KEYS; i++)
+   {
+      makeLegacyCollision(acKey, i, FLOOD_BLOCKS);
+      uHash = 0;
+      ASSURE(SymTable_getHashed(oSymTable, acKey, strlen(acKey), &uHash)
+         == oSymTable);
+      ASSURE(SymTable_removeHashed(oSymTable, acKey, strlen(acKey),
+         &uHash) == oSymTable);
+   }
+   ASSURE(SymTable_getLength(oSymTable) == 0);
+   SymTable_free(oSymTable);
+
+   /* Before any reseed, the caller's hashes and the table's agree */
+   oSymTable = SymTable_newWithSeed(SymTableHash_wyhash, 5);
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < FLOOD_KEYS; i++)
+   {
+      sprintf(acKey, "%d", i);
+      uHash = SymTableHash_wyhash(acKey, strlen(acKey), 5);
+      ASSURE(SymTable_putHashed(oSymTable, acKey, strlen(acKey), &uHash,
+         acKey));
+      ASSURE(SymTable_replaceHashed(oSymTable, acKey, strlen(acKey),
+         &uHash, oSymTable) == acKey);
+   }
+   for (i = 0; i < FLOOD_KEYS; i++)
+   {
+      sprintf(acKey, "%d", i);
+      uHash = SymTableHash_wyhash(acKey, strlen(acKey), 5);
+      ASSURE(SymTable_get(oSymTable, acKey) == oSymTable);
+      ASSURE(SymTable_containsHashed(oSymTable, acKey, strlen(acKey),
+         &uHash));
+   }
+   SymTable_free(oSymTable);
+
+   /* The same keys do not collide in a default table */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < FLOOD_KEYS; i++)
+   {
+      makeLegacyCollision(acKey, i, FLOOD_BLOCKS);
+      ASSURE(SymTable_put(oSymTable, acKey, oSymTable));
+   }
+   ASSURE(! hasPileUp(oSymTable));
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that iBindingCount sequential numeric keys, the keys that
+   testLargeTable uses, spread evenly over a default table and a
+   CRC32C table, and stay findable in a read-mostly one. */
+
+static void testSequentialKeys(int iBindingCount)
+{
+   SymTable_T oSymTable;
+   SymTable_T oReadMostly;
+   SymTable_T oCrc32c;
+   char acKey[MAX_KEY_LENGTH];
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the spread of sequential keys.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   oReadMostly = SymTable_newReadMostly();
+   oCrc32c = SymTable_newWithHash(SymTableHash_crc32c);
+   ASSURE(oSymTable != NULL && oReadMostly != NULL && oCrc32c != NULL);
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_put(oSymTable, acKey, oSymTable));
+      ASSURE(SymTable_put(oReadMostly, acKey, oReadMostly));
+      ASSURE(SymTable_put(oCrc32c, acKey, oCrc32c));
+   }
+   ASSURE(! hasPileUp(oSymTable));
+   ASSURE(! hasPileUp(oCrc32c));
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_get(oSymTable, acKey) == oSymTable);
+      ASSURE(SymTable_contains(oReadMostly, acKey));
+      ASSURE(SymTable_get(oCrc32c, acKey) == oCrc32c);
+   }
+   SymTable_free(oSymTable);
+   SymTable_free(oReadMostly);
+   SymTable_free(oCrc32c);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the batch operations on a table of each kind with
+   iBindingCount keys of many lengths, every third one put twice. */
+
+static void testBatchOperations(int iBindingCount)
+{
+   SymTable_T aoSymTables[3];
+   const char **ppcKeys;
+   const void **ppvValues;
+   void **ppvFound;
+   uint64_t *puHashes;
+   size_t *puLengths;
+   int *piResults;
+   char *pcKeyText;
+   size_t uCount = (size_t)iBindingCount + (size_t)iBindingCount / 3;
+   size_t uAdded;
+   size_t u;
+   int iTable;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the batch operations of a SymTable.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   ppcKeys = (const char**)malloc(sizeof(char*) * (uCount + 1));
+   ppvValues = (const void**)malloc(sizeof(void*) * (uCount + 1));
+   ppvFound = (void**)malloc(sizeof(void*) * (uCount + 1));
+   puHashes = (uint64_t*)malloc(sizeof(uint64_t) * (uCount + 1));
+   puLengths = (size_t*)malloc(sizeof(size_t) * (uCount + 1));
+   piResults = (int*)malloc(sizeof(int) * (uCount + 1));
+   pcKeyText = (char*)malloc((size_t)MAX_KEY_LENGTH * (uCount + 1));
+   ASSURE(ppcKeys != NULL && ppvValues != NULL && ppvFound != NULL &&
+      puHashes != NULL && puLengths != NULL && piResults != NULL &&
+      pcKeyText != NULL);
+   if (ppcKeys == NULL || ppvValues == NULL || ppvFound == NULL ||
+      puHashes == NULL || puLengths == NULL || piResults == NULL ||
+      pcKeyText == NULL)
+      return;
+
+   /* Keys iBindingCount and up repeat earlier keys */
+   for (u = 0; u < uCount; u++)
+   {
+      char *pcKey = pcKeyText + u * MAX_KEY_LENGTH;
+      int iIndex = u < (size_t)iBindingCount ? (int)u :
+         (int)(u - (size_t)iBindingCount) * 3;
+      sprintf(pcKey, "%.*s%d", iIndex % 20, "abcdefghijklmnopqrst",
+         iIndex);
+      ppcKeys[u] = pcKey;
+      ppvValues[u] = pcKey;
+      puLengths[u] = strlen(pcKey);
+   }
+
+   SymTableHash_hashBatch(SymTableHash_murmur3, ppcKeys, puLengths,
+      uCount, 99, puHashes);
+   for (u = 0; u < uCount; u++)
+      ASSURE(puHashes[u] ==
+         SymTableHash_murmur3(ppcKeys[u], puLengths[u], 99));
+
+   aoSymTables[0] = SymTable_new();
+   aoSymTables[1] = SymTable_newWithHash(SymTableHash_murmur3);
+   aoSymTables[2] = SymTable_newReadMostly();
+   for (iTable = 0; iTable < 3; iTable++)
+   {
+      SymTable_T oSymTable = aoSymTables[iTable];
+      ASSURE(oSymTable != NULL);
+      if (oSymTable == NULL)
+         continue;
+
+      uAdded = SymTable_putBatch(oSymTable, ppcKeys, ppvValues, uCount,
+         piResults);
+      ASSURE(uAdded == (size_t)iBindingCount);
+      ASSURE(SymTable_getLength(oSymTable) == (size_t)iBindingCount);
+      for (u = 0; u < uCount; u++)
+         ASSURE(piResults[u] == (u < (size_t)iBindingCount));
+
+      /* A batch that mixes present and absent keys */
+      ppcKeys[uCount] = "absent";
+      SymTable_getBatch(oSymTable, ppcKeys, uCount + 1, ppvFound);
+      SymTable_containsBatch(oSymTable, ppcKeys, uCount + 1, piResults);
+      for (u = 0; u < uCount; u++)
+      {
+         i = u < (size_t)iBindingCount ? (int)u :
+            (int)(u - (size_t)iBindingCount) * 3;
+         ASSURE(ppvFound[u] == ppvValues[i]);
+         ASSURE(piResults[u] == 1);
+      }
+      ASSURE(ppvFound[uCount] == NULL);
+      ASSURE(piResults[uCount] == 0);
+
+      ASSURE(SymTable_putBatch(oSymTable, ppcKeys, ppvValues, 0, NULL)
+         == 0);
+      SymTable_free(oSymTable);
+   }
+
+   free(ppcKeys);
+   free(ppvValues);
+   free(ppvFound);
+   free(puHashes);
+   free(puLengths);
+   free(piResults);
+   free(pcKeyText);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The values that testFreeze binds: key "f<i>" is bound to
+   pcFrozenValues + i. */
+
+static char *pcFrozenValues;
+
+/* Check that pvValue is the value bound to pcKey in testFreeze, and
+   add the key's index to the long that pvExtra points to. */
+
+static void sumFrozenValues(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   char acKey[MAX_KEY_LENGTH];
+   int iIndex = (int)((char*)pvValue - pcFrozenValues);
+
+   sprintf(acKey, "f%d", iIndex);
+   ASSURE(strcmp(pcKey, acKey) == 0);
+   *(long*)pvExtra += iIndex;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test freezing an empty table, an ordinary table and a read-mostly
+   table of iBindingCount bindings, the last built on four threads:
+   every binding stays findable, absent keys stay absent, and every
+   change fails and changes nothing. */
+
+static void testFreeze(int iBindingCount)
+{
+   SymTable_T aoSymTables[3];
+   const char *apcBatch[2];
+   void *apvBatch[2];
+   int aiBatch[2];
+   char acKey[MAX_KEY_LENGTH];
+   long lSum;
+   int iTable;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing frozen SymTables.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   pcFrozenValues = (char*)malloc((size_t)iBindingCount + 1);
+   aoSymTables[0] = SymTable_new();
+   ASSURE(pcFrozenValues != NULL && aoSymTables[0] != NULL);
+   if (pcFrozenValues == NULL || aoSymTables[0] == NULL)
+      return;
+   ASSURE(SymTable_freeze(aoSymTables[0]));
+   ASSURE(SymTable_getLength(aoSymTables[0]) == 0);
+   ASSURE(! SymTable_contains(aoSymTables[0], "f0"));
+   ASSURE(SymTable_get(aoSymTables[0], "") == NULL);
+   ASSURE(! SymTable_put(aoSymTables[0], "f0", "f0"));
+   SymTable_free(aoSymTables[0]);
+
+   aoSymTables[1] = SymTable_new();
+   aoSymTables[2] = SymTable_newReadMostly();
+   for (iTable = 1; iTable < 3; iTable++)
+   {
+      SymTable_T oSymTable = aoSymTables[iTable];
+      ASSURE(oSymTable != NULL);
+      if (oSymTable == NULL)
+         continue;
+
+      for (i = 0; i < iBindingCount; i++)
+      {
+         sprintf(acKey, "f%d", i);
+         ASSURE(SymTable_put(oSymTable, acKey, pcFrozenValues + i));
+      }
+      SymTable_remove(oSymTable, "f0");
+      if (iTable == 2)
+         SymTable_setResizeThreads(oSymTable, 4);
+
+      ASSURE(SymTable_freeze(oSymTable));
+      ASSURE(SymTable_freeze(oSymTable));
+      ASSURE(SymTable_getLength(oSymTable) ==
+         (size_t)(iBindingCount > 0 ? iBindingCount - 1 : 0));
+
+      for (i = 1; i < iBindingCount; i++)
+      {
+         sprintf(acKey, "f%d", i);
+         ASSURE(SymTable_get(oSymTable, acKey) == pcFrozenValues + i);
+         ASSURE(SymTable_contains(oSymTable, acKey));
+         sprintf(acKey, "f%d#", i);
+         ASSURE(! SymTable_contains(oSymTable, acKey));
+      }
+      ASSURE(! SymTable_contains(oSymTable, "f0"));
+
+      /* Every change fails and changes nothing */
+      ASSURE(! SymTable_put(oSymTable, "f0", "f0"));
+      ASSURE(SymTable_replace(oSymTable, "f1", "f1") == NULL);
+      ASSURE(SymTable_remove(oSymTable, "f1") == NULL);
+      apcBatch[0] = "f0";
+      apcBatch[1] = "f1";
+      ASSURE(SymTable_putBatch(oSymTable, apcBatch,
+         (const void *const *)(void*)apcBatch, 2, aiBatch) == 0);
+      ASSURE(aiBatch[0] == 0 && aiBatch[1] == 0);
+      ASSURE(SymTable_getLength(oSymTable) ==
+         (size_t)(iBindingCount > 0 ? iBindingCount - 1 : 0));
+
+      SymTable_getBatch(oSymTable, apcBatch, 2, apvBatch);
+      SymTable_containsBatch(oSymTable, apcBatch, 2, aiBatch);
+      ASSURE(apvBatch[0] == NULL && aiBatch[0] == 0);
+      if (iBindingCount > 1)
+         ASSURE(apvBatch[1] == pcFrozenValues + 1 && aiBatch[1] == 1);
+
+      lSum = 0;
+      SymTable_map(oSymTable, sumFrozenValues, &lSum);
+      ASSURE(lSum == (long)iBindingCount * (iBindingCount - 1) / 2);
+      SymTable_free(oSymTable);
+   }
+   free(pcFrozenValues);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the hash functions of the hash table SymTable. Write the
+   output of the tests to stdout. argv[1] is the number of bindings in
+   the large-table test. Exit with EXIT_FAILURE if argv[1] is missing
+   or not a non-negative number. Otherwise return 0. */
+
+int main(int argc, char *argv[])
+{
+   int iBindingCount;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s bindingcount\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+
+   if (sscanf(argv[1], "%d", &iBindingCount) != 1)
+   {
+      fprintf(stderr, "bindingcount must be numeric\n");
+      exit(EXIT_FAILURE);
+   }
+   if (iBindingCount < 0)
+   {
+      fprintf(stderr, "bindingcount cannot be negative\n");
+      exit(EXIT_FAILURE);
+   }
+
+   testHashFunctions();
+   testFloodResistance();
+   testSequentialKeys(iBindingCount);
+   testBatchOperations(iBindingCount);
+   testFreeze(iBindingCount);
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
@@ -0,0 +1,978 @@
+/*--------------------------------------------------------------------*/
+/* testsymtablehashio.c                                               */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "symtable.h"
+#include "symtablehash.h"
+#include "symtablestream.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* The longest key that the tests build. */
+
+enum {MAX_KEY_LENGTH = 32};
+
+/* The longest chain that the histograms in these tests tell apart. */
+
+enum {MAX_CHAIN_LENGTH = 64};
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of buckets of oSymTable. */
+
+static size_t countBuckets(SymTable_T oSymTable)
+{
+   size_t auCounts[MAX_CHAIN_LENGTH + 1];
+   size_t uBuckets = 0;
+   size_t uLength;
+
+   SymTable_getChainHistogram(oSymTable, auCounts, MAX_CHAIN_LENGTH);
+   for (uLength = 0; uLength <= MAX_CHAIN_LENGTH; uLength++)
+      uBuckets += auCounts[uLength];
+   return uBuckets;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The file that testSnapshot saves to, and a second one that it
+   copies damaged snapshots to. */
+
+static const char *pcSnapshotPath = "testsymtablehashio.snapshot";
+static const char *pcDamagedPath = "testsymtablehashio.damaged";
+
+/* Check that pvValue is the value bound to pcKey in testSnapshot,
+   where the empty key is bound to 0, and add it to the long that
+   pvExtra points to. */
+
+static void sumSnapshotValues(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   char acKey[MAX_KEY_LENGTH];
+   long lValue = (long)(size_t)pvValue;
+
+   if (lValue == 0)
+      strcpy(acKey, "");
+   else
+      sprintf(acKey, "s%ld", lValue - 1);
+   ASSURE(strcmp(pcKey, acKey) == 0);
+   *(long*)pvExtra += lValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Copy the first uLength bytes of the file named pcFrom to the file
+   named pcTo, with the byte at uFlip, if within them, inverted.
+   Return 1 if the copy was made, and 0 otherwise. */
+
+static int copyDamaged(const char *pcFrom, const char *pcTo,
+   size_t uLength, size_t uFlip)
+{
+   FILE *psFrom;
+   FILE *psTo;
+   size_t u;
+   int iChar;
+
+   psFrom = fopen(pcFrom, "rb");
+   if (psFrom == NULL)
+      return 0;
+   psTo = fopen(pcTo, "wb");
+   if (psTo == NULL)
+   {
+      fclose(psFrom);
+      return 0;
+   }
+   for (u = 0; u < uLength && (iChar = getc(psFrom)) != EOF; u++)
+      putc(u == uFlip ? ~iChar & 0xff : iChar, psTo);
+   fclose(psFrom);
+   return fclose(psTo) == 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test saving a table of iBindingCount bindings, whose values are
+   integers, and serving it from the mapped snapshot: every binding is
+   found, absent keys stay absent, every change fails, a mapped table
+   saves anew, and files that are missing, cut short or damaged are
+   refused. */
+
+static void testSnapshot(int iBindingCount)
+{
+   SymTable_T oSymTable;
+   SymTable_T oMapped;
+   SymTable_T oResaved;
+   const char *apcBatch[2];
+   void *apvBatch[2];
+   int aiBatch[2];
+   char acKey[MAX_KEY_LENGTH];
+   long lSum;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing mapped SymTable snapshots.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   /* An empty table */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   if (oSymTable == NULL)
+      return;
+   ASSURE(SymTable_save(oSymTable, pcSnapshotPath));
+   SymTable_free(oSymTable);
+   oMapped = SymTable_openMapped(pcSnapshotPath);
+   ASSURE(oMapped != NULL);
+   if (oMapped != NULL)
+   {
+      ASSURE(SymTable_getLength(oMapped) == 0);
+      ASSURE(! SymTable_contains(oMapped, ""));
+      ASSURE(SymTable_get(oMapped, "s0") == NULL);
+      SymTable_free(oMapped);
+   }
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   if (oSymTable == NULL)
+      return;
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "s%d", i);
+      ASSURE(SymTable_put(oSymTable, acKey, (void*)(size_t)(i + 1)));
+   }
+   ASSURE(SymTable_put(oSymTable, "", (void*)(size_t)0));
+   ASSURE(SymTable_save(oSymTable, pcSnapshotPath));
+   SymTable_free(oSymTable);
+
+   oMapped = SymTable_openMapped(pcSnapshotPath);
+   ASSURE(oMapped != NULL);
+   if (oMapped == NULL)
+      return;
+   ASSURE(SymTable_getLength(oMapped) == (size_t)iBindingCount + 1);
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "s%d", i);
+      ASSURE(SymTable_get(oMapped, acKey) == (void*)(size_t)(i + 1));
+      ASSURE(SymTable_contains(oMapped, acKey));
+      sprintf(acKey, "s%d#", i);
+      ASSURE(! SymTable_contains(oMapped, acKey));
+   }
+   ASSURE(SymTable_contains(oMapped, ""));
+   ASSURE(SymTable_get(oMapped, "") == NULL);
+   ASSURE(! SymTable_contains(oMapped, "s"));
+
+   /* Every change fails and changes nothing */
+   ASSURE(! SymTable_put(oMapped, "t0", "t0"));
+   ASSURE(SymTable_replace(oMapped, "s0", "s0") == NULL);
+   ASSURE(SymTable_remove(oMapped, "s0") == NULL);
+   ASSURE(SymTable_freeze(oMapped));
+   apcBatch[0] = "t0";
+   apcBatch[1] = "s0";
+   ASSURE(SymTable_putBatch(oMapped, apcBatch,
+      (const void *const *)(void*)apcBatch, 2, aiBatch) == 0);
+   ASSURE(SymTable_getLength(oMapped) == (size_t)iBindingCount + 1);
+   SymTable_getBatch(oMapped, apcBatch, 2, apvBatch);
+   ASSURE(apvBatch[0] == NULL);
+   if (iBindingCount > 0)
+      ASSURE(apvBatch[1] == (void*)(size_t)1);
+
+   /* The empty key's value is 0, so the sum is that of the others */
+   lSum = 0;
+   SymTable_map(oMapped, sumSnapshotValues, &lSum);
+   ASSURE(lSum == (long)iBindingCount * (iBindingCount + 1) / 2);
+
+   /* Saving over the mapped file replaces it without disturbing the
+      mapping, and the new snapshot holds the same bindings */
+   ASSURE(SymTable_save(oMapped, pcSnapshotPath));
+   ASSURE(SymTable_get(oMapped, "s0") ==
+      (iBindingCount > 0 ? (void*)(size_t)1 : NULL));
+   oResaved = SymTable_openMapped(pcSnapshotPath);
+   ASSURE(oResaved != NULL);
+   if (oResaved != NULL)
+   {
+      ASSURE(SymTable_getLength(oResaved) == (size_t)iBindingCount + 1);
+      lSum = 0;
+      SymTable_map(oResaved, sumSnapshotValues, &lSum);
+      ASSURE(lSum == (long)iBindingCount * (iBindingCount + 1) / 2);
+      SymTable_free(oResaved);
+   }
+   SymTable_free(oMapped);
+
+   /* Missing, cut short and damaged files are refused */
+   ASSURE(SymTable_openMapped("testsymtablehashio.missing") == NULL);
+   ASSURE(copyDamaged(pcSnapshotPath, pcDamagedPath, 40, 40));
+   ASSURE(SymTable_openMapped(pcDamagedPath) == NULL);
+   ASSURE(copyDamaged(pcSnapshotPath, pcDamagedPath, (size_t)-1, 0));
+   ASSURE(SymTable_openMapped(pcDamagedPath) == NULL);
+   ASSURE(copyDamaged(pcSnapshotPath, pcDamagedPath, (size_t)-1, 8));
+   ASSURE(SymTable_openMapped(pcDamagedPath) == NULL);
+
+   remove(pcDamagedPath);
+   remove(pcSnapshotPath);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the size in bytes of the file named pcPath, or 0 if it cannot
+   be read. */
+
+static size_t getFileSize(const char *pcPath)
+{
+   FILE *psFile;
+   long lSize;
+
+   psFile = fopen(pcPath, "rb");
+   if (psFile == NULL)
+      return 0;
+   if (fseek(psFile, 0, SEEK_END) != 0)
+      lSize = 0;
+   else
+      lSize = ftell(psFile);
+   fclose(psFile);
+   return lSize > 0 ? (size_t)lSize : 0;
+}
+
+/* The bytes of a snapshot's header that, inverted, must make it
+   unreadable: the entry and pointer sizes, the byte order mark, the
+   file size, the top byte of the binding count, the bucket count, the
+   low and top bytes of the bucket index's offset, the low byte of the
+   entries' offset, and the top bytes of the keys' offset and size. */
+
+static const size_t auHeaderBytes[] =
+   {12, 14, 16, 24, 47, 48, 56, 63, 64, 79, 87};
+
+/* The size of a snapshot's header, past which the bindings begin. */
+
+enum {SNAPSHOT_HEADER_BYTES = 88};
+
+/* Count in the int that pvExtra points to a binding that
+   SymTable_map visits in a damaged snapshot. */
+
+static void countDamaged(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   (void)pcKey;
+   (void)pvValue;
+   (*(int*)pvExtra)++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test mapping snapshots of iBindingCount bindings that are damaged or
+   cut short: a header with any field changed and a file of any shorter
+   length are refused, and damage past the header makes lookups miss
+   but never read outside the file. */
+
+static void testDamagedSnapshot(int iBindingCount)
+{
+   SymTable_T oSymTable;
+   SymTable_T oMapped;
+   char acKey[MAX_KEY_LENGTH];
+   size_t uSize;
+   size_t uStride;
+   size_t u;
+   int iVisited;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing damaged SymTable snapshots.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   if (oSymTable == NULL)
+      return;
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "s%d", i);
+      ASSURE(SymTable_put(oSymTable, acKey, (void*)(size_t)(i + 1)));
+   }
+   ASSURE(SymTable_save(oSymTable, pcSnapshotPath));
+   SymTable_free(oSymTable);
+   uSize = getFileSize(pcSnapshotPath);
+   ASSURE(uSize > SNAPSHOT_HEADER_BYTES);
+
+   /* A damaged header */
+   for (u = 0; u < sizeof(auHeaderBytes) / sizeof(auHeaderBytes[0]); u++)
+   {
+      ASSURE(copyDamaged(pcSnapshotPath, pcDamagedPath, (size_t)-1,
+         auHeaderBytes[u]));
+      oMapped = SymTable_openMapped(pcDamagedPath);
+      ASSURE(oMapped == NULL);
+      if (oMapped != NULL)
+         SymTable_free(oMapped);
+   }
+
+   /* A file cut short anywhere, the header included */
+   uStride = uSize / 32 + 1;
+   for (u = 0; u < uSize; u += u < SNAPSHOT_HEADER_BYTES + 8 ? 1 : uStride)
+   {
+      ASSURE(copyDamaged(pcSnapshotPath, pcDamagedPath, u, (size_t)-1));
+      oMapped = SymTable_openMapped(pcDamagedPath);
+      ASSURE(oMapped == NULL);
+      if (oMapped != NULL)
+         SymTable_free(oMapped);
+   }
+
+   /* Damage past the header: the file maps, and every lookup finds its
+      binding or misses */
+   for (u = SNAPSHOT_HEADER_BYTES; u < uSize; u += uStride)
+   {
+      ASSURE(copyDamaged(pcSnapshotPath, pcDamagedPath, (size_t)-1, u));
+      oMapped = SymTable_openMapped(pcDamagedPath);
+      ASSURE(oMapped != NULL);
+      if (oMapped == NULL)
+         continue;
+      for (i = 0; i < iBindingCount; i += 1 + iBindingCount / 256)
+      {
+         sprintf(acKey, "s%d", i);
+         (void)SymTable_get(oMapped, acKey);
+      }
+      ASSURE(! SymTable_contains(oMapped, "absent"));
+      iVisited = 0;
+      SymTable_map(oMapped, countDamaged, &iVisited);
+      ASSURE(iVisited <= iBindingCount);
+      SymTable_free(oMapped);
+   }
+
+   remove(pcDamagedPath);
+   remove(pcSnapshotPath);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The longest value encoding that testStream's decoder accepts. */
+
+enum {MAX_VALUE_LENGTH = 256};
+
+/* Encode pvValue, an integer, in decimal, padded with zeros to 200
+   digits when it is a multiple of 1000 so that some encodings outgrow
+   the writer's first buffer. Give up on the integer that pvExtra, if
+   not NULL, points to. */
+
+static size_t encodeInteger(const void *pvValue, void *pvBuffer,
+   size_t uSize, void *pvExtra)
+{
+   char acDigits[MAX_VALUE_LENGTH];
+   size_t uValue = (size_t)pvValue;
+   size_t uLength;
+
+   if (pvExtra != NULL && uValue == *(size_t*)pvExtra)
+      return (size_t)-1;
+   uLength = (size_t)sprintf(acDigits, "%0*lu",
+      uValue % 1000 == 0 ? 200 : 1, (unsigned long)uValue);
+   if (uLength <= uSize)
+      memcpy(pvBuffer, acDigits, uLength);
+   return uLength;
+}
+
+/* Decode the uLength decimal digits at pvBuffer into an integer stored
+   in *ppvValue. Count the call in the int that pvExtra points to. */
+
+static int decodeInteger(const void *pvBuffer, size_t uLength,
+   void **ppvValue, void *pvExtra)
+{
+   char acDigits[MAX_VALUE_LENGTH];
+
+   (*(int*)pvExtra)++;
+   if (uLength == 0 || uLength >= MAX_VALUE_LENGTH)
+      return 0;
+   memcpy(acDigits, pvBuffer, uLength);
+   acDigits[uLength] = '\0';
+   *ppvValue = (void*)(size_t)strtoul(acDigits, NULL, 10);
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test streaming a table of iBindingCount bindings, whose values are
+   integers, out to a file and back: every binding returns with its
+   value, reading stops right after the table, a frozen table streams
+   like a mutable one, and streams that are cut short, clash with a
+   bound key or are not streams at all are refused. */
+
+static void testStream(int iBindingCount)
+{
+   SymTable_T oSymTable;
+   SymTable_T oRead;
+   FILE *psFile;
+   FILE *psShort;
+   FILE *psHeader;
+   char acKey[MAX_KEY_LENGTH + 80];
+   long lSize;
+   long l;
+   size_t uGiveUp;
+   int iDecoded;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable streams.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   oRead = SymTable_new();
+   psFile = tmpfile();
+   psShort = tmpfile();
+   ASSURE(oSymTable != NULL && oRead != NULL && psFile != NULL &&
+      psShort != NULL);
+   if (oSymTable == NULL || oRead == NULL || psFile == NULL ||
+      psShort == NULL)
+      return;
+
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "k%d", i);
+      ASSURE(SymTable_put(oSymTable, acKey, (void*)(size_t)(i + 1)));
+   }
+   memset(acKey, 'x', MAX_KEY_LENGTH + 70);
+   acKey[MAX_KEY_LENGTH + 70] = '\0';
+   ASSURE(SymTable_put(oSymTable, acKey, (void*)(size_t)7));
+
+   /* Out and back, with a byte after the table */
+   ASSURE(SymTable_writeStream(oSymTable, psFile, encodeInteger, NULL));
+   ASSURE(putc('!', psFile) == '!');
+   rewind(psFile);
+   iDecoded = 0;
+   ASSURE(SymTable_readStream(oRead, psFile, decodeInteger, NULL,
+      &iDecoded));
+   ASSURE(getc(psFile) == '!');
+   ASSURE(iDecoded == iBindingCount + 1);
+   ASSURE(SymTable_getLength(oRead) == (size_t)iBindingCount + 1);
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "k%d", i);
+      ASSURE(SymTable_get(oRead, acKey) == (void*)(size_t)(i + 1));
+   }
+   memset(acKey, 'x', MAX_KEY_LENGTH + 70);
+   ASSURE(SymTable_get(oRead, acKey) == (void*)(size_t)7);
+
+   /* Reading the same stream again clashes with the first key */
+   rewind(psFile);
+   iDecoded = 0;
+   ASSURE(! SymTable_readStream(oRead, psFile, decodeInteger, NULL,
+      &iDecoded));
+   ASSURE(iDecoded == 0);
+   ASSURE(SymTable_getLength(oRead) == (size_t)iBindingCount + 1);
+   SymTable_free(oRead);
+
+   /* Without callbacks, values are empty and come back NULL */
+   rewind(psFile);
+   ASSURE(SymTable_writeStream(oSymTable, psFile, NULL, NULL));
+   rewind(psFile);
+   oRead = SymTable_newReadMostly();
+   ASSURE(oRead != NULL);
+   if (oRead != NULL)
+   {
+      ASSURE(SymTable_readStream(oRead, psFile, NULL, NULL, NULL));
+      ASSURE(SymTable_getLength(oRead) == (size_t)iBindingCount + 1);
+      ASSURE(iBindingCount == 0 || (SymTable_contains(oRead, "k0") &&
+         SymTable_get(oRead, "k0") == NULL));
+      SymTable_free(oRead);
+   }
+
+   /* An encoder that gives up fails the write */
+   uGiveUp = 7;
+   rewind(psFile);
+   ASSURE(! SymTable_writeStream(oSymTable, psFile, encodeInteger,
+      &uGiveUp));
+
+   /* A frozen table streams the same bindings */
+   ASSURE(SymTable_freeze(oSymTable));
+   rewind(psFile);
+   ASSURE(SymTable_writeStream(oSymTable, psFile, encodeInteger, NULL));
+   lSize = ftell(psFile);
+   rewind(psFile);
+   oRead = SymTable_new();
+   ASSURE(oRead != NULL);
+   if (oRead != NULL)
+   {
+      iDecoded = 0;
+      ASSURE(SymTable_readStream(oRead, psFile, decodeInteger, NULL,
+         &iDecoded));
+      ASSURE(SymTable_getLength(oRead) == (size_t)iBindingCount + 1);
+      SymTable_free(oRead);
+   }
+
+   /* A stream cut short keeps what was read before the cut */
+   rewind(psFile);
+   for (l = 0; l < lSize - 1; l++)
+      putc(getc(psFile), psShort);
+   rewind(psShort);
+   oRead = SymTable_new();
+   ASSURE(oRead != NULL);
+   if (oRead != NULL)
+   {
+      iDecoded = 0;
+      ASSURE(! SymTable_readStream(oRead, psShort, decodeInteger, NULL,
+         &iDecoded));
+      ASSURE(SymTable_getLength(oRead) == (size_t)iBindingCount);
+      SymTable_free(oRead);
+   }
+
+   /* Something other than a stream */
+   rewind(psShort);
+   fputs("not a symbol table", psShort);
+   rewind(psShort);
+   oRead = SymTable_new();
+   ASSURE(oRead != NULL);
+   if (oRead != NULL)
+   {
+      ASSURE(! SymTable_readStream(oRead, psShort, NULL, NULL, NULL));
+      ASSURE(SymTable_getLength(oRead) == 0);
+      SymTable_free(oRead);
+   }
+
+   /* A header that announces 2^24 bindings in a file that holds none
+      must not make the table reserve room for them */
+   psHeader = tmpfile();
+   oRead = SymTable_new();
+   ASSURE(psHeader != NULL && oRead != NULL);
+   if (psHeader != NULL && oRead != NULL)
+   {
+      fwrite("SymTabSt\001\200\200\200\010", 1, 13, psHeader);
+      rewind(psHeader);
+      ASSURE(! SymTable_readStream(oRead, psHeader, NULL, NULL, NULL));
+      ASSURE(SymTable_getLength(oRead) == 0);
+      ASSURE(countBuckets(oRead) < 4096);
+   }
+   if (psHeader != NULL)
+      fclose(psHeader);
+   if (oRead != NULL)
+      SymTable_free(oRead);
+
+   /* A frozen table is refused before the stream is read */
+   rewind(psFile);
+   iDecoded = 0;
+   ASSURE(! SymTable_readStream(oSymTable, psFile, decodeInteger, NULL,
+      &iDecoded));
+   ASSURE(iDecoded == 0);
+   ASSURE(ftell(psFile) == 0);
+
+   fclose(psShort);
+   fclose(psFile);
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a temporary file holding the first lLength bytes of psFrom,
+   with the byte at lFlip, if within them, inverted, rewound and ready
+   to read. Return NULL if the file cannot be made. */
+
+static FILE *copyStream(FILE *psFrom, long lLength, long lFlip)
+{
+   FILE *psTo;
+   long l;
+   int iChar;
+
+   psTo = tmpfile();
+   if (psTo == NULL)
+      return NULL;
+   rewind(psFrom);
+   for (l = 0; l < lLength && (iChar = getc(psFrom)) != EOF; l++)
+      putc(l == lFlip ? ~iChar & 0xff : iChar, psTo);
+   rewind(psTo);
+   return psTo;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The start of a stream of one binding whose key claims to be 2^40
+   bytes long, followed by just three of them. */
+
+static const unsigned char aucHugeKey[] =
+   {'S', 'y', 'm', 'T', 'a', 'b', 'S', 't', 1, 1,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x20, 'a', 'b', 'c'};
+
+/* Return a stream holding aucHugeKey, rewound and ready to read: a
+   temporary file if iSeekable, or else the read end of a pipe. Return
+   NULL if the stream cannot be made. */
+
+static FILE *makeHugeKeyStream(int iSeekable)
+{
+   FILE *psFile;
+   int aiFds[2];
+   ssize_t written;
+
+   if (iSeekable)
+   {
+      psFile = tmpfile();
+      if (psFile == NULL)
+         return NULL;
+      fwrite(aucHugeKey, 1, sizeof(aucHugeKey), psFile);
+      rewind(psFile);
+      return psFile;
+   }
+
+   /* The bytes fit in the pipe's buffer, so they can all be written
+      before anything reads them */
+   if (pipe(aiFds) != 0)
+      return NULL;
+   written = write(aiFds[1], aucHugeKey, sizeof(aucHugeKey));
+   close(aiFds[1]);
+   psFile = fdopen(aiFds[0], "rb");
+   if (written != (ssize_t)sizeof(aucHugeKey) || psFile == NULL)
+   {
+      if (psFile != NULL)
+         fclose(psFile);
+      else
+         close(aiFds[0]);
+      return NULL;
+   }
+   return psFile;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test reading streams of iBindingCount bindings that are damaged or
+   cut short: a stream whose magic, version or count is damaged is
+   refused before any binding is read, a stream cut short anywhere is
+   refused with at most the bindings before the cut read, and a key
+   claiming far more bytes than follow it is refused, from a file or a
+   pipe, without reading anything. */
+
+static void testDamagedStream(int iBindingCount)
+{
+   SymTable_T oSymTable;
+   SymTable_T oRead;
+   FILE *psFile;
+   FILE *psDamaged;
+   char acKey[MAX_KEY_LENGTH];
+   long lSize;
+   long lStride;
+   long l;
+   int iDecoded;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing damaged SymTable streams.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   psFile = tmpfile();
+   ASSURE(oSymTable != NULL && psFile != NULL);
+   if (oSymTable == NULL || psFile == NULL)
+      return;
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "k%d", i);
+      ASSURE(SymTable_put(oSymTable, acKey, (void*)(size_t)(i + 1)));
+   }
+   ASSURE(SymTable_writeStream(oSymTable, psFile, encodeInteger, NULL));
+   lSize = ftell(psFile);
+   SymTable_free(oSymTable);
+
+   /* A damaged magic or version, the first nine bytes */
+   for (l = 0; l < 9; l++)
+   {
+      psDamaged = copyStream(psFile, lSize, l);
+      oRead = SymTable_new();
+      ASSURE(psDamaged != NULL && oRead != NULL);
+      if (psDamaged != NULL && oRead != NULL)
+      {
+         iDecoded = 0;
+         ASSURE(! SymTable_readStream(oRead, psDamaged, decodeInteger,
+            NULL, &iDecoded));
+         ASSURE(iDecoded == 0);
+         ASSURE(SymTable_getLength(oRead) == 0);
+      }
+      if (psDamaged != NULL)
+         fclose(psDamaged);
+      if (oRead != NULL)
+         SymTable_free(oRead);
+   }
+
+   /* A count too long for 64 bits */
+   psDamaged = tmpfile();
+   oRead = SymTable_new();
+   ASSURE(psDamaged != NULL && oRead != NULL);
+   if (psDamaged != NULL && oRead != NULL)
+   {
+      fwrite("SymTabSt\001", 1, 9, psDamaged);
+      for (i = 0; i < 10; i++)
+         putc(0xff, psDamaged);
+      putc(0x01, psDamaged);
+      rewind(psDamaged);
+      ASSURE(! SymTable_readStream(oRead, psDamaged, NULL, NULL, NULL));
+      ASSURE(SymTable_getLength(oRead) == 0);
+   }
+   if (psDamaged != NULL)
+      fclose(psDamaged);
+   if (oRead != NULL)
+      SymTable_free(oRead);
+
+   /* A key length of 2^40, which must be refused rather than
+      reserved */
+   for (i = 0; i < 2; i++)
+   {
+      psDamaged = makeHugeKeyStream(i == 0);
+      oRead = SymTable_new();
+      ASSURE(psDamaged != NULL && oRead != NULL);
+      if (psDamaged != NULL && oRead != NULL)
+      {
+         ASSURE(! SymTable_readStream(oRead, psDamaged, NULL, NULL,
+            NULL));
+         ASSURE(SymTable_getLength(oRead) == 0);
+      }
+      if (psDamaged != NULL)
+         fclose(psDamaged);
+      if (oRead != NULL)
+         SymTable_free(oRead);
+   }
+
+   /* A stream cut short anywhere, the header included */
+   lStride = lSize / 32 + 1;
+   for (l = 0; l < lSize; l += l < 16 ? 1 : lStride)
+   {
+      psDamaged = copyStream(psFile, l, -1);
+      oRead = SymTable_new();
+      ASSURE(psDamaged != NULL && oRead != NULL);
+      if (psDamaged != NULL && oRead != NULL)
+      {
+         iDecoded = 0;
+         ASSURE(! SymTable_readStream(oRead, psDamaged, decodeInteger,
+            NULL, &iDecoded));
+         ASSURE(SymTable_getLength(oRead) < (size_t)iBindingCount ||
+            iBindingCount == 0);
+         ASSURE(SymTable_getLength(oRead) == (size_t)iDecoded);
+      }
+      if (psDamaged != NULL)
+         fclose(psDamaged);
+      if (oRead != NULL)
+         SymTable_free(oRead);
+   }
+
+   fclose(psFile);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The file that testLoadText writes and loads. */
+
+static const char *pcTextPath = "testsymtablehashio.tsv";
+
+/* Convert the uLength decimal digits at pcText into an integer stored
+   in *ppvValue; no digits make 0. Fail on anything but digits. */
+
+static int parseInteger(const char *pcText, size_t uLength,
+   void **ppvValue, void *pvExtra)
+{
+   size_t uValue = 0;
+   size_t u;
+
+   (void)pvExtra;
+   for (u = 0; u < uLength; u++)
+   {
+      if (pcText[u] < '0' || pcText[u] > '9')
+         return 0;
+      uValue = uValue * 10 + (size_t)(pcText[u] - '0');
+   }
+   *ppvValue = (void*)uValue;
+   return 1;
+}
+
+/* Write to the file named pcTextPath iBindingCount lines binding
+   "t<i>" to i + 1, some ending in "\r\n", followed by pcTail. Return
+   1 if the file was written, and 0 otherwise. */
+
+static int writeText(int iBindingCount, const char *pcTail)
+{
+   FILE *psFile;
+   int i;
+
+   psFile = fopen(pcTextPath, "wb");
+   if (psFile == NULL)
+      return 0;
+   for (i = 0; i < iBindingCount; i++)
+      fprintf(psFile, "t%d\t%d%s", i, i + 1, i % 7 == 3 ? "\r\n" : "\n");
+   fputs(pcTail, psFile);
+   return fclose(psFile) == 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test loading a text file of iBindingCount lines and a few odd ones
+   on one thread, on four threads and into a read-mostly table on three
+   threads: every line's binding is there, the first line with a key
+   wins, keys already bound keep their values, and files that are
+   missing or hold a value that does not parse fail. */
+
+static void testLoadText(int iBindingCount)
+{
+   SymTable_T oSymTable;
+   FILE *psFile;
+   char acKey[MAX_KEY_LENGTH];
+   int iTable;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing loading SymTables from text files.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   /* A repeated key, empty lines, a line without a tab, an empty key,
+      and a last line without '\n' */
+   ASSURE(writeText(iBindingCount,
+      "t0\t999999\n\n\r\nbare\n\t5\nt1\t888888\r\nlast\t42"));
+
+   for (iTable = 0; iTable < 3; iTable++)
+   {
+      oSymTable = iTable < 2 ? SymTable_new() : SymTable_newReadMostly();
+      ASSURE(oSymTable != NULL);
+      if (oSymTable == NULL)
+         continue;
+      SymTable_setResizeThreads(oSymTable, (size_t)(iTable == 0 ? 1 :
+         iTable == 1 ? 4 : 3));
+      ASSURE(SymTable_put(oSymTable, "last", "bound before"));
+
+      ASSURE(SymTable_loadText(oSymTable, pcTextPath, parseInteger, NULL));
+      ASSURE(SymTable_getLength(oSymTable) == (size_t)iBindingCount +
+         (iBindingCount > 1 ? 3 : iBindingCount == 1 ? 4 : 5));
+      for (i = 0; i < iBindingCount; i++)
+      {
+         sprintf(acKey, "t%d", i);
+         ASSURE(SymTable_get(oSymTable, acKey) == (void*)(size_t)(i + 1));
+      }
+      ASSURE(SymTable_get(oSymTable, "t0") ==
+         (void*)(size_t)(iBindingCount > 0 ? 1 : 999999));
+      ASSURE(SymTable_contains(oSymTable, "bare"));
+      ASSURE(SymTable_get(oSymTable, "bare") == NULL);
+      ASSURE(SymTable_get(oSymTable, "") == (void*)(size_t)5);
+      ASSURE(strcmp((char*)SymTable_get(oSymTable, "last"),
+         "bound before") == 0);
+      ASSURE(! SymTable_contains(oSymTable, "t0\t999999"));
+      ASSURE(! SymTable_contains(oSymTable, "bare\r"));
+
+      /* Loading again adds nothing */
+      ASSURE(SymTable_loadText(oSymTable, pcTextPath, NULL, NULL));
+      ASSURE(SymTable_getLength(oSymTable) == (size_t)iBindingCount +
+         (iBindingCount > 1 ? 3 : iBindingCount == 1 ? 4 : 5));
+
+      /* A frozen table refuses */
+      ASSURE(SymTable_freeze(oSymTable));
+      ASSURE(! SymTable_loadText(oSymTable, pcTextPath, NULL, NULL));
+      SymTable_free(oSymTable);
+   }
+
+   /* A value that does not parse fails the load */
+   ASSURE(writeText(iBindingCount, "bad\tvalue\n"));
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   if (oSymTable != NULL)
+   {
+      SymTable_setResizeThreads(oSymTable, 4);
+      ASSURE(! SymTable_loadText(oSymTable, pcTextPath, parseInteger,
+         NULL));
+      ASSURE(! SymTable_contains(oSymTable, "bad"));
+      ASSURE(SymTable_loadText(oSymTable, pcTextPath, NULL, NULL));
+      ASSURE(SymTable_getLength(oSymTable) == (size_t)iBindingCount + 1);
+
+      /* An empty file adds nothing, and a missing one fails */
+      ASSURE(writeText(0, ""));
+      ASSURE(SymTable_loadText(oSymTable, pcTextPath, parseInteger,
+         NULL));
+      ASSURE(SymTable_getLength(oSymTable) == (size_t)iBindingCount + 1);
+      ASSURE(! SymTable_loadText(oSymTable, "testsymtablehashio.missing",
+         NULL, NULL));
+      SymTable_free(oSymTable);
+   }
+
+   /* A '\0' in a key fails the load */
+   ASSURE(writeText(iBindingCount, ""));
+   psFile = fopen(pcTextPath, "ab");
+   ASSURE(psFile != NULL);
+   if (psFile != NULL)
+   {
+      ASSURE(fwrite("nul\0key\t1\n", 1, 10, psFile) == 10);
+      ASSURE(fclose(psFile) == 0);
+   }
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   if (oSymTable != NULL)
+   {
+      ASSURE(! SymTable_loadText(oSymTable, pcTextPath, NULL, NULL));
+      ASSURE(! SymTable_contains(oSymTable, "nul"));
+      SymTable_free(oSymTable);
+   }
+
+   /* A file cut in the middle of its last value loads what is there */
+   ASSURE(writeText(iBindingCount, "cut\t12"));
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   if (oSymTable != NULL)
+   {
+      ASSURE(SymTable_loadText(oSymTable, pcTextPath, parseInteger, NULL));
+      ASSURE(SymTable_getLength(oSymTable) == (size_t)iBindingCount + 1);
+      ASSURE(SymTable_get(oSymTable, "cut") == (void*)(size_t)12);
+      SymTable_free(oSymTable);
+   }
+
+   remove(pcTextPath);
+}
+
+
+/*--------------------------------------------------------------------*/
+
+/* Test saving, streaming and loading the hash table SymTable with
+   argv[1] bindings, and reading files that are damaged or cut short.
+   Write to stdout a message for each test that fails. Exit with
+   EXIT_FAILURE if argv[1] is missing or not a non-negative number.
+   Otherwise return 0. */
+
+int main(int argc, char *argv[])
+{
+   int iBindingCount;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s bindingcount\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+
+   if (sscanf(argv[1], "%d", &iBindingCount) != 1)
+   {
+      fprintf(stderr, "bindingcount must be numeric\n");
+      exit(EXIT_FAILURE);
+   }
+   if (iBindingCount < 0)
+   {
+      fprintf(stderr, "bindingcount cannot be negative\n");
+      exit(EXIT_FAILURE);
+   }
+
+   testSnapshot(iBindingCount);
+   testDamagedSnapshot(iBindingCount);
+   testStream(iBindingCount);
+   testDamagedStream(iBindingCount);
+   testLoadText(iBindingCount);
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
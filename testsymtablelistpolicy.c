@@ -0,0 +1,253 @@
+/*--------------------------------------------------------------------*/
+/* testsymtablelistpolicy.c                                           */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#include "symtable.h"
+#include "symtablelist.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* The longest key that the tests build. */
+
+enum {MAX_KEY_LENGTH = 16};
+
+/* The most bindings a table in these tests gets: every lookup in a
+   list walks it, so larger tables only make the tests slow. */
+
+enum {MAX_BINDINGS = 1000};
+
+/*--------------------------------------------------------------------*/
+
+/* The order in which SymTable_map visited the bindings of a table. */
+
+struct Order
+{
+   /* The keys, in the order visited */
+   const char **ppcKeys;
+
+   /* How many were visited */
+   int iCount;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Append pcKey to the struct Order that pvExtra points to, and check
+   that pvValue is the key's own string. */
+
+static void recordKey(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   struct Order *psOrder = (struct Order*)pvExtra;
+
+   ASSURE(strcmp((const char*)pvValue, pcKey) == 0);
+   psOrder->ppcKeys[psOrder->iCount++] = pcKey;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Store in psOrder the order in which SymTable_map visits the
+   bindings of oSymTable. */
+
+static void getOrder(SymTable_T oSymTable, struct Order *psOrder)
+{
+   psOrder->iCount = 0;
+   SymTable_map(oSymTable, recordKey, psOrder);
+   ASSURE(psOrder->iCount == (int)SymTable_getLength(oSymTable));
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the position of pcKey in psOrder, or -1 if it is not
+   there. */
+
+static int findKey(const struct Order *psOrder, const char *pcKey)
+{
+   int i;
+
+   for (i = 0; i < psOrder->iCount; i++)
+      if (strcmp(psOrder->ppcKeys[i], pcKey) == 0)
+         return i;
+   return -1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test each access policy on a table of iBindingCount bindings, at
+   most MAX_BINDINGS: where a lookup moves the binding it finds, that
+   a miss and the other operations move nothing, that the count of
+   comparisons matches the positions looked up, and that a long run of
+   lookups, removes and puts keeps every binding. */
+
+static void testPolicies(int iBindingCount)
+{
+   static const enum SymTableListPolicy aePolicies[] =
+      {SYMTABLE_KEEP_ORDER, SYMTABLE_MOVE_TO_FRONT, SYMTABLE_TRANSPOSE};
+   enum {POLICY_COUNT = sizeof(aePolicies) / sizeof(aePolicies[0])};
+   SymTable_T oSymTable;
+   struct Order sBefore;
+   struct Order sAfter;
+   char *pcKeys;
+   char *pcKey;
+   size_t uComparisons;
+   int iPolicy;
+   int iPosition;
+   int iStep;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the access policies.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   if (iBindingCount > MAX_BINDINGS)
+      iBindingCount = MAX_BINDINGS;
+   if (iBindingCount < 3)
+      iBindingCount = 3;
+
+   pcKeys = (char*)malloc((size_t)iBindingCount * MAX_KEY_LENGTH);
+   sBefore.ppcKeys = (const char**)malloc((size_t)iBindingCount *
+      sizeof(const char*));
+   sAfter.ppcKeys = (const char**)malloc((size_t)iBindingCount *
+      sizeof(const char*));
+   ASSURE(pcKeys != NULL && sBefore.ppcKeys != NULL &&
+      sAfter.ppcKeys != NULL);
+   /* atoi(pcKey + 3) gives a key's index back */
+   for (i = 0; i < iBindingCount; i++)
+      sprintf(pcKeys + (size_t)i * MAX_KEY_LENGTH, "key%d", i);
+
+   for (iPolicy = 0; iPolicy < POLICY_COUNT; iPolicy++)
+   {
+      oSymTable = SymTable_new();
+      ASSURE(oSymTable != NULL);
+      ASSURE(SymTable_getComparisonCount(oSymTable) == 0);
+      SymTable_setAccessPolicy(oSymTable, aePolicies[iPolicy]);
+      for (i = 0; i < iBindingCount; i++)
+      {
+         pcKey = pcKeys + (size_t)i * MAX_KEY_LENGTH;
+         ASSURE(SymTable_put(oSymTable, pcKey, pcKey));
+      }
+
+      /* A miss, a put of a present key and a replace move nothing */
+      getOrder(oSymTable, &sBefore);
+      ASSURE(SymTable_get(oSymTable, "absent") == NULL);
+      ASSURE(SymTable_getComparisonCount(oSymTable) ==
+         (size_t)iBindingCount);
+      pcKey = pcKeys + (size_t)atoi(sBefore.ppcKeys[1] + 3) *
+         MAX_KEY_LENGTH;
+      ASSURE(! SymTable_put(oSymTable, pcKey, NULL));
+      ASSURE(SymTable_replace(oSymTable, pcKey, pcKey) == pcKey);
+      getOrder(oSymTable, &sAfter);
+      ASSURE(memcmp(sBefore.ppcKeys, sAfter.ppcKeys,
+         (size_t)iBindingCount * sizeof(const char*)) == 0);
+
+      /* A hit at position iPosition costs iPosition + 1 comparisons
+         and moves the binding as the policy says */
+      iPosition = iBindingCount / 2;
+      pcKey = (char*)sBefore.ppcKeys[iPosition];
+      uComparisons = SymTable_getComparisonCount(oSymTable);
+      ASSURE(SymTable_contains(oSymTable, pcKey));
+      ASSURE(SymTable_getComparisonCount(oSymTable) ==
+         uComparisons + (size_t)iPosition + 1);
+      getOrder(oSymTable, &sAfter);
+      if (aePolicies[iPolicy] == SYMTABLE_KEEP_ORDER)
+         ASSURE(findKey(&sAfter, pcKey) == iPosition);
+      else if (aePolicies[iPolicy] == SYMTABLE_MOVE_TO_FRONT)
+         ASSURE(findKey(&sAfter, pcKey) == 0);
+      else
+      {
+         ASSURE(findKey(&sAfter, pcKey) == iPosition - 1);
+         ASSURE(findKey(&sAfter, sBefore.ppcKeys[iPosition - 1]) ==
+            iPosition);
+      }
+
+      /* Transposing the first binding, or moving it to the front,
+         leaves it there */
+      ASSURE(strcmp((const char*)SymTable_get(oSymTable,
+         sAfter.ppcKeys[0]), sAfter.ppcKeys[0]) == 0);
+      getOrder(oSymTable, &sBefore);
+      ASSURE(sBefore.ppcKeys[0] == sAfter.ppcKeys[0]);
+
+      /* Lookups, removes and puts in turn keep every binding */
+      srand(1);
+      for (iStep = 0; iStep < 20 * iBindingCount; iStep++)
+      {
+         i = rand() % iBindingCount;
+         pcKey = pcKeys + (size_t)i * MAX_KEY_LENGTH;
+         if (iStep % 7 == 0)
+         {
+            ASSURE(SymTable_remove(oSymTable, pcKey) == pcKey);
+            ASSURE(SymTable_put(oSymTable, pcKey, pcKey));
+         }
+         else
+            ASSURE(SymTable_get(oSymTable, pcKey) == pcKey);
+      }
+      getOrder(oSymTable, &sAfter);
+      ASSURE(sAfter.iCount == iBindingCount);
+      for (i = 0; i < iBindingCount; i++)
+         ASSURE(findKey(&sAfter, pcKeys + (size_t)i * MAX_KEY_LENGTH)
+            >= 0);
+
+      SymTable_free(oSymTable);
+   }
+
+   free(sAfter.ppcKeys);
+   free(sBefore.ppcKeys);
+   free(pcKeys);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the access policies of the list SymTable with argv[1]
+   bindings, at most MAX_BINDINGS. Write to stdout a message for each
+   test that fails. Exit with EXIT_FAILURE if argv[1] is missing or
+   not a non-negative number. Otherwise return 0. */
+
+int main(int argc, char *argv[])
+{
+   int iBindingCount;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s bindingcount\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+
+   if (sscanf(argv[1], "%d", &iBindingCount) != 1)
+   {
+      fprintf(stderr, "bindingcount must be numeric\n");
+      exit(EXIT_FAILURE);
+   }
+   if (iBindingCount < 0)
+   {
+      fprintf(stderr, "bindingcount cannot be negative\n");
+      exit(EXIT_FAILURE);
+   }
+
+   testPolicies(iBindingCount);
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
@@ -0,0 +1,201 @@
+/*--------------------------------------------------------------------*/
+/* testsymtablemph.c                                                  */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#include "symtablemph.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* The longest key that the tests build. */
+
+enum {MAX_KEY_LENGTH = 16};
+
+/* How many keys share one hash in testCollisions, and how many threads
+   share each build. */
+
+enum {COLLIDING_COUNT = 100, THREAD_COUNT = 4};
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the same hash for every key that begins with 'x', whatever
+   the seed, and the wyhash of any other key. It stands in for keys
+   whose collisions no seed can break. */
+
+static uint64_t collidingHash(const char *pcKey, size_t uLength,
+   uint64_t uSeed)
+{
+   if (uLength > 0 && pcKey[0] == 'x')
+      return 0x0123456789abcdefu;
+   return SymTableHash_wyhash(pcKey, uLength, uSeed);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the same hash for every key. */
+
+static uint64_t constantHash(const char *pcKey, size_t uLength,
+   uint64_t uSeed)
+{
+   (void)pcKey;
+   (void)uLength;
+   (void)uSeed;
+   return 0x5555555555555555u;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Count the bindings that SymTableMPH_map visits, checking that each
+   is bound to its own key, in the int that pvExtra points to. */
+
+static void countBinding(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   ASSURE(strcmp((const char*)pvValue, pcKey) == 0);
+   (*(int*)pvExtra)++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Check that oSymTableMPH binds each of the iKeyCount keys of
+   apcKeys to itself, and nothing else. */
+
+static void checkIndex(SymTableMPH_T oSymTableMPH,
+   const char *const apcKeys[], int iKeyCount)
+{
+   void *pvValue;
+   int iVisited = 0;
+   int i;
+
+   ASSURE(SymTableMPH_getLength(oSymTableMPH) == (size_t)iKeyCount);
+   for (i = 0; i < iKeyCount; i++)
+   {
+      pvValue = NULL;
+      ASSURE(SymTableMPH_find(oSymTableMPH, apcKeys[i],
+         strlen(apcKeys[i]), &pvValue));
+      ASSURE(pvValue == apcKeys[i]);
+   }
+   pvValue = NULL;
+   ASSURE(! SymTableMPH_find(oSymTableMPH, "x-1", 3, &pvValue));
+   ASSURE(! SymTableMPH_find(oSymTableMPH, "k-1", 3, &pvValue));
+   ASSURE(pvValue == NULL);
+   SymTableMPH_map(oSymTableMPH, countBinding, &iVisited);
+   ASSURE(iVisited == iKeyCount);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Build an index over iColliding keys that share one hash under every
+   seed and iBindingCount keys that do not, hashed with *pfHash. The
+   build must not fail as if memory were insufficient: it must fall
+   back to SipHash, and every key must then be found. */
+
+static void testCollisions(SymTableHashFn_T pfHash, int iColliding,
+   int iBindingCount)
+{
+   SymTableMPH_T oSymTableMPH;
+   char *pcKeys;
+   const char **apcKeys;
+   int iKeyCount = iColliding + iBindingCount;
+   int i;
+
+   pcKeys = (char*)malloc(((size_t)iKeyCount + 1) * MAX_KEY_LENGTH);
+   apcKeys = (const char**)malloc(((size_t)iKeyCount + 1) *
+      sizeof(const char*));
+   ASSURE(pcKeys != NULL && apcKeys != NULL);
+   if (pcKeys == NULL || apcKeys == NULL)
+      exit(EXIT_FAILURE);
+   for (i = 0; i < iKeyCount; i++)
+   {
+      apcKeys[i] = pcKeys + (size_t)i * MAX_KEY_LENGTH;
+      sprintf(pcKeys + (size_t)i * MAX_KEY_LENGTH,
+         i < iColliding ? "x%d" : "k%d", i);
+   }
+
+   oSymTableMPH = SymTableMPH_newWithHash(apcKeys,
+      (const void *const *)apcKeys, (size_t)iKeyCount, THREAD_COUNT,
+      pfHash);
+   ASSURE(oSymTableMPH != NULL);
+   if (oSymTableMPH != NULL)
+   {
+      checkIndex(oSymTableMPH, apcKeys, iKeyCount);
+      SymTableMPH_free(oSymTableMPH);
+   }
+
+   /* The default hash, with the same keys */
+   oSymTableMPH = SymTableMPH_new(apcKeys, (const void *const *)apcKeys,
+      (size_t)iKeyCount, THREAD_COUNT);
+   ASSURE(oSymTableMPH != NULL);
+   if (oSymTableMPH != NULL)
+   {
+      checkIndex(oSymTableMPH, apcKeys, iKeyCount);
+      SymTableMPH_free(oSymTableMPH);
+   }
+
+   free(apcKeys);
+   free(pcKeys);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTableMPH with keys that collide under every seed, alongside
+   argv[1] keys that do not. Write to stdout a message for each test
+   that fails. Exit with EXIT_FAILURE if argv[1] is missing or not a
+   non-negative number. Otherwise return 0. */
+
+int main(int argc, char *argv[])
+{
+   int iBindingCount;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s bindingcount\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+
+   if (sscanf(argv[1], "%d", &iBindingCount) != 1)
+   {
+      fprintf(stderr, "bindingcount must be numeric\n");
+      exit(EXIT_FAILURE);
+   }
+   if (iBindingCount < 0)
+   {
+      fprintf(stderr, "bindingcount cannot be negative\n");
+      exit(EXIT_FAILURE);
+   }
+
+   printf("------------------------------------------------------\n");
+   printf("Testing keys that collide under every seed.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+   testCollisions(collidingHash, 0, iBindingCount);
+   testCollisions(collidingHash, 2, iBindingCount);
+   testCollisions(collidingHash, COLLIDING_COUNT, iBindingCount);
+   testCollisions(constantHash, 0,
+      iBindingCount < 1000 ? iBindingCount : 1000);
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
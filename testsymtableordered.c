@@ -0,0 +1,413 @@
+/*--------------------------------------------------------------------*/
+/* testsymtableordered.c                                              */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#include "symtable.h"
+#include "symtableordered.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* The longest key that the tests build. */
+
+enum {MAX_KEY_LENGTH = 48};
+
+/* How many namespaces the keys of the range and prefix tests are
+   spread over. */
+
+enum {NAMESPACE_COUNT = 12};
+
+/*--------------------------------------------------------------------*/
+
+/* What a visit of the bindings expects and has seen so far. A NULL
+   bound or prefix selects everything. */
+
+struct Visit
+{
+   /* The range that every visited key must lie in */
+   const char *pcLow;
+   const char *pcHigh;
+
+   /* The prefix that every visited key must begin with */
+   const char *pcPrefix;
+
+   /* The last key visited, or NULL before the first. It is kept as
+      the binding's value, which is the key's own string, since the
+      key that *pfApply gets need not outlive the call */
+   const char *pcLast;
+
+   /* How many bindings were visited */
+   int iCount;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) if pcKey lies in the range and has the prefix that
+   psVisit selects, 0 (FALSE) otherwise. */
+
+static int isSelected(const struct Visit *psVisit, const char *pcKey)
+{
+   if (psVisit->pcLow != NULL && strcmp(pcKey, psVisit->pcLow) < 0)
+      return 0;
+   if (psVisit->pcHigh != NULL && strcmp(pcKey, psVisit->pcHigh) >= 0)
+      return 0;
+   if (psVisit->pcPrefix != NULL &&
+      strncmp(pcKey, psVisit->pcPrefix, strlen(psVisit->pcPrefix)) != 0)
+      return 0;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Check that pcKey is selected by the struct Visit that pvExtra points
+   to, that it follows the last key visited and that pvValue is the
+   key's own string, and count it. */
+
+static void checkVisit(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   struct Visit *psVisit = (struct Visit*)pvExtra;
+
+   ASSURE(isSelected(psVisit, pcKey));
+   ASSURE(psVisit->pcLast == NULL || strcmp(psVisit->pcLast, pcKey) < 0);
+   ASSURE(strcmp((const char*)pvValue, pcKey) == 0);
+   psVisit->pcLast = (const char*)pvValue;
+   psVisit->iCount++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Start a visit that selects the keys in [pcLow, pcHigh) that begin
+   with pcPrefix. */
+
+static void startVisit(struct Visit *psVisit, const char *pcLow,
+   const char *pcHigh, const char *pcPrefix)
+{
+   psVisit->pcLow = pcLow;
+   psVisit->pcHigh = pcHigh;
+   psVisit->pcPrefix = pcPrefix;
+   psVisit->pcLast = NULL;
+   psVisit->iCount = 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write to acKey the iIndex-th key of the range and prefix tests: a
+   namespaced identifier, as a compiler would bind. */
+
+static void makeKey(char *acKey, int iIndex)
+{
+   sprintf(acKey, "ns%d::detail::symbol_%d", iIndex % NAMESPACE_COUNT,
+      iIndex / NAMESPACE_COUNT);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a table that binds each of the first iBindingCount keys of
+   makeKey to a copy of itself, put in a shuffled order. Store the
+   copies, which the caller frees, in *ppcKeys. */
+
+static SymTable_T buildTable(int iBindingCount, char **ppcKeys)
+{
+   SymTable_T oSymTable;
+   char *pcKeys;
+   int *aiOrder;
+   int iTemp;
+   int i;
+   int j;
+
+   oSymTable = SymTable_new();
+   pcKeys = (char*)malloc((size_t)iBindingCount * MAX_KEY_LENGTH + 1);
+   aiOrder = (int*)malloc((size_t)iBindingCount * sizeof(int) + 1);
+   ASSURE(oSymTable != NULL && pcKeys != NULL && aiOrder != NULL);
+
+   for (i = 0; i < iBindingCount; i++)
+   {
+      makeKey(pcKeys + (size_t)i * MAX_KEY_LENGTH, i);
+      aiOrder[i] = i;
+   }
+   srand(1);
+   for (i = iBindingCount - 1; i > 0; i--)
+   {
+      j = rand() % (i + 1);
+      iTemp = aiOrder[i];
+      aiOrder[i] = aiOrder[j];
+      aiOrder[j] = iTemp;
+   }
+   for (i = 0; i < iBindingCount; i++)
+   {
+      char *pcKey = pcKeys + (size_t)aiOrder[i] * MAX_KEY_LENGTH;
+      ASSURE(SymTable_put(oSymTable, pcKey, pcKey));
+   }
+   ASSURE(SymTable_getLength(oSymTable) == (size_t)iBindingCount);
+
+   free(aiOrder);
+   *ppcKeys = pcKeys;
+   return oSymTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return how many of the first iBindingCount keys of makeKey that
+   are not yet removed the visit psVisit selects. abRemoved tells
+   which are removed, or is NULL if none are. */
+
+static int countSelected(const struct Visit *psVisit,
+   const char *pcKeys, const char *abRemoved, int iBindingCount)
+{
+   int iCount = 0;
+   int i;
+
+   for (i = 0; i < iBindingCount; i++)
+      if ((abRemoved == NULL || ! abRemoved[i]) &&
+         isSelected(psVisit, pcKeys + (size_t)i * MAX_KEY_LENGTH))
+         iCount++;
+   return iCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that SymTable_map visits every binding in order while a table
+   of iBindingCount bindings is built in a shuffled order and then
+   taken apart again: first every third key, then the rest. */
+
+static void testOrder(int iBindingCount)
+{
+   SymTable_T oSymTable;
+   struct Visit sVisit;
+   char *pcKeys;
+   char *abRemoved;
+   char *pcKey;
+   int iRemoved = 0;
+   int iPass;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the order of the bindings.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = buildTable(iBindingCount, &pcKeys);
+   abRemoved = (char*)calloc((size_t)iBindingCount + 1, 1);
+   ASSURE(abRemoved != NULL);
+
+   startVisit(&sVisit, NULL, NULL, NULL);
+   SymTable_map(oSymTable, checkVisit, &sVisit);
+   ASSURE(sVisit.iCount == iBindingCount);
+
+   for (iPass = 0; iPass < 2; iPass++)
+   {
+      for (i = 0; i < iBindingCount; i++)
+      {
+         if (abRemoved[i] || (iPass == 0 && i % 3 != 0))
+            continue;
+         pcKey = pcKeys + (size_t)i * MAX_KEY_LENGTH;
+         ASSURE(SymTable_remove(oSymTable, pcKey) == pcKey);
+         ASSURE(SymTable_remove(oSymTable, pcKey) == NULL);
+         abRemoved[i] = 1;
+         iRemoved++;
+      }
+      ASSURE(SymTable_getLength(oSymTable) ==
+         (size_t)(iBindingCount - iRemoved));
+      for (i = 0; i < iBindingCount; i++)
+      {
+         pcKey = pcKeys + (size_t)i * MAX_KEY_LENGTH;
+         ASSURE(SymTable_contains(oSymTable, pcKey) == ! abRemoved[i]);
+      }
+      startVisit(&sVisit, NULL, NULL, NULL);
+      SymTable_map(oSymTable, checkVisit, &sVisit);
+      ASSURE(sVisit.iCount == iBindingCount - iRemoved);
+   }
+
+   /* The emptied table still works */
+   ASSURE(SymTable_put(oSymTable, "", ""));
+   ASSURE(SymTable_get(oSymTable, "") != NULL);
+   ASSURE(SymTable_remove(oSymTable, "") != NULL);
+   ASSURE(SymTable_getLength(oSymTable) == 0);
+
+   SymTable_free(oSymTable);
+   free(abRemoved);
+   free(pcKeys);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that keys order as strcmp orders them where that is easy to
+   get wrong: the empty key, keys that are prefixes of one another,
+   keys that differ only past their first eight bytes, and bytes above
+   127. */
+
+static void testAwkwardKeys(void)
+{
+   static const char *apcKeys[] =
+   {
+      "", "a", "ab", "abcdefg", "abcdefgh", "abcdefgh0", "abcdefghi",
+      "abcdefghij", "abcdefgi", "b", "\x7f", "\x80", "\xff", "\xff\xff"
+   };
+   enum {KEY_COUNT = sizeof(apcKeys) / sizeof(apcKeys[0])};
+   SymTable_T oSymTable;
+   struct Visit sVisit;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the order of awkward keys.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = KEY_COUNT - 1; i >= 0; i--)
+      ASSURE(SymTable_put(oSymTable, apcKeys[i], apcKeys[i]));
+   for (i = 0; i < KEY_COUNT; i++)
+      ASSURE(SymTable_get(oSymTable, apcKeys[i]) == apcKeys[i]);
+   ASSURE(! SymTable_contains(oSymTable, "abcdef"));
+   ASSURE(! SymTable_contains(oSymTable, "abcdefgh1"));
+
+   startVisit(&sVisit, NULL, NULL, NULL);
+   SymTable_map(oSymTable, checkVisit, &sVisit);
+   ASSURE(sVisit.iCount == KEY_COUNT);
+
+   startVisit(&sVisit, NULL, NULL, "abcdefgh");
+   SymTable_mapPrefix(oSymTable, "abcdefgh", checkVisit, &sVisit);
+   ASSURE(sVisit.iCount == 4);
+
+   startVisit(&sVisit, "abcdefgh", "abcdefgi", NULL);
+   SymTable_mapRange(oSymTable, "abcdefgh", "abcdefgi", checkVisit,
+      &sVisit);
+   ASSURE(sVisit.iCount == 4);
+
+   startVisit(&sVisit, "\x80", NULL, NULL);
+   SymTable_mapRange(oSymTable, "\x80", NULL, checkVisit, &sVisit);
+   ASSURE(sVisit.iCount == 3);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_mapRange and SymTable_mapPrefix on a table of
+   iBindingCount namespaced keys: open, empty, inverted and ordinary
+   ranges, and prefixes that match everything, a namespace, several
+   namespaces, one key or nothing. */
+
+static void testRangesAndPrefixes(int iBindingCount)
+{
+   static const char *apcRanges[][2] =
+   {
+      {NULL, NULL}, {"ns3::", NULL}, {NULL, "ns3::"}, {"ns3::", "ns5::"},
+      {"ns1", "ns1~"}, {"ns4::", "ns4::"}, {"ns5::", "ns3::"},
+      {"ns2::detail::symbol_1", "ns2::detail::symbol_2"}, {"zz", NULL},
+      {NULL, ""}
+   };
+   static const char *apcPrefixes[] =
+   {
+      "", "ns", "ns1", "ns1::", "ns7::detail::symbol_1",
+      "ns7::detail::symbol_1x", "ns12::", "zz"
+   };
+   enum {RANGE_COUNT = sizeof(apcRanges) / sizeof(apcRanges[0]),
+      PREFIX_COUNT = sizeof(apcPrefixes) / sizeof(apcPrefixes[0])};
+   SymTable_T oSymTable;
+   struct Visit sVisit;
+   char *pcKeys;
+   char *abRemoved;
+   int iPass;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing ranges and prefixes.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = buildTable(iBindingCount, &pcKeys);
+   abRemoved = (char*)calloc((size_t)iBindingCount + 1, 1);
+   ASSURE(abRemoved != NULL);
+
+   /* The second pass sees a table with every other key removed */
+   for (iPass = 0; iPass < 2; iPass++)
+   {
+      for (i = 0; i < RANGE_COUNT; i++)
+      {
+         startVisit(&sVisit, apcRanges[i][0], apcRanges[i][1], NULL);
+         SymTable_mapRange(oSymTable, apcRanges[i][0], apcRanges[i][1],
+            checkVisit, &sVisit);
+         ASSURE(sVisit.iCount ==
+            countSelected(&sVisit, pcKeys, abRemoved, iBindingCount));
+      }
+      for (i = 0; i < PREFIX_COUNT; i++)
+      {
+         startVisit(&sVisit, NULL, NULL, apcPrefixes[i]);
+         SymTable_mapPrefix(oSymTable, apcPrefixes[i], checkVisit,
+            &sVisit);
+         ASSURE(sVisit.iCount ==
+            countSelected(&sVisit, pcKeys, abRemoved, iBindingCount));
+      }
+      for (i = 0; iPass == 0 && i < iBindingCount; i += 2)
+      {
+         ASSURE(SymTable_remove(oSymTable,
+            pcKeys + (size_t)i * MAX_KEY_LENGTH) != NULL);
+         abRemoved[i] = 1;
+      }
+   }
+
+   SymTable_free(oSymTable);
+   free(abRemoved);
+   free(pcKeys);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the ordered extensions of the SymTable ADT with argv[1]
+   bindings. Write to stdout a message for each test that fails.
+   Exit with EXIT_FAILURE if argv[1] is missing or not a
+   non-negative number. Otherwise return 0. */
+
+int main(int argc, char *argv[])
+{
+   int iBindingCount;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s bindingcount\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+
+   if (sscanf(argv[1], "%d", &iBindingCount) != 1)
+   {
+      fprintf(stderr, "bindingcount must be numeric\n");
+      exit(EXIT_FAILURE);
+   }
+   if (iBindingCount < 0)
+   {
+      fprintf(stderr, "bindingcount cannot be negative\n");
+      exit(EXIT_FAILURE);
+   }
+
+   testOrder(iBindingCount);
+   testAwkwardKeys();
+   testRangesAndPrefixes(iBindingCount);
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
@@ -0,0 +1,727 @@
+/*--------------------------------------------------------------------*/
+/* testsymtablethreads.c                                              */
+/* Author: Ephraim Meles                                              */
+/*--------------------------------------------------------------------*/
+
+#include "symtable.h"
+#include "symtablehash.h"
+#include "symtableshard.h"
+#include "symtablefc.h"
+#include "symtablercu.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* The number of threads that each concurrent test starts. */
+
+enum {THREAD_COUNT = 4};
+
+/* The longest key that the concurrent tests build. */
+
+enum {MAX_KEY_LENGTH = 16};
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add 1 to the size_t that pvExtra points to. Every binding that
+   these tests create has a non-NULL value. */
+
+static void countBinding(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   assert(pcKey != NULL);
+   assert(pvValue != NULL);
+   assert(pvExtra != NULL);
+
+   (*(size_t*)pvExtra)++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The work handed to one thread of a concurrent test: the table to
+   use and the range [iFirst, iFirst + iCount) of keys to touch. Keys
+   are the decimal spellings of the integers in the range, and each
+   binding's value is the address of its ThreadWork. */
+
+struct ThreadWork
+{
+   void *pvTable;
+   int iFirst;
+   int iCount;
+   int iFailures;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Test the most basic SymTableShard functions. */
+
+static void testShardBasics(void)
+{
+   SymTableShard_T oSymTableShard;
+   char acJeter[] = "Jeter";
+   char acMantle[] = "Mantle";
+   char acShortstop[] = "Shortstop";
+   char acCenterField[] = "Center Field";
+   char *pcValue;
+   size_t uCount = 0;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the most basic SymTableShard functions.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTableShard = SymTableShard_new(SYMTABLESHARD_MAX_BITS + 1);
+   ASSURE(oSymTableShard == NULL);
+
+   oSymTableShard = SymTableShard_new(0);
+   ASSURE(oSymTableShard != NULL);
+   ASSURE(SymTableShard_put(oSymTableShard, acJeter, acShortstop));
+   ASSURE(SymTableShard_getLength(oSymTableShard) == 1);
+   SymTableShard_free(oSymTableShard);
+
+   oSymTableShard = SymTableShard_new(4);
+   ASSURE(oSymTableShard != NULL);
+
+   ASSURE(SymTableShard_put(oSymTableShard, acJeter, acShortstop));
+   ASSURE(SymTableShard_put(oSymTableShard, acMantle, acCenterField));
+   ASSURE(! SymTableShard_put(oSymTableShard, acJeter, acCenterField));
+   ASSURE(SymTableShard_getLength(oSymTableShard) == 2);
+
+   ASSURE(SymTableShard_contains(oSymTableShard, acJeter));
+   ASSURE(! SymTableShard_contains(oSymTableShard, "Ruth"));
+
+   pcValue = (char*)SymTableShard_get(oSymTableShard, acMantle);
+   ASSURE(pcValue == acCenterField);
+
+   pcValue = (char*)
+      SymTableShard_replace(oSymTableShard, acMantle, acShortstop);
+   ASSURE(pcValue == acCenterField);
+   pcValue = (char*)SymTableShard_get(oSymTableShard, acMantle);
+   ASSURE(pcValue == acShortstop);
+
+   SymTableShard_map(oSymTableShard, countBinding, &uCount);
+   ASSURE(uCount == 2);
+
+   pcValue = (char*)SymTableShard_remove(oSymTableShard, acJeter);
+   ASSURE(pcValue == acShortstop);
+   pcValue = (char*)SymTableShard_remove(oSymTableShard, acJeter);
+   ASSURE(pcValue == NULL);
+   ASSURE(SymTableShard_getLength(oSymTableShard) == 1);
+
+   SymTableShard_free(oSymTableShard);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Put, check, and then remove the keys described by pvArg (a
+   struct ThreadWork) in a SymTableShard. Count failures. */
+
+static void *shardWorker(void *pvArg)
+{
+   struct ThreadWork *psWork = (struct ThreadWork*)pvArg;
+   SymTableShard_T oSymTableShard = (SymTableShard_T)psWork->pvTable;
+   char acKey[MAX_KEY_LENGTH];
+   int i;
+
+   for (i = psWork->iFirst; i < psWork->iFirst + psWork->iCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      if (! SymTableShard_put(oSymTableShard, acKey, psWork))
+         psWork->iFailures++;
+   }
+   for (i = psWork->iFirst; i < psWork->iFirst + psWork->iCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      if (SymTableShard_get(oSymTableShard, acKey) != psWork)
+         psWork->iFailures++;
+   }
+   for (i = psWork->iFirst; i < psWork->iFirst + psWork->iCount; i += 2)
+   {
+      sprintf(acKey, "%d", i);
+      if (SymTableShard_remove(oSymTableShard, acKey) != psWork)
+         psWork->iFailures++;
+   }
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test a SymTableShard that THREAD_COUNT threads fill at the same
+   time, each with iBindingCount keys of its own. */
+
+static void testShardThreads(int iBindingCount)
+{
+   SymTableShard_T oSymTableShard;
+   pthread_t aThreads[THREAD_COUNT];
+   struct ThreadWork asWork[THREAD_COUNT];
+   size_t uExpected = 0;
+   size_t uCount = 0;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a SymTableShard shared by several threads.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTableShard = SymTableShard_new(6);
+   ASSURE(oSymTableShard != NULL);
+
+   for (i = 0; i < THREAD_COUNT; i++)
+   {
+      asWork[i].pvTable = oSymTableShard;
+      asWork[i].iFirst = i * iBindingCount;
+      asWork[i].iCount = iBindingCount;
+      asWork[i].iFailures = 0;
+      ASSURE(pthread_create(&aThreads[i], NULL, shardWorker,
+         &asWork[i]) == 0);
+   }
+   for (i = 0; i < THREAD_COUNT; i++)
+   {
+      pthread_join(aThreads[i], NULL);
+      ASSURE(asWork[i].iFailures == 0);
+      uExpected += (size_t)(iBindingCount / 2);
+   }
+
+   ASSURE(SymTableShard_getLength(oSymTableShard) == uExpected);
+   SymTableShard_map(oSymTableShard, countBinding, &uCount);
+   ASSURE(uCount == uExpected);
+
+   SymTableShard_free(oSymTableShard);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Look up every key of the stable range described by pvArg (a
+   struct ThreadWork) in a read-mostly SymTable several times while
+   a writer changes the table. Count lookups that miss. */
+
+static void *readMostlyReader(void *pvArg)
+{
+   enum {PASS_COUNT = 4};
+
+   struct ThreadWork *psWork = (struct ThreadWork*)pvArg;
+   SymTable_T oSymTable = (SymTable_T)psWork->pvTable;
+   char acKey[MAX_KEY_LENGTH];
+   int iPass;
+   int i;
+
+   for (iPass = 0; iPass < PASS_COUNT; iPass++)
+      for (i = psWork->iFirst; i < psWork->iFirst + psWork->iCount; i++)
+      {
+         sprintf(acKey, "s%d", i);
+         if (SymTable_get(oSymTable, acKey) != oSymTable)
+            psWork->iFailures++;
+         if (! SymTable_contains(oSymTable, acKey))
+            psWork->iFailures++;
+      }
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test a read-mostly SymTable whose stable bindings THREAD_COUNT
+   readers look up while this thread puts, replaces, and removes
+   iBindingCount other bindings, forcing several resizes. */
+
+static void testReadMostlyThreads(int iBindingCount)
+{
+   SymTable_T oSymTable;
+   pthread_t aThreads[THREAD_COUNT];
+   struct ThreadWork asWork[THREAD_COUNT];
+   char acKey[MAX_KEY_LENGTH];
+   char acValue[] = "value";
+   int iStableCount = 1000;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a read-mostly SymTable shared by several threads.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_newReadMostly();
+   ASSURE(oSymTable != NULL);
+
+   for (i = 0; i < iStableCount; i++)
+   {
+      sprintf(acKey, "s%d", i);
+      ASSURE(SymTable_put(oSymTable, acKey, oSymTable));
+   }
+
+   for (i = 0; i < THREAD_COUNT; i++)
+   {
+      asWork[i].pvTable = oSymTable;
+      asWork[i].iFirst = 0;
+      asWork[i].iCount = iStableCount;
+      asWork[i].iFailures = 0;
+      ASSURE(pthread_create(&aThreads[i], NULL, readMostlyReader,
+         &asWork[i]) == 0);
+   }
+
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "w%d", i);
+      ASSURE(SymTable_put(oSymTable, acKey, acValue));
+      ASSURE(SymTable_replace(oSymTable, acKey, oSymTable) == acValue);
+      if (i % 2 == 0)
+         ASSURE(SymTable_remove(oSymTable, acKey) == oSymTable);
+   }
+
+   for (i = 0; i < THREAD_COUNT; i++)
+   {
+      pthread_join(aThreads[i], NULL);
+      ASSURE(asWork[i].iFailures == 0);
+   }
+
+   ASSURE(SymTable_getLength(oSymTable) ==
+      (size_t)(iStableCount + iBindingCount / 2));
+   ASSURE(SymTable_get(oSymTable, "w1") ==
+      (iBindingCount > 1 ? oSymTable : NULL));
+   ASSURE(SymTable_get(oSymTable, "w0") == NULL);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The state that the loader thread of the load test shares with the
+   thread that puts. */
+
+struct LoadTextRun
+{
+   SymTable_T oSymTable;
+   const char *pcPath;
+   int iStop;
+   int iFailures;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Until the run described by pvArg (a struct LoadTextRun) stops, and
+   at least once, load its text file into its table. Count loads that
+   fail. */
+
+static void *textLoader(void *pvArg)
+{
+   struct LoadTextRun *psRun = (struct LoadTextRun*)pvArg;
+
+   do
+   {
+      if (! SymTable_loadText(psRun->oSymTable, psRun->pcPath, NULL, NULL))
+         psRun->iFailures++;
+   } while (! __atomic_load_n(&psRun->iStop, __ATOMIC_ACQUIRE));
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test a thread loading a text file of iBindingCount lines into a
+   read-mostly SymTable, over and over, while this thread puts
+   PUT_FACTOR times as many other bindings, which may grow the table
+   between a load's hashing and its inserts: every binding of both
+   must be there, once. */
+
+static void testLoadTextThreads(int iBindingCount)
+{
+   enum {PUT_FACTOR = 16};
+
+   static const char *pcTextPath = "testsymtablethreads.tsv";
+
+   struct LoadTextRun sRun;
+   pthread_t sThread;
+   FILE *psFile;
+   char acKey[MAX_KEY_LENGTH];
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing loading a text file while another thread puts.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   psFile = fopen(pcTextPath, "wb");
+   ASSURE(psFile != NULL);
+   if (psFile == NULL)
+      return;
+   for (i = 0; i < iBindingCount; i++)
+      fprintf(psFile, "t%d\n", i);
+   ASSURE(fclose(psFile) == 0);
+
+   sRun.oSymTable = SymTable_newReadMostly();
+   ASSURE(sRun.oSymTable != NULL);
+   SymTable_setResizeThreads(sRun.oSymTable, THREAD_COUNT);
+   sRun.pcPath = pcTextPath;
+   sRun.iStop = 0;
+   sRun.iFailures = 0;
+   ASSURE(pthread_create(&sThread, NULL, textLoader, &sRun) == 0);
+
+   for (i = 0; i < PUT_FACTOR * iBindingCount; i++)
+   {
+      sprintf(acKey, "w%d", i);
+      ASSURE(SymTable_put(sRun.oSymTable, acKey, sRun.oSymTable));
+   }
+
+   __atomic_store_n(&sRun.iStop, 1, __ATOMIC_RELEASE);
+   pthread_join(sThread, NULL);
+   ASSURE(sRun.iFailures == 0);
+
+   ASSURE(SymTable_getLength(sRun.oSymTable) ==
+      (size_t)((PUT_FACTOR + 1) * iBindingCount));
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "t%d", i);
+      ASSURE(SymTable_contains(sRun.oSymTable, acKey));
+      ASSURE(SymTable_get(sRun.oSymTable, acKey) == NULL);
+   }
+   for (i = 0; i < PUT_FACTOR * iBindingCount; i++)
+   {
+      sprintf(acKey, "w%d", i);
+      ASSURE(SymTable_get(sRun.oSymTable, acKey) == sRun.oSymTable);
+   }
+
+   SymTable_free(sRun.oSymTable);
+   remove(pcTextPath);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test a SymTable that rehashes on several threads each time it
+   grows while iBindingCount bindings are put into it. */
+
+static void testParallelResize(int iBindingCount)
+{
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   size_t uCount = 0;
+   int iFailures = 0;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a SymTable that grows on several threads.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   SymTable_setResizeThreads(oSymTable, THREAD_COUNT);
+
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      if (! SymTable_put(oSymTable, acKey, oSymTable))
+         iFailures++;
+   }
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      if (SymTable_get(oSymTable, acKey) != oSymTable)
+         iFailures++;
+   }
+   ASSURE(iFailures == 0);
+   ASSURE(SymTable_getLength(oSymTable) == (size_t)iBindingCount);
+   SymTable_map(oSymTable, countBinding, &uCount);
+   ASSURE(uCount == (size_t)iBindingCount);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Put, check, replace, and then remove the keys described by pvArg
+   (a struct ThreadWork) in a SymTableFC. Count failures. */
+
+static void *flatCombiningWorker(void *pvArg)
+{
+   struct ThreadWork *psWork = (struct ThreadWork*)pvArg;
+   SymTableFC_T oSymTableFC = (SymTableFC_T)psWork->pvTable;
+   char acKey[MAX_KEY_LENGTH];
+   int i;
+
+   for (i = psWork->iFirst; i < psWork->iFirst + psWork->iCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      if (! SymTableFC_put(oSymTableFC, acKey, oSymTableFC))
+         psWork->iFailures++;
+      if (SymTableFC_put(oSymTableFC, acKey, oSymTableFC))
+         psWork->iFailures++;
+   }
+   for (i = psWork->iFirst; i < psWork->iFirst + psWork->iCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      if (! SymTableFC_contains(oSymTableFC, acKey))
+         psWork->iFailures++;
+      if (SymTableFC_replace(oSymTableFC, acKey, psWork) != oSymTableFC)
+         psWork->iFailures++;
+      if (SymTableFC_get(oSymTableFC, acKey) != psWork)
+         psWork->iFailures++;
+   }
+   for (i = psWork->iFirst; i < psWork->iFirst + psWork->iCount; i += 2)
+   {
+      sprintf(acKey, "%d", i);
+      if (SymTableFC_remove(oSymTableFC, acKey) != psWork)
+         psWork->iFailures++;
+   }
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test a SymTableFC that THREAD_COUNT threads change at the same
+   time, each with iBindingCount keys of its own. */
+
+static void testFlatCombiningThreads(int iBindingCount)
+{
+   SymTableFC_T oSymTableFC;
+   pthread_t aThreads[THREAD_COUNT];
+   struct ThreadWork asWork[THREAD_COUNT];
+   size_t uExpected = 0;
+   size_t uCount = 0;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a SymTableFC shared by several threads.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTableFC = SymTableFC_new();
+   ASSURE(oSymTableFC != NULL);
+
+   ASSURE(SymTableFC_getLength(oSymTableFC) == 0);
+   ASSURE(SymTableFC_get(oSymTableFC, "Jeter") == NULL);
+   ASSURE(SymTableFC_remove(oSymTableFC, "Jeter") == NULL);
+   ASSURE(SymTableFC_replace(oSymTableFC, "Jeter", NULL) == NULL);
+
+   for (i = 0; i < THREAD_COUNT; i++)
+   {
+      asWork[i].pvTable = oSymTableFC;
+      asWork[i].iFirst = i * iBindingCount;
+      asWork[i].iCount = iBindingCount;
+      asWork[i].iFailures = 0;
+      ASSURE(pthread_create(&aThreads[i], NULL, flatCombiningWorker,
+         &asWork[i]) == 0);
+   }
+   for (i = 0; i < THREAD_COUNT; i++)
+   {
+      pthread_join(aThreads[i], NULL);
+      ASSURE(asWork[i].iFailures == 0);
+      uExpected += (size_t)(iBindingCount / 2);
+   }
+
+   ASSURE(SymTableFC_getLength(oSymTableFC) == uExpected);
+   SymTableFC_map(oSymTableFC, countBinding, &uCount);
+   ASSURE(uCount == uExpected);
+
+   SymTableFC_free(oSymTableFC);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The snapshot test's shared state: the holder of the versions, the
+   marker that every binding of version i is bound to (&aiVersions[i]),
+   the number of keys in each version, and the flag that tells the
+   readers to stop. */
+
+struct SnapshotRun
+{
+   SymTableRCU_T oSymTableRCU;
+   int *aiVersions;
+   int iKeyCount;
+   int iStop;
+};
+
+/* One reader thread of the snapshot test. */
+
+struct SnapshotWork
+{
+   struct SnapshotRun *psRun;
+   int iFailures;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Until the run described by pvArg (a struct SnapshotWork) stops,
+   acquire the current version, check that every binding in it belongs
+   to that one version and that versions never go backwards, and
+   release it. Count failures. */
+
+static void *snapshotReader(void *pvArg)
+{
+   struct SnapshotWork *psWork = (struct SnapshotWork*)pvArg;
+   struct SnapshotRun *psRun = psWork->psRun;
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   size_t uTicket;
+   int *piMarker;
+   int iLastVersion = 0;
+   int i;
+
+   while (! __atomic_load_n(&psRun->iStop, __ATOMIC_ACQUIRE))
+   {
+      oSymTable = SymTable_acquireSnapshot(psRun->oSymTableRCU, &uTicket);
+      piMarker = (int*)SymTable_get(oSymTable, "version");
+      if (piMarker == NULL)
+      {
+         if (iLastVersion != 0 || SymTable_getLength(oSymTable) != 0)
+            psWork->iFailures++;
+      }
+      else
+      {
+         if (*piMarker < iLastVersion)
+            psWork->iFailures++;
+         iLastVersion = *piMarker;
+         if (SymTable_getLength(oSymTable) !=
+               (size_t)psRun->iKeyCount + 1)
+            psWork->iFailures++;
+         for (i = 0; i < psRun->iKeyCount; i++)
+         {
+            sprintf(acKey, "k%d", i);
+            if (SymTable_get(oSymTable, acKey) != piMarker)
+               psWork->iFailures++;
+         }
+      }
+      SymTable_releaseSnapshot(psRun->oSymTableRCU, uTicket);
+   }
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test a SymTableRCU whose versions THREAD_COUNT readers acquire
+   while this thread builds and publishes new versions. The number of
+   versions grows with iBindingCount. */
+
+static void testSnapshotThreads(int iBindingCount)
+{
+   enum {KEYS_PER_VERSION = 64};
+
+   struct SnapshotRun sRun;
+   pthread_t aThreads[THREAD_COUNT];
+   struct SnapshotWork asWork[THREAD_COUNT];
+   SymTableRCU_T oSymTableRCU;
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   size_t uTicket;
+   int iVersionCount = iBindingCount / 100 + 1;
+   int iVersion;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable snapshots shared by several threads.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTableRCU = SymTableRCU_new();
+   ASSURE(oSymTableRCU != NULL);
+
+   oSymTable = SymTable_acquireSnapshot(oSymTableRCU, &uTicket);
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_getLength(oSymTable) == 0);
+   SymTable_releaseSnapshot(oSymTableRCU, uTicket);
+
+   sRun.oSymTableRCU = oSymTableRCU;
+   sRun.aiVersions = (int*)malloc(sizeof(int) * (size_t)(iVersionCount + 1));
+   ASSURE(sRun.aiVersions != NULL);
+   if (sRun.aiVersions == NULL)
+      return;
+   sRun.iKeyCount = KEYS_PER_VERSION;
+   sRun.iStop = 0;
+
+   for (i = 0; i < THREAD_COUNT; i++)
+   {
+      asWork[i].psRun = &sRun;
+      asWork[i].iFailures = 0;
+      ASSURE(pthread_create(&aThreads[i], NULL, snapshotReader,
+         &asWork[i]) == 0);
+   }
+
+   for (iVersion = 1; iVersion <= iVersionCount; iVersion++)
+   {
+      sRun.aiVersions[iVersion] = iVersion;
+      oSymTable = SymTable_new();
+      ASSURE(oSymTable != NULL);
+      ASSURE(SymTable_put(oSymTable, "version",
+         &sRun.aiVersions[iVersion]));
+      for (i = 0; i < KEYS_PER_VERSION; i++)
+      {
+         sprintf(acKey, "k%d", i);
+         ASSURE(SymTable_put(oSymTable, acKey,
+            &sRun.aiVersions[iVersion]));
+      }
+      SymTable_publish(oSymTableRCU, oSymTable);
+   }
+
+   __atomic_store_n(&sRun.iStop, 1, __ATOMIC_RELEASE);
+   for (i = 0; i < THREAD_COUNT; i++)
+   {
+      pthread_join(aThreads[i], NULL);
+      ASSURE(asWork[i].iFailures == 0);
+   }
+
+   oSymTable = SymTable_acquireSnapshot(oSymTableRCU, &uTicket);
+   ASSURE(SymTable_get(oSymTable, "version") ==
+      &sRun.aiVersions[iVersionCount]);
+   SymTable_releaseSnapshot(oSymTableRCU, uTicket);
+
+   SymTableRCU_free(oSymTableRCU);
+   free(sRun.aiVersions);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the thread-safe SymTable front ends. Write the output of the
+   tests to stdout. argv[1] is the number of bindings that each
+   thread puts into a shared table. Exit with EXIT_FAILURE if argv[1]
+   is missing or not a non-negative number. Otherwise return 0. */
+
+int main(int argc, char *argv[])
+{
+   int iBindingCount;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s bindingcount\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+
+   if (sscanf(argv[1], "%d", &iBindingCount) != 1)
+   {
+      fprintf(stderr, "bindingcount must be numeric\n");
+      exit(EXIT_FAILURE);
+   }
+   if (iBindingCount < 0)
+   {
+      fprintf(stderr, "bindingcount cannot be negative\n");
+      exit(EXIT_FAILURE);
+   }
+
+   testShardBasics();
+   testShardThreads(iBindingCount);
+   testReadMostlyThreads(iBindingCount);
+   testLoadTextThreads(iBindingCount);
+   testParallelResize(iBindingCount);
+   testFlatCombiningThreads(iBindingCount);
+   testSnapshotThreads(iBindingCount);
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}